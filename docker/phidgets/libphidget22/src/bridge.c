@@ -34,6 +34,7 @@
 #include "util/jsmn.h"	/* JSON */
 #include "mos/mos_base64.h"
 #include "mos/mos_assert.h"
+#include "mos/mos_atomic.h"
 #include "mos/bsdqueue.h"
 #include "bridge.h"
 #include "network/network.h"
@@ -336,6 +337,7 @@ processBPHeader(pjsmntok_t *token, const char *text, BridgePacket **bridgePacket
 	uint64_t			phidid = 0;		/* phidget id */
 	uint64_t			ocid = 0;		/* open channel id */
 	int					chidx = 0;		/* channel index */
+	uint64_t			timestamp = 0;	/* input timestamp */
 
 	*bridgePacket = (BridgePacket *)NULL;
 	bp = NULL;
@@ -404,6 +406,11 @@ processBPHeader(pjsmntok_t *token, const char *text, BridgePacket **bridgePacket
 				goto error;
 			chidx = (int)i64;
 			break;
+		case 'T':
+			if (pjsmn_uint64(text, token, &u64) != 0)
+				goto error;
+			timestamp = u64;
+			break;
 		case 'e':
 			if (bp == NULL)
 				goto error;
@@ -414,6 +421,7 @@ processBPHeader(pjsmntok_t *token, const char *text, BridgePacket **bridgePacket
 			bp->phidid = phidid;
 			bp->ocid = ocid;
 			bp->chidx = chidx;
+			bp->timestamp = timestamp;
 
 			*bridgePacket = bp;
 			return (off + 2);
@@ -695,10 +703,19 @@ renderBridgePacketJSON(BridgePacket *bp, char *buf, uint32_t *bufsz) {
 	p = &buf[0];
 	n = *bufsz;
 	w = snprintf(p, n,
-	  "{\"v\":0,\"s\":%d,\"f\":%u,\"p\":%d,\"I\":%"PRIu64",\"O\":%"PRIu64",\"X\":%d,\"c\":%u,\"e\":{\n",
+	  "{\"v\":0,\"s\":%d,\"f\":%u,\"p\":%d,\"I\":%"PRIu64",\"O\":%"PRIu64",\"X\":%d,\"c\":%u,",
 	  bp->source, bp->flags, bp->vpkt, bp->phidid, bp->ocid, bp->chidx, bp->entrycnt);
 	ADJUSTPTRANDLEN;
 
+	/* The input timestamp must precede the entries: the parser stops reading the header at "e" */
+	if (bp->timestamp != 0) {
+		w = snprintf(p, n, "\"T\":%"PRIu64",", bp->timestamp);
+		ADJUSTPTRANDLEN;
+	}
+
+	w = snprintf(p, n, "\"e\":{\n");
+	ADJUSTPTRANDLEN;
+
 	for (off = 0; off < bp->entrycnt; off++) {
 		if (bp->entry[off].name)
 			w = snprintf(p, n, "\"%s\":", bp->entry[off].name);
@@ -837,6 +854,551 @@ renderBridgePacketJSON(BridgePacket *bp, char *buf, uint32_t *bufsz) {
 	return (EPHIDGET_OK);
 }
 
+/*
+ * Binary bridge packet encoding (BPENC_BINARY).
+ *
+ * Used in place of JSON when negotiated during the handshake.  Scalars are little-endian, and
+ * FLOAT and DBL values are sent as IEEE 754 doubles so the value is not rounded through text.
+ *
+ *  header: magic(1) version(1) source(1) vpkt(4) flags(4) phidid(8) ocid(8) chidx(4) entrycnt(2)
+ *          [timestamp(8)]
+ *  entry:  type(1) name(1) [namelen(1) name] value
+ *
+ * Version 2 (BPENC_BINARYTS) adds the input timestamp to the header; version 1 packets are still
+ * accepted from peers that negotiated BPENC_BINARY.
+ *
+ * The name byte is 0 for an unnamed (positional) entry, the index + 1 of an interned name, or
+ * BPBIN_NAME_INLINE if the name follows.  Strings, JSON and arrays are prefixed by a 16 bit count.
+ */
+#define BPBIN_MAGIC			0xB9	/* cannot start a JSON packet */
+#define BPBIN_VERSION		1
+#define BPBIN_VERSIONTS		2
+#define BPBIN_HEADERLEN		33
+#define BPBIN_HEADERLENTS	41
+#define BPBIN_NAME_INLINE	0xFF
+
+/*
+ * Names common enough to be worth a table entry.  Only ever append to this list.
+ */
+static const char *bpbinNames[] = {
+	"_class_version_",
+};
+#define BPBIN_NAMECNT	(sizeof(bpbinNames) / sizeof(bpbinNames[0]))
+
+static int
+bpbinPut(uint8_t **p, const uint8_t *end, uint64_t v, int n) {
+	int i;
+
+	if (end - *p < n)
+		return (-1);
+
+	for (i = 0; i < n; i++, v >>= 8)
+		*(*p)++ = (uint8_t)v;
+	return (0);
+}
+
+static int
+bpbinGet(const uint8_t **p, const uint8_t *end, uint64_t *v, int n) {
+	int i;
+
+	if (end - *p < n)
+		return (-1);
+
+	*v = 0;
+	for (i = 0; i < n; i++)
+		*v |= (uint64_t)(*p)[i] << (i * 8);
+	*p += n;
+	return (0);
+}
+
+static int
+bpbinPutDbl(uint8_t **p, const uint8_t *end, double d) {
+	uint64_t u64;
+
+	memcpy(&u64, &d, sizeof(u64));
+	return (bpbinPut(p, end, u64, 8));
+}
+
+static int
+bpbinGetDbl(const uint8_t **p, const uint8_t *end, double *d) {
+	uint64_t u64;
+
+	if (bpbinGet(p, end, &u64, 8) != 0)
+		return (-1);
+	memcpy(d, &u64, sizeof(*d));
+	return (0);
+}
+
+static int
+bpbinPutBytes(uint8_t **p, const uint8_t *end, const void *buf, size_t len) {
+
+	if (len > 0xFFFF || bpbinPut(p, end, len, 2) != 0 || (size_t)(end - *p) < len)
+		return (-1);
+
+	if (len > 0)
+		memcpy(*p, buf, len);
+	*p += len;
+	return (0);
+}
+
+/*
+ * Entries created from a JSON packet are named by their offset: send those as unnamed.
+ */
+static int
+bpbinIsPositionalName(const char *name, int off) {
+	int n;
+
+	if (*name == '\0')
+		return (0);
+
+	for (n = 0; *name >= '0' && *name <= '9'; name++)
+		n = n * 10 + (*name - '0');
+
+	return (*name == '\0' && n == off);
+}
+
+static int
+bpbinPutName(uint8_t **p, const uint8_t *end, const char *name, int off) {
+	size_t len;
+	size_t i;
+
+	if (name == NULL || bpbinIsPositionalName(name, off))
+		return (bpbinPut(p, end, 0, 1));
+
+	for (i = 0; i < BPBIN_NAMECNT; i++)
+		if (strcmp(name, bpbinNames[i]) == 0)
+			return (bpbinPut(p, end, i + 1, 1));
+
+	len = strlen(name);
+	if (len > 0xFF || end - *p < (ptrdiff_t)len + 2)
+		return (-1);
+
+	*(*p)++ = BPBIN_NAME_INLINE;
+	*(*p)++ = (uint8_t)len;
+	memcpy(*p, name, len);
+	*p += len;
+	return (0);
+}
+
+static int
+bpbinPutArray(uint8_t **p, const uint8_t *end, BridgePacketEntry *bpe) {
+	uint64_t v;
+	int err;
+	int sz;
+	int i;
+
+	switch (bpe->type) {
+	case BPE_UI8ARRAY:
+		return (bpbinPutBytes(p, end, bpe->bpe_ui8array, bpe->bpe_cnt));
+	case BPE_I16ARRAY:
+	case BPE_UI16ARRAY:
+		sz = 2;
+		break;
+	case BPE_I32ARRAY:
+	case BPE_UI32ARRAY:
+		sz = 4;
+		break;
+	default:
+		sz = 8;
+		break;
+	}
+
+	if (bpbinPut(p, end, bpe->bpe_cnt, 2) != 0 || end - *p < bpe->bpe_cnt * sz)
+		return (-1);
+
+	err = 0;
+	for (i = 0; i < bpe->bpe_cnt && err == 0; i++) {
+		switch (bpe->type) {
+		case BPE_I16ARRAY:
+			v = (uint16_t)bpe->bpe_i16array[i];
+			break;
+		case BPE_UI16ARRAY:
+			v = bpe->bpe_ui16array[i];
+			break;
+		case BPE_I32ARRAY:
+			v = (uint32_t)bpe->bpe_i32array[i];
+			break;
+		case BPE_UI32ARRAY:
+			v = bpe->bpe_ui32array[i];
+			break;
+		case BPE_I64ARRAY:
+			v = (uint64_t)bpe->bpe_i64array[i];
+			break;
+		case BPE_UI64ARRAY:
+			v = bpe->bpe_ui64array[i];
+			break;
+		case BPE_DBLARRAY:
+		default:
+			err = bpbinPutDbl(p, end, bpe->bpe_dblarray[i]);
+			continue;
+		}
+		err = bpbinPut(p, end, v, sz);
+	}
+	return (err);
+}
+
+/*
+ * Renders in the binary version that matches the negotiated encoding (BPENC_BINARY or BPENC_BINARYTS).
+ */
+PhidgetReturnCode
+renderBridgePacketBinary(BridgePacket *bp, int bpenc, uint8_t *buf, uint32_t *bufsz) {
+	BridgePacketEntry *bpe;
+	const uint8_t *end;
+	uint8_t *p;
+	int err;
+	int off;
+
+	if (*bufsz > NR_MAXDATALEN)
+		return (EPHIDGET_INVALIDARG);
+
+	p = buf;
+	end = buf + *bufsz;
+
+	if (end - p < (bpenc == BPENC_BINARYTS ? BPBIN_HEADERLENTS : BPBIN_HEADERLEN))
+		return (EPHIDGET_INVALIDARG);
+
+	bpbinPut(&p, end, BPBIN_MAGIC, 1);
+	bpbinPut(&p, end, bpenc == BPENC_BINARYTS ? BPBIN_VERSIONTS : BPBIN_VERSION, 1);
+	bpbinPut(&p, end, bp->source, 1);
+	bpbinPut(&p, end, bp->vpkt, 4);
+	bpbinPut(&p, end, bp->flags, 4);
+	bpbinPut(&p, end, bp->phidid, 8);
+	bpbinPut(&p, end, bp->ocid, 8);
+	bpbinPut(&p, end, (uint32_t)bp->chidx, 4);
+	bpbinPut(&p, end, bp->entrycnt, 2);
+	if (bpenc == BPENC_BINARYTS)
+		bpbinPut(&p, end, bp->timestamp, 8);
+
+	for (off = 0; off < bp->entrycnt; off++) {
+		bpe = &bp->entry[off];
+
+		/* Pointers are meaningless to the peer (and are not rendered in JSON either) */
+		if (bpe->type == BPE_PTR) {
+			if (bpbinPut(&p, end, BPE_NONE, 1) != 0 || bpbinPutName(&p, end, bpe->name, off) != 0)
+				return (EPHIDGET_INVALIDARG);
+			continue;
+		}
+
+		if (bpbinPut(&p, end, bpe->type, 1) != 0 || bpbinPutName(&p, end, bpe->name, off) != 0)
+			return (EPHIDGET_INVALIDARG);
+
+		switch (bpe->type) {
+		case BPE_NONE:
+			err = 0;
+			break;
+		case BPE_UI8:
+			err = bpbinPut(&p, end, bpe->bpe_ui64, 1);
+			break;
+		case BPE_I16:
+		case BPE_UI16:
+			err = bpbinPut(&p, end, bpe->bpe_ui64, 2);
+			break;
+		case BPE_I32:
+		case BPE_UI32:
+			err = bpbinPut(&p, end, bpe->bpe_ui64, 4);
+			break;
+		case BPE_I64:
+		case BPE_UI64:
+			err = bpbinPut(&p, end, bpe->bpe_ui64, 8);
+			break;
+		case BPE_FLOAT:
+		case BPE_DBL:
+			err = bpbinPutDbl(&p, end, bpe->bpe_dbl);
+			break;
+		case BPE_STR:
+			err = bpbinPutBytes(&p, end, bpe->bpe_str, strlen(bpe->bpe_str));
+			break;
+		case BPE_JSON:
+			err = bpbinPutBytes(&p, end, bpe->bpe_ptr, strlen((const char *)bpe->bpe_ptr));
+			break;
+		case BPE_UI8ARRAY:
+		case BPE_I16ARRAY:
+		case BPE_UI16ARRAY:
+		case BPE_I32ARRAY:
+		case BPE_UI32ARRAY:
+		case BPE_I64ARRAY:
+		case BPE_UI64ARRAY:
+		case BPE_DBLARRAY:
+			err = bpbinPutArray(&p, end, bpe);
+			break;
+		default:
+			return (EPHIDGET_UNSUPPORTED);
+		}
+		if (err != 0)
+			return (EPHIDGET_INVALIDARG);
+	}
+
+	*bufsz = (uint32_t)(p - buf);
+	return (EPHIDGET_OK);
+}
+
+static int
+bpbinGetName(const uint8_t **p, const uint8_t *end, BridgePacketEntry *bpe) {
+	char name[256];
+	uint64_t v;
+
+	if (bpbinGet(p, end, &v, 1) != 0)
+		return (-1);
+
+	if (v == 0)
+		return (0);
+
+	if (v <= BPBIN_NAMECNT) {
+		bpe->name = mos_strdup(bpbinNames[v - 1], NULL);
+		return (0);
+	}
+
+	if (v != BPBIN_NAME_INLINE || bpbinGet(p, end, &v, 1) != 0 || end - *p < (ptrdiff_t)v)
+		return (-1);
+
+	memcpy(name, *p, (size_t)v);
+	name[v] = '\0';
+	*p += v;
+
+	bpe->name = mos_strdup(name, NULL);
+	return (0);
+}
+
+static int
+bpbinGetString(const uint8_t **p, const uint8_t *end, BridgePacketEntry *bpe) {
+	char strbuf[BPE_STR_LEN + 1];
+	uint64_t len;
+
+	if (bpbinGet(p, end, &len, 2) != 0 || end - *p < (ptrdiff_t)len)
+		return (-1);
+
+	if (bpe->type == BPE_STR) {
+		if (len > BPE_STR_LEN)
+			return (-1);
+		memcpy(strbuf, *p, (size_t)len);
+		strbuf[len] = '\0';
+		bpe->bpe_ptr = mos_strdup(strbuf, NULL);
+	} else {
+		if (len == 0 || len + 1 > BPE_MAXARRAY_LEN)
+			return (-1);
+		bpe->bpe_len = (uint16_t)(len + 1);
+		bpe->bpe_ptr = mos_malloc(bpe->bpe_len);
+		memcpy(bpe->bpe_ptr, *p, (size_t)len);
+		((char *)bpe->bpe_ptr)[len] = '\0';
+	}
+
+	*p += len;
+	return (0);
+}
+
+static int
+bpbinGetArray(const uint8_t **p, const uint8_t *end, BridgePacket *bp, int off) {
+	BridgePacketEntry *bpe;
+	uint64_t cnt;
+	uint64_t v;
+	double d;
+	int sz;
+	int i;
+
+	bpe = &bp->entry[off];
+
+	switch (bpe->type) {
+	case BPE_UI8ARRAY:
+		sz = 1;
+		break;
+	case BPE_I16ARRAY:
+	case BPE_UI16ARRAY:
+		sz = 2;
+		break;
+	case BPE_I32ARRAY:
+	case BPE_UI32ARRAY:
+		sz = 4;
+		break;
+	default:
+		sz = 8;
+		break;
+	}
+
+	if (bpbinGet(p, end, &cnt, 2) != 0)
+		return (-1);
+	/* the same element limit as the JSON encoding: bpe_len must also hold the size in bytes */
+	if (cnt > BPE_MAXARRAY_LEN || cnt * sz > 0xFFFF || end - *p < (ptrdiff_t)(cnt * sz))
+		return (-1);
+
+	allocArray(bp, (size_t)cnt, bpe->type, off);
+	v = 0;
+	d = 0;
+
+	if (bpe->type == BPE_UI8ARRAY) {
+		if (cnt > 0)
+			memcpy(bpe->bpe_ui8array, *p, (size_t)cnt);
+		*p += cnt;
+		return (0);
+	}
+
+	for (i = 0; i < (int)cnt; i++) {
+		if (bpe->type == BPE_DBLARRAY) {
+			bpbinGetDbl(p, end, &d);
+			bpe->bpe_dblarray[i] = d;
+			continue;
+		}
+
+		bpbinGet(p, end, &v, sz);
+		switch (bpe->type) {
+		case BPE_I16ARRAY:
+			bpe->bpe_i16array[i] = (int16_t)v;
+			break;
+		case BPE_UI16ARRAY:
+			bpe->bpe_ui16array[i] = (uint16_t)v;
+			break;
+		case BPE_I32ARRAY:
+			bpe->bpe_i32array[i] = (int32_t)v;
+			break;
+		case BPE_UI32ARRAY:
+			bpe->bpe_ui32array[i] = (uint32_t)v;
+			break;
+		case BPE_I64ARRAY:
+			bpe->bpe_i64array[i] = (int64_t)v;
+			break;
+		case BPE_UI64ARRAY:
+		default:
+			bpe->bpe_ui64array[i] = v;
+			break;
+		}
+	}
+	return (0);
+}
+
+PhidgetReturnCode
+parseBridgePacketBinary(BridgePacket **bridgePacket, const uint8_t *buf, uint32_t buflen) {
+	BridgePacketEntry *bpe;
+	const uint8_t *end;
+	const uint8_t *p;
+	BridgePacket *bp;
+	uint64_t hdr[10];
+	uint64_t v;
+	int err;
+	int off;
+
+	*bridgePacket = NULL;
+
+	p = buf;
+	end = buf + buflen;
+
+	if (buflen < BPBIN_HEADERLEN || buf[0] != BPBIN_MAGIC)
+		return (EPHIDGET_INVALID);
+
+	if (buf[1] != BPBIN_VERSION && buf[1] != BPBIN_VERSIONTS) {
+		logerr("unsupported binary bridge packet version %d", buf[1]);
+		return (EPHIDGET_UNSUPPORTED);
+	}
+
+	if (buf[1] == BPBIN_VERSIONTS && buflen < BPBIN_HEADERLENTS)
+		return (EPHIDGET_INVALID);
+
+	/* the length was checked above */
+	memset(hdr, 0, sizeof(hdr));
+	bpbinGet(&p, end, &hdr[0], 1);	/* magic */
+	bpbinGet(&p, end, &hdr[1], 1);	/* version */
+	bpbinGet(&p, end, &hdr[2], 1);
+	bpbinGet(&p, end, &hdr[3], 4);
+	bpbinGet(&p, end, &hdr[4], 4);
+	bpbinGet(&p, end, &hdr[5], 8);
+	bpbinGet(&p, end, &hdr[6], 8);
+	bpbinGet(&p, end, &hdr[7], 4);
+	bpbinGet(&p, end, &hdr[8], 2);
+	if (buf[1] == BPBIN_VERSIONTS)
+		bpbinGet(&p, end, &hdr[9], 8);
+
+	if (hdr[2] != BPS_BRIDGE && hdr[2] != BPS_JSON)
+		return (EPHIDGET_INVALID);
+	if (hdr[8] > BRIDGE_PACKET_ENTRY_MAX)
+		return (EPHIDGET_INVALID);
+
+	// NOTE: add some extra entries - some device code adds to an existing BridgePacket
+	allocBridgePacket(&bp, (uint16_t)hdr[8] + 4);
+	bp->source = (BridgePacketSource)hdr[2];
+	bp->vpkt = (bridgepacket_t)hdr[3];
+	bp->flags = (uint32_t)hdr[4];
+	bp->phidid = hdr[5];
+	bp->ocid = hdr[6];
+	bp->chidx = (int32_t)(uint32_t)hdr[7];
+	bp->timestamp = hdr[9];
+
+	for (off = 0; off < (int)hdr[8]; off++) {
+		/* count the entry now so it is freed if it is only partially decoded */
+		bp->entrycnt = (uint16_t)(off + 1);
+		bpe = &bp->entry[off];
+
+		if (bpbinGet(&p, end, &v, 1) != 0 || v > BPE_JSON || v == BPE_PTR)
+			goto error;
+		bpe->type = (BridgePacketEntryType)v;
+
+		if (bpbinGetName(&p, end, bpe) != 0)
+			goto error;
+
+		switch (bpe->type) {
+		case BPE_NONE:
+			err = 0;
+			break;
+		case BPE_UI8:
+			err = bpbinGet(&p, end, &bpe->bpe_ui64, 1);
+			break;
+		case BPE_UI16:
+			err = bpbinGet(&p, end, &bpe->bpe_ui64, 2);
+			break;
+		case BPE_UI32:
+			err = bpbinGet(&p, end, &bpe->bpe_ui64, 4);
+			break;
+		case BPE_UI64:
+			err = bpbinGet(&p, end, &bpe->bpe_ui64, 8);
+			break;
+		case BPE_I16:
+			err = bpbinGet(&p, end, &v, 2);
+			bpe->bpe_i64 = (int16_t)v;
+			break;
+		case BPE_I32:
+			err = bpbinGet(&p, end, &v, 4);
+			bpe->bpe_i64 = (int32_t)v;
+			break;
+		case BPE_I64:
+			err = bpbinGet(&p, end, &v, 8);
+			bpe->bpe_i64 = (int64_t)v;
+			break;
+		case BPE_FLOAT:
+		case BPE_DBL:
+			err = bpbinGetDbl(&p, end, &bpe->bpe_dbl);
+			break;
+		case BPE_STR:
+		case BPE_JSON:
+			err = bpbinGetString(&p, end, bpe);
+			break;
+		default:
+			err = bpbinGetArray(&p, end, bp, off);
+			break;
+		}
+		if (err != 0)
+			goto error;
+	}
+
+	if (p != end)
+		goto error;
+
+	*bridgePacket = bp;
+	return (EPHIDGET_OK);
+
+error:
+	logerr("invalid binary bridge packet");
+	destroyBridgePacket(&bp);
+	return (EPHIDGET_INVALID);
+}
+
+/*
+ * Parses a bridge packet read from the network, in whichever encoding the peer used.
+ */
+PhidgetReturnCode
+parseBridgePacket(void *tokens, BridgePacket **bridgePacket, const void *data, uint32_t datalen) {
+
+	if (datalen > 0 && ((const uint8_t *)data)[0] == BPBIN_MAGIC)
+		return (parseBridgePacketBinary(bridgePacket, data, datalen));
+	return (parseBridgePacketJSON(tokens, bridgePacket, data, datalen));
+}
+
 PhidgetReturnCode
 createBridgePacket(BridgePacket **bridgePacket, bridgepacket_t pkt, uint16_t entrycnt, const char *fmt, ...) {
 	PhidgetReturnCode res;
@@ -849,57 +1411,104 @@ createBridgePacket(BridgePacket **bridgePacket, bridgepacket_t pkt, uint16_t ent
 	return (res);
 }
 
-PhidgetReturnCode
-createBridgePacketv(BridgePacket **bridgePacket, bridgepacket_t pkt, uint16_t entrycnt, const char *fmt, va_list va) {
-	BridgePacket *bp;
-	const char *cptr;
+/*
+ * Bridge packet templates.
+ *
+ * Each format string passed to createBridgePacket() is compiled once into a template describing the
+ * type, array count and name of every entry.  Packets are then built by filling the entries directly
+ * from the arguments, and share the template's copy of the entry names.
+ *
+ * Templates are found by the address of the format string, which is almost always a literal, and
+ * the string is compared to guard against formats built at run time.  Templates are only added to
+ * the hash chains, and are complete before they are published, so lookups do not lock.
+ */
+#define BPT_HASHSZ		256
+#define BPT_MAX			4096	/* formats compiled without being cached past this */
+#define BPT_ARGCNT		-1		/* array count passed as an argument ('*') */
+
+typedef struct _BridgePacketSlot {
+	BridgePacketEntryType	type;
+	int						cnt;		/* array count, or BPT_ARGCNT */
+	char					*name;		/* NULL if unnamed */
+} BridgePacketSlot;
+
+typedef struct _BridgePacketTemplate {
+	struct _BridgePacketTemplate	*next;
+	const char						*fmt;		/* address the template was compiled from */
+	char							*fmtcopy;
+	uint16_t						slotcnt;
+	BridgePacketSlot				slot[];
+} BridgePacketTemplate;
+
+static BridgePacketTemplate	*bptHash[BPT_HASHSZ];	/* published with mos_atomic_swap_ptr() */
+static mos_mutex_t			bptLock;		/* serializes additions */
+static uint32_t				bptCnt;
+
+static uint32_t
+bptHashFmt(const char *fmt) {
+
+	return ((uint32_t)(((uintptr_t)fmt >> 3) ^ ((uintptr_t)fmt >> 11)) % BPT_HASHSZ);
+}
+
+static void
+freeBridgePacketTemplate(BridgePacketTemplate *bpt) {
+	int i;
+
+	for (i = 0; i < bpt->slotcnt; i++)
+		if (bpt->slot[i].name != NULL)
+			mos_free(bpt->slot[i].name, MOSM_FSTR);
+
+	mos_free(bpt->fmtcopy, MOSM_FSTR);
+	mos_free(bpt, sizeof(BridgePacketTemplate) + bpt->slotcnt * sizeof(BridgePacketSlot));
+}
+
+/*
+ * Compiles a format string into a template.  Returns NULL if the format is invalid.
+ */
+static BridgePacketTemplate *
+compileBridgePacketTemplate(const char *fmt) {
+	BridgePacketTemplate *bpt;
+	BridgePacketEntryType type;
+	const char *f;
 	char name[64];
-	void *arrptr;
 	int nameoff;
+	int slotcnt;
 	int ch;
 	int n;
-	int sz;
 
-	*bridgePacket = (BridgePacket *)NULL;
+	/* Every entry has exactly one '%' */
+	for (slotcnt = 0, f = fmt; *f != '\0'; f++)
+		if (*f == '%')
+			slotcnt++;
 
-	// NOTE: add some extra entries - some device code adds to an existing BridgePacket
-	allocBridgePacket(&bp, entrycnt + 4);
-	bp->source = BPS_BRIDGE;
-	bp->vpkt = pkt;
+	if (slotcnt > BRIDGE_PACKET_ENTRY_MAX)
+		return (NULL);
 
-	if (fmt == NULL) {
-		*bridgePacket = bp;
-		return (EPHIDGET_OK);
-	}
+	bpt = mos_zalloc(sizeof(BridgePacketTemplate) + slotcnt * sizeof(BridgePacketSlot));
+	bpt->fmt = fmt;
+	bpt->fmtcopy = mos_strdup(fmt, NULL);
 
-	for (bp->entrycnt = 0; bp->entrycnt < bp->entrylen; bp->entrycnt++) {
+	for (;;) {
 		memset(name, 0, sizeof(name));
 		nameoff = 0;
 
 		while ((ch = (uint8_t)*fmt++) != '%') {
-			if (ch == '\0') {
-				*bridgePacket = bp;
-				return (EPHIDGET_OK);
-			}
+			if (ch == '\0')
+				return (bpt);
 			if (ch == ',' || ch == '=')
 				continue;
 			name[nameoff] = (char)ch;
 			nameoff++;
-			if (nameoff >= (int)sizeof(name)) {
-				destroyBridgePacket(&bp);
-				return (EPHIDGET_INVALIDARG);
-			}
+			if (nameoff >= (int)sizeof(name))
+				goto bad;
 		}
 
-		if (nameoff != 0)
-			bp->entry[bp->entrycnt].name = mos_strdup(name, NULL);
-
 		n = 0;
 
 	reswitch:
 		switch (ch = (uint8_t)*fmt++) {
 		case '*':
-			n = va_arg(va, int);
+			n = BPT_ARGCNT;
 			goto reswitch;
 		case '0': case '1': case '2': case '3': case '4':
 		case '5': case '6': case '7': case '8': case '9':
@@ -913,178 +1522,308 @@ createBridgePacketv(BridgePacket **bridgePacket, bridgepacket_t pkt, uint16_t en
 		case 'u':
 			switch ((uint8_t)(*fmt)) {
 			case 'h':
-				bp->entry[bp->entrycnt].type = BPE_UI16;
-				bp->entry[bp->entrycnt].bpe_ui64 = va_arg(va, int);
+				type = BPE_UI16;
 				fmt++;
 				break;
 			case 'l':
-				bp->entry[bp->entrycnt].type = BPE_UI64;
-				bp->entry[bp->entrycnt].bpe_ui64 = va_arg(va, uint64_t);
+				type = BPE_UI64;
 				fmt++;
 				break;
 			default:
-				bp->entry[bp->entrycnt].type = BPE_UI32;
-				bp->entry[bp->entrycnt].bpe_ui64 = va_arg(va, uint32_t);
+				type = BPE_UI32;
 				break;
 			}
 			break;
 		case 'c':
-			bp->entry[bp->entrycnt].type = BPE_UI8;
-			bp->entry[bp->entrycnt].bpe_ui64 = va_arg(va, int);
+			type = BPE_UI8;
 			break;
 		case 'h':
-			bp->entry[bp->entrycnt].type = BPE_I16;
-			bp->entry[bp->entrycnt].bpe_i64 = va_arg(va, int);
+			type = BPE_I16;
 			break;
 		case 'd':
-			bp->entry[bp->entrycnt].type = BPE_I32;
-			bp->entry[bp->entrycnt].bpe_i64 = va_arg(va, int);
+			type = BPE_I32;
 			break;
 		case 'l':
-			bp->entry[bp->entrycnt].type = BPE_I64;
-			bp->entry[bp->entrycnt].bpe_i64 = va_arg(va, int64_t);
+			type = BPE_I64;
 			break;
 		case 'f':
-			bp->entry[bp->entrycnt].type = BPE_FLOAT;
-			bp->entry[bp->entrycnt].bpe_dbl = va_arg(va, double);
+			type = BPE_FLOAT;
 			break;
 		case 'g':
-			bp->entry[bp->entrycnt].type = BPE_DBL;
-			bp->entry[bp->entrycnt].bpe_dbl = va_arg(va, double);
+			type = BPE_DBL;
 			break;
 		case 's':
-			bp->entry[bp->entrycnt].type = BPE_STR;
-			cptr = va_arg(va, const char *);
-			if (strlen(cptr) > BPE_STR_LEN)
-				return (EPHIDGET_INVALIDARG);
-			bp->entry[bp->entrycnt].bpe_ptr = mos_strdup(cptr, NULL);
+			type = BPE_STR;
 			break;
 		case 'p':
-			bp->entry[bp->entrycnt].type = BPE_PTR;
-			bp->entry[bp->entrycnt].bpe_ptr = va_arg(va, void *);
+			type = BPE_PTR;
 			break;
 		case 'R':
-			if (n > BPE_MAXARRAY_LEN) {
-				destroyBridgePacket(&bp);
-				return (EPHIDGET_INVALIDARG);
-			}
-			allocArray(bp, n, BPE_UI8ARRAY, bp->entrycnt);
-			arrptr = va_arg(va, uint8_t *);
-			if (n > 0)
-				memcpy(bp->entry[bp->entrycnt].bpe_ui8array, arrptr, n);
+			type = BPE_UI8ARRAY;
 			break;
 		case 'H':
-			sz = n * sizeof(int16_t);
-			if (sz > BPE_MAXARRAY_LEN) {
-				destroyBridgePacket(&bp);
-				return (EPHIDGET_INVALIDARG);
-			}
-			allocArray(bp, n, BPE_I16ARRAY, bp->entrycnt);
-			arrptr = va_arg(va, int16_t *);
-			if (n > 0)
-				memcpy(bp->entry[bp->entrycnt].bpe_i16array, arrptr, sz);
+			type = BPE_I16ARRAY;
 			break;
 		case 'I':
-			sz = n * sizeof(int32_t);
-			if (sz > BPE_MAXARRAY_LEN) {
-				destroyBridgePacket(&bp);
-				return (EPHIDGET_INVALIDARG);
-			}
-			allocArray(bp, n, BPE_I32ARRAY, bp->entrycnt);
-			arrptr = va_arg(va, int32_t *);
-			if (n > 0)
-				memcpy(bp->entry[bp->entrycnt].bpe_i32array, arrptr, sz);
+			type = BPE_I32ARRAY;
 			break;
 		case 'U':
 			switch ((uint8_t)(*fmt)) {
 			case 'H':
-				sz = n * sizeof(uint16_t);
-				if (sz > BPE_MAXARRAY_LEN) {
-					destroyBridgePacket(&bp);
-					return (EPHIDGET_INVALIDARG);
-				}
-				allocArray(bp, n, BPE_UI16ARRAY, bp->entrycnt);
-				arrptr = va_arg(va, uint16_t *);
-				if (n > 0)
-					memcpy(bp->entry[bp->entrycnt].bpe_ui16array, arrptr, sz);
+				type = BPE_UI16ARRAY;
 				fmt++;
 				break;
 			case 'L':
-				sz = n * sizeof(uint64_t);
-				if (sz > BPE_MAXARRAY_LEN) {
-					destroyBridgePacket(&bp);
-					return (EPHIDGET_INVALIDARG);
-				}
-				allocArray(bp, n, BPE_UI64ARRAY, bp->entrycnt);
-				arrptr = va_arg(va, uint64_t *);
-				if (n > 0)
-					memcpy(bp->entry[bp->entrycnt].bpe_ui64array, arrptr, sz);
+				type = BPE_UI64ARRAY;
 				fmt++;
 				break;
 			default:
-				sz = n * sizeof(uint32_t);
-				if (sz > BPE_MAXARRAY_LEN) {
-					destroyBridgePacket(&bp);
-					return (EPHIDGET_INVALIDARG);
-				}
-				allocArray(bp, n, BPE_UI32ARRAY, bp->entrycnt);
-				arrptr = va_arg(va, uint32_t *);
-				if (n > 0)
-					memcpy(bp->entry[bp->entrycnt].bpe_ui32array, arrptr, sz);
+				type = BPE_UI32ARRAY;
 				break;
 			}
 			break;
 		case 'L':
-			sz = n * sizeof(int64_t);
-			if (sz > BPE_MAXARRAY_LEN) {
-				destroyBridgePacket(&bp);
-				return (EPHIDGET_INVALIDARG);
-			}
-			allocArray(bp, n, BPE_I64ARRAY, bp->entrycnt);
-			arrptr = va_arg(va, int64_t *);
-			if (n > 0)
-				memcpy(bp->entry[bp->entrycnt].bpe_i64array, arrptr, sz);
+			type = BPE_I64ARRAY;
 			break;
 		case 'G':
-			sz = n * sizeof(double);
-			if (sz > BPE_MAXARRAY_LEN) {
-				destroyBridgePacket(&bp);
+			type = BPE_DBLARRAY;
+			break;
+		case 'J':
+			type = BPE_JSON;
+			break;
+		default:
+			goto bad;
+		}
+
+		bpt->slot[bpt->slotcnt].type = type;
+		bpt->slot[bpt->slotcnt].cnt = n;
+		if (nameoff != 0)
+			bpt->slot[bpt->slotcnt].name = mos_strdup(name, NULL);
+		bpt->slotcnt++;
+	}
+
+bad:
+	freeBridgePacketTemplate(bpt);
+	return (NULL);
+}
+
+/*
+ * Returns the template for the format, compiling it if required.  *tmp is set if the template was
+ * not cached, and must be freed by the caller.
+ */
+static BridgePacketTemplate *
+getBridgePacketTemplate(const char *fmt, int *tmp) {
+	BridgePacketTemplate *bpt;
+	uint32_t h;
+
+	*tmp = 0;
+	h = bptHashFmt(fmt);
+
+	for (bpt = bptHash[h]; bpt != NULL; bpt = bpt->next)
+		if (bpt->fmt == fmt && strcmp(bpt->fmtcopy, fmt) == 0)
+			return (bpt);
+
+	bpt = compileBridgePacketTemplate(fmt);
+	if (bpt == NULL)
+		return (NULL);
+
+	mos_mutex_lock(&bptLock);
+	if (bptCnt >= BPT_MAX) {
+		mos_mutex_unlock(&bptLock);
+		*tmp = 1;
+		return (bpt);
+	}
+	/* A duplicate from a racing thread is harmless: the first in the chain is always found */
+	bpt->next = bptHash[h];
+	mos_atomic_swap_ptr((void **)&bptHash[h], bpt);	/* publish after the template is complete */
+	bptCnt++;
+	mos_mutex_unlock(&bptLock);
+
+	return (bpt);
+}
+
+void
+PhidgetBridgeInit() {
+
+	mos_mutex_init(&bptLock);
+}
+
+void
+PhidgetBridgeFini() {
+	BridgePacketTemplate *bpt;
+	int i;
+
+	mos_mutex_lock(&bptLock);
+	for (i = 0; i < BPT_HASHSZ; i++) {
+		while ((bpt = bptHash[i]) != NULL) {
+			bptHash[i] = bpt->next;
+			freeBridgePacketTemplate(bpt);
+		}
+	}
+	bptCnt = 0;
+	mos_mutex_unlock(&bptLock);
+	mos_mutex_destroy(&bptLock);
+}
+
+/*
+ * Fills the entries of a new packet from the template.  The entry names reference the template's
+ * names unless copynames is set, which is required if the template does not outlive the packet.
+ */
+static PhidgetReturnCode
+fillBridgePacket(BridgePacket *bp, const BridgePacketTemplate *bpt, int copynames, va_list va) {
+	const BridgePacketSlot *slot;
+	BridgePacketEntry *bpe;
+	const char *cptr;
+	void *arrptr;
+	size_t sz;
+	int n;
+
+	/* the entry array must also have room for one more entry than the format describes */
+	if (bpt->slotcnt >= bp->entrylen)
+		return (EPHIDGET_2BIG);
+
+	for (slot = bpt->slot; bp->entrycnt < bpt->slotcnt; slot++) {
+		bpe = &bp->entry[bp->entrycnt];
+
+		n = slot->cnt;
+		if (n == BPT_ARGCNT)
+			n = va_arg(va, int);
+
+		bpe->type = slot->type;
+
+		switch (slot->type) {
+		case BPE_UI8:
+		case BPE_UI16:
+			bpe->bpe_ui64 = va_arg(va, int);
+			break;
+		case BPE_UI32:
+			bpe->bpe_ui64 = va_arg(va, uint32_t);
+			break;
+		case BPE_UI64:
+			bpe->bpe_ui64 = va_arg(va, uint64_t);
+			break;
+		case BPE_I16:
+		case BPE_I32:
+			bpe->bpe_i64 = va_arg(va, int);
+			break;
+		case BPE_I64:
+			bpe->bpe_i64 = va_arg(va, int64_t);
+			break;
+		case BPE_FLOAT:
+		case BPE_DBL:
+			bpe->bpe_dbl = va_arg(va, double);
+			break;
+		case BPE_STR:
+			cptr = va_arg(va, const char *);
+			if (strlen(cptr) > BPE_STR_LEN) {
+				bpe->type = BPE_NONE;
 				return (EPHIDGET_INVALIDARG);
 			}
-			allocArray(bp, n, BPE_DBLARRAY, bp->entrycnt);
-			arrptr = va_arg(va, double *);
-			if (n > 0)
-				memcpy(bp->entry[bp->entrycnt].bpe_dblarray, arrptr, sz);
+			bpe->bpe_ptr = mos_strdup(cptr, NULL);
 			break;
-		case 'J':
+		case BPE_PTR:
+			bpe->bpe_ptr = va_arg(va, void *);
+			break;
+		case BPE_JSON:
 			cptr = va_arg(va, const char *);
 			n = (int)strlen(cptr);
 			if (n == 0 || n > BPE_MAXARRAY_LEN) {
-				destroyBridgePacket(&bp);
+				bpe->type = BPE_NONE;
 				return (EPHIDGET_INVALIDARG);
 			}
-			bp->entry[bp->entrycnt].type = BPE_JSON;
-			bp->entry[bp->entrycnt].bpe_len = (uint16_t)(n + 1);
-			bp->entry[bp->entrycnt].bpe_ptr = (uint8_t *)mos_malloc(n + 1);
-			mos_strlcpy((char *)bp->entry[bp->entrycnt].bpe_ptr, cptr, n + 1);
+			bpe->bpe_len = (uint16_t)(n + 1);
+			bpe->bpe_ptr = (uint8_t *)mos_malloc(n + 1);
+			mos_strlcpy((char *)bpe->bpe_ptr, cptr, n + 1);
 			break;
 		default:
-			destroyBridgePacket(&bp);
-			return (EPHIDGET_INVALIDARG);
+			switch (slot->type) {
+			case BPE_UI8ARRAY:
+				sz = n;
+				break;
+			case BPE_I16ARRAY:
+			case BPE_UI16ARRAY:
+				sz = n * sizeof(uint16_t);
+				break;
+			case BPE_I32ARRAY:
+			case BPE_UI32ARRAY:
+				sz = n * sizeof(uint32_t);
+				break;
+			default:
+				sz = n * sizeof(uint64_t);
+				break;
+			}
+			if (n < 0 || sz > BPE_MAXARRAY_LEN) {
+				bpe->type = BPE_NONE;
+				return (EPHIDGET_INVALIDARG);
+			}
+			allocArray(bp, n, slot->type, bp->entrycnt);
+			arrptr = va_arg(va, void *);
+			if (n > 0)
+				memcpy(bpe->bpe_ptr, arrptr, sz);
+			break;
+		}
+
+		/* named last so a failed entry has no name to leak */
+		if (copynames) {
+			bpe->name = slot->name != NULL ? mos_strdup(slot->name, NULL) : NULL;
+			bpe->nameref = 0;
+		} else {
+			bpe->name = slot->name;
+			bpe->nameref = 1;
 		}
+		bp->entrycnt++;
 	}
 
-	destroyBridgePacket(&bp);
+	return (EPHIDGET_OK);
+}
+
+PhidgetReturnCode
+createBridgePacketv(BridgePacket **bridgePacket, bridgepacket_t pkt, uint16_t entrycnt, const char *fmt, va_list va) {
+	BridgePacketTemplate *bpt;
+	PhidgetReturnCode res;
+	BridgePacket *bp;
+	int tmp;
 
-	return (EPHIDGET_2BIG);
+	*bridgePacket = (BridgePacket *)NULL;
+
+	bpt = NULL;
+	if (fmt != NULL) {
+		bpt = getBridgePacketTemplate(fmt, &tmp);
+		if (bpt == NULL)
+			return (EPHIDGET_INVALIDARG);
+	}
+
+	// NOTE: add some extra entries - some device code adds to an existing BridgePacket
+	allocBridgePacket(&bp, entrycnt + 4);
+	bp->source = BPS_BRIDGE;
+	bp->vpkt = pkt;
+
+	if (bpt == NULL) {
+		*bridgePacket = bp;
+		return (EPHIDGET_OK);
+	}
+
+	res = fillBridgePacket(bp, bpt, tmp, va);
+	if (tmp)
+		freeBridgePacketTemplate(bpt);
+
+	if (res != EPHIDGET_OK) {
+		destroyBridgePacket(&bp);
+		return (res);
+	}
+
+	*bridgePacket = bp;
+	return (EPHIDGET_OK);
 }
 
 void
 freeBridgePacketEntry(BridgePacketEntry *bpe, int freename) {
 
 	if (freename && bpe->name) {
-		mos_free(bpe->name, MOSM_FSTR);
+		if (!bpe->nameref)
+			mos_free(bpe->name, MOSM_FSTR);
 		bpe->name = NULL;
+		bpe->nameref = 0;
 	}
 
 	switch (bpe->type) {
@@ -1502,6 +2241,49 @@ allowDataGram(BridgePacket *bp) {
 	return (bridgePacketSupportsDataGram(bp->vpkt));
 }
 
+/*
+ * Most events render to well under this: anything larger is rendered into a scratch buffer of the
+ * maximum payload size.
+ */
+#define NETEVENT_RENDERSZ	2048
+
+/*
+ * Renders a bridge packet event in the specified encoding, into a buffer that can be queued on any
+ * number of network connections that negotiated that encoding.
+ */
+PhidgetReturnCode
+renderNetEventBuffer(BridgePacket *bp, int bpenc, NetEventBuffer **eb) {
+	uint8_t buf[NETEVENT_RENDERSZ];
+	PhidgetReturnCode res;
+	uint8_t *rbuf;
+	uint32_t len;
+
+	rbuf = buf;
+	len = sizeof (buf);
+
+	for (;;) {
+		if (bpenc >= BPENC_BINARY)
+			res = renderBridgePacketBinary(bp, bpenc, rbuf, &len);
+		else
+			res = renderBridgePacketJSON(bp, (char *)rbuf, &len);
+
+		/* The render functions do not distinguish running out of space: retry once at full size */
+		if (res == EPHIDGET_OK || rbuf != buf)
+			break;
+
+		rbuf = mos_malloc(NR_MAXDATALEN);
+		len = NR_MAXDATALEN;
+	}
+
+	if (res == EPHIDGET_OK)
+		res = createNetEventBuffer(MSG_DEVICE, SMSG_DEVBRIDGEPKT, rbuf, len, allowDataGram(bp), eb);
+
+	if (rbuf != buf)
+		mos_free(rbuf, NR_MAXDATALEN);
+
+	return (res);
+}
+
 /*
  * Renders and sends a bridge packet to the specified network connection.
  */
@@ -1519,7 +2301,10 @@ networkSendBridgePacket(PhidgetChannelHandle channel, BridgePacket *bp, PhidgetN
 	NetConnWriteLock(nc);
 
 	len = nc->databufsz;
-	res = renderBridgePacketJSON(bp, nc->databuf, &len);
+	if (nc->bpenc >= BPENC_BINARY)
+		res = renderBridgePacketBinary(bp, nc->bpenc, (uint8_t *)nc->databuf, &len);
+	else
+		res = renderBridgePacketJSON(bp, nc->databuf, &len);
 	if (res != EPHIDGET_OK) {
 		NetConnWriteUnlock(nc);
 		return (res);
@@ -1748,6 +2533,17 @@ bridgeSendBPToChannelNC(PhidgetChannelHandle channel, PhidgetNetConnHandle nc, B
 	if (nc)
 		bridgePacketSetNetConn(bp, nc);
 
+	/* packets produced while handling device input carry the time that input was read */
+	if (bp->timestamp == 0 && channel->parent != NULL)
+		bp->timestamp = PhidgetDevice_getInputTime(channel->parent);
+
+	if (bp->vpkt == BP_STATECHANGE && channel->class == PHIDCHCLASS_DIGITALINPUT) {
+		if (!PhidgetDigitalInput_debounce(channel, bp)) {
+			destroyBridgePacket(&bp);
+			return (EPHIDGET_OK);
+		}
+	}
+
 	/* dispatcher is responsible for destroying the bridge packet */
 	return (dispatchChannelBridgePacket(channel, bp));
 }
@@ -58,6 +58,12 @@ int supportedBridgePacket(PhidgetChannelHandle, bridgepacket_t);
 #define BPE_MAXARRAY_LEN		8192	/* cannot be more the how many tokens we allow */
 #define BPE_STR_LEN				(JSON_STRING_MAX / 2)
 
+/* Bridge packet encodings, negotiated during the network handshake */
+#define BPENC_JSON				0
+#define BPENC_BINARY			1
+#define BPENC_BINARYTS			2	/* binary, with input timestamps */
+#define BPENC_MAX				BPENC_BINARYTS
+
 #define BPE_ISEVENT_FLAG		0x01
 #define BPE_ISFROMNET_FLAG		0x02
 #define BPE_ISREPLY_FLAG		0x04	/* Bridge Packet was read from the network */
@@ -143,6 +149,7 @@ typedef union _BridgePacketValue {
 typedef struct _BridgePacketEntry {
 	BridgePacketEntryType	type;
 	char					*name;
+	uint8_t					nameref;	/* name belongs to a bridge packet template: do not free */
 	uint16_t				cnt;	/* the number of types elements */
 	uint16_t				len;	/* ptr length (number of bytes allocated) */
 	BridgePacketValue		val;
@@ -173,6 +180,7 @@ typedef struct _BridgePacket {
 	uint64_t			phidid;		/* phidget id */
 	uint64_t			ocid;		/* open channel id */
 	int					chidx;		/* channel index */
+	uint64_t			timestamp;	/* host monotonic time (usec) the input was read, 0 if unknown */
 	uint16_t			entrycnt;
 	uint16_t			_refcnt;	/* should not be modified without the lock: flag private */
 	mos_tlock_t			*lock;
@@ -190,7 +198,12 @@ PhidgetReturnCode createBridgePacketv(BridgePacket **, bridgepacket_t, uint16_t,
 PhidgetReturnCode createBridgePacket(BridgePacket **, bridgepacket_t, uint16_t, const char *, ...) BP_PRINTF_LIKE(4, 5);
 PhidgetReturnCode renderBridgePacketJSON(BridgePacket *, char *, uint32_t *);
 PhidgetReturnCode parseBridgePacketJSON(void *tokens, BridgePacket **, const char *, uint32_t);
+PhidgetReturnCode renderBridgePacketBinary(BridgePacket *, int, uint8_t *, uint32_t *);
+PhidgetReturnCode parseBridgePacketBinary(BridgePacket **, const uint8_t *, uint32_t);
+PhidgetReturnCode parseBridgePacket(void *tokens, BridgePacket **, const void *, uint32_t);
 void freeBridgePacketEntry(BridgePacketEntry *, int);
+void PhidgetBridgeInit(void);
+void PhidgetBridgeFini(void);
 void destroyBridgePacket(BridgePacket **);
 void retainBridgePacket(BridgePacket *);
 
@@ -211,6 +224,7 @@ PhidgetReturnCode bridgeSendBPToChannelNC(PhidgetChannelHandle, PhidgetNetConnHa
 PhidgetReturnCode networkSendBridgePacket(PhidgetChannelHandle, BridgePacket *, PhidgetNetConnHandle);
 
 PhidgetReturnCode dispatchChannelBridgePacket(PhidgetChannelHandle, BridgePacket *);
+int bridgePacketCoalescable(PhidgetChannelHandle, BridgePacket *);
 
 int getBridgePacketArrayCnt(BridgePacket *bp, int off);
 int getBridgePacketArrayLen(BridgePacket *bp, int off);
@@ -225,5 +225,8 @@ bridgepacketinfo_t bridgepacketinfo[] = {
 	{ "BP_SETENABLEEXPECTEDPOSITION", 0}, /* 0xbd */
 	{ "BP_EXPECTEDVELOCITYCHANGE", 0}, /* 0xbe */
 	{ "BP_SETENABLEEXPECTEDVELOCITY", 0}, /* 0xbf */
+	{ "BP_SETDEBOUNCE", 0}, /* 0xc0 */
+	{ "BP_INPUTSNAPSHOT", 0}, /* 0xc1 */
+	{ "BP_SETINPUTSNAPSHOTENABLED", 0}, /* 0xc2 */
 	{ (void *)0, 0 }
 };
@@ -3,7 +3,7 @@
 
 /* Generated By SpecTools:BridgePacketsH */
 
-#define BRIDGEPACKET_COUNT 0xBF
+#define BRIDGEPACKET_COUNT 0xC2
 
 typedef enum bridgepackets {
 	BP_SETSTATUS = 0x0,
@@ -198,6 +198,9 @@ typedef enum bridgepackets {
 	BP_SETENABLEEXPECTEDPOSITION = 0xBD,
 	BP_EXPECTEDVELOCITYCHANGE = 0xBE,
 	BP_SETENABLEEXPECTEDVELOCITY = 0xBF,
+	BP_SETDEBOUNCE = 0xC0,
+	BP_INPUTSNAPSHOT = 0xC1,
+	BP_SETINPUTSNAPSHOTENABLED = 0xC2,
 } bridgepacket_t;
 
 typedef struct {
@@ -5,6 +5,296 @@
 #include "class/digitalinput.gen.h"
 #include "class/digitalinput.gen.c"
 
+/*
+ * Debounce filter
+ *
+ * State changes from the device are filtered on the thread that reads them, before they are dispatched,
+ * so both local handlers and network clients of this channel see the filtered stream.
+ *
+ * DEBOUNCE_MODE_TRAILING_EDGE: a new state is only reported once the input has held it for debounceTime.
+ *   Bounces shorter than that never reach the user, at the cost of debounceTime latency on every change.
+ *
+ * DEBOUNCE_MODE_LEADING_EDGE: a change is reported immediately if the input has been quiet for
+ *   debounceTime; further changes are held back until the input has been quiet for debounceTime again,
+ *   after which the final state is reported if it differs.
+ *
+ * Held back states are delivered by a timer thread, which is started the first time it is needed.
+ * A channel holds a reference while it is on the pending list.
+ */
+#define DEBOUNCE_IDLE_WAIT	(250 * MOS_MSEC)
+
+static mos_mutex_t debounceLock;
+static mos_cond_t debounceCond;
+static MTAILQ_HEAD(debounce_list, _PhidgetDigitalInput) debounceList;
+static int debounceThreadRun;
+
+static void
+debounceSchedule(PhidgetDigitalInputHandle ch, mostime_t deadline) {
+
+	ch->debounceDeadline = deadline;
+	if (ch->debouncePending)
+		return;
+
+	PhidgetRetain(ch);
+	ch->debouncePending = 1;
+	MTAILQ_INSERT_TAIL(&debounceList, ch, debounceLink);
+	mos_cond_broadcast(&debounceCond);
+}
+
+/*
+ * Returns PTRUE if the channel's reference was handed back and must be released once the lock is dropped.
+ */
+static int
+debounceCancel(PhidgetDigitalInputHandle ch) {
+
+	if (!ch->debouncePending)
+		return (PFALSE);
+
+	MTAILQ_REMOVE(&debounceList, ch, debounceLink);
+	ch->debouncePending = 0;
+	return (PTRUE);
+}
+
+static void
+debounceDeliver(PhidgetDigitalInputHandle ch, int state, mostime_t timestamp) {
+	BridgePacket *bp;
+
+	if (!ISATTACHED(ch))
+		return;
+
+	if (createBridgePacket(&bp, BP_STATECHANGE, 1, "%d", state) != EPHIDGET_OK)
+		return;
+
+	bp->timestamp = timestamp;
+	dispatchChannelBridgePacket((PhidgetChannelHandle)ch, bp);
+}
+
+static MOS_TASK_RESULT
+debounceTimerThread(void *arg) {
+	PhidgetDigitalInputHandle ch;
+	mostime_t now, wake;
+	mostime_t timestamp;
+	int deliver;
+	int state;
+
+	mos_task_setname("Phidget22 Debounce Timer Thread");
+	loginfo("Debounce timer thread started: 0x%08x", mos_self());
+
+	mos_mutex_lock(&debounceLock);
+	while (debounceThreadRun == 1) {
+		now = mos_gettime_usec();
+		wake = now + DEBOUNCE_IDLE_WAIT / 1000;
+
+		MTAILQ_FOREACH(ch, &debounceList, debounceLink) {
+			if (ch->debounceDeadline <= now)
+				break;
+			if (ch->debounceDeadline < wake)
+				wake = ch->debounceDeadline;
+		}
+
+		if (ch == NULL) {
+			mos_cond_timedwait(&debounceCond, &debounceLock, (wake - now) * 1000);
+			continue;
+		}
+
+		debounceCancel(ch);
+		deliver = ch->debounceRawState != ch->debounceState;
+		state = ch->debounceState = ch->debounceRawState;
+		timestamp = ch->debounceRawTime;
+		mos_mutex_unlock(&debounceLock);
+
+		if (deliver)
+			debounceDeliver(ch, state, timestamp);
+		PhidgetRelease(&ch);
+
+		mos_mutex_lock(&debounceLock);
+	}
+
+	debounceThreadRun = 0;
+	mos_cond_broadcast(&debounceCond);
+	mos_mutex_unlock(&debounceLock);
+
+	loginfo("Debounce timer thread exiting normally");
+	MOS_TASK_EXIT(EPHIDGET_OK);
+}
+
+/*
+ * Must be called with debounceLock held.
+ */
+static void
+debounceStartThread(void) {
+	mos_task_t task;
+
+	if (debounceThreadRun != 0)
+		return;
+
+	debounceThreadRun = 1;
+	if (mos_task_create(&task, debounceTimerThread, NULL) != 0) {
+		logerr("Failed to start debounce timer thread");
+		debounceThreadRun = 0;
+	}
+}
+
+/*
+ * Called from the read path for every state change on a digital input channel.
+ * Returns PTRUE if the packet should be dispatched; otherwise the caller destroys it.
+ */
+int
+PhidgetDigitalInput_debounce(PhidgetChannelHandle phid, BridgePacket *bp) {
+	PhidgetDigitalInputHandle ch;
+	mostime_t now, period;
+	int release;
+	int deliver;
+	int state;
+
+	ch = (PhidgetDigitalInputHandle)phid;
+
+	state = getBridgePacketInt32(bp, 0);
+	now = bp->timestamp != 0 ? (mostime_t)bp->timestamp : mos_gettime_usec();
+	period = (mostime_t)ch->debounceTime * 1000;
+	release = PFALSE;
+	deliver = PFALSE;
+
+	mos_mutex_lock(&debounceLock);
+
+	if (ch->debounceState == PUNK_BOOL || period == 0) {
+		release = debounceCancel(ch);
+		ch->debounceRawState = ch->debounceState = state;
+		ch->debounceRawTime = now;
+		ch->debounceQuietUntil = now + period;
+		deliver = PTRUE;
+		goto done;
+	}
+
+	if (state == ch->debounceRawState)
+		goto done;
+
+	ch->debounceRawState = state;
+	ch->debounceRawTime = now;
+
+	if (ch->debounceMode == DEBOUNCE_MODE_LEADING_EDGE) {
+		if (now >= ch->debounceQuietUntil && state != ch->debounceState) {
+			ch->debounceState = state;
+			release = debounceCancel(ch);
+			deliver = PTRUE;
+		} else if (state == ch->debounceState) {
+			release = debounceCancel(ch);
+		}
+		ch->debounceQuietUntil = now + period;
+		if (!deliver && state != ch->debounceState)
+			debounceSchedule(ch, ch->debounceQuietUntil);
+	} else {
+		if (state == ch->debounceState)
+			release = debounceCancel(ch);
+		else
+			debounceSchedule(ch, now + period);
+	}
+
+	if (ch->debouncePending)
+		debounceStartThread();
+
+done:
+	mos_mutex_unlock(&debounceLock);
+
+	if (release)
+		PhidgetRelease(&ch);
+
+	return (deliver);
+}
+
+/*
+ * Applies a new debounce configuration. A state being held back is rescheduled against the new time, or
+ * delivered straight away if debouncing has been turned off.
+ */
+static void
+debounceConfigure(PhidgetDigitalInputHandle ch, uint32_t debounceTime,
+  PhidgetDigitalInput_DebounceMode debounceMode) {
+	mostime_t timestamp;
+	int release;
+	int deliver;
+	int state;
+
+	release = PFALSE;
+	deliver = PFALSE;
+
+	mos_mutex_lock(&debounceLock);
+
+	ch->debounceTime = debounceTime;
+	ch->debounceMode = debounceMode;
+
+	if (ch->debouncePending) {
+		if (debounceTime == 0) {
+			release = debounceCancel(ch);
+			deliver = ch->debounceRawState != ch->debounceState;
+			ch->debounceState = ch->debounceRawState;
+		} else {
+			debounceSchedule(ch, ch->debounceRawTime + (mostime_t)debounceTime * 1000);
+		}
+	}
+	state = ch->debounceState;
+	timestamp = ch->debounceRawTime;
+
+	mos_mutex_unlock(&debounceLock);
+
+	if (deliver)
+		debounceDeliver(ch, state, timestamp);
+	if (release)
+		PhidgetRelease(&ch);
+}
+
+static void
+debounceReset(PhidgetDigitalInputHandle ch) {
+	int release;
+
+	mos_mutex_lock(&debounceLock);
+	release = debounceCancel(ch);
+	ch->debounceRawState = ch->debounceState = ch->state;
+	ch->debounceRawTime = mos_gettime_usec();
+	ch->debounceQuietUntil = 0;
+	mos_mutex_unlock(&debounceLock);
+
+	if (release)
+		PhidgetRelease(&ch);
+}
+
+int
+PhidgetDigitalInput_inputSnapshotEnabled(PhidgetChannelHandle phid) {
+
+	return (((PhidgetDigitalInputHandle)phid)->inputSnapshotEnabled == PTRUE);
+}
+
+void
+PhidgetDigitalInputInit(void) {
+
+	mos_mutex_init(&debounceLock);
+	mos_cond_init(&debounceCond);
+	MTAILQ_INIT(&debounceList);
+}
+
+void
+PhidgetDigitalInputFini(void) {
+	PhidgetDigitalInputHandle ch;
+
+	mos_mutex_lock(&debounceLock);
+	if (debounceThreadRun == 1) {
+		debounceThreadRun = 2;
+		mos_cond_broadcast(&debounceCond);
+		while (debounceThreadRun != 0)
+			mos_cond_wait(&debounceCond, &debounceLock);
+	}
+
+	while ((ch = MTAILQ_FIRST(&debounceList)) != NULL) {
+		debounceCancel(ch);
+		mos_mutex_unlock(&debounceLock);
+		PhidgetRelease(&ch);
+		mos_mutex_lock(&debounceLock);
+	}
+	mos_mutex_unlock(&debounceLock);
+
+	mos_mutex_destroy(&debounceLock);
+	mos_cond_destroy(&debounceCond);
+}
+
 static void
 PhidgetDigitalInput_errorHandler(PhidgetChannelHandle phid, Phidget_ErrorEventCode code) {
 	PhidgetDigitalInputHandle ch = (PhidgetDigitalInputHandle)phid;
@@ -19,7 +309,16 @@ PhidgetDigitalInput_free(PhidgetChannelHandle *ch) {
 
 API_PRETURN
 PhidgetDigitalInput_create(PhidgetDigitalInputHandle *phidp) {
-	return (_create(phidp));
+	PhidgetReturnCode res;
+
+	res = _create(phidp);
+	if (res != EPHIDGET_OK)
+		return (res);
+
+	(*phidp)->debounceMode = DEBOUNCE_MODE_TRAILING_EDGE;
+	(*phidp)->debounceRawState = PUNK_BOOL;
+	(*phidp)->debounceState = PUNK_BOOL;
+	return (EPHIDGET_OK);
 }
 
 static PhidgetReturnCode CCONV
@@ -34,7 +333,14 @@ PhidgetDigitalInput_getStatus(PhidgetChannelHandle phid, BridgePacket **bp) {
 
 static PhidgetReturnCode CCONV
 PhidgetDigitalInput_initAfterOpen(PhidgetChannelHandle phid) {
-	return (_initAfterOpen(phid));
+	PhidgetReturnCode res;
+
+	res = _initAfterOpen(phid);
+	if (res != EPHIDGET_OK)
+		return (res);
+
+	debounceReset((PhidgetDigitalInputHandle)phid);
+	return (EPHIDGET_OK);
 }
 
 static PhidgetReturnCode CCONV
@@ -44,13 +350,43 @@ PhidgetDigitalInput_setDefaults(PhidgetChannelHandle phid) {
 
 static PhidgetReturnCode
 PhidgetDigitalInput_bridgeInput(PhidgetChannelHandle phid, BridgePacket *bp) {
+	PhidgetDigitalInput_DebounceMode debounceMode;
 	PhidgetDigitalInputHandle ch;
+	uint32_t debounceTime;
 
 	TESTPTR(phid);
 	ch = (PhidgetDigitalInputHandle)phid;
 
 	switch (bp->vpkt) {
 
+	/* handled by the library: the device never sees it */
+	case BP_SETDEBOUNCE:
+		debounceTime = getBridgePacketUInt32(bp, 0);
+		debounceMode = (PhidgetDigitalInput_DebounceMode)getBridgePacketInt32(bp, 1);
+		if (debounceTime > MAX_DEBOUNCE_TIME)
+			return (MOS_ERROR(bp->iop, EPHIDGET_INVALIDARG, "Value must be in range: 0 - %u.",
+			  MAX_DEBOUNCE_TIME));
+		if (debounceMode != DEBOUNCE_MODE_TRAILING_EDGE && debounceMode != DEBOUNCE_MODE_LEADING_EDGE)
+			return (MOS_ERROR(bp->iop, EPHIDGET_INVALIDARG, "Specified DebounceMode is unsupported."));
+
+		if (debounceTime != ch->debounceTime || debounceMode != ch->debounceMode) {
+			debounceConfigure(ch, debounceTime, debounceMode);
+			if (bridgePacketIsFromNet(bp)) {
+				FIRE_PROPERTYCHANGE(ch, "DebounceTime");
+				FIRE_PROPERTYCHANGE(ch, "DebounceMode");
+			}
+		}
+		return (EPHIDGET_OK);
+
+	/* handled by the library: snapshots are assembled by the VINT device as its input is demuxed */
+	case BP_SETINPUTSNAPSHOTENABLED:
+		TESTBOOL_IOP(bp->iop, getBridgePacketInt32(bp, 0));
+		ch->inputSnapshotEnabled = getBridgePacketInt32(bp, 0);
+		if (bridgePacketIsFromNet(bp)) {
+			FIRE_PROPERTYCHANGE(ch, "InputSnapshotEnabled");
+		}
+		return (EPHIDGET_OK);
+
 	case BP_INPUTMODECHANGE:
 		ch->inputMode = getBridgePacketInt32(bp, 0);
 		FIRE_PROPERTYCHANGE(ch, "InputMode");
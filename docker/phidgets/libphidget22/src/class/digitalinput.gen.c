@@ -25,8 +25,22 @@ struct _PhidgetDigitalInput {
 	Phidget_InputMode inputMode;
 	Phidget_PowerSupply powerSupply;
 	int state;
+	uint32_t debounceTime;
+	PhidgetDigitalInput_DebounceMode debounceMode;
+	int inputSnapshotEnabled;
 	PhidgetDigitalInput_OnStateChangeCallback StateChange;
 	void *StateChangeCtx;
+	PhidgetDigitalInput_OnInputSnapshotCallback InputSnapshot;
+	void *InputSnapshotCtx;
+
+	/* Debounce filter state: protected by debounceLock in digitalinput.c */
+	int debounceRawState;			/* last state reported by the device */
+	int debounceState;				/* last state let through */
+	mostime_t debounceRawTime;		/* when the device reported debounceRawState */
+	mostime_t debounceQuietUntil;	/* leading edge: changes before this are held back */
+	mostime_t debounceDeadline;		/* when the held back state is due, if debouncePending */
+	int debouncePending;
+	MTAILQ_ENTRY(_PhidgetDigitalInput) debounceLink;
 };
 
 static PhidgetReturnCode CCONV
@@ -37,8 +51,8 @@ _setStatus(PhidgetChannelHandle phid, BridgePacket *bp) {
 	ch = (PhidgetDigitalInputHandle)phid;
 
 	version = getBridgePacketUInt32ByName(bp, "_class_version_");
-	if (version != 0) {
-		loginfo("%"PRIphid": server/client class version mismatch: %d != 0 - functionality may be limited.", phid, version);
+	if (version != 2) {
+		loginfo("%"PRIphid": server/client class version mismatch: %d != 2 - functionality may be limited.", phid, version);
 	}
 
 	if (version >= 0)
@@ -47,6 +61,12 @@ _setStatus(PhidgetChannelHandle phid, BridgePacket *bp) {
 		ch->powerSupply = getBridgePacketInt32ByName(bp, "powerSupply");
 	if (version >= 0)
 		ch->state = getBridgePacketInt32ByName(bp, "state");
+	if (version >= 1)
+		ch->debounceTime = getBridgePacketUInt32ByName(bp, "debounceTime");
+	if (version >= 1)
+		ch->debounceMode = getBridgePacketInt32ByName(bp, "debounceMode");
+	if (version >= 2)
+		ch->inputSnapshotEnabled = getBridgePacketInt32ByName(bp, "inputSnapshotEnabled");
 
 	return (EPHIDGET_OK);
 }
@@ -57,14 +77,20 @@ _getStatus(PhidgetChannelHandle phid, BridgePacket **bp) {
 
 	ch = (PhidgetDigitalInputHandle)phid;
 
-	return (createBridgePacket(bp, BP_SETSTATUS, 4, "_class_version_=%u"
+	return (createBridgePacket(bp, BP_SETSTATUS, 7, "_class_version_=%u"
 	  ",inputMode=%d"
 	  ",powerSupply=%d"
 	  ",state=%d"
-	  ,0 /* class version */
+	  ",debounceTime=%u"
+	  ",debounceMode=%d"
+	  ",inputSnapshotEnabled=%d"
+	  ,2 /* class version */
 	  ,ch->inputMode
 	  ,ch->powerSupply
 	  ,ch->state
+	  ,ch->debounceTime
+	  ,ch->debounceMode
+	  ,ch->inputSnapshotEnabled
 	));
 }
 
@@ -105,6 +131,9 @@ _bridgeInput(PhidgetChannelHandle phid, BridgePacket *bp) {
 		ch->state = getBridgePacketInt32(bp, 0);
 		FIRECH(ch, StateChange, ch->state);
 		break;
+	case BP_INPUTSNAPSHOT:
+		FIRECH(ch, InputSnapshot, getBridgePacketUInt32(bp, 0), getBridgePacketUInt32(bp, 1), bp->timestamp);
+		break;
 	default:
 		logerr("%"PRIphid": unsupported bridge packet:0x%x", phid, bp->vpkt);
 		res = EPHIDGET_UNSUPPORTED;
@@ -511,6 +540,78 @@ PhidgetDigitalInput_getState(PhidgetDigitalInputHandle ch, int *state) {
 	return (EPHIDGET_OK);
 }
 
+API_PRETURN
+PhidgetDigitalInput_setDebounceTime(PhidgetDigitalInputHandle ch, uint32_t debounceTime) {
+
+	TESTPTR_PR(ch);
+	TESTCHANNELCLASS_PR(ch, PHIDCHCLASS_DIGITALINPUT);
+	TESTATTACHED_PR(ch);
+	TESTRANGE_PR(debounceTime, "%u", 0, MAX_DEBOUNCE_TIME);
+
+	return (bridgeSendToDevice((PhidgetChannelHandle)ch, BP_SETDEBOUNCE, NULL, NULL, 2, "%u%d",
+	  debounceTime, ch->debounceMode));
+}
+
+API_PRETURN
+PhidgetDigitalInput_getDebounceTime(PhidgetDigitalInputHandle ch, uint32_t *debounceTime) {
+
+	TESTPTR_PR(ch);
+	TESTPTR_PR(debounceTime);
+	TESTCHANNELCLASS_PR(ch, PHIDCHCLASS_DIGITALINPUT);
+	TESTATTACHED_PR(ch);
+
+	*debounceTime = ch->debounceTime;
+	return (EPHIDGET_OK);
+}
+
+API_PRETURN
+PhidgetDigitalInput_setDebounceMode(PhidgetDigitalInputHandle ch,
+  PhidgetDigitalInput_DebounceMode debounceMode) {
+
+	TESTPTR_PR(ch);
+	TESTCHANNELCLASS_PR(ch, PHIDCHCLASS_DIGITALINPUT);
+	TESTATTACHED_PR(ch);
+
+	return (bridgeSendToDevice((PhidgetChannelHandle)ch, BP_SETDEBOUNCE, NULL, NULL, 2, "%u%d",
+	  ch->debounceTime, debounceMode));
+}
+
+API_PRETURN
+PhidgetDigitalInput_getDebounceMode(PhidgetDigitalInputHandle ch,
+  PhidgetDigitalInput_DebounceMode *debounceMode) {
+
+	TESTPTR_PR(ch);
+	TESTPTR_PR(debounceMode);
+	TESTCHANNELCLASS_PR(ch, PHIDCHCLASS_DIGITALINPUT);
+	TESTATTACHED_PR(ch);
+
+	*debounceMode = ch->debounceMode;
+	return (EPHIDGET_OK);
+}
+
+API_PRETURN
+PhidgetDigitalInput_setInputSnapshotEnabled(PhidgetDigitalInputHandle ch, int inputSnapshotEnabled) {
+
+	TESTPTR_PR(ch);
+	TESTCHANNELCLASS_PR(ch, PHIDCHCLASS_DIGITALINPUT);
+	TESTATTACHED_PR(ch);
+
+	return (bridgeSendToDevice((PhidgetChannelHandle)ch, BP_SETINPUTSNAPSHOTENABLED, NULL, NULL, 1, "%d",
+	  inputSnapshotEnabled));
+}
+
+API_PRETURN
+PhidgetDigitalInput_getInputSnapshotEnabled(PhidgetDigitalInputHandle ch, int *inputSnapshotEnabled) {
+
+	TESTPTR_PR(ch);
+	TESTPTR_PR(inputSnapshotEnabled);
+	TESTCHANNELCLASS_PR(ch, PHIDCHCLASS_DIGITALINPUT);
+	TESTATTACHED_PR(ch);
+
+	*inputSnapshotEnabled = ch->inputSnapshotEnabled;
+	return (EPHIDGET_OK);
+}
+
 API_PRETURN
 PhidgetDigitalInput_setOnStateChangeHandler(PhidgetDigitalInputHandle ch,
   PhidgetDigitalInput_OnStateChangeCallback fptr, void *ctx) {
@@ -523,3 +624,16 @@ PhidgetDigitalInput_setOnStateChangeHandler(PhidgetDigitalInputHandle ch,
 
 	return (EPHIDGET_OK);
 }
+
+API_PRETURN
+PhidgetDigitalInput_setOnInputSnapshotHandler(PhidgetDigitalInputHandle ch,
+  PhidgetDigitalInput_OnInputSnapshotCallback fptr, void *ctx) {
+
+	TESTPTR_PR(ch);
+	TESTCHANNELCLASS_PR(ch, PHIDCHCLASS_DIGITALINPUT);
+
+	ch->InputSnapshot = fptr;
+	ch->InputSnapshotCtx = ctx;
+
+	return (EPHIDGET_OK);
+}
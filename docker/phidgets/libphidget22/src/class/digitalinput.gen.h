@@ -19,6 +19,16 @@ API_PRETURN_HDR PhidgetDigitalInput_setPowerSupply(PhidgetDigitalInputHandle ch,
 API_PRETURN_HDR PhidgetDigitalInput_getPowerSupply(PhidgetDigitalInputHandle ch,
   Phidget_PowerSupply *powerSupply);
 API_PRETURN_HDR PhidgetDigitalInput_getState(PhidgetDigitalInputHandle ch, int *state);
+API_PRETURN_HDR PhidgetDigitalInput_setDebounceTime(PhidgetDigitalInputHandle ch, uint32_t debounceTime);
+API_PRETURN_HDR PhidgetDigitalInput_getDebounceTime(PhidgetDigitalInputHandle ch, uint32_t *debounceTime);
+API_PRETURN_HDR PhidgetDigitalInput_setDebounceMode(PhidgetDigitalInputHandle ch,
+  PhidgetDigitalInput_DebounceMode debounceMode);
+API_PRETURN_HDR PhidgetDigitalInput_getDebounceMode(PhidgetDigitalInputHandle ch,
+  PhidgetDigitalInput_DebounceMode *debounceMode);
+API_PRETURN_HDR PhidgetDigitalInput_setInputSnapshotEnabled(PhidgetDigitalInputHandle ch,
+  int inputSnapshotEnabled);
+API_PRETURN_HDR PhidgetDigitalInput_getInputSnapshotEnabled(PhidgetDigitalInputHandle ch,
+  int *inputSnapshotEnabled);
 
 /* Events */
 typedef void (CCONV *PhidgetDigitalInput_OnStateChangeCallback)(PhidgetDigitalInputHandle ch, void *ctx,
@@ -26,5 +36,10 @@ typedef void (CCONV *PhidgetDigitalInput_OnStateChangeCallback)(PhidgetDigitalIn
 
 API_PRETURN_HDR PhidgetDigitalInput_setOnStateChangeHandler(PhidgetDigitalInputHandle ch,
   PhidgetDigitalInput_OnStateChangeCallback fptr, void *ctx);
+typedef void (CCONV *PhidgetDigitalInput_OnInputSnapshotCallback)(PhidgetDigitalInputHandle ch, void *ctx,
+  uint32_t state, uint32_t changed, uint64_t timestamp);
+
+API_PRETURN_HDR PhidgetDigitalInput_setOnInputSnapshotHandler(PhidgetDigitalInputHandle ch,
+  PhidgetDigitalInput_OnInputSnapshotCallback fptr, void *ctx);
 
 #endif /* _DIGITALINPUT_H_ */
@@ -46,6 +46,7 @@
 #define PHIDGET_CLOSING_FLAG			0x00001000	/* Phidget device is closing */
 #define PHIDGET_HASINITIALSTATE_FLAG	0x00002000	/* Phidget channel initial state is available */
 #define PHIDGET_INITIALIZED_FLAG		0x00004000	/* Channel has been reset and defaults set */
+#define PHIDGET_COALESCE_FLAG			0x00008000	/* Channel value events are coalesced to the latest value */
 #define PHIDGET_OBJFLAG_MASK			0xFF000000	/* Flags reserved for other objects */
 
 #define BP_FLAG_NOFORWARD				0x01000000	/* Do not forward to network connections */
@@ -74,6 +75,9 @@ typedef enum {
 
 #define DEFAULT_TRANSFER_TIMEOUT		1000
 
+/* Longest stable time the DigitalInput debounce filter accepts (ms) */
+#define MAX_DEBOUNCE_TIME				10000
+
 /*
  * Open flags
  */
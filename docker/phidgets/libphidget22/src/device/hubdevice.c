@@ -36,11 +36,14 @@
 
 #include "device/vintdevice.h"
 #include "mos/mos_time.h"
+#include "stats.h"
 
 static PhidgetReturnCode _setADCCalibrationValues(mosiop_t iop, PhidgetHubDeviceHandle phid,
   const double voltageInputGain[6], const double voltageRatioGain[6]);
 static PhidgetReturnCode _setADCCalibrationValuesGainOffset(mosiop_t iop, PhidgetHubDeviceHandle phid, int portCount,
 	const double *voltageInputOffset, const double *voltageInputGain, const double *voltageRatioOffset, const double *voltageRatioGain);
+static void releasePacketSpace(PhidgetHubDeviceHandle phid, int hubPort, size_t packetSize);
+static void grantPacketSpace(PhidgetHubDeviceHandle phid, int hubPort);
 static void logTXBufferStatus(const char *file, int line, const char *func, Phidget_LogLevel level,
 	const char *message, PhidgetHubDeviceHandle hub, uint8_t *buf);
 
@@ -347,6 +350,41 @@ logTXBufferStatus(const char *file, int line, const char *func, Phidget_LogLevel
 	PhidgetLog_loge(file, line, func, "phidget22vint", level, "%s%s", message, str);
 }
 
+/*
+ * Digital input changes are collected per VINT device while a hub transfer is demuxed, and flushed as one
+ * snapshot per device once the whole transfer has been processed.
+ */
+static void
+queueInputSnapshot(PhidgetHubDeviceHandle phid, PhidgetDeviceHandle vintDevice) {
+	PhidgetVINTDeviceHandle vint;
+
+	vint = (PhidgetVINTDeviceHandle)vintDevice;
+	if (vint->inputSnapshotChanged == 0 || vint->inputSnapshotQueued)
+		return;
+
+	if (phid->inputSnapshotDeviceCnt == VINTHUB_MAXPORTS) {
+		PhidgetVINTDevice_flushInputSnapshot(vint);
+		return;
+	}
+
+	PhidgetRetain(vintDevice);
+	vint->inputSnapshotQueued = 1;
+	phid->inputSnapshotDevice[phid->inputSnapshotDeviceCnt++] = vintDevice;
+}
+
+static void
+flushInputSnapshots(PhidgetHubDeviceHandle phid) {
+	PhidgetDeviceHandle vintDevice;
+	int i;
+
+	for (i = 0; i < phid->inputSnapshotDeviceCnt; i++) {
+		vintDevice = phid->inputSnapshotDevice[i];
+		PhidgetVINTDevice_flushInputSnapshot((PhidgetVINTDeviceHandle)vintDevice);
+		PhidgetRelease(&vintDevice);
+	}
+	phid->inputSnapshotDeviceCnt = 0;
+}
+
 static PhidgetReturnCode
 processVintPacket(PhidgetHubDeviceHandle phid, uint8_t *buffer) {
 	PhidgetDeviceHandle vintDevice;
@@ -393,36 +431,56 @@ processVintPacket(PhidgetHubDeviceHandle phid, uint8_t *buffer) {
 	// Sending the data count portion, so the packet length is +1
 	// NOTE: We ignore the return value on purpose
 	vintDevice->dataInput(vintDevice, buffer + 2, dataCount + 1);
+	queueInputSnapshot(phid, vintDevice);
 	PhidgetRelease(&vintDevice);
 
 	return (EPHIDGET_OK);
 }
 
+/*
+ * Marks the ports in portMask as having an unknown TX buffer count and asks the hub for new
+ * counts.  The hub answers for every port at once, so one request covers all of them.
+ */
 static void
-readInTXBufferCounts(PhidgetHubDeviceHandle phid, int port) {
+readInTXBufferCounts(PhidgetHubDeviceHandle phid, uint32_t portMask) {
 	PhidgetReturnCode ret;
+	int port;
 
-	PhidgetLock(phid);
-	vintlogdebug("outstandingPacketCnt changed from %d|%d (used|free) to UNK, Port %d", TXBUF_USED(phid, port), TXBUF_FREE(phid, port), port);
-	phid->outstandingPacketCnt[port] = PUNK_SIZE;
-	PhidgetUnlock(phid);
+	for (port = 0; port < VINTHUB_MAXPORTS; port++) {
+		if (!(portMask & (1U << port)))
+			continue;
+		mos_mutex_lock(&phid->outstandingPacketCntLock[port]);
+		vintlogdebug("outstandingPacketCnt changed from %d|%d (used|free) to UNK, Port %d", TXBUF_USED(phid, port), TXBUF_FREE(phid, port), port);
+		phid->outstandingPacketCnt[port] = PUNK_SIZE;
+		mos_mutex_unlock(&phid->outstandingPacketCntLock[port]);
+	}
 
 	// Request a new count
-	vintlogdebug("VINTHUB_HUBINPACKET_TXBUFFERSTATUS request, Port %d", port);
+	vintlogdebug("VINTHUB_HUBINPACKET_TXBUFFERSTATUS request, Ports 0x%02x", portMask);
 	if ((ret = sendHubPacket(NULL, phid, VINTHUB_HUBPACKET_GETTXBUFFERSTATUS, NULL, 0)) != EPHIDGET_OK)
 		vintlogerr("Error sending VINTHUB_HUBPACKET_GETTXBUFFERSTATUS msg to Hub.");
 }
 
 static PhidgetReturnCode
 processPacketReturnCodes(PhidgetHubDeviceHandle phid, uint8_t *buffer, size_t length) {
+	size_t released[VINTHUB_MAXPORTS];
 	PhidgetPacketTrackerHandle packetTracker;
 	VINTPacketStatusCode response;
 	PhidgetReturnCode res;
 	size_t packetSpace;
+	uint32_t resync;
 	int packetID;
 	int readPtr;
 	int port;
 
+	/*
+	 * One IN packet can return codes for many OUT packets across the ports.  The space they
+	 * free is added up per port and released once, and ports whose count needs to be read
+	 * from the hub again share a single GETTXBUFFERSTATUS request.
+	 */
+	memset(released, 0, sizeof(released));
+	resync = 0;
+
 	readPtr = 0;
 	while (readPtr < (int)length) {
 		packetID = buffer[readPtr] & 0x7F;
@@ -450,11 +508,13 @@ processPacketReturnCodes(PhidgetHubDeviceHandle phid, uint8_t *buffer, size_t le
 				  "Probably this packet is from a previous session or detached device.",
 				  packetID, response, Phidget_strVINTPacketStatusCode(response));
 			//Request a new count because our count will now be out
-			readInTXBufferCounts(phid, port);
+			if (port < VINTHUB_MAXPORTS)
+				resync |= (1U << port);
 			continue;
 		}
 
-		PhidgetHubDevice_releasePacketSpace(phid, port, packetSpace);
+		if (port < VINTHUB_MAXPORTS)
+			released[port] += packetSpace;
 
 		switch (res) {
 
@@ -475,7 +535,8 @@ processPacketReturnCodes(PhidgetHubDeviceHandle phid, uint8_t *buffer, size_t le
 			vintlogerr("Got a NOSPACE response from a VINT device, Port %d. "
 			  "This usually indicates firmware problems.", port);
 			//Request a new count because our count will now be out
-			readInTXBufferCounts(phid, port);
+			if (port < VINTHUB_MAXPORTS)
+				resync |= (1U << port);
 			break;
 		case EPHIDGET_NOTATTACHED:
 			vintloginfo("Got a NOTATTACHED response from a VINT device, Port %d", port);
@@ -500,12 +561,28 @@ processPacketReturnCodes(PhidgetHubDeviceHandle phid, uint8_t *buffer, size_t le
 			break;
 		}
 	}
+
+	/*
+	 * A port being read in again has its count replaced by the hub's, so anything released
+	 * on it here no longer matters.
+	 */
+	for (port = 0; port < VINTHUB_MAXPORTS; port++) {
+		if (released[port] != 0 && !(resync & (1U << port))) {
+			mos_mutex_lock(&phid->outstandingPacketCntLock[port]);
+			releasePacketSpace(phid, port, released[port]);
+			mos_mutex_unlock(&phid->outstandingPacketCntLock[port]);
+		}
+	}
+
+	if (resync != 0)
+		readInTXBufferCounts(phid, resync);
+
 	return (EPHIDGET_OK);
 }
 
-//dataInput - parses device packets
-static PhidgetReturnCode CCONV
-PhidgetHubDevice_dataInput(PhidgetDeviceHandle device, uint8_t *buffer, size_t length) {
+//processHubInput - parses device packets
+static PhidgetReturnCode
+processHubInput(PhidgetDeviceHandle device, uint8_t *buffer, size_t length) {
 	PhidgetChannelHandle channel;
 	PhidgetDeviceHandle childdev;
 	PhidgetHubDeviceHandle hub;
@@ -568,11 +645,12 @@ PhidgetHubDevice_dataInput(PhidgetDeviceHandle device, uint8_t *buffer, size_t l
 			switch (buffer[readPtr]) {
 			case VINTHUB_HUBINPACKET_TXBUFFERSTATUS:
 				readPtr++;
-				PhidgetLock(hub);
 				vintlogdebug("VINTHUB_HUBINPACKET_TXBUFFERSTATUS packet filling outstandingPacketCnt");
 				for (i = 0; i < hub->devChannelCnts.numVintPorts; i++) {
+					mos_mutex_lock(&hub->outstandingPacketCntLock[i]);
 					// Only fill in the buffer status for ports that we have requested this for
 					if (hub->outstandingPacketCnt[i] != PUNK_SIZE) {
+						mos_mutex_unlock(&hub->outstandingPacketCntLock[i]);
 						readPtr++;
 						continue;
 					}
@@ -583,10 +661,10 @@ PhidgetHubDevice_dataInput(PhidgetDeviceHandle device, uint8_t *buffer, size_t l
 					hub->outstandingPacketCnt[i] = hub->internalPacketInBufferLen - 1 - buffer[readPtr++];
 
 					vintlogverbose("outstandingPacketCnt updated from firmware: %d|%d (used|free), Port %d", TXBUF_USED(hub, i), TXBUF_FREE(hub, i), i);
+					grantPacketSpace(hub, i);
+					mos_mutex_unlock(&hub->outstandingPacketCntLock[i]);
 				}
 				logtxbufferstatus(PHIDGET_LOG_VERBOSE, "TXBUFFERSTATUS: ", hub, buffer + 3);
-				PhidgetBroadcast(hub);
-				PhidgetUnlock(hub);
 				hub->outstandingPacketCntValid = 1;
 				break;
 			case VINTHUB_HUBINPACKET_OVERCURRENT:
@@ -795,10 +873,12 @@ PhidgetHubDevice_dataInput(PhidgetDeviceHandle device, uint8_t *buffer, size_t l
 			 */
 			PhidgetLock(hub);
 			for (i = 0; i < hub->devChannelCnts.numVintPorts; i++) {
+				mos_mutex_lock(&hub->outstandingPacketCntLock[i]);
 				if (hub->outstandingPacketCnt[i]) {
 					hub->outstandingPacketCnt[i] = PUNK_SIZE;
 					vintlogdebug("outstandingPacketCnt changed from %d|%d (used|free) to UNK, Port %d", TXBUF_USED(hub, i), TXBUF_FREE(hub, i), i);
 				}
+				mos_mutex_unlock(&hub->outstandingPacketCntLock[i]);
 				_setPacketsReturnCode((PhidgetDeviceHandle)hub, i, EPHIDGET_INTERRUPTED);
 			}
 			PhidgetUnlock(hub);
@@ -812,6 +892,17 @@ PhidgetHubDevice_dataInput(PhidgetDeviceHandle device, uint8_t *buffer, size_t l
 	return (EPHIDGET_OK);
 }
 
+//dataInput - parses device packets, then delivers any input snapshots they produced
+static PhidgetReturnCode CCONV
+PhidgetHubDevice_dataInput(PhidgetDeviceHandle device, uint8_t *buffer, size_t length) {
+	PhidgetReturnCode res;
+
+	res = processHubInput(device, buffer, length);
+	flushInputSnapshots((PhidgetHubDeviceHandle)device);
+
+	return (res);
+}
+
 static PhidgetReturnCode CCONV
 PhidgetHubDevice_bridgeInput(PhidgetChannelHandle ch, BridgePacket *bp) {
 	PhidgetHubDeviceHandle phid = (PhidgetHubDeviceHandle)ch->parent;
@@ -867,10 +958,44 @@ PhidgetHubDevice_bridgeInput(PhidgetChannelHandle ch, BridgePacket *bp) {
 	}
 }
 
-void
-PhidgetHubDevice_releasePacketSpace(PhidgetHubDeviceHandle phid, int hubPort, size_t packetSize) {
+/*
+ * Hands the space free on a port to the claimers queued for it, oldest first.  A claimer that
+ * does not fit stops the queue so later, smaller packets cannot overtake it.
+ *
+ * Called with the port locked.
+ */
+static void
+grantPacketSpace(PhidgetHubDeviceHandle phid, int hubPort) {
+	PhidgetHubCreditWaiter *waiter;
+	int granted;
+
+	granted = 0;
+	while ((waiter = MTAILQ_FIRST(&phid->creditWaiters[hubPort])) != NULL) {
+		// < because our limit is internalPacketInBufferLen - 1
+		if (phid->outstandingPacketCnt[hubPort] == PUNK_SIZE ||
+		  phid->outstandingPacketCnt[hubPort] + waiter->len >= phid->internalPacketInBufferLen)
+			break;
+
+		phid->outstandingPacketCnt[hubPort] += waiter->len;
+		MTAILQ_REMOVE(&phid->creditWaiters[hubPort], waiter, link);
+		phid->creditQueueDepth[hubPort]--;
+		waiter->granted = 1;
+		granted = 1;
+
+		vintlogverbose("Granting %d bytes to a queued claim, %d|%d used|free, Port %d", (int)waiter->len,
+			TXBUF_USED(phid, hubPort), TXBUF_FREE(phid, hubPort), hubPort);
+	}
+
+	if (granted)
+		mos_cond_broadcast(&phid->outstandingPacketCntCond[hubPort]);
+}
+
+/*
+ * Called with the port locked.
+ */
+static void
+releasePacketSpace(PhidgetHubDeviceHandle phid, int hubPort, size_t packetSize) {
 
-	PhidgetLock(phid);
 	if (phid->outstandingPacketCnt[hubPort] != PUNK_SIZE) {
 		// When a packet is lost, things can get out of sync. Make sure we don't go below 0!
 		if (phid->outstandingPacketCnt[hubPort] < packetSize)
@@ -881,52 +1006,85 @@ PhidgetHubDevice_releasePacketSpace(PhidgetHubDeviceHandle phid, int hubPort, si
 		MOS_ASSERT(phid->outstandingPacketCnt[hubPort] <= phid->internalPacketInBufferLen);
 		vintlogverbose("Releasing %d bytes, %d|%d used|free, Port %d", (int)packetSize,
 			TXBUF_USED(phid, hubPort), TXBUF_FREE(phid, hubPort), hubPort);
-		PhidgetBroadcast(phid);
+		grantPacketSpace(phid, hubPort);
 	} else {
 		vintlogverbose("Trying to release %d bytes while outstandingPacketCnt is UNK, Port %d", (int)packetSize,
 			TXBUF_USED(phid, hubPort), TXBUF_FREE(phid, hubPort), hubPort);
 	}
-	PhidgetUnlock(phid);
 }
 
+void
+PhidgetHubDevice_releasePacketSpace(PhidgetHubDeviceHandle phid, int hubPort, size_t packetSize) {
+
+	mos_mutex_lock(&phid->outstandingPacketCntLock[hubPort]);
+	releasePacketSpace(phid, hubPort, packetSize);
+	mos_mutex_unlock(&phid->outstandingPacketCntLock[hubPort]);
+}
+
+/*
+ * Claims TX buffer space on a hub port for a packet.  Each port has its own lock, so a port that
+ * is out of space does not hold up the others.  If the space is not free, or other claims are
+ * already queued on the port, the claim queues behind them and waits up to 2 seconds to be
+ * granted space by PhidgetHubDevice_releasePacketSpace() or a TX buffer status update.
+ */
 PhidgetReturnCode
 PhidgetHubDevice_claimPacketSpace(PhidgetHubDeviceHandle phid, int hubPort, size_t packetSize) {
+	PhidgetHubCreditWaiter waiter;
 	size_t pktCnt;
 	mostime_t now;
 	mostime_t tm;
 
-	PhidgetLock(phid);
-
-	if (!_ISATTACHED((&phid->phid))) {
-		PhidgetUnlock(phid);
+	if (!ISATTACHED(phid))
 		return (EPHIDGET_NOTATTACHED);
+
+	mos_mutex_lock(&phid->outstandingPacketCntLock[hubPort]);
+
+	pktCnt = phid->outstandingPacketCnt[hubPort];
+
+	// < because our limit is internalPacketInBufferLen - 1
+	if (MTAILQ_EMPTY(&phid->creditWaiters[hubPort]) && pktCnt != PUNK_SIZE &&
+	  (pktCnt + packetSize < phid->internalPacketInBufferLen)) {
+		phid->outstandingPacketCnt[hubPort] += packetSize;
+		vintlogverbose("Claiming %d bytes, %d|%d used|free, Port %d", (int)packetSize,
+			TXBUF_USED(phid, hubPort), TXBUF_FREE(phid, hubPort), hubPort);
+		mos_mutex_unlock(&phid->outstandingPacketCntLock[hubPort]);
+		return (EPHIDGET_OK);
 	}
 
-	tm = mos_gettime_usec() + (2 * 1000000);
+	waiter.len = packetSize;
+	waiter.granted = 0;
+	MTAILQ_INSERT_TAIL(&phid->creditWaiters[hubPort], &waiter, link);
+	phid->creditStarvedCnt[hubPort]++;
+	if (++phid->creditQueueDepth[hubPort] > phid->creditQueueMaxDepth[hubPort])
+		phid->creditQueueMaxDepth[hubPort] = phid->creditQueueDepth[hubPort];
 
-	for (;;) {
-		pktCnt = phid->outstandingPacketCnt[hubPort];
+	vintlogverbose("Queueing claim for %d bytes behind %d others, %d|%d used|free, Port %d", (int)packetSize,
+		phid->creditQueueDepth[hubPort] - 1, TXBUF_USED(phid, hubPort), TXBUF_FREE(phid, hubPort), hubPort);
 
-		// < because our limit is internalPacketInBufferLen - 1
-		if (pktCnt != PUNK_SIZE && (pktCnt + packetSize < phid->internalPacketInBufferLen))
-			break;
+	tm = mos_gettime_usec() + (2 * 1000000);
 
+	while (!waiter.granted) {
 		now = mos_gettime_usec();
-		if (now < tm) {
-			PhidgetTimedWait(phid, (uint32_t)(tm - now) / 1000);
-		} else {
-			PhidgetUnlock(phid);
+		if (now >= tm) {
+			MTAILQ_REMOVE(&phid->creditWaiters[hubPort], &waiter, link);
+			phid->creditQueueDepth[hubPort]--;
+			phid->creditTimeoutCnt[hubPort]++;
+
+			// The claims queued behind this one may fit now
+			grantPacketSpace(phid, hubPort);
+			mos_mutex_unlock(&phid->outstandingPacketCntLock[hubPort]);
+
+			incPhidgetStat("hub.credit_timeouts");
 			vintlogverbose("Timed out claiming packet space, Port %d", hubPort);
 			return (EPHIDGET_TIMEOUT);
 		}
+		mos_cond_timedwait(&phid->outstandingPacketCntCond[hubPort], &phid->outstandingPacketCntLock[hubPort],
+		  (tm - now) * 1000);
 	}
 
-	phid->outstandingPacketCnt[hubPort] += packetSize;
-	vintlogverbose("Claiming %d bytes, %d|%d used|free, Port %d", (int)packetSize,
-		TXBUF_USED(phid, hubPort), TXBUF_FREE(phid, hubPort), hubPort);
-
-	PhidgetUnlock(phid);
+	mos_mutex_unlock(&phid->outstandingPacketCntLock[hubPort]);
 
+	incPhidgetStat("hub.credit_waits");
 	return (EPHIDGET_OK);
 }
 
@@ -942,6 +1100,9 @@ PhidgetHubDevice_claimPacketSpace(PhidgetHubDeviceHandle phid, int hubPort, size
  *         010: Device packet - data/commands passed on to VINT devices or configure hub ports
  *  bit 3-0: Device packet: Destination hub port.
  *           Hub packet: hub packet type (PhidgetHubDevice_HubPacketType)
+ *
+ * The packet has no length field: the hub takes the length from the transfer, so each OUT
+ * transfer carries exactly one device packet and packets for different ports cannot share one.
  */
 PhidgetReturnCode
 PhidgetHubDevice_makePacket(PhidgetHubDeviceHandle phid, PhidgetDeviceHandle vintDevice, int packetID,
@@ -1121,17 +1282,35 @@ sendHubPortPacket(mosiop_t iop, PhidgetHubDeviceHandle hub, int hubPort, Phidget
 static void CCONV
 PhidgetHubDevice_free(PhidgetDeviceHandle *phidG) {
 	PhidgetHubDeviceHandle phid;
+	int i;
 
 	phid = (PhidgetHubDeviceHandle)*phidG;
 
+	for (i = 0; i < VINTHUB_MAXPORTS; i++) {
+		mos_cond_destroy(&phid->outstandingPacketCntCond[i]);
+		mos_mutex_destroy(&phid->outstandingPacketCntLock[i]);
+	}
+
 	mos_free(phid, sizeof(*phid));
 	*phidG = NULL;
 }
 
 static PhidgetReturnCode CCONV
 PhidgetHubDevice_close(PhidgetDeviceHandle phidG) {
+	PhidgetHubDeviceHandle phid;
+	int i;
+
+	phid = (PhidgetHubDeviceHandle)phidG;
 
 	waitForAllPendingPackets(phidG);
+
+	for (i = 0; i < VINTHUB_MAXPORTS; i++) {
+		if (phid->creditStarvedCnt[i] == 0)
+			continue;
+		vintlogdebug("Port %d credit queue: %u claims queued, max depth %u, %u timed out", i,
+			phid->creditStarvedCnt[i], phid->creditQueueMaxDepth[i], phid->creditTimeoutCnt[i]);
+	}
+
 	return (EPHIDGET_OK);
 }
 
@@ -1145,6 +1324,9 @@ PhidgetHubDevice_create(PhidgetHubDeviceHandle *phidp) {
 	phid->phid.initAfterCreate = PhidgetHubDevice_initAfterCreate;
 
 	for (i = 0; i < VINTHUB_MAXPORTS; i++) {
+		mos_mutex_init(&phid->outstandingPacketCntLock[i]);
+		mos_cond_init(&phid->outstandingPacketCntCond[i]);
+		MTAILQ_INIT(&phid->creditWaiters[i]);
 		phid->portProtocolVersion[i] = PUNK_UINT8;
 		phid->portSupportsSetSpeed[i] = PUNK_BOOL;
 		phid->portSupportsAutoSetSpeed[i] = PUNK_BOOL;
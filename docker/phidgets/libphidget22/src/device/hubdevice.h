@@ -115,14 +115,42 @@ typedef enum {
 #define VINTHUB_ADCCalibTable_ID 		1004
 #define VINTHUB_ADCCalibTable_LENGTH 	28
 
+/*
+ * A claimer waiting for TX buffer space on a hub port.  Lives on the claimer's stack while it is
+ * queued.
+ */
+typedef struct _PhidgetHubCreditWaiter {
+	size_t len;
+	int granted;
+	MTAILQ_ENTRY(_PhidgetHubCreditWaiter) link;
+} PhidgetHubCreditWaiter;
+
+typedef MTAILQ_HEAD(hubcreditwaiters, _PhidgetHubCreditWaiter) hubcreditwaiters_t;
+
 struct _PhidgetHubDevice {
 #undef devChannelCnts
 #define devChannelCnts	phid.deviceInfo.UDD->channelCnts.hub
 	PhidgetDevice phid;
 
+	mos_mutex_t outstandingPacketCntLock[VINTHUB_MAXPORTS]; /* protects outstandingPacketCnt and the credit queues */
+	/* VINT devices with digital input changes in the transfer being processed - read thread only */
+	PhidgetDeviceHandle inputSnapshotDevice[VINTHUB_MAXPORTS];
+	int inputSnapshotDeviceCnt;
+
+	mos_cond_t outstandingPacketCntCond[VINTHUB_MAXPORTS];
 	size_t outstandingPacketCnt[VINTHUB_MAXPORTS];
 	BOOL outstandingPacketCntValid;
 
+	/*
+	 * Claimers that find a port's TX buffer full queue here and are granted space in order as
+	 * packet returns free it.
+	 */
+	hubcreditwaiters_t creditWaiters[VINTHUB_MAXPORTS];
+	uint32_t creditQueueDepth[VINTHUB_MAXPORTS];
+	uint32_t creditQueueMaxDepth[VINTHUB_MAXPORTS];
+	uint32_t creditStarvedCnt[VINTHUB_MAXPORTS];	/* claims that had to queue */
+	uint32_t creditTimeoutCnt[VINTHUB_MAXPORTS];	/* claims that gave up */
+
 	size_t internalPacketInBufferLen;
 
 	int packetCounter;
@@ -54,6 +54,60 @@ PhidgetVINTDevice_initAfterOpen(PhidgetDeviceHandle device) {
 	return (EPHIDGET_OK);
 }
 
+/*
+ * Folds a digital input state change into the device's input snapshot. This is done for every channel,
+ * open or not, so the snapshot always describes the whole device.
+ */
+static void
+recordInputSnapshot(PhidgetVINTDeviceHandle phid, int channelIndex, const uint8_t *buf, int len) {
+	uint32_t bit;
+	int state;
+
+	if (channelIndex >= 32)
+		return;
+
+	// Decoded as the device's packet handler decodes it, so the snapshot agrees with BP_STATECHANGE
+	state = getVINTInputState(phid->phid.deviceInfo.UDD->uid, buf[0], buf + 1, len - 1);
+	if (state < 0)
+		return;
+
+	bit = 1U << channelIndex;
+	if (state)
+		phid->inputSnapshotState |= bit;
+	else
+		phid->inputSnapshotState &= ~bit;
+	phid->inputSnapshotChanged |= bit;
+}
+
+/*
+ * Delivers the input snapshot gathered from one hub transfer as a single event to each open digital input
+ * channel that asked for snapshots.
+ */
+void
+PhidgetVINTDevice_flushInputSnapshot(PhidgetVINTDeviceHandle phid) {
+	PhidgetChannelHandle channel;
+	uint32_t changed;
+	int i;
+
+	changed = phid->inputSnapshotChanged;
+	phid->inputSnapshotChanged = 0;
+	phid->inputSnapshotQueued = 0;
+
+	if (changed == 0)
+		return;
+
+	for (i = 0; i < VINTHUB_MAXCHANNELS; i++) {
+		channel = getAttachedChannel((PhidgetDeviceHandle)phid, i);
+		if (channel == NULL)
+			continue;
+
+		if (channel->class == PHIDCHCLASS_DIGITALINPUT && PhidgetCKFlags(channel, PHIDGET_INITIALIZED_FLAG) &&
+		  PhidgetDigitalInput_inputSnapshotEnabled(channel))
+			bridgeSendToChannel(channel, BP_INPUTSNAPSHOT, 2, "%u%u", phid->inputSnapshotState, changed);
+		PhidgetRelease(&channel);
+	}
+}
+
 static PhidgetReturnCode CCONV
 PhidgetVINTDevice_dataInput(PhidgetDeviceHandle device, uint8_t *buffer, size_t length) {
 	PhidgetChannelHandle vintChannel;
@@ -81,6 +135,8 @@ PhidgetVINTDevice_dataInput(PhidgetDeviceHandle device, uint8_t *buffer, size_t
 		return (EPHIDGET_UNEXPECTED);
 	}
 
+	recordInputSnapshot((PhidgetVINTDeviceHandle)device, channelIndex, buffer + readPtr, dataCount);
+
 	vintChannel = getAttachedChannel(device, channelIndex);
 	if (vintChannel == NULL) {
 		vintlogverbose("Dropping VINT Packet addressed to closed channel - probably channel was not closed properly previously.");
@@ -33,6 +33,7 @@
 
 typedef struct _PhidgetVINTDevice *PhidgetVINTDeviceHandle;
 PhidgetReturnCode PhidgetVINTDevice_create(PhidgetVINTDeviceHandle *phid);
+void PhidgetVINTDevice_flushInputSnapshot(PhidgetVINTDeviceHandle phid);
 
 PhidgetReturnCode PhidgetVINTDevice_makePacket(
 	PhidgetVINTDeviceHandle		vintDevice,
@@ -69,6 +70,11 @@ struct _PhidgetVINTDevice {
 	Phidget_PowerSupply powerSupply;
 	Phidget_RTDWireSetup RTDWireSetup;
 
+	// Digital input snapshot - bit n is the last reported state of channel n. Only touched by the hub read thread.
+	uint32_t inputSnapshotState;
+	uint32_t inputSnapshotChanged;	// bits reported since the last flush
+	int inputSnapshotQueued;		// waiting on the hub to be flushed
+
 } typedef PhidgetVINTDeviceInfo;
 
 #endif
@@ -8,6 +8,12 @@
 #include "mos/mos_os.h"
 #include "mos/mos_time.h"
 #include "mos/mos_assert.h"
+#include "mos/mos_atomic.h"
+
+#ifdef _LINUX
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
 
 #ifdef DEBUG
 #define displog(...) PhidgetLog_loge(NULL, 0, __func__, "_phidget22disp", PHIDGET_LOG_INFO, __VA_ARGS__)
@@ -17,17 +23,18 @@
 
 #define DISPATCHENTRY_PHID_IMAX		64		/* inbound limit to allow on a given phid */
 #define DISPATCHENTRY_PHID_OSOFTMAX	200		/* soft outbound limit to allow on a given phid */
-#define DISPATCHENTRY_PHID_OHARDMAX	4096	/* hard outbound limit to allow on a given phid */
 #define DISPATCHENTRY_MAX			32768	/* max entries to create before failing */
 #define DISPATCHENTRY_DESIRED		256		/* entries to try and balance the system at */
 #define DISPATCHENTRY_MAXDATA		64		/* data buffer size */
 
-#define DISPATCHERS_MAX				32	/* max dispatch threads we will allow at one time */
-#define DISPATCHERS_DESIRED_IDLE	4	/* the number of idle threads we'd like to have */
+#define DISPATCHRING_SIZE			256		/* outbound slots preallocated per phid (hard limit): power of 2 */
+#define DISPATCHRING_MASK			(DISPATCHRING_SIZE - 1)
+#define DISPATCHRING_LATEST			8		/* value event types that can be coalesced per phid */
 
-extern uint32_t phidgetChannelsCount;
+#define DISPATCHERS_MAX				32	/* max dispatch threads that may be configured */
+#define DISPATCHERS_DEFAULT			4	/* dispatch threads when the pool size is not configured */
 
-#define DISPATCHERS_DESIRED (phidgetChannelsCount + DISPATCHERS_DESIRED_IDLE)
+#define DISPATCH_HELP_WAIT			(10 * MOS_MSEC)	/* recheck period for a dispatcher blocked on a user request */
 
 typedef enum dispatchtype {
 	DE_NOTHING			= 0,
@@ -55,15 +62,17 @@ typedef enum dispatchtype {
 #define DISPATCHENTRY_INBOUND	0x02		/* flag the entry as coming from a user call */
 #define DISPATCHENTRY_WAITING	0x04		/* cleared when an entry is handled */
 #define DISPATCHENTRY_NORETURN	0x08		/* tell dispatcher not to return de (returned by waiter) */
+#define DISPATCHENTRY_RING		0x10		/* entry is a slot in a phid outbound ring */
+#define DISPATCHENTRY_LATEST	0x20		/* bridge packet is taken from a coalescing cell on delivery */
 
-/* By default, everything is outbound */
-#define OUTBOUND(de)	(((de)->flags & DISPATCHENTRY_INBOUND) == 0)
+typedef struct _DispatchLatest DispatchLatest;
 
 typedef struct bpdispatchentry {
 	BridgePacket				*bp;
 	PhidgetNetConnHandle		nc;
 	int							forward;
 	int							reqseq;
+	DispatchLatest				*latest;
 } bpdispatchentry_t;
 
 typedef struct userreqdispatchentry {
@@ -110,11 +119,50 @@ mos_fasttlock_t					dispatchLock;
 mos_cond_t						dispatchCond;
 
 static dispatchentry_list_t		dispatchEntryList;
-static uint32_t					dispatchOutListCount;
-static phidgets_t				dispatchOutList;
-static uint32_t					dispatchInListCount;
-static phidgets_t				dispatchInList;
 
+/*
+ * A dispatch thread, and the phids scheduled on it.
+ *
+ * A phid is scheduled on its home dispatcher, which takes phids from the head of its lists.  An idle
+ * dispatcher steals from the tail of the other dispatchers' lists.  A phid is only ever on one list,
+ * or being drained by one dispatcher, so the events for a phid are delivered in order.
+ */
+typedef struct _Dispatcher {
+	mos_mutex_t					lock;			/* protects the lists and flags */
+	mos_cond_t					cond;
+	phidgets_t					outList;
+	phidgets_t					inList;
+	mos_task_t					task;
+	uint32_t					index;
+	int							cpu;			/* cpu the thread is bound to, or -1 */
+	uint8_t						running;		/* the thread exists: protected by dispatchLock */
+	uint8_t						waiting;		/* parked, or about to park */
+	uint8_t						wake;			/* work may have been queued while waiting */
+	uint8_t						stop;
+} Dispatcher, *DispatcherHandle;
+
+static Dispatcher				dispatchers[DISPATCHERS_MAX];
+static uint32_t					dispatcherCount = DISPATCHERS_DEFAULT;	/* configured pool size */
+static uint64_t					dispatcherAffinity;		/* cpus to bind the dispatchers to, 0 for any */
+static uint32_t					dispatcherLists;		/* lists that may hold phids: max pool size used */
+static uint32_t					dispatchersStarted;		/* the pool has been started */
+static uint32_t					dispatchersRunning;		/* threads that exist: protected by dispatchLock */
+static uint32_t					dispatchersIdle;		/* threads parked, or about to park */
+
+/*
+ * Manual drain: outbound events for user handles are queued here and run by Phidget_drainEvents()
+ * on the application's thread.  dispatchEventFd becomes readable while there are events to drain.
+ */
+static uint32_t					dispatchManual;
+static mos_mutex_t				dispatchManualLock;
+static phidgets_t				dispatchManualList;
+static int						dispatchEventFd = -1;
+
+static int helpDispatch(DispatcherHandle);
+
+/*
+ * Inbound (from user) queue: entries come from the shared pool.
+ */
 typedef struct _Dispatch {
 	struct dispatchentry_list	list;
 	uint16_t					count;
@@ -122,11 +170,49 @@ typedef struct _Dispatch {
 	uint8_t						softErrorThrown;
 } Dispatch, *DispatchHandle;
 
+/*
+ * Outbound (to user) queue: a bounded MPSC ring of preallocated entries.
+ *
+ * Each slot carries a sequence number: a producer may claim the slot at position pos when
+ * seq == pos, and publishes it by setting seq = pos + 1.  The consumer may take it when
+ * seq == pos + 1, and hands it back to producers by setting seq = pos + DISPATCHRING_SIZE.
+ *
+ * Entries are filled and dispatched in place, so producers never take a dispatcher lock or the phid
+ * lock.  A dispatcher lock is only taken when the ring goes from idle to scheduled.
+ */
+typedef struct _DispatchSlot {
+	uint32_t					seq;
+	DispatchEntry				de;
+} DispatchSlot;
+
+/*
+ * Latest value of a bridge packet type, for channels that coalesce value events.
+ *
+ * The producer that finds the cell empty queues an entry for it; producers that find a value in
+ * the cell replace it, as an entry is already waiting.  The entry takes whatever value is in the
+ * cell when it is delivered.
+ */
+struct _DispatchLatest {
+	uint32_t					vpkt;			/* bridge packet type, or 0 (BP_SETSTATUS) if free */
+	BridgePacket				*bp;			/* value waiting to be delivered */
+};
+
+typedef struct _DispatchRing {
+	uint32_t					head;			/* next position to consume */
+	uint32_t					tail;			/* next position to produce */
+	uint32_t					scheduled;		/* on a dispatcher list, or being drained */
+	uint32_t					max;
+	uint8_t						softErrorThrown;
+	DispatchLatest				latest[DISPATCHRING_LATEST];
+	DispatchSlot				slots[DISPATCHRING_SIZE];
+} DispatchRing, *DispatchRingHandle;
+
+#define DISPATCHRING_DEPTH(ring)	\
+	(mos_atomic_get_32(&(ring)->tail) - mos_atomic_get_32(&(ring)->head))
+
 static int initialized;				/* init flag */
 
 static uint32_t entryCount;			/* how many have been allocated */
-static uint32_t dispatchers;		/* how many dispatch threads exist */
-static uint32_t dispatchersRunning;	/* how many dispatch threads are busy */
 
 static void cleanDispatchEntry(DispatchEntryHandle);
 
@@ -156,47 +242,215 @@ freeDispatchEntry(DispatchEntryHandle de) {
 	decPhidgetStat("dispatch.entries");
 }
 
+static int
+dispatcherCPU(uint32_t index) {
+	uint32_t cpus;
+	int cpu;
+
+	if (dispatcherAffinity == 0)
+		return (-1);
+
+	for (cpus = 0, cpu = 0; cpu < 64; cpu++)
+		if (dispatcherAffinity & (1ULL << cpu))
+			cpus++;
+
+	/* the index'th cpu in the mask, wrapping if there are more dispatchers than cpus */
+	index %= cpus;
+	for (cpu = 0; cpu < 64; cpu++) {
+		if ((dispatcherAffinity & (1ULL << cpu)) == 0)
+			continue;
+		if (index-- == 0)
+			break;
+	}
+	return (cpu);
+}
+
+/*
+ * Starts the dispatch threads if they are not running.
+ */
 static void
-entryDispatched(void) {
-	mos_task_t task;
-	int idle;
+startDispatchers(void) {
+	DispatcherHandle d;
+	uint32_t i;
 	int res;
 
+	if (mos_atomic_get_32(&dispatchersStarted))
+		return;
+
 	mos_fasttlock_lock(&dispatchLock);
-	idle = dispatchers - dispatchersRunning;
-	if (idle < 1 && dispatchers < DISPATCHERS_MAX) {
-		logdebug("creating dispatcher");
-		res = mos_task_create(&task, PhidgetDispatcher, NULL);
+	if (dispatchersStarted || initialized != 1) {
+		mos_fasttlock_unlock(&dispatchLock);
+		return;
+	}
+
+	for (i = 0; i < dispatcherCount; i++) {
+		d = &dispatchers[i];
+		if (d->running)
+			continue;
+
+		mos_mutex_lock(&d->lock);
+		d->cpu = dispatcherCPU(i);
+		d->stop = 0;
+		d->wake = 1;	/* phids may have been left on the lists */
+		mos_mutex_unlock(&d->lock);
+
+		res = mos_task_create(&d->task, PhidgetDispatcher, d);
 		if (res) {
-			logerr("error creating dispatcher: 0x%08x", res);
-		} else {
-			incPhidgetStat("dispatch.dispatchers");
-			incPhidgetStat("dispatch.dispatchers_ever");
-			dispatchers++;
-			logdebug("created dispatcher - dispatchers: %d", dispatchers);
+			logerr("error creating dispatcher %u: 0x%08x", i, res);
+			continue;
 		}
+		d->running = 1;
+		dispatchersRunning++;
+		incPhidgetStat("dispatch.dispatchers");
+		incPhidgetStat("dispatch.dispatchers_ever");
 	}
-	mos_cond_signal(&dispatchCond);
+	logdebug("started %u dispatchers", dispatchersRunning);
+
+	mos_atomic_swap_32(&dispatchersStarted, 1);
 	mos_fasttlock_unlock(&dispatchLock);
 }
 
 /*
- * Requires dispatchLock
+ * Returns the dispatcher that is running on the calling thread, or NULL.
+ */
+static DispatcherHandle
+currentDispatcher(void) {
+	mos_task_t self;
+	uint32_t i;
+
+	self = mos_self();
+	for (i = 0; i < dispatcherLists; i++) {
+		if (dispatchers[i].running && mos_task_equal(dispatchers[i].task, self))
+			return (&dispatchers[i]);
+	}
+	return (NULL);
+}
+
+static DispatcherHandle
+homeDispatcher(PhidgetHandle phid) {
+	uintptr_t h;
+
+	h = (uintptr_t)phid;
+	h ^= h >> 9;
+	h ^= h >> 17;
+
+	return (&dispatchers[(h / sizeof (void *)) % mos_atomic_get_32(&dispatcherCount)]);
+}
+
+/*
+ * Wakes one parked dispatcher other than skip, so that it can steal work.
+ */
+static void
+wakeIdleDispatcher(DispatcherHandle skip) {
+	DispatcherHandle d;
+	uint32_t count;
+	uint32_t i;
+
+	count = mos_atomic_get_32(&dispatcherCount);
+	for (i = 1; i <= count; i++) {
+		d = &dispatchers[(skip->index + i) % count];
+		if (d == skip)
+			continue;
+		mos_mutex_lock(&d->lock);
+		if (d->waiting && !d->wake) {
+			d->wake = 1;
+			mos_cond_signal(&d->cond);
+			mos_mutex_unlock(&d->lock);
+			incPhidgetStat("dispatch.idle_wakeups");
+			return;
+		}
+		mos_mutex_unlock(&d->lock);
+	}
+}
+
+static void
+signalEventFd(void) {
+#ifdef _LINUX
+	uint64_t one;
+
+	one = 1;
+	if (dispatchEventFd >= 0 && write(dispatchEventFd, &one, sizeof (one)) != sizeof (one) && errno != EAGAIN)
+		logwarn("failed to signal event fd: %d", errno);
+#endif
+}
+
+static void
+clearEventFd(void) {
+#ifdef _LINUX
+	uint64_t cnt;
+
+	if (dispatchEventFd >= 0 && read(dispatchEventFd, &cnt, sizeof (cnt)) < 0 && errno != EAGAIN)
+		logwarn("failed to clear event fd: %d", errno);
+#endif
+}
+
+/*
+ * Returns true if the outbound events of phid are run by Phidget_drainEvents().
+ *
+ * Only channels and managers opened by the user are drained manually.  Channels that are attaching
+ * stay on the dispatchers, as the attach event initializes the channel and openWaitForAttachment()
+ * waits for it to complete.
  */
 static int
-dispatchTaskNeeded(void) {
+manualDispatch(PhidgetHandle phid) {
+
+	if (mos_atomic_get_32(&dispatchManual) == 0)
+		return (0);
+
+	if (PhidgetManagerCast(phid))
+		return (1);
 
-	if (initialized == 0 && dispatchOutListCount == 0 && dispatchInListCount == 0)
+	if (PhidgetChannelCast(phid) == NULL)
 		return (0);
 
-	return (dispatchers - dispatchersRunning <= DISPATCHERS_DESIRED);
+	return (PhidgetCKFlagsNoLock(phid, PHIDGET_OPENBYNETCLIENT_FLAG | PHIDGET_ATTACHING_FLAG) == 0);
 }
 
 /*
- * Requires dispatchLock
+ * Queues phid on its home dispatcher, and makes sure a dispatcher will run it.
+ * The reference held by the caller is given to the list.
+ */
+static void
+scheduleDispatch(PhidgetHandle phid, int out) {
+	DispatcherHandle d;
+	int waiting;
+
+	if (out && manualDispatch(phid)) {
+		mos_mutex_lock(&dispatchManualLock);
+		MTAILQ_INSERT_TAIL(&dispatchManualList, phid, dispatchOutLink);
+		mos_mutex_unlock(&dispatchManualLock);
+		signalEventFd();
+		return;
+	}
+
+	startDispatchers();
+
+	d = homeDispatcher(phid);
+	mos_mutex_lock(&d->lock);
+	if (out)
+		MTAILQ_INSERT_TAIL(&d->outList, phid, dispatchOutLink);
+	else
+		MTAILQ_INSERT_TAIL(&d->inList, phid, dispatchInLink);
+	waiting = d->waiting;
+	if (waiting) {
+		d->wake = 1;
+		mos_cond_signal(&d->cond);
+	}
+	mos_mutex_unlock(&d->lock);
+
+	/*
+	 * The home dispatcher is busy: wake one idle dispatcher to steal the phid rather than waking
+	 * every thread.
+	 */
+	if (!waiting && mos_atomic_get_32(&dispatchersIdle) > 0)
+		wakeIdleDispatcher(d);
+}
+
+/*
+ * Requires the dispatcher lock
  */
 static PhidgetHandle
-getDispatchOutPhidget() {
+getDispatchOutPhidget(DispatcherHandle d, int steal) {
 	PhidgetHandle tphid;
 	PhidgetHandle phid;
 
@@ -206,16 +460,16 @@ getDispatchOutPhidget() {
 	 *
 	 * Local channels will always be ATTACHED or DETACHING.
 	 */
-	MTAILQ_FOREACH_SAFE(phid, &dispatchOutList, dispatchOutLink, tphid) {
+	phid = steal ? MTAILQ_LAST(&d->outList, phidgets) : MTAILQ_FIRST(&d->outList);
+	for (; phid != NULL; phid = tphid) {
+		tphid = steal ? MTAILQ_PREV(phid, phidgets, dispatchOutLink) : MTAILQ_NEXT(phid, dispatchOutLink);
 		if (ISATTACHEDORDETACHING(phid)) {
-			MTAILQ_REMOVE(&dispatchOutList, phid, dispatchOutLink);
-			dispatchOutListCount--;
+			MTAILQ_REMOVE(&d->outList, phid, dispatchOutLink);
 			return (phid); // reference assigned to the caller
 		} else if (!ISOPEN(phid)) {
-			MTAILQ_REMOVE(&dispatchOutList, phid, dispatchOutLink);
-			dispatchOutListCount--;
-			// Flag must be cleared here because we don't return the phid to the Dispatcher
-			PhidgetCLRFlags(phid, PHIDGET_DISPATCHOUT_FLAG);
+			MTAILQ_REMOVE(&d->outList, phid, dispatchOutLink);
+			// Must be cleared here because we don't return the phid to the Dispatcher
+			mos_atomic_swap_32(&((DispatchRingHandle)phid->dispatchOutHandle)->scheduled, 0);
 		}
 	}
 
@@ -223,25 +477,69 @@ getDispatchOutPhidget() {
 }
 
 /*
- * Requires dispatchLock
+ * Requires the dispatcher lock
  */
 static PhidgetHandle
-getDispatchInPhidget() {
+getDispatchInPhidget(DispatcherHandle d, int steal) {
 	PhidgetHandle phid;
 
-	phid = MTAILQ_FIRST(&dispatchInList);
+	phid = steal ? MTAILQ_LAST(&d->inList, phidgets) : MTAILQ_FIRST(&d->inList);
 	if (phid == NULL)
 		return (NULL);
 
-	MTAILQ_REMOVE(&dispatchInList, phid, dispatchInLink);
-	dispatchInListCount--;
+	MTAILQ_REMOVE(&d->inList, phid, dispatchInLink);
 	return (phid); // reference assigned to the caller
 }
 
+/*
+ * Takes a phid from the lists of d, inbound (from the user) first.
+ */
+static PhidgetHandle
+takeDispatchPhidget(DispatcherHandle d, int steal, int inOnly, int *out) {
+	PhidgetHandle phid;
+
+	mos_mutex_lock(&d->lock);
+	*out = 0;
+	phid = getDispatchInPhidget(d, steal);
+	if (phid == NULL && !inOnly) {
+		phid = getDispatchOutPhidget(d, steal);
+		*out = 1;
+	}
+	mos_mutex_unlock(&d->lock);
+
+	return (phid);
+}
+
+/*
+ * Finds work for self: its own lists first, then any other dispatcher's.
+ */
+static PhidgetHandle
+findDispatchPhidget(DispatcherHandle self, int inOnly, int *out) {
+	PhidgetHandle phid;
+	uint32_t lists;
+	uint32_t i;
+
+	phid = takeDispatchPhidget(self, 0, inOnly, out);
+	if (phid != NULL)
+		return (phid);
+
+	lists = mos_atomic_get_32(&dispatcherLists);
+	for (i = 1; i < lists; i++) {
+		phid = takeDispatchPhidget(&dispatchers[(self->index + i) % lists], 1, inOnly, out);
+		if (phid != NULL) {
+			incPhidgetStat("dispatch.steals");
+			return (phid);
+		}
+	}
+
+	return (NULL);
+}
+
 void PhidgetDispatchInit(void);
 
 void
 PhidgetDispatchInit(void) {
+	uint32_t i;
 
 	mos_glock((void *)0);
 	if (initialized) {
@@ -257,17 +555,25 @@ PhidgetDispatchInit(void) {
 	MTAILQ_INIT(&dispatchEntryList);
 	entryCount = 0;
 
-	MTAILQ_INIT(&dispatchOutList);
-	dispatchOutListCount = 0;
+	for (i = 0; i < DISPATCHERS_MAX; i++) {
+		mos_mutex_init(&dispatchers[i].lock);
+		mos_cond_init(&dispatchers[i].cond);
+		MTAILQ_INIT(&dispatchers[i].outList);
+		MTAILQ_INIT(&dispatchers[i].inList);
+		dispatchers[i].index = i;
+		dispatchers[i].cpu = -1;
+	}
 
-	MTAILQ_INIT(&dispatchInList);
-	dispatchInListCount = 0;
+	mos_mutex_init(&dispatchManualLock);
+	MTAILQ_INIT(&dispatchManualList);
 
-	dispatchers = 0;
+	dispatcherLists = dispatcherCount;
+	dispatchersStarted = 0;
 	dispatchersRunning = 0;
+	dispatchersIdle = 0;
 
 	setPhidgetStat("dispatch.max_dispatchers", DISPATCHERS_MAX);
-	setPhidgetStat("dispatch.desired_idle_dispatchers", DISPATCHERS_DESIRED_IDLE);
+	setPhidgetStat("dispatch.pool_size", dispatcherCount);
 	setPhidgetStat("dispatch.max_entries", DISPATCHENTRY_MAX);
 	setPhidgetStat("dispatch.desired_entries", DISPATCHENTRY_DESIRED);
 }
@@ -277,6 +583,7 @@ void PhidgetDispatchFini(void);
 void
 PhidgetDispatchFini(void) {
 	DispatchEntryHandle de, de2;
+	uint32_t i;
 
 	mos_glock((void *)0);
 	if (initialized == 0) {
@@ -302,21 +609,147 @@ PhidgetDispatchFini(void) {
 
 	MOS_ASSERT(entryCount == 0);
 	MTAILQ_INIT(&dispatchEntryList);
+
+	for (i = 0; i < DISPATCHERS_MAX; i++) {
+		mos_mutex_destroy(&dispatchers[i].lock);
+		mos_cond_destroy(&dispatchers[i].cond);
+	}
+	mos_mutex_destroy(&dispatchManualLock);
 }
 
-void
-PhidgetDispatchStop(void) {
-	/* wait for the dispatchers to exit */
+/*
+ * Waits for the dispatchers to exit.
+ *
+ * Requires dispatchLock
+ */
+static void
+stopDispatchers(void) {
+	DispatcherHandle d;
+	uint32_t i;
 
 	displog("stopping dispatch");
-	mos_fasttlock_lock(&dispatchLock);
 	initialized = 0;
-	while (dispatchers > 0) {
-		mos_cond_broadcast(&dispatchCond);
-		mos_fasttlock_timedwait(&dispatchCond, &dispatchLock, 1000000000);
+
+	/*
+	 * Dispatchers finish the work that can be run before they exit.
+	 */
+	for (i = 0; i < dispatcherLists; i++) {
+		d = &dispatchers[i];
+		mos_mutex_lock(&d->lock);
+		d->stop = 1;
+		d->wake = 1;
+		mos_cond_signal(&d->cond);
+		mos_mutex_unlock(&d->lock);
 	}
+
+	while (dispatchersRunning > 0)
+		mos_fasttlock_timedwait(&dispatchCond, &dispatchLock, 1000000000);
+
+	mos_atomic_swap_32(&dispatchersStarted, 0);
 	initialized = 1;
+}
+
+void
+PhidgetDispatchStop(void) {
+
+	mos_fasttlock_lock(&dispatchLock);
+	stopDispatchers();
+	mos_fasttlock_unlock(&dispatchLock);
+}
+
+/*
+ * Moves phids off the lists of dispatchers that are no longer in the pool.
+ *
+ * Requires dispatchLock, and the dispatchers to be stopped.
+ */
+static void
+rehomeDispatch(void) {
+	PhidgetHandle phid;
+	DispatcherHandle d;
+	DispatcherHandle h;
+	uint32_t i;
+
+	for (i = dispatcherCount; i < dispatcherLists; i++) {
+		d = &dispatchers[i];
+		mos_mutex_lock(&d->lock);
+		while ((phid = MTAILQ_FIRST(&d->inList)) != NULL) {
+			MTAILQ_REMOVE(&d->inList, phid, dispatchInLink);
+			h = homeDispatcher(phid);
+			mos_mutex_lock(&h->lock);
+			MTAILQ_INSERT_TAIL(&h->inList, phid, dispatchInLink);
+			mos_mutex_unlock(&h->lock);
+		}
+		while ((phid = MTAILQ_FIRST(&d->outList)) != NULL) {
+			MTAILQ_REMOVE(&d->outList, phid, dispatchOutLink);
+			h = homeDispatcher(phid);
+			mos_mutex_lock(&h->lock);
+			MTAILQ_INSERT_TAIL(&h->outList, phid, dispatchOutLink);
+			mos_mutex_unlock(&h->lock);
+		}
+		mos_mutex_unlock(&d->lock);
+	}
+}
+
+/*
+ * Restarts the pool with a new size and affinity.
+ */
+static PhidgetReturnCode
+configureDispatchers(uint32_t count, uint64_t affinity) {
+
+	if (currentDispatcher() != NULL)
+		return (PHID_RETURN_ERRSTR(EPHIDGET_BUSY, "The dispatcher pool cannot be configured from an event handler."));
+
+	mos_glock((void *)0);
+	if (initialized == 0) {
+		dispatcherCount = count;
+		dispatcherAffinity = affinity;
+		mos_gunlock((void *)0);
+		return (EPHIDGET_OK);
+	}
+
+	mos_fasttlock_lock(&dispatchLock);
+	stopDispatchers();
+
+	mos_atomic_swap_32(&dispatcherCount, count);
+	dispatcherAffinity = affinity;
+
+	/*
+	 * Late producers may still have queued on a list beyond the new size, so dispatchers keep
+	 * looking at every list that has been used.
+	 */
+	if (count > dispatcherLists)
+		mos_atomic_swap_32(&dispatcherLists, count);
+	rehomeDispatch();
+	setPhidgetStat("dispatch.pool_size", count);
 	mos_fasttlock_unlock(&dispatchLock);
+
+	startDispatchers();
+	mos_gunlock((void *)0);
+
+	return (EPHIDGET_OK);
+}
+
+API_PRETURN
+Phidget_setDispatcherCount(uint32_t count) {
+
+	TESTRANGE_PR(count, "%u", 1, DISPATCHERS_MAX);
+
+	return (configureDispatchers(count, dispatcherAffinity));
+}
+
+API_PRETURN
+Phidget_getDispatcherCount(uint32_t *count) {
+
+	TESTPTR_PR(count);
+	*count = dispatcherCount;
+
+	return (EPHIDGET_OK);
+}
+
+API_PRETURN
+Phidget_setDispatcherAffinity(uint64_t cpuMask) {
+
+	return (configureDispatchers(dispatcherCount, cpuMask));
 }
 
 static PhidgetReturnCode
@@ -342,9 +775,28 @@ getDispatchEntry(DispatchEntryHandle *de) {
 	return (EPHIDGET_OK);
 }
 
+/*
+ * Moves the pending value of a coalesced entry into the entry.  Returns 0 if there is nothing to
+ * deliver, as the value was taken by an earlier entry for the same cell.
+ */
+static int
+takeDispatchLatest(DispatchEntryHandle de) {
+
+	if ((de->flags & DISPATCHENTRY_LATEST) == 0)
+		return (1);
+
+	de->flags &= ~DISPATCHENTRY_LATEST;
+	de->de_bpe.bp = mos_atomic_swap_ptr((void **)&de->de_bpe.latest->bp, NULL);
+	de->de_bpe.latest = NULL;
+
+	return (de->de_bpe.bp != NULL);
+}
+
 static void
 cleanDispatchEntry(DispatchEntryHandle de) {
 
+	takeDispatchLatest(de);
+
 	/*
 	 * Make sure any referenced objects are freed when the dispatch thread exits.
 	 */
@@ -399,13 +851,65 @@ cleanDispatchEntry(DispatchEntryHandle de) {
 	de->flags = 0;
 }
 
+static DispatchSlot *
+dispatchSlotOf(DispatchEntryHandle de) {
+
+	return ((DispatchSlot *)((uint8_t *)de - offsetof(DispatchSlot, de)));
+}
+
+/*
+ * Hands a consumed slot back to the producers.
+ */
+static void
+releaseDispatchSlot(DispatchEntryHandle de) {
+	DispatchSlot *slot;
+	uint32_t seq;
+
+	slot = dispatchSlotOf(de);
+	seq = mos_atomic_get_32(&slot->seq);
+	de->flags = 0;
+	mos_atomic_swap_32(&slot->seq, seq - 1 + DISPATCHRING_SIZE);
+}
+
+/*
+ * Publishes a claimed slot to the consumer.
+ */
+static void
+publishDispatchSlot(DispatchEntryHandle de) {
+	DispatchSlot *slot;
+	uint32_t seq;
+
+	slot = dispatchSlotOf(de);
+	seq = mos_atomic_get_32(&slot->seq);
+	de->flags |= DISPATCHENTRY_ONLIST;
+	mos_atomic_swap_32(&slot->seq, seq + 1);
+}
+
 static PhidgetReturnCode
 returnDispatchEntry(DispatchEntryHandle de) {
+	uint8_t flags;
 
 	MOS_ASSERT((de->flags & DISPATCHENTRY_NORETURN) == 0);
 
+	flags = de->flags;
 	if (de->type != DE_NOTHING)
 		cleanDispatchEntry(de);
+
+	if (flags & DISPATCHENTRY_RING) {
+		/*
+		 * A slot that was claimed but never published still holds its place in the ring: publish
+		 * it empty so the consumer can step over it.
+		 */
+		de->type = DE_NOTHING;
+		if (flags & DISPATCHENTRY_ONLIST) {
+			releaseDispatchSlot(de);
+		} else {
+			de->flags = DISPATCHENTRY_RING;
+			publishDispatchSlot(de);
+		}
+		return (EPHIDGET_OK);
+	}
+
 	mos_fasttlock_lock(&dispatchLock);
 	if (entryCount >= DISPATCHENTRY_DESIRED) {
 		freeDispatchEntry(de);
@@ -418,19 +922,16 @@ returnDispatchEntry(DispatchEntryHandle de) {
 	return (EPHIDGET_OK);
 }
 
+/*
+ * Requires the phid lock
+ */
 static DispatchHandle
-getDispatchHandle(PhidgetHandle phid, int out) {
+getDispatchHandle(PhidgetHandle phid) {
 	DispatchHandle dph;
 
-	if (out) {
-		if (phid->dispatchOutHandle)
-			return (phid->dispatchOutHandle);
-		phid->dispatchOutHandle = dph = mos_malloc(sizeof(*dph));
-	} else {
-		if (phid->dispatchInHandle)
-			return (phid->dispatchInHandle);
-		phid->dispatchInHandle = dph = mos_malloc(sizeof(*dph));
-	}
+	if (phid->dispatchInHandle)
+		return (phid->dispatchInHandle);
+	phid->dispatchInHandle = dph = mos_malloc(sizeof(*dph));
 
 	MTAILQ_INIT(&dph->list);
 	dph->count = 0;
@@ -440,34 +941,82 @@ getDispatchHandle(PhidgetHandle phid, int out) {
 	return (dph);
 }
 
-static void
-clearPhidgetDispatchOut(PhidgetHandle phid, int dataOnly) {
-	DispatchEntryHandle de;
-	DispatchHandle dph;
-	int cnt;
+/*
+ * The ring is never freed before the phid, so once it has been created it can be used without
+ * holding the phid lock.
+ */
+static DispatchRingHandle
+getDispatchRing(PhidgetHandle phid) {
+	DispatchRingHandle ring;
+	uint32_t i;
 
-	cnt = 0;
+	ring = phid->dispatchOutHandle;
+	if (ring != NULL)
+		return (ring);
 
 	PhidgetLock(phid);
+	if (phid->dispatchOutHandle == NULL) {
+		ring = mos_zalloc(sizeof(*ring));
+		for (i = 0; i < DISPATCHRING_SIZE; i++)
+			ring->slots[i].seq = i;
+		phid->dispatchOutHandle = ring;
+	}
+	ring = phid->dispatchOutHandle;
+	PhidgetUnlock(phid);
+
+	return (ring);
+}
+
+/*
+ * Takes the next published entry off the ring, or returns NULL if there is none.
+ *
+ * The entry stays in its slot, and the slot is not reused until the entry is returned.  Safe to call
+ * from more than one thread, as the queue may be cleared while a dispatcher is draining it.
+ */
+static DispatchEntryHandle
+popDispatchSlot(DispatchRingHandle ring) {
+	DispatchSlot *slot;
+	uint32_t pos;
+	uint32_t seq;
+
+	pos = mos_atomic_get_32(&ring->head);
 	for (;;) {
-		if (phid->dispatchOutHandle != NULL) {
-			dph = phid->dispatchOutHandle;
-			de = MTAILQ_FIRST(&dph->list);
+		slot = &ring->slots[pos & DISPATCHRING_MASK];
+		seq = mos_atomic_get_32(&slot->seq);
+		if ((int32_t)(seq - (pos + 1)) < 0)
+			return (NULL);	/* empty, or the producer has not published yet */
+		if (seq == pos + 1 && mos_atomic_cas_32(&ring->head, pos, pos + 1) == pos)
+			return (&slot->de);
+		pos = mos_atomic_get_32(&ring->head);
+	}
+}
 
-			// list is empty
-			if (de == NULL)
-				break;
+/*
+ * Returns true if the next entry on the ring has been published.
+ */
+static int
+dispatchRingReady(DispatchRingHandle ring) {
+	uint32_t pos;
 
-			MTAILQ_REMOVE(&dph->list, de, link);
-			MOS_ASSERT(dph->count > 0);
-			dph->count--;
-			cnt++;
-			PhidgetUnlock(phid);
-			returnDispatchEntry(de);
-			PhidgetLock(phid);
-		}
+	pos = mos_atomic_get_32(&ring->head);
+	return (mos_atomic_get_32(&ring->slots[pos & DISPATCHRING_MASK].seq) == pos + 1);
+}
+
+static void
+clearPhidgetDispatchOut(PhidgetHandle phid) {
+	DispatchRingHandle ring;
+	DispatchEntryHandle de;
+	int cnt;
+
+	ring = phid->dispatchOutHandle;
+	if (ring == NULL)
+		return;
+
+	cnt = 0;
+	while ((de = popDispatchSlot(ring)) != NULL) {
+		returnDispatchEntry(de);
+		cnt++;
 	}
-	PhidgetUnlock(phid);
 	loginfo("cleared %d packets", cnt);
 }
 
@@ -489,15 +1038,223 @@ dispatchErrorNotify(PhidgetHandle phid, int throwError, Phidget_LogLevel lvl, co
 	va_end(va);
 }
 
+/*
+ * Claims a slot on the outbound ring of phid for an entry of the given type.
+ *
+ * The entry must be filled in and then handed to insertDispatchEntry(), or returned with
+ * returnDispatchEntry().
+ */
+static PhidgetReturnCode
+getDispatchSlot(PhidgetHandle phid, dispatchtype_t type, DispatchEntryHandle *de) {
+	DispatchRingHandle ring;
+	DispatchSlot *slot;
+	uint32_t depth;
+	uint32_t pos;
+	uint32_t seq;
+
+	MOS_ASSERT(initialized == 1);
+
+	/*
+	 * Do not allow data events to be dispatched after we begin detaching the channel.
+	 * This is done so that upcalls are made with the ATTACHED flag set which allows property
+	 * gets to succeed.
+	 */
+	if (type > DE_NOT_DETACHING &&
+	  (PhidgetCKFlagsNoLock(phid, PHIDGET_DETACHING_FLAG) ||
+	  !PhidgetCKFlagsNoLock(phid, PHIDGET_ATTACHED_FLAG | PHIDGET_ATTACHING_FLAG))) {
+		logwarn("%"PRIphid": dropping dispatch as channel is not attached or detaching", phid);
+		clearPhidgetDispatchOut(phid);
+		return (EPHIDGET_NOTATTACHED);
+	}
+
+	ring = getDispatchRing(phid);
+
+	/*
+	 * At the soft limit, only allow some event types to be thrown away
+	 */
+	depth = DISPATCHRING_DEPTH(ring);
+	if (type > DE_THROW_AWAY && depth >= DISPATCHENTRY_PHID_OSOFTMAX) {
+		dispatchErrorNotify(phid, ring->softErrorThrown ? PFALSE : PTRUE, PHIDGET_LOG_WARNING,
+			"%"PRIphid": Event queue is full; dropping event(s). Make sure data event handlers are fast and non-blocking, or reduce data rate.", phid);
+		ring->softErrorThrown = 1;
+		/*
+		 * If this happens on the server while trying to send to a client, clear the dispatch
+		 * queue as we are falling behind and this will not get better..
+		 */
+		if (PhidgetCKFlags(phid, PHIDGET_OPENBYNETCLIENT_FLAG)) {
+			logwarn("throwing away outbound data events");
+			clearPhidgetDispatchOut(phid);
+		}
+		return (EPHIDGET_NOSPC);
+	} else if (ring->softErrorThrown && depth < (DISPATCHENTRY_PHID_OSOFTMAX - 5)) {
+		// Don't clear the soft error flag until we have >= 5 free space in the dispatch queue
+		ring->softErrorThrown = 0;
+	}
+
+	pos = mos_atomic_get_32(&ring->tail);
+	for (;;) {
+		slot = &ring->slots[pos & DISPATCHRING_MASK];
+		seq = mos_atomic_get_32(&slot->seq);
+		if (seq == pos) {
+			if (mos_atomic_cas_32(&ring->tail, pos, pos + 1) == pos)
+				break;
+		} else if ((int32_t)(seq - pos) < 0) {
+			/*
+			 * At the hard limit we assume something is wrong, so stop queuing entries.
+			 */
+			dispatchErrorNotify(phid, PTRUE, PHIDGET_LOG_ERROR,
+				"%"PRIphid": Event queue is full (hard); dropping entry (type=%d). Make sure data event handlers are fast and non-blocking, or reduce data rate.", phid, type);
+			incPhidgetStat("dispatch.ring_full");
+			return (EPHIDGET_NOSPC);
+		}
+		pos = mos_atomic_get_32(&ring->tail);
+	}
+
+	depth = pos + 1 - mos_atomic_get_32(&ring->head);
+	if (depth > ring->max)
+		ring->max = depth;
+
+	*de = &slot->de;
+	(*de)->type = type;
+	(*de)->flags = DISPATCHENTRY_RING;
+
+	return (EPHIDGET_OK);
+}
+
+/*
+ * Value events: a newer packet supersedes an older one of the same type.
+ *
+ * Edge events (digital input state, errors, tags, ...), and packets that carry a change relative to
+ * the previous packet, must all be delivered and are never coalesced.
+ */
+int
+bridgePacketCoalescable(PhidgetChannelHandle channel, BridgePacket *bp) {
+
+	switch (bp->vpkt) {
+	case BP_ACCELERATIONCHANGE:
+	case BP_ANGULARRATEUPDATE:
+	case BP_BACKEMFCHANGE:
+	case BP_BRAKINGSTRENGTHCHANGE:
+	case BP_CURRENTCHANGE:
+	case BP_DBCHANGE:
+	case BP_DISTANCECHANGE:
+	case BP_DUTYCYCLECHANGE:
+	case BP_FIELDSTRENGTHCHANGE:
+	case BP_FREQUENCYCHANGE:
+	case BP_HEADINGCHANGE:
+	case BP_HUMIDITYCHANGE:
+	case BP_ILLUMINANCECHANGE:
+	case BP_INDUCTANCECHANGE:
+	case BP_PHCHANGE:
+	case BP_PRESSURECHANGE:
+	case BP_RESISTANCECHANGE:
+	case BP_SENSORCHANGE:
+	case BP_SONARUPDATE:
+	case BP_SPATIALALGDATA:
+	case BP_SPATIALDATA:
+	case BP_TEMPERATURECHANGE:
+	case BP_TOUCHINPUTVALUECHANGE:
+	case BP_VELOCITYCHANGE:
+	case BP_VOLTAGECHANGE:
+	case BP_VOLTAGERATIOCHANGE:
+		return (1);
+	case BP_POSITIONCHANGE:
+		/* encoder position changes are relative */
+		return (channel->class != PHIDCHCLASS_ENCODER);
+	default:
+		return (0);
+	}
+}
+
+static DispatchLatest *
+getDispatchLatest(DispatchRingHandle ring, uint32_t vpkt) {
+	uint32_t cur;
+	int i;
+
+	for (i = 0; i < DISPATCHRING_LATEST; i++) {
+		cur = mos_atomic_get_32(&ring->latest[i].vpkt);
+		if (cur == 0)
+			cur = mos_atomic_cas_32(&ring->latest[i].vpkt, 0, vpkt);
+		if (cur == 0 || cur == vpkt)
+			return (&ring->latest[i]);
+	}
+
+	return (NULL);	/* out of cells: queue normally */
+}
+
+/*
+ * Stores bp as the latest value of its type if the channel coalesces value events.
+ *
+ * Returns NULL if bp must be queued as usual.  Otherwise bp belongs to the returned cell, and
+ * *queued is set if an entry for the cell is already waiting: the caller must queue an entry for the
+ * cell if it is not.
+ */
+static DispatchLatest *
+coalesceBridgePacket(PhidgetChannelHandle channel, BridgePacket *bp, int *queued) {
+	DispatchLatest *latest;
+	BridgePacket *old;
+
+	if (!PhidgetCKFlagsNoLock(channel, PHIDGET_COALESCE_FLAG) || !bridgePacketCoalescable(channel, bp))
+		return (NULL);
+
+	latest = getDispatchLatest(getDispatchRing((PhidgetHandle)channel), bp->vpkt);
+	if (latest == NULL)
+		return (NULL);
+
+	old = mos_atomic_swap_ptr((void **)&latest->bp, bp);
+	*queued = (old != NULL);
+	if (old != NULL) {
+		destroyBridgePacket(&old);
+		incPhidgetStat("dispatch.coalesced");
+	}
+
+	return (latest);
+}
+
+/*
+ * The entry for a cell could not be queued: take back whatever value is in the cell so that the next
+ * value queues a new entry.
+ */
+static void
+uncoalesceBridgePacket(DispatchLatest *latest) {
+	BridgePacket *bp;
+
+	bp = mos_atomic_swap_ptr((void **)&latest->bp, NULL);
+	if (bp != NULL)
+		destroyBridgePacket(&bp);
+}
+
+static PhidgetReturnCode
+insertDispatchRing(PhidgetHandle phid, DispatchEntryHandle de) {
+	DispatchRingHandle ring;
+
+	ring = phid->dispatchOutHandle;
+	publishDispatchSlot(de);
+
+	/*
+	 * Only the producer that moves the ring from idle to scheduled has to queue the phid and wake a
+	 * dispatcher: anybody else is covered by the dispatcher that will drain the ring.
+	 */
+	if (mos_atomic_cas_32(&ring->scheduled, 0, 1) != 0)
+		return (EPHIDGET_OK);
+
+	PhidgetRetain(phid);
+	scheduleDispatch(phid, 1);
+
+	return (EPHIDGET_OK);
+}
+
 /*
  * Always returns the dispatch entry: even in the case of error.
  * Callers must realize that the payload cannot be referenced after this call returns.
  */
 static PhidgetReturnCode
 insertDispatchEntry(PhidgetHandle phid, DispatchEntryHandle de) {
-	uint16_t soft, hard;
 	DispatchHandle dph;
 
+	if (de->flags & DISPATCHENTRY_RING)
+		return (insertDispatchRing(phid, de));
+
 #ifndef NDEBUG
 	/*
 	 * If NORETURN is set, WAITING must also be set.
@@ -509,60 +1266,25 @@ insertDispatchEntry(PhidgetHandle phid, DispatchEntryHandle de) {
 	PhidgetLock(phid);
 
 	/*
-	 * Do not allow data events to be dispatched after we begin detaching the channel.
-	 * This is done so that upcalls are made with the ATTACHED flag set which allows property
-	 * gets to succeed.
+	 * Do not allow data events to be dispatched after we begin detaching the channel.
 	 */
 	if (de->type > DE_NOT_DETACHING && (_ISDETACHING(phid) || !_ISATTACHEDORATTACHING(phid))) {
 		PhidgetUnlock(phid);
 		logwarn("%"PRIphid": dropping dispatch as channel is not attached or detaching", phid);
-		clearPhidgetDispatchOut(phid, 1);
+		clearPhidgetDispatchOut(phid);
 		returnDispatchEntry(de); /* releases the reference passed to us */
 		return (EPHIDGET_NOTATTACHED);
 	}
 
-	if (OUTBOUND(de)) {
-		soft = DISPATCHENTRY_PHID_OSOFTMAX;
-		hard = DISPATCHENTRY_PHID_OHARDMAX;
-	} else {
-		soft = hard = DISPATCHENTRY_PHID_IMAX;
-	}
-	dph = getDispatchHandle(phid, OUTBOUND(de));
-
-	/*
-	 * At the soft limit, only allow some event types to be thrown away
-	 */
-	if (de->type > DE_THROW_AWAY && dph->count >= soft) {
-		PhidgetUnlock(phid);
-		dispatchErrorNotify(phid, dph->softErrorThrown ? PFALSE : PTRUE, PHIDGET_LOG_WARNING,
-			"%"PRIphid": Event queue is full; dropping event(s). Make sure data event handlers are fast and non-blocking, or reduce data rate.", phid);
-		returnDispatchEntry(de);
-		dph->softErrorThrown = 1;
-		/*
-		 * If this happens on the server while trying to send to a client, clear the dispatch
-		 * queue as we are falling behind and this will not get better..
-		 */
-		if (PhidgetCKFlags(phid, PHIDGET_OPENBYNETCLIENT_FLAG)) {
-			logwarn("throwing away outbound data events");
-			clearPhidgetDispatchOut(phid, 1);
-		}
-		return (EPHIDGET_NOSPC);
-	} else if (dph->softErrorThrown && dph->count < (soft - 5)) {
-		// Don't clear the soft error flag until we have >= 5 free space in the dispatch queue
-		dph->softErrorThrown = 0;
-	}
+	dph = getDispatchHandle(phid);
 
 	/*
-	 * At the hard limit we assume something is wrong, so stop queuing entries.
+	 * At the limit we assume something is wrong, so stop queuing entries.
 	 */
-	if (dph->count > hard) {
+	if (dph->count > DISPATCHENTRY_PHID_IMAX) {
 		PhidgetUnlock(phid);
-		if (OUTBOUND(de))
-			dispatchErrorNotify(phid, PTRUE, PHIDGET_LOG_ERROR,
-				"%"PRIphid": Event queue is full (hard); dropping entry (type=%d). Make sure data event handlers are fast and non-blocking, or reduce data rate.", phid, de->type);
-		else
-			dispatchErrorNotify(phid, PTRUE, PHIDGET_LOG_ERROR,
-				"%"PRIphid": Command queue is full; dropping entry (type=%d). If sending commands from multiple threads or using async sets, make sure that total pending commands is less than %d.", phid, de->type, hard);
+		dispatchErrorNotify(phid, PTRUE, PHIDGET_LOG_ERROR,
+			"%"PRIphid": Command queue is full; dropping entry (type=%d). If sending commands from multiple threads or using async sets, make sure that total pending commands is less than %d.", phid, de->type, DISPATCHENTRY_PHID_IMAX);
 		returnDispatchEntry(de);
 		return (EPHIDGET_NOSPC);
 	}
@@ -574,26 +1296,11 @@ insertDispatchEntry(PhidgetHandle phid, DispatchEntryHandle de) {
 
 	PhidgetUnlock(phid);
 
-	if (OUTBOUND(de)) {
-		if (PhidgetCKandSetFlags(phid, PHIDGET_DISPATCHOUT_FLAG) == EPHIDGET_OK) {
-			PhidgetRetain(phid);
-			mos_fasttlock_lock(&dispatchLock);
-			MTAILQ_INSERT_TAIL(&dispatchOutList, phid, dispatchOutLink);
-			dispatchOutListCount++;
-			mos_fasttlock_unlock(&dispatchLock);
-		}
-	} else {
-		if (PhidgetCKandSetFlags(phid, PHIDGET_DISPATCHIN_FLAG) == EPHIDGET_OK) {
-			PhidgetRetain(phid);
-			mos_fasttlock_lock(&dispatchLock);
-			MTAILQ_INSERT_TAIL(&dispatchInList, phid, dispatchInLink);
-			dispatchInListCount++;
-			mos_fasttlock_unlock(&dispatchLock);
-		}
+	if (PhidgetCKandSetFlags(phid, PHIDGET_DISPATCHIN_FLAG) == EPHIDGET_OK) {
+		PhidgetRetain(phid);
+		scheduleDispatch(phid, 0);
 	}
 
-	entryDispatched();
-
 	return (EPHIDGET_OK);
 }
 
@@ -605,11 +1312,10 @@ dispatchUserRequestCallback(PhidgetChannelHandle ch, Phidget_AsyncCallback cb, v
 
 	MOS_ASSERT(cb != NULL);
 
-	res = getDispatchEntry(&de);
+	res = getDispatchSlot((PhidgetHandle)ch, DE_USERREQCALLBACK, &de);
 	if (res != EPHIDGET_OK)
 		return (res);
 
-	de->type = DE_USERREQCALLBACK;
 	PhidgetRetain(ch);
 	de->de_ureq.channel = ch;
 	de->de_ureq.cb = cb;
@@ -621,9 +1327,11 @@ dispatchUserRequestCallback(PhidgetChannelHandle ch, Phidget_AsyncCallback cb, v
 
 PhidgetReturnCode
 dispatchUserRequest(PhidgetChannelHandle ch, BridgePacket *bp, Phidget_AsyncCallback cb, void *ctx) {
+	DispatcherHandle self;
 	DispatchEntryHandle de;
 	PhidgetReturnCode res;
 	mostime_t tm;
+	int helped;
 
 	res = getDispatchEntry(&de);
 	if (res != EPHIDGET_OK)
@@ -652,10 +1360,24 @@ dispatchUserRequest(PhidgetChannelHandle ch, BridgePacket *bp, Phidget_AsyncCall
 		return (res);
 
 	if (cb == NULL) {
+		/*
+		 * When called from an event handler, the dispatcher runs inbound requests while it waits:
+		 * otherwise the pool could deadlock with every dispatcher waiting on a request.
+		 */
+		self = currentDispatcher();
 		tm = mos_gettime_usec();
 		mos_mutex_lock(&de->lock);
 		while (de->flags & DISPATCHENTRY_WAITING) {
-			mos_cond_timedwait(&de->cond, &de->lock, MOS_SEC /* nsec */);
+			if (self != NULL) {
+				mos_mutex_unlock(&de->lock);
+				helped = helpDispatch(self);
+				mos_mutex_lock(&de->lock);
+				if (helped)
+					continue;
+				if ((de->flags & DISPATCHENTRY_WAITING) == 0)
+					break;
+			}
+			mos_cond_timedwait(&de->cond, &de->lock, self ? DISPATCH_HELP_WAIT : MOS_SEC /* nsec */);
 			/*
 			 * A timeout should not occur, but if it does de will probably get leaked.
 			 * The only way this can happen is if the entry has not been dispatched for some reason (bug),
@@ -695,11 +1417,10 @@ dispatchChannelAttach(PhidgetChannelHandle channel) {
 
 	TESTPTR(channel);
 
-	res = getDispatchEntry(&de);
+	res = getDispatchSlot((PhidgetHandle)channel, DE_CHANNEL_ATTACH, &de);
 	if (res != EPHIDGET_OK)
 		return (res);
 
-	de->type = DE_CHANNEL_ATTACH;
 	de->de_channel = channel;
 	PhidgetRetain(channel);
 	return (insertDispatchEntry((PhidgetHandle)channel, de));
@@ -712,11 +1433,10 @@ dispatchChannelInitialEvents(PhidgetChannelHandle channel) {
 
 	TESTPTR(channel);
 
-	res = getDispatchEntry(&de);
+	res = getDispatchSlot((PhidgetHandle)channel, DE_CHANNEL_INITEVENTS, &de);
 	if (res != EPHIDGET_OK)
 		return (res);
 
-	de->type = DE_CHANNEL_INITEVENTS;
 	de->de_channel = channel;
 	PhidgetRetain(channel);
 	return (insertDispatchEntry((PhidgetHandle)channel, de));
@@ -730,11 +1450,10 @@ dispatchChannelSetStatus(PhidgetChannelHandle channel) {
 
 	TESTPTR(channel);
 
-	res = getDispatchEntry(&de);
+	res = getDispatchSlot((PhidgetHandle)channel, DE_CHANNEL_SETSTATUS, &de);
 	if (res != EPHIDGET_OK)
 		return (res);
 
-	de->type = DE_CHANNEL_SETSTATUS;
 	de->de_channel = channel;
 	PhidgetRetain(channel);
 	return (insertDispatchEntry((PhidgetHandle)channel, de));
@@ -747,11 +1466,10 @@ dispatchChannelDetach(PhidgetChannelHandle channel) {
 
 	TESTPTR(channel);
 
-	res = getDispatchEntry(&de);
+	res = getDispatchSlot((PhidgetHandle)channel, DE_CHANNEL_DETACH, &de);
 	if (res != EPHIDGET_OK)
 		return (res);
 
-	de->type = DE_CHANNEL_DETACH;
 	de->de_channel = channel;
 	PhidgetRetain(channel);
 	return (insertDispatchEntry((PhidgetHandle)channel, de));
@@ -765,21 +1483,36 @@ dispatchChannelBridgePacket(PhidgetChannelHandle channel, BridgePacket *bp) {
 	DispatchEntryHandle de;
 	PhidgetReturnCode res;
 
+	DispatchLatest *latest;
+	int queued;
+
 	TESTPTR(channel);
 	TESTPTR(bp);
 
-	res = getDispatchEntry(&de);
-	if (res != EPHIDGET_OK) {
-		destroyBridgePacket(&bp);
-		return (res);
-	}
-
 	// NOTE: We got a non-error bridge packet from the local device - clear the error to ensure that the next error we see is reported right away.
 	if (bp->vpkt != BP_ERROREVENT && !bridgePacketIsFromNet(bp))
 		PhidgetChannel_clearErrorEvent(channel);
 
-	de->type = DE_CHANNEL_BRIDGEPKT;
-	de->de_bp = bp;
+	latest = coalesceBridgePacket(channel, bp, &queued);
+	if (latest != NULL && queued)
+		return (EPHIDGET_OK);
+
+	res = getDispatchSlot((PhidgetHandle)channel, DE_CHANNEL_BRIDGEPKT, &de);
+	if (res != EPHIDGET_OK) {
+		if (latest != NULL)
+			uncoalesceBridgePacket(latest);
+		else
+			destroyBridgePacket(&bp);
+		return (res);
+	}
+
+	if (latest != NULL) {
+		de->flags |= DISPATCHENTRY_LATEST;
+		de->de_bpe.bp = NULL;
+		de->de_bpe.latest = latest;
+	} else {
+		de->de_bp = bp;
+	}
 	return (insertDispatchEntry((PhidgetHandle)channel, de));
 }
 
@@ -790,11 +1523,10 @@ dispatchDeviceAttach(PhidgetDeviceHandle device) {
 
 	TESTPTR(device);
 
-	res = getDispatchEntry(&de);
+	res = getDispatchSlot((PhidgetHandle)device, DE_DEVICE_ATTACH, &de);
 	if (res != EPHIDGET_OK)
 		return (res);
 
-	de->type = DE_DEVICE_ATTACH;
 	de->de_device = device;
 	PhidgetRetain(device);
 	return (insertDispatchEntry((PhidgetHandle)device, de));
@@ -807,11 +1539,10 @@ dispatchDeviceDetach(PhidgetDeviceHandle device) {
 
 	TESTPTR(device);
 
-	res = getDispatchEntry(&de);
+	res = getDispatchSlot((PhidgetHandle)device, DE_DEVICE_DETACH, &de);
 	if (res != EPHIDGET_OK)
 		return (res);
 
-	de->type = DE_DEVICE_DETACH;
 	de->de_device = device;
 	PhidgetRetain(device);
 	return (insertDispatchEntry((PhidgetHandle)device, de));
@@ -824,11 +1555,10 @@ dispatchManagerAttach(PhidgetManagerHandle manager) {
 
 	TESTPTR(manager);
 
-	res = getDispatchEntry(&de);
+	res = getDispatchSlot((PhidgetHandle)manager, DE_MGR_ATTACH, &de);
 	if (res != EPHIDGET_OK)
 		return (res);
 
-	de->type = DE_MGR_ATTACH;
 	de->de_manager = manager;
 	PhidgetRetain(manager);
 	return (insertDispatchEntry((PhidgetHandle)manager, de));
@@ -843,11 +1573,10 @@ dispatchManagerAttachChannel(PhidgetManagerHandle manager, PhidgetChannelHandle
 
 	TESTPTR(manager);
 
-	res = getDispatchEntry(&de);
+	res = getDispatchSlot((PhidgetHandle)manager, DE_MGR_ATTACHCH, &de);
 	if (res != EPHIDGET_OK)
 		return (res);
 
-	de->type = DE_MGR_ATTACHCH;
 	de->de_channel = channel;
 	PhidgetRetain(channel);
 	return (insertDispatchEntry((PhidgetHandle)manager, de));
@@ -862,11 +1591,10 @@ dispatchManagerDetachChannel(PhidgetManagerHandle manager, PhidgetChannelHandle
 
 	TESTPTR(manager);
 
-	res = getDispatchEntry(&de);
+	res = getDispatchSlot((PhidgetHandle)manager, DE_MGR_DETACHCH, &de);
 	if (res != EPHIDGET_OK)
 		return (res);
 
-	de->type = DE_MGR_DETACHCH;
 	de->de_channel = channel;
 	PhidgetRetain(channel);
 	return (insertDispatchEntry((PhidgetHandle)manager, de));
@@ -879,11 +1607,13 @@ static PhidgetReturnCode
 _dispatchBridgePacket(mosiop_t iop, PhidgetNetConnHandle nc, int server, BridgePacket *bp, int forward,
   int reqseq) {
 	PhidgetChannelHandle channel;
+	DispatchLatest *latest;
 	PhidgetDeviceHandle phid;
 	DispatchEntryHandle de;
 	PhidgetReturnCode res;
 	uint64_t ocid;
 	uint64_t pid;
+	int queued;
 	int chidx;
 
 	TESTPTR(nc);
@@ -899,12 +1629,6 @@ _dispatchBridgePacket(mosiop_t iop, PhidgetNetConnHandle nc, int server, BridgeP
 		return (MOS_ERROR(iop, EPHIDGET_INVALIDARG, "invalid channel index:%d", chidx));
 	}
 
-	res = getDispatchEntry(&de);
-	if (res != EPHIDGET_OK) {
-		destroyBridgePacket(&bp);
-		return (MOS_ERROR(iop, res, "failed to get dispatch entry"));
-	}
-
 	/*
 	 * On the client, we should have been given the open channel id.
 	 * On the server, we use the device and channel index.
@@ -913,7 +1637,6 @@ _dispatchBridgePacket(mosiop_t iop, PhidgetNetConnHandle nc, int server, BridgeP
 		channel = getChannelById(ocid);
 		if (channel == NULL) {
 			destroyBridgePacket(&bp);
-			returnDispatchEntry(de);
 			return (MOS_ERROR(iop, EPHIDGET_NOENT, "no such channel:%llu", ocid));
 		}
 		assert(isNetworkPhidget(channel));
@@ -921,7 +1644,6 @@ _dispatchBridgePacket(mosiop_t iop, PhidgetNetConnHandle nc, int server, BridgeP
 		phid = getDeviceById(pid);
 		if (phid == NULL) {
 			destroyBridgePacket(&bp);
-			returnDispatchEntry(de);
 			return (MOS_ERROR(iop, EPHIDGET_NOENT, "no such device in device list: 0x%llx", pid));
 		}
 
@@ -930,22 +1652,47 @@ _dispatchBridgePacket(mosiop_t iop, PhidgetNetConnHandle nc, int server, BridgeP
 
 		if (channel == NULL) {
 			destroyBridgePacket(&bp);
-			returnDispatchEntry(de);
 			return (MOS_ERROR(iop, EPHIDGET_NOENT, "no channel at index:%d", chidx));
 		}
 		assert(!isNetworkPhidget(channel));
 	}
 
-	if (server)
-		de->type = DE_SERVERBRIDGEPACKET;
-	else
-		de->type = DE_CLIENTBRIDGEPACKET;
+	/*
+	 * Commands from clients are inbound, events from the server are outbound.
+	 */
+	latest = NULL;
+	if (server) {
+		res = getDispatchEntry(&de);
+		if (res == EPHIDGET_OK) {
+			de->type = DE_SERVERBRIDGEPACKET;
+			de->flags |= DISPATCHENTRY_INBOUND;
+		}
+	} else {
+		if (bridgePacketIsEvent(bp)) {
+			latest = coalesceBridgePacket(channel, bp, &queued);
+			if (latest != NULL && queued) {
+				PhidgetRelease(&channel);
+				return (EPHIDGET_OK);
+			}
+		}
+		res = getDispatchSlot((PhidgetHandle)channel, DE_CLIENTBRIDGEPACKET, &de);
+	}
+	if (res != EPHIDGET_OK) {
+		PhidgetRelease(&channel);
+		if (latest != NULL)
+			uncoalesceBridgePacket(latest);
+		else
+			destroyBridgePacket(&bp);
+		return (MOS_ERROR(iop, res, "failed to get dispatch entry"));
+	}
 
 	PhidgetRetain(nc);
 
-	if (server)
-		de->flags |= DISPATCHENTRY_INBOUND;
-
+	if (latest != NULL) {
+		de->flags |= DISPATCHENTRY_LATEST;
+		de->de_bpe.latest = latest;
+		bp = NULL;
+	}
 	de->de_bpe.bp = bp;
 	de->de_bpe.nc = nc;
 	de->de_bpe.forward = forward;
@@ -1267,54 +2014,73 @@ dispatchEntry(PhidgetHandle phid, DispatchEntryHandle de) {
 	MOS_PANIC("Not a supported phidget handle");
 }
 
-static MOS_TASK_RESULT
-PhidgetDispatcher(void *arg) {
+/*
+ * Drains the inbound or outbound queue of phid, and releases the reference taken from the list.
+ *
+ * manual is set when called from Phidget_drainEvents(), which may limit the number of entries run
+ * with max (0 for no limit).  If the outbound queue is not empty when we stop, the phid stays
+ * scheduled and is queued again.  Returns the number of entries run.
+ */
+static uint32_t
+runDispatch(PhidgetHandle phid, int out, int manual, uint32_t max) {
+	DispatchRingHandle ring;
 	DispatchEntryHandle de;
-	PhidgetHandle phid;
 	DispatchHandle dph;
+	uint32_t cnt;
+	int scheduled;
 	int returnde;
-	int out;
+	int requeue;
 
-	mos_task_setname("Phidget22 Dispatcher Thread");
-	logdebug("dispatcher thread started: 0x%08x", mos_self());
-
-	mos_fasttlock_lock(&dispatchLock);
-	while (dispatchTaskNeeded()) {
-
-		/*
-		 * Threads will handle dispatches from the user first, and to the user second.
-		 */
-		out = 0;
-		phid = getDispatchInPhidget();
-		if (phid == NULL) {
-			phid = getDispatchOutPhidget();
-			if (phid == NULL) {
-				mos_fasttlock_wait(&dispatchCond, &dispatchLock);
-				continue;
-			}
+	incPhidgetStat("dispatch.dispatchers_running");
 
-			out = 1;	/* handle the outbound queue */
-		}
+	displog("+dispatching %"PRIphid"", phid);
+	PhidgetLock(phid);
 
-		dispatchersRunning++;
-		mos_fasttlock_unlock(&dispatchLock);
+	ring = phid->dispatchOutHandle;
+	scheduled = out;
+	requeue = 0;
+	cnt = 0;
 
-		incPhidgetStat("dispatch.dispatchers_running");
+	for (;;) {
+		if (out) {
+			if (!(phid->__flags & PHIDGET_ATTACHED_FLAG) && !(phid->__flags & PHIDGET_DETACHING_FLAG)) {
+				break;
+			}
 
-		displog("+dispatching %"PRIphid"", phid);
-		PhidgetLock(phid);
+			/*
+			 * Moved between the dispatchers and manual drain (the channel finished attaching, or
+			 * the mode was changed), or hit the drain limit.
+			 */
+			if (manualDispatch(phid) != manual || (max != 0 && cnt >= max)) {
+				requeue = 1;
+				break;
+			}
 
-		for (;;) {
-			if (out) {
-				if (!(phid->__flags & PHIDGET_ATTACHED_FLAG) && !(phid->__flags & PHIDGET_DETACHING_FLAG)) {
-					break;
-				}
-			} else {
-				if (!(phid->__flags & PHIDGET_OPEN_FLAG))
+			de = popDispatchSlot(ring);
+			if (de == NULL) {
+				/*
+				 * Unschedule, then look again: a producer that published after we looked, but
+				 * still saw the ring as scheduled, is relying on us to deliver its entry.
+				 */
+				mos_atomic_swap_32(&ring->scheduled, 0);
+				scheduled = 0;
+				if (!dispatchRingReady(ring) || mos_atomic_cas_32(&ring->scheduled, 0, 1) != 0)
 					break;
+				scheduled = 1;
+				continue;
+			}
+
+			// Claimed by a producer that then failed, or a coalesced value already delivered: nothing to dispatch
+			if (de->type == DE_NOTHING || !takeDispatchLatest(de)) {
+				returnDispatchEntry(de);
+				continue;
 			}
+			returnde = 1;
+		} else {
+			if (!(phid->__flags & PHIDGET_OPEN_FLAG))
+				break;
 
-			dph = getDispatchHandle(phid, out);
+			dph = getDispatchHandle(phid);
 			de = MTAILQ_FIRST(&dph->list);
 			if (de == NULL)
 				break;
@@ -1329,37 +2095,117 @@ PhidgetDispatcher(void *arg) {
 			mos_mutex_lock(&de->lock);
 			returnde = (de->flags & DISPATCHENTRY_NORETURN) == 0;
 			mos_mutex_unlock(&de->lock);
-
-			phid->dispatchThread = mos_self();
-
-			PhidgetBroadcast(phid);
-			PhidgetUnlock(phid);
-			dispatchEntry(phid, de);
-			if (returnde)
-				returnDispatchEntry(de);
-			PhidgetLock(phid);
 		}
 
-		/* clear dispatch flag so it will be added to list */
-		if (out)
-			phid->__flags &= ~PHIDGET_DISPATCHOUT_FLAG;
-		else
-			phid->__flags &= ~PHIDGET_DISPATCHIN_FLAG;
+		phid->dispatchThread = mos_self();
 
 		PhidgetBroadcast(phid);
 		PhidgetUnlock(phid);
-		displog("-dispatching %"PRIphid"", phid);
+		dispatchEntry(phid, de);
+		if (returnde)
+			returnDispatchEntry(de);
+		cnt++;
+		PhidgetLock(phid);
+	}
+
+	/* clear dispatch flag so it will be added to list */
+	if (out) {
+		if (scheduled && !requeue)
+			mos_atomic_swap_32(&ring->scheduled, 0);
+	} else {
+		phid->__flags &= ~PHIDGET_DISPATCHIN_FLAG;
+	}
+
+	PhidgetBroadcast(phid);
+	PhidgetUnlock(phid);
+	displog("-dispatching %"PRIphid"", phid);
+	if (requeue)
+		scheduleDispatch(phid, 1);	/* still scheduled: the reference goes back on a list */
+	else
 		PhidgetRelease(&phid);
 
-		decPhidgetStat("dispatch.dispatchers_running");
-		mos_fasttlock_lock(&dispatchLock);
-		dispatchersRunning--;
+	decPhidgetStat("dispatch.dispatchers_running");
+	return (cnt);
+}
+
+/*
+ * Runs one phid with inbound requests, if there is one.
+ */
+static int
+helpDispatch(DispatcherHandle self) {
+	PhidgetHandle phid;
+	int out;
+
+	phid = findDispatchPhidget(self, 1, &out);
+	if (phid == NULL)
+		return (0);
+
+	runDispatch(phid, out, 0, 0);
+	return (1);
+}
+
+static MOS_TASK_RESULT
+PhidgetDispatcher(void *arg) {
+	DispatcherHandle self;
+	PhidgetHandle phid;
+	int res;
+	int out;
+
+	self = arg;
+	self->task = mos_self();
+
+	mos_task_setname("Phidget22 Dispatcher Thread %u", self->index);
+	logdebug("dispatcher thread %u started: 0x%08x", self->index, mos_self());
+
+	if (self->cpu >= 0) {
+		res = mos_task_setaffinity(self->cpu);
+		if (res != 0)
+			logwarn("failed to bind dispatcher %u to cpu %d: 0x%08x", self->index, self->cpu, res);
 	}
 
-	dispatchers--;
-	logdebug("dispatcher thread exiting: 0x%08x - dispatchers: %d", mos_self(), dispatchers);
-	decPhidgetStat("dispatch.dispatchers");
+	for (;;) {
+		phid = findDispatchPhidget(self, 0, &out);
+		if (phid == NULL) {
+			/*
+			 * Flag that we are idle, then look once more: anything queued after this point will
+			 * wake us.
+			 */
+			mos_mutex_lock(&self->lock);
+			self->waiting = 1;
+			self->wake = 0;
+			mos_mutex_unlock(&self->lock);
+			mos_atomic_add_32(&dispatchersIdle, 1);
+
+			phid = findDispatchPhidget(self, 0, &out);
+
+			mos_mutex_lock(&self->lock);
+			if (phid == NULL) {
+				if (self->stop) {
+					self->waiting = 0;
+					mos_mutex_unlock(&self->lock);
+					mos_atomic_add_32(&dispatchersIdle, -1);
+					break;
+				}
+				while (!self->wake && !self->stop)
+					mos_cond_wait(&self->cond, &self->lock);
+			}
+			self->waiting = 0;
+			mos_mutex_unlock(&self->lock);
+			mos_atomic_add_32(&dispatchersIdle, -1);
+
+			if (phid == NULL)
+				continue;
+		}
+
+		runDispatch(phid, out, 0, 0);
+	}
 
+	logdebug("dispatcher thread %u exiting: 0x%08x", self->index, mos_self());
+
+	mos_fasttlock_lock(&dispatchLock);
+	self->running = 0;
+	dispatchersRunning--;
+	decPhidgetStat("dispatch.dispatchers");
 	mos_cond_signal(&dispatchCond);
 	mos_fasttlock_unlock(&dispatchLock);
 
@@ -1435,12 +2281,126 @@ stopDispatch(PhidgetHandle phid, int sendEvents) {
 	}
 }
 
+/*
+ * Called when a phid becomes attached: any dispatcher may be holding it on a list.
+ */
 void
 wakeDispatch(void) {
+	DispatcherHandle d;
+	uint32_t i;
+
+	for (i = 0; i < mos_atomic_get_32(&dispatcherLists); i++) {
+		d = &dispatchers[i];
+		mos_mutex_lock(&d->lock);
+		d->wake = 1;
+		mos_cond_signal(&d->cond);
+		mos_mutex_unlock(&d->lock);
+	}
 
-	mos_fasttlock_lock(&dispatchLock);
-	mos_cond_signal(&dispatchCond);
-	mos_fasttlock_unlock(&dispatchLock);
+	if (mos_atomic_get_32(&dispatchManual))
+		signalEventFd();
+}
+
+/*
+ * Takes the next phid that can be run from the manual drain list.
+ */
+static PhidgetHandle
+getManualDispatchPhidget(void) {
+	PhidgetHandle tphid;
+	PhidgetHandle phid;
+
+	mos_mutex_lock(&dispatchManualLock);
+	MTAILQ_FOREACH_SAFE(phid, &dispatchManualList, dispatchOutLink, tphid) {
+		if (ISATTACHEDORDETACHING(phid)) {
+			MTAILQ_REMOVE(&dispatchManualList, phid, dispatchOutLink);
+			mos_mutex_unlock(&dispatchManualLock);
+			return (phid);
+		} else if (!ISOPEN(phid)) {
+			MTAILQ_REMOVE(&dispatchManualList, phid, dispatchOutLink);
+			mos_atomic_swap_32(&((DispatchRingHandle)phid->dispatchOutHandle)->scheduled, 0);
+		}
+	}
+	mos_mutex_unlock(&dispatchManualLock);
+
+	return (NULL);
+}
+
+API_PRETURN
+Phidget_setManualEventDrain(int manual) {
+	PhidgetHandle phid;
+
+	if (manual && dispatchEventFd < 0) {
+#ifdef _LINUX
+		mos_glock((void *)0);
+		if (dispatchEventFd < 0)
+			dispatchEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		mos_gunlock((void *)0);
+		if (dispatchEventFd < 0)
+			return (PHID_RETURN_ERRSTR(EPHIDGET_UNEXPECTED, "Failed to create event fd: %d", errno));
+#else
+		return (PHID_RETURN_ERRSTR(EPHIDGET_UNSUPPORTED, "Manual event drain is not supported on this platform."));
+#endif
+	}
+
+	mos_atomic_swap_32(&dispatchManual, manual ? 1 : 0);
+	if (manual)
+		return (EPHIDGET_OK);
+
+	/*
+	 * Hand anything that was waiting to be drained to the dispatchers.
+	 */
+	mos_mutex_lock(&dispatchManualLock);
+	while ((phid = MTAILQ_FIRST(&dispatchManualList)) != NULL) {
+		MTAILQ_REMOVE(&dispatchManualList, phid, dispatchOutLink);
+		mos_mutex_unlock(&dispatchManualLock);
+		scheduleDispatch(phid, 1);
+		mos_mutex_lock(&dispatchManualLock);
+	}
+	mos_mutex_unlock(&dispatchManualLock);
+
+	return (EPHIDGET_OK);
+}
+
+API_PRETURN
+Phidget_getEventFd(int *fd) {
+
+	TESTPTR_PR(fd);
+
+	if (mos_atomic_get_32(&dispatchManual) == 0 || dispatchEventFd < 0)
+		return (PHID_RETURN_ERRSTR(EPHIDGET_UNSUPPORTED, "Manual event drain is not enabled."));
+
+	*fd = dispatchEventFd;
+	return (EPHIDGET_OK);
+}
+
+/*
+ * Runs up to max (0 for all) pending events on the calling thread.
+ */
+API_PRETURN
+Phidget_drainEvents(uint32_t max, uint32_t *count) {
+	PhidgetHandle phid;
+	uint32_t cnt;
+
+	if (mos_atomic_get_32(&dispatchManual) == 0)
+		return (PHID_RETURN_ERRSTR(EPHIDGET_UNSUPPORTED, "Manual event drain is not enabled."));
+
+	/*
+	 * Reset before draining: anything queued from here on signals the fd again.
+	 */
+	clearEventFd();
+
+	cnt = 0;
+	while (max == 0 || cnt < max) {
+		phid = getManualDispatchPhidget();
+		if (phid == NULL)
+			break;
+		cnt += runDispatch(phid, 1, 1, max == 0 ? 0 : max - cnt);
+	}
+
+	if (count != NULL)
+		*count = cnt;
+
+	return (EPHIDGET_OK);
 }
 
 void
@@ -1449,26 +2409,12 @@ clearPhidgetDispatch(PhidgetHandle phid) {
 	DispatchEntryHandle de;
 	DispatchHandle dph;
 
+	clearPhidgetDispatchOut(phid);
+
 	PhidgetLock(phid);
 
 	channel = PhidgetChannelCast(phid);
 
-	if (phid->dispatchOutHandle != NULL) {
-		dph = phid->dispatchOutHandle;
-
-		for (;;) {
-			de = MTAILQ_FIRST(&dph->list);
-			if (de == NULL)
-				break;
-			MTAILQ_REMOVE(&dph->list, de, link);
-			MOS_ASSERT(dph->count > 0);
-			dph->count--;
-			PhidgetUnlock(phid);
-			returnDispatchEntry(de);
-			PhidgetLock(phid);
-		}
-	}
-
 	if (phid->dispatchInHandle != NULL) {
 		dph = phid->dispatchInHandle;
 
@@ -1507,10 +2453,17 @@ clearPhidgetDispatch(PhidgetHandle phid) {
 
 void
 freeDispatchHandle(PhidgetHandle phid) {
+	DispatchRingHandle ring;
+	int i;
 
 	PhidgetLock(phid);
 	if (phid->dispatchOutHandle) {
-		mos_free(phid->dispatchOutHandle, sizeof(Dispatch));
+		ring = phid->dispatchOutHandle;
+		for (i = 0; i < DISPATCHRING_LATEST; i++) {
+			if (ring->latest[i].bp != NULL)
+				destroyBridgePacket(&ring->latest[i].bp);
+		}
+		mos_free(phid->dispatchOutHandle, sizeof(DispatchRing));
 		phid->dispatchOutHandle = NULL;
 	}
 	if (phid->dispatchInHandle) {
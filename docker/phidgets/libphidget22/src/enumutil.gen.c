@@ -1,1637 +1,619 @@
 #include "phidgetbase.h"
 #include "phidget.h"
 
-API_IRETURN
-Phidget_enumFromString(const char *name) {
-
-	if (mos_strcasecmp(name, "ENCODER_IO_MODE_PUSH_PULL") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "ENCODER_IO_MODE_LINE_DRIVER_2K2") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "ENCODER_IO_MODE_LINE_DRIVER_10K") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "ENCODER_IO_MODE_OPEN_COLLECTOR_2K2") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "ENCODER_IO_MODE_OPEN_COLLECTOR_10K") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "EPHIDGET_OK") == 0)
-		return (0);
-
-	if (mos_strcasecmp(name, "EPHIDGET_HALLSENSOR") == 0)
-		return (64);
-
-	if (mos_strcasecmp(name, "EPHIDGET_NOENT") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "EPHIDGET_TIMEOUT") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "EPHIDGET_KEEPALIVE") == 0)
-		return (58);
-
-	if (mos_strcasecmp(name, "EPHIDGET_INTERRUPTED") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "EPHIDGET_IO") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "EPHIDGET_NOMEMORY") == 0)
-		return (6);
-
-	if (mos_strcasecmp(name, "EPHIDGET_ACCESS") == 0)
-		return (7);
-
-	if (mos_strcasecmp(name, "EPHIDGET_FAULT") == 0)
-		return (8);
-
-	if (mos_strcasecmp(name, "EPHIDGET_BUSY") == 0)
-		return (9);
-
-	if (mos_strcasecmp(name, "EPHIDGET_EXIST") == 0)
-		return (10);
-
-	if (mos_strcasecmp(name, "EPHIDGET_NOTDIR") == 0)
-		return (11);
-
-	if (mos_strcasecmp(name, "EPHIDGET_ISDIR") == 0)
-		return (12);
-
-	if (mos_strcasecmp(name, "EPHIDGET_INVALID") == 0)
-		return (13);
-
-	if (mos_strcasecmp(name, "EPHIDGET_NFILE") == 0)
-		return (14);
-
-	if (mos_strcasecmp(name, "EPHIDGET_MFILE") == 0)
-		return (15);
-
-	if (mos_strcasecmp(name, "EPHIDGET_NOSPC") == 0)
-		return (16);
-
-	if (mos_strcasecmp(name, "EPHIDGET_FBIG") == 0)
-		return (17);
-
-	if (mos_strcasecmp(name, "EPHIDGET_ROFS") == 0)
-		return (18);
-
-	if (mos_strcasecmp(name, "EPHIDGET_RO") == 0)
-		return (19);
-
-	if (mos_strcasecmp(name, "EPHIDGET_UNSUPPORTED") == 0)
-		return (20);
-
-	if (mos_strcasecmp(name, "EPHIDGET_INVALIDARG") == 0)
-		return (21);
-
-	if (mos_strcasecmp(name, "EPHIDGET_AGAIN") == 0)
-		return (22);
-
-	if (mos_strcasecmp(name, "EPHIDGET_NOTEMPTY") == 0)
-		return (26);
-
-	if (mos_strcasecmp(name, "EPHIDGET_PERM") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "EPHIDGET_DUPLICATE") == 0)
-		return (27);
-
-	if (mos_strcasecmp(name, "EPHIDGET_BADPASSWORD") == 0)
-		return (37);
-
-	if (mos_strcasecmp(name, "EPHIDGET_NETUNAVAIL") == 0)
-		return (45);
-
-	if (mos_strcasecmp(name, "EPHIDGET_CONNREF") == 0)
-		return (35);
-
-	if (mos_strcasecmp(name, "EPHIDGET_CONNRESET") == 0)
-		return (46);
-
-	if (mos_strcasecmp(name, "EPHIDGET_HOSTUNREACH") == 0)
-		return (48);
-
-	if (mos_strcasecmp(name, "EPHIDGET_NODEV") == 0)
-		return (40);
-
-	if (mos_strcasecmp(name, "EPHIDGET_WRONGDEVICE") == 0)
-		return (50);
-
-	if (mos_strcasecmp(name, "EPHIDGET_PIPE") == 0)
-		return (41);
-
-	if (mos_strcasecmp(name, "EPHIDGET_RESOLV") == 0)
-		return (44);
-
-	if (mos_strcasecmp(name, "EPHIDGET_UNKNOWNVAL") == 0)
-		return (51);
-
-	if (mos_strcasecmp(name, "EPHIDGET_NOTATTACHED") == 0)
-		return (52);
-
-	if (mos_strcasecmp(name, "EPHIDGET_INVALIDPACKET") == 0)
-		return (53);
-
-	if (mos_strcasecmp(name, "EPHIDGET_2BIG") == 0)
-		return (54);
-
-	if (mos_strcasecmp(name, "EPHIDGET_BADVERSION") == 0)
-		return (55);
-
-	if (mos_strcasecmp(name, "EPHIDGET_CLOSED") == 0)
-		return (56);
-
-	if (mos_strcasecmp(name, "EPHIDGET_NOTCONFIGURED") == 0)
-		return (57);
-
-	if (mos_strcasecmp(name, "EPHIDGET_EOF") == 0)
-		return (31);
-
-	if (mos_strcasecmp(name, "EPHIDGET_FAILSAFE") == 0)
-		return (59);
-
-	if (mos_strcasecmp(name, "EPHIDGET_UNKNOWNVALHIGH") == 0)
-		return (60);
-
-	if (mos_strcasecmp(name, "EPHIDGET_UNKNOWNVALLOW") == 0)
-		return (61);
-
-	if (mos_strcasecmp(name, "EPHIDGET_BADPOWER") == 0)
-		return (62);
-
-	if (mos_strcasecmp(name, "EPHIDGET_POWERCYCLE") == 0)
-		return (63);
-
-	if (mos_strcasecmp(name, "EPHIDGET_UNEXPECTED") == 0)
-		return (28);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_BADVERSION") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_ESTOP") == 0)
-		return (4117);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_NETWORK") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_DISPATCH") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_FAILURE") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_OK") == 0)
-		return (4096);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_OVERRUN") == 0)
-		return (4098);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_PACKETLOST") == 0)
-		return (4099);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_WRAP") == 0)
-		return (4100);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_OVERTEMP") == 0)
-		return (4101);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_OVERCURRENT") == 0)
-		return (4102);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_OUTOFRANGE") == 0)
-		return (4103);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_BUSY") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_SATURATION") == 0)
-		return (4105);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_OVERVOLTAGE") == 0)
-		return (4107);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_FAILSAFE") == 0)
-		return (4108);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_VOLTAGEERROR") == 0)
-		return (4109);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_ENERGYDUMP") == 0)
-		return (4110);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_MOTORSTALL") == 0)
-		return (4111);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_INVALIDSTATE") == 0)
-		return (4112);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_BADCONNECTION") == 0)
-		return (4113);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_OUTOFRANGEHIGH") == 0)
-		return (4114);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_OUTOFRANGELOW") == 0)
-		return (4115);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_FAULT") == 0)
-		return (4116);
-
-	if (mos_strcasecmp(name, "EEPHIDGET_BADPOWER") == 0)
-		return (4104);
-
-	if (mos_strcasecmp(name, "PHIDID_NOTHING") == 0)
-		return (0);
-
-	if (mos_strcasecmp(name, "PHIDID_UNKNOWN") == 0)
-		return (125);
-
-	if (mos_strcasecmp(name, "PHIDID_DIGITALINPUT_PORT") == 0)
-		return (95);
-
-	if (mos_strcasecmp(name, "PHIDID_DIGITALOUTPUT_PORT") == 0)
-		return (96);
-
-	if (mos_strcasecmp(name, "PHIDID_VOLTAGEINPUT_PORT") == 0)
-		return (97);
-
-	if (mos_strcasecmp(name, "PHIDID_VOLTAGERATIOINPUT_PORT") == 0)
-		return (98);
-
-	if (mos_strcasecmp(name, "PHIDID_DICTIONARY") == 0)
-		return (111);
-
-	if (mos_strcasecmp(name, "PHIDID_1000") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "PHIDID_1001") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "PHIDID_1002") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "PHIDID_1008") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "PHIDID_1010_1013_1018_1019") == 0)
-		return (6);
-
-	if (mos_strcasecmp(name, "PHIDID_1011") == 0)
-		return (7);
-
-	if (mos_strcasecmp(name, "PHIDID_1012") == 0)
-		return (8);
-
-	if (mos_strcasecmp(name, "PHIDID_1014") == 0)
-		return (9);
-
-	if (mos_strcasecmp(name, "PHIDID_1015") == 0)
-		return (10);
-
-	if (mos_strcasecmp(name, "PHIDID_1016") == 0)
-		return (11);
-
-	if (mos_strcasecmp(name, "PHIDID_1017") == 0)
-		return (12);
-
-	if (mos_strcasecmp(name, "PHIDID_1023") == 0)
-		return (13);
-
-	if (mos_strcasecmp(name, "PHIDID_1024") == 0)
-		return (14);
-
-	if (mos_strcasecmp(name, "PHIDID_1030") == 0)
-		return (15);
-
-	if (mos_strcasecmp(name, "PHIDID_1031") == 0)
-		return (16);
-
-	if (mos_strcasecmp(name, "PHIDID_1032") == 0)
-		return (17);
-
-	if (mos_strcasecmp(name, "PHIDID_1040") == 0)
-		return (18);
-
-	if (mos_strcasecmp(name, "PHIDID_1041") == 0)
-		return (19);
-
-	if (mos_strcasecmp(name, "PHIDID_1042") == 0)
-		return (20);
-
-	if (mos_strcasecmp(name, "PHIDID_1043") == 0)
-		return (21);
-
-	if (mos_strcasecmp(name, "PHIDID_1044") == 0)
-		return (22);
-
-	if (mos_strcasecmp(name, "PHIDID_1045") == 0)
-		return (23);
-
-	if (mos_strcasecmp(name, "PHIDID_1046") == 0)
-		return (24);
-
-	if (mos_strcasecmp(name, "PHIDID_1047") == 0)
-		return (25);
-
-	if (mos_strcasecmp(name, "PHIDID_1048") == 0)
-		return (26);
-
-	if (mos_strcasecmp(name, "PHIDID_1049") == 0)
-		return (27);
-
-	if (mos_strcasecmp(name, "PHIDID_1051") == 0)
-		return (28);
-
-	if (mos_strcasecmp(name, "PHIDID_1052") == 0)
-		return (29);
-
-	if (mos_strcasecmp(name, "PHIDID_1053") == 0)
-		return (30);
-
-	if (mos_strcasecmp(name, "PHIDID_1054") == 0)
-		return (31);
-
-	if (mos_strcasecmp(name, "PHIDID_1055") == 0)
-		return (32);
-
-	if (mos_strcasecmp(name, "PHIDID_1056") == 0)
-		return (33);
-
-	if (mos_strcasecmp(name, "PHIDID_1057") == 0)
-		return (34);
-
-	if (mos_strcasecmp(name, "PHIDID_1058") == 0)
-		return (35);
-
-	if (mos_strcasecmp(name, "PHIDID_1059") == 0)
-		return (36);
-
-	if (mos_strcasecmp(name, "PHIDID_1060") == 0)
-		return (37);
-
-	if (mos_strcasecmp(name, "PHIDID_1061") == 0)
-		return (38);
-
-	if (mos_strcasecmp(name, "PHIDID_1062") == 0)
-		return (39);
-
-	if (mos_strcasecmp(name, "PHIDID_1063") == 0)
-		return (40);
-
-	if (mos_strcasecmp(name, "PHIDID_1064") == 0)
-		return (41);
-
-	if (mos_strcasecmp(name, "PHIDID_1065") == 0)
-		return (42);
-
-	if (mos_strcasecmp(name, "PHIDID_1066") == 0)
-		return (43);
-
-	if (mos_strcasecmp(name, "PHIDID_1067") == 0)
-		return (44);
-
-	if (mos_strcasecmp(name, "PHIDID_1202_1203") == 0)
-		return (45);
-
-	if (mos_strcasecmp(name, "PHIDID_1204") == 0)
-		return (46);
-
-	if (mos_strcasecmp(name, "PHIDID_1215__1218") == 0)
-		return (47);
-
-	if (mos_strcasecmp(name, "PHIDID_1219__1222") == 0)
-		return (48);
-
-	if (mos_strcasecmp(name, "PHIDID_ADP1000") == 0)
-		return (49);
-
-	if (mos_strcasecmp(name, "PHIDID_DAQ1000") == 0)
-		return (51);
-
-	if (mos_strcasecmp(name, "PHIDID_DAQ1200") == 0)
-		return (52);
-
-	if (mos_strcasecmp(name, "PHIDID_DAQ1300") == 0)
-		return (53);
-
-	if (mos_strcasecmp(name, "PHIDID_DAQ1301") == 0)
-		return (54);
-
-	if (mos_strcasecmp(name, "PHIDID_DAQ1400") == 0)
-		return (55);
-
-	if (mos_strcasecmp(name, "PHIDID_DAQ1500") == 0)
-		return (56);
-
-	if (mos_strcasecmp(name, "PHIDID_DCC1000") == 0)
-		return (57);
-
-	if (mos_strcasecmp(name, "PHIDID_DCC1001") == 0)
-		return (110);
-
-	if (mos_strcasecmp(name, "PHIDID_DCC1002") == 0)
-		return (117);
-
-	if (mos_strcasecmp(name, "PHIDID_DCC1003") == 0)
-		return (120);
-
-	if (mos_strcasecmp(name, "PHIDID_DCC1100") == 0)
-		return (108);
-
-	if (mos_strcasecmp(name, "PHIDID_DST1000") == 0)
-		return (58);
-
-	if (mos_strcasecmp(name, "PHIDID_DST1001") == 0)
-		return (121);
-
-	if (mos_strcasecmp(name, "PHIDID_DST1002") == 0)
-		return (126);
-
-	if (mos_strcasecmp(name, "PHIDID_DST1200") == 0)
-		return (59);
-
-	if (mos_strcasecmp(name, "PHIDID_ENC1000") == 0)
-		return (60);
-
-	if (mos_strcasecmp(name, "PHIDID_FIRMWARE_UPGRADE_SPI") == 0)
-		return (104);
-
-	if (mos_strcasecmp(name, "PHIDID_FIRMWARE_UPGRADE_STM32F0") == 0)
-		return (102);
-
-	if (mos_strcasecmp(name, "PHIDID_FIRMWARE_UPGRADE_STM32F3") == 0)
-		return (145);
-
-	if (mos_strcasecmp(name, "PHIDID_FIRMWARE_UPGRADE_STM32G0") == 0)
-		return (143);
-
-	if (mos_strcasecmp(name, "PHIDID_FIRMWARE_UPGRADE_STM8S") == 0)
-		return (103);
-
-	if (mos_strcasecmp(name, "PHIDID_FIRMWARE_UPGRADE_USB") == 0)
-		return (101);
-
-	if (mos_strcasecmp(name, "PHIDID_HIN1000") == 0)
-		return (61);
-
-	if (mos_strcasecmp(name, "PHIDID_HIN1001") == 0)
-		return (62);
-
-	if (mos_strcasecmp(name, "PHIDID_HIN1100") == 0)
-		return (63);
-
-	if (mos_strcasecmp(name, "PHIDID_HIN1101") == 0)
-		return (109);
-
-	if (mos_strcasecmp(name, "PHIDID_HUB0000") == 0)
-		return (64);
-
-	if (mos_strcasecmp(name, "PHIDID_HUB0001") == 0)
-		return (142);
-
-	if (mos_strcasecmp(name, "PHIDID_HUB0004") == 0)
-		return (67);
-
-	if (mos_strcasecmp(name, "PHIDID_HUB5000") == 0)
-		return (123);
-
-	if (mos_strcasecmp(name, "PHIDID_HUM1000") == 0)
-		return (69);
-
-	if (mos_strcasecmp(name, "PHIDID_HUM1001") == 0)
-		return (127);
-
-	if (mos_strcasecmp(name, "PHIDID_HUM1100") == 0)
-		return (136);
-
-	if (mos_strcasecmp(name, "PHIDID_INTERFACEKIT_4_8_8") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "PHIDID_LCD1100") == 0)
-		return (70);
-
-	if (mos_strcasecmp(name, "PHIDID_LED1000") == 0)
-		return (71);
-
-	if (mos_strcasecmp(name, "PHIDID_LUX1000") == 0)
-		return (72);
-
-	if (mos_strcasecmp(name, "PHIDID_MOT0100") == 0)
-		return (146);
-
-	if (mos_strcasecmp(name, "PHIDID_MOT0109") == 0)
-		return (140);
-
-	if (mos_strcasecmp(name, "PHIDID_MOT0110") == 0)
-		return (141);
-
-	if (mos_strcasecmp(name, "PHIDID_MOT1100") == 0)
-		return (73);
-
-	if (mos_strcasecmp(name, "PHIDID_MOT1101") == 0)
-		return (74);
-
-	if (mos_strcasecmp(name, "PHIDID_MOT1102") == 0)
-		return (137);
-
-	if (mos_strcasecmp(name, "PHIDID_OUT1000") == 0)
-		return (75);
-
-	if (mos_strcasecmp(name, "PHIDID_OUT1001") == 0)
-		return (76);
-
-	if (mos_strcasecmp(name, "PHIDID_OUT1002") == 0)
-		return (77);
-
-	if (mos_strcasecmp(name, "PHIDID_OUT1100") == 0)
-		return (78);
-
-	if (mos_strcasecmp(name, "PHIDID_PRE1000") == 0)
-		return (79);
-
-	if (mos_strcasecmp(name, "PHIDID_RCC0004") == 0)
-		return (124);
-
-	if (mos_strcasecmp(name, "PHIDID_RCC1000") == 0)
-		return (80);
-
-	if (mos_strcasecmp(name, "PHIDID_REL1000") == 0)
-		return (81);
-
-	if (mos_strcasecmp(name, "PHIDID_REL1100") == 0)
-		return (82);
-
-	if (mos_strcasecmp(name, "PHIDID_REL1101") == 0)
-		return (83);
-
-	if (mos_strcasecmp(name, "PHIDID_SAF1000") == 0)
-		return (84);
-
-	if (mos_strcasecmp(name, "PHIDID_SND1000") == 0)
-		return (85);
-
-	if (mos_strcasecmp(name, "PHIDID_STC1000") == 0)
-		return (86);
-
-	if (mos_strcasecmp(name, "PHIDID_STC1001") == 0)
-		return (115);
-
-	if (mos_strcasecmp(name, "PHIDID_STC1002") == 0)
-		return (118);
-
-	if (mos_strcasecmp(name, "PHIDID_STC1003") == 0)
-		return (119);
-
-	if (mos_strcasecmp(name, "PHIDID_STC1005") == 0)
-		return (149);
-
-	if (mos_strcasecmp(name, "PHIDID_TMP1000") == 0)
-		return (87);
-
-	if (mos_strcasecmp(name, "PHIDID_TMP1100") == 0)
-		return (88);
-
-	if (mos_strcasecmp(name, "PHIDID_TMP1101") == 0)
-		return (89);
-
-	if (mos_strcasecmp(name, "PHIDID_TMP1200") == 0)
-		return (90);
-
-	if (mos_strcasecmp(name, "PHIDID_VCP1000") == 0)
-		return (92);
-
-	if (mos_strcasecmp(name, "PHIDID_VCP1001") == 0)
-		return (93);
-
-	if (mos_strcasecmp(name, "PHIDID_VCP1002") == 0)
-		return (94);
-
-	if (mos_strcasecmp(name, "PHIDID_VCP1100") == 0)
-		return (105);
-
-	if (mos_strcasecmp(name, "PHIDGET_LOG_CRITICAL") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "PHIDGET_LOG_ERROR") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "PHIDGET_LOG_WARNING") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "PHIDGET_LOG_INFO") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "PHIDGET_LOG_DEBUG") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "PHIDGET_LOG_VERBOSE") == 0)
-		return (6);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_NOTHING") == 0)
-		return (0);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_ACCELEROMETER") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_ADVANCEDSERVO") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_ANALOG") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_BRIDGE") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_DATAADAPTER") == 0)
-		return (25);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_DICTIONARY") == 0)
-		return (24);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_ENCODER") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_FIRMWAREUPGRADE") == 0)
-		return (23);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_FREQUENCYCOUNTER") == 0)
-		return (6);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_GENERIC") == 0)
-		return (22);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_GPS") == 0)
-		return (7);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_HUB") == 0)
-		return (8);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_INTERFACEKIT") == 0)
-		return (9);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_IR") == 0)
-		return (10);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_LED") == 0)
-		return (11);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_MESHDONGLE") == 0)
-		return (12);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_MOTORCONTROL") == 0)
-		return (13);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_PHSENSOR") == 0)
-		return (14);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_RFID") == 0)
-		return (15);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_SERVO") == 0)
-		return (16);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_SPATIAL") == 0)
-		return (17);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_STEPPER") == 0)
-		return (18);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_TEMPERATURESENSOR") == 0)
-		return (19);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_TEXTLCD") == 0)
-		return (20);
-
-	if (mos_strcasecmp(name, "PHIDCLASS_VINT") == 0)
-		return (21);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_NOTHING") == 0)
-		return (0);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_ACCELEROMETER") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_BLDCMOTOR") == 0)
-		return (35);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_CAPACITIVETOUCH") == 0)
-		return (14);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_CURRENTINPUT") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_CURRENTOUTPUT") == 0)
-		return (38);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_DATAADAPTER") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_DCMOTOR") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_DICTIONARY") == 0)
-		return (36);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_DIGITALINPUT") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_DIGITALOUTPUT") == 0)
-		return (6);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_DISTANCESENSOR") == 0)
-		return (7);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_ENCODER") == 0)
-		return (8);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_FIRMWAREUPGRADE") == 0)
-		return (32);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_FREQUENCYCOUNTER") == 0)
-		return (9);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_GENERIC") == 0)
-		return (33);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_GPS") == 0)
-		return (10);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_GYROSCOPE") == 0)
-		return (12);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_HUB") == 0)
-		return (13);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_HUMIDITYSENSOR") == 0)
-		return (15);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_IR") == 0)
-		return (16);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_LCD") == 0)
-		return (11);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_LIGHTSENSOR") == 0)
-		return (17);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_MAGNETOMETER") == 0)
-		return (18);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_MESHDONGLE") == 0)
-		return (19);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_MOTORPOSITIONCONTROLLER") == 0)
-		return (34);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_MOTORVELOCITYCONTROLLER") == 0)
-		return (39);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_PHSENSOR") == 0)
-		return (37);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_POWERGUARD") == 0)
-		return (20);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_PRESSURESENSOR") == 0)
-		return (21);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_RCSERVO") == 0)
-		return (22);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_RESISTANCEINPUT") == 0)
-		return (23);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_RFID") == 0)
-		return (24);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_SOUNDSENSOR") == 0)
-		return (25);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_SPATIAL") == 0)
-		return (26);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_STEPPER") == 0)
-		return (27);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_TEMPERATURESENSOR") == 0)
-		return (28);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_VOLTAGEINPUT") == 0)
-		return (29);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_VOLTAGEOUTPUT") == 0)
-		return (30);
-
-	if (mos_strcasecmp(name, "PHIDCHCLASS_VOLTAGERATIOINPUT") == 0)
-		return (31);
-
-	if (mos_strcasecmp(name, "PHIDCHSUBCLASS_NONE") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "PHIDCHSUBCLASS_DIGITALOUTPUT_DUTY_CYCLE") == 0)
-		return (16);
-
-	if (mos_strcasecmp(name, "PHIDCHSUBCLASS_DIGITALOUTPUT_FREQUENCY") == 0)
-		return (18);
-
-	if (mos_strcasecmp(name, "PHIDCHSUBCLASS_DIGITALOUTPUT_LED_DRIVER") == 0)
-		return (17);
-
-	if (mos_strcasecmp(name, "PHIDCHSUBCLASS_ENCODER_MODE_SETTABLE") == 0)
-		return (96);
-
-	if (mos_strcasecmp(name, "PHIDCHSUBCLASS_LCD_GRAPHIC") == 0)
-		return (80);
-
-	if (mos_strcasecmp(name, "PHIDCHSUBCLASS_LCD_TEXT") == 0)
-		return (81);
-
-	if (mos_strcasecmp(name, "PHIDCHSUBCLASS_SPATIAL_AHRS") == 0)
-		return (112);
-
-	if (mos_strcasecmp(name, "PHIDCHSUBCLASS_TEMPERATURESENSOR_RTD") == 0)
-		return (32);
-
-	if (mos_strcasecmp(name, "PHIDCHSUBCLASS_TEMPERATURESENSOR_THERMOCOUPLE") == 0)
-		return (33);
-
-	if (mos_strcasecmp(name, "PHIDCHSUBCLASS_VOLTAGEINPUT_SENSOR_PORT") == 0)
-		return (48);
-
-	if (mos_strcasecmp(name, "PHIDCHSUBCLASS_VOLTAGERATIOINPUT_BRIDGE") == 0)
-		return (65);
-
-	if (mos_strcasecmp(name, "PHIDCHSUBCLASS_VOLTAGERATIOINPUT_SENSOR_PORT") == 0)
-		return (64);
-
-	if (mos_strcasecmp(name, "MESHMODE_ROUTER") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "MESHMODE_SLEEPYENDDEVICE") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "POWER_SUPPLY_OFF") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "POWER_SUPPLY_12V") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "POWER_SUPPLY_24V") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "RTD_WIRE_SETUP_2WIRE") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "RTD_WIRE_SETUP_3WIRE") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "RTD_WIRE_SETUP_4WIRE") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "INPUT_MODE_NPN") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "INPUT_MODE_PNP") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "FAN_MODE_OFF") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "FAN_MODE_ON") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "FAN_MODE_AUTO") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "MOTOR_DRIVE_TYPE_COAST") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "MOTOR_DRIVE_TYPE_ACTIVE") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "MOTOR_POSITION_TYPE_ENCODER") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "MOTOR_POSITION_TYPE_HALL") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "SPATIAL_PRECISION_HYBRID") == 0)
-		return (0);
-
-	if (mos_strcasecmp(name, "SPATIAL_PRECISION_HIGH") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "SPATIAL_PRECISION_LOW") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_NONE") == 0)
-		return (0);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_WATT") == 0)
-		return (17);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_PERCENT") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_DECIBEL") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_MILLIMETER") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_CENTIMETER") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_METER") == 0)
-		return (6);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_GRAM") == 0)
-		return (7);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_KILOGRAM") == 0)
-		return (8);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_BOOLEAN") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_AMPERE") == 0)
-		return (10);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_KILOPASCAL") == 0)
-		return (11);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_VOLT") == 0)
-		return (12);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_DEGREE_CELCIUS") == 0)
-		return (13);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_LUX") == 0)
-		return (14);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_GAUSS") == 0)
-		return (15);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_PH") == 0)
-		return (16);
-
-	if (mos_strcasecmp(name, "PHIDUNIT_MILLIAMPERE") == 0)
-		return (9);
-
-	if (mos_strcasecmp(name, "PHIDGETSERVER_NONE") == 0)
-		return (0);
-
-	if (mos_strcasecmp(name, "PHIDGETSERVER_DEVICELISTENER") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "PHIDGETSERVER_DEVICE") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "PHIDGETSERVER_DEVICEREMOTE") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "PHIDGETSERVER_WWWLISTENER") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "PHIDGETSERVER_WWW") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "PHIDGETSERVER_WWWREMOTE") == 0)
-		return (6);
-
-	if (mos_strcasecmp(name, "PHIDGETSERVER_SBC") == 0)
-		return (7);
-
-	if (mos_strcasecmp(name, "BRIDGE_GAIN_1") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "BRIDGE_GAIN_2") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "BRIDGE_GAIN_4") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "BRIDGE_GAIN_8") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "BRIDGE_GAIN_16") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "BRIDGE_GAIN_32") == 0)
-		return (6);
-
-	if (mos_strcasecmp(name, "BRIDGE_GAIN_64") == 0)
-		return (7);
-
-	if (mos_strcasecmp(name, "BRIDGE_GAIN_128") == 0)
-		return (8);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_VOLTAGERATIO") == 0)
-		return (0);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3522") == 0)
-		return (35220);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1101_SHARP_2Y0A21") == 0)
-		return (11012);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1101_SHARP_2Y0A02") == 0)
-		return (11013);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1102") == 0)
-		return (11020);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1103") == 0)
-		return (11030);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1104") == 0)
-		return (11040);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1105") == 0)
-		return (11050);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1106") == 0)
-		return (11060);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1107") == 0)
-		return (11070);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1108") == 0)
-		return (11080);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1109") == 0)
-		return (11090);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1110") == 0)
-		return (11100);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1111") == 0)
-		return (11110);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1112") == 0)
-		return (11120);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1113") == 0)
-		return (11130);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1115") == 0)
-		return (11150);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1116") == 0)
-		return (11160);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1118_AC") == 0)
-		return (11181);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1118_DC") == 0)
-		return (11182);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1119_AC") == 0)
-		return (11191);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1119_DC") == 0)
-		return (11192);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1120") == 0)
-		return (11200);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1121") == 0)
-		return (11210);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1101_SHARP_2D120X") == 0)
-		return (11011);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1122_DC") == 0)
-		return (11222);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1124") == 0)
-		return (11240);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1125_HUMIDITY") == 0)
-		return (11251);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1125_TEMPERATURE") == 0)
-		return (11252);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1126") == 0)
-		return (11260);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1128") == 0)
-		return (11280);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1129") == 0)
-		return (11290);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1131") == 0)
-		return (11310);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1134") == 0)
-		return (11340);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1136") == 0)
-		return (11360);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1137") == 0)
-		return (11370);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1138") == 0)
-		return (11380);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1139") == 0)
-		return (11390);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1140") == 0)
-		return (11400);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1141") == 0)
-		return (11410);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1146") == 0)
-		return (11460);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3120") == 0)
-		return (31200);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3121") == 0)
-		return (31210);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3122") == 0)
-		return (31220);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3123") == 0)
-		return (31230);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3130") == 0)
-		return (31300);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3520") == 0)
-		return (35200);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3521") == 0)
-		return (35210);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1122_AC") == 0)
-		return (11221);
-
-	if (mos_strcasecmp(name, "LED_FORWARD_VOLTAGE_1_7V") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "LED_FORWARD_VOLTAGE_2_75V") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "LED_FORWARD_VOLTAGE_3_2V") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "LED_FORWARD_VOLTAGE_3_9V") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "LED_FORWARD_VOLTAGE_4_0V") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "LED_FORWARD_VOLTAGE_4_8V") == 0)
-		return (6);
-
-	if (mos_strcasecmp(name, "LED_FORWARD_VOLTAGE_5_0V") == 0)
-		return (7);
-
-	if (mos_strcasecmp(name, "LED_FORWARD_VOLTAGE_5_6V") == 0)
-		return (8);
-
-	if (mos_strcasecmp(name, "RCSERVO_VOLTAGE_5V") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "RCSERVO_VOLTAGE_6V") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "RCSERVO_VOLTAGE_7_4V") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "VOLTAGE_OUTPUT_RANGE_10V") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "VOLTAGE_OUTPUT_RANGE_5V") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "VOLTAGE_RANGE_10mV") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "VOLTAGE_RANGE_AUTO") == 0)
-		return (11);
-
-	if (mos_strcasecmp(name, "VOLTAGE_RANGE_200mV") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "VOLTAGE_RANGE_312_5mV") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "VOLTAGE_RANGE_400mV") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "VOLTAGE_RANGE_40mV") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "VOLTAGE_RANGE_2V") == 0)
-		return (7);
-
-	if (mos_strcasecmp(name, "VOLTAGE_RANGE_5V") == 0)
-		return (8);
-
-	if (mos_strcasecmp(name, "VOLTAGE_RANGE_15V") == 0)
-		return (9);
-
-	if (mos_strcasecmp(name, "VOLTAGE_RANGE_40V") == 0)
-		return (10);
-
-	if (mos_strcasecmp(name, "VOLTAGE_RANGE_1000mV") == 0)
-		return (6);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_VOLTAGE") == 0)
-		return (0);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_VCP4114") == 0)
-		return (41140);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1117") == 0)
-		return (11170);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1123") == 0)
-		return (11230);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1127") == 0)
-		return (11270);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1130_PH") == 0)
-		return (11301);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1130_ORP") == 0)
-		return (11302);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1132") == 0)
-		return (11320);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1133") == 0)
-		return (11330);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1135") == 0)
-		return (11350);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1142") == 0)
-		return (11420);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1143") == 0)
-		return (11430);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3500") == 0)
-		return (35000);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3501") == 0)
-		return (35010);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3502") == 0)
-		return (35020);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3503") == 0)
-		return (35030);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3507") == 0)
-		return (35070);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3508") == 0)
-		return (35080);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3509") == 0)
-		return (35090);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_1114") == 0)
-		return (11140);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3511") == 0)
-		return (35110);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3512") == 0)
-		return (35120);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3513") == 0)
-		return (35130);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3514") == 0)
-		return (35140);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3515") == 0)
-		return (35150);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3516") == 0)
-		return (35160);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3517") == 0)
-		return (35170);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3518") == 0)
-		return (35180);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3519") == 0)
-		return (35190);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3584") == 0)
-		return (35840);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3585") == 0)
-		return (35850);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3586") == 0)
-		return (35860);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3587") == 0)
-		return (35870);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3588") == 0)
-		return (35880);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3589") == 0)
-		return (35890);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_MOT2002_LOW") == 0)
-		return (20020);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_MOT2002_MED") == 0)
-		return (20021);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_MOT2002_HIGH") == 0)
-		return (20022);
-
-	if (mos_strcasecmp(name, "SENSOR_TYPE_3510") == 0)
-		return (35100);
-
-	if (mos_strcasecmp(name, "PROTOCOL_EM4100") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "PROTOCOL_ISO11785_FDX_B") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "PROTOCOL_PHIDGETS") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "SPATIAL_ALGORITHM_NONE") == 0)
-		return (0);
-
-	if (mos_strcasecmp(name, "SPATIAL_ALGORITHM_AHRS") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "SPATIAL_ALGORITHM_IMU") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "RTD_TYPE_PT100_3850") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "RTD_TYPE_PT1000_3850") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "RTD_TYPE_PT100_3920") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "RTD_TYPE_PT1000_3920") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "THERMOCOUPLE_TYPE_J") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "THERMOCOUPLE_TYPE_K") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "THERMOCOUPLE_TYPE_E") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "THERMOCOUPLE_TYPE_T") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "FILTER_TYPE_ZERO_CROSSING") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "FILTER_TYPE_LOGIC_LEVEL") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "IR_ENCODING_UNKNOWN") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "IR_ENCODING_SPACE") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "IR_ENCODING_PULSE") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "IR_ENCODING_BIPHASE") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "IR_ENCODING_RC5") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "IR_ENCODING_RC6") == 0)
-		return (6);
-
-	if (mos_strcasecmp(name, "IR_LENGTH_UNKNOWN") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "IR_LENGTH_CONSTANT") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "IR_LENGTH_VARIABLE") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "CONTROL_MODE_STEP") == 0)
-		return (0);
-
-	if (mos_strcasecmp(name, "CONTROL_MODE_RUN") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "FONT_User1") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "FONT_User2") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "FONT_6x10") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "FONT_5x8") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "FONT_6x12") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "SCREEN_SIZE_NONE") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "SCREEN_SIZE_64x128") == 0)
-		return (13);
-
-	if (mos_strcasecmp(name, "SCREEN_SIZE_2x8") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "SCREEN_SIZE_1x16") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "SCREEN_SIZE_2x16") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "SCREEN_SIZE_4x16") == 0)
-		return (6);
-
-	if (mos_strcasecmp(name, "SCREEN_SIZE_1x8") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "SCREEN_SIZE_4x20") == 0)
-		return (8);
-
-	if (mos_strcasecmp(name, "SCREEN_SIZE_2x24") == 0)
-		return (9);
-
-	if (mos_strcasecmp(name, "SCREEN_SIZE_1x40") == 0)
-		return (10);
-
-	if (mos_strcasecmp(name, "SCREEN_SIZE_2x40") == 0)
-		return (11);
-
-	if (mos_strcasecmp(name, "SCREEN_SIZE_4x40") == 0)
-		return (12);
-
-	if (mos_strcasecmp(name, "SCREEN_SIZE_2x20") == 0)
-		return (7);
-
-	if (mos_strcasecmp(name, "PIXEL_STATE_OFF") == 0)
-		return (0);
-
-	if (mos_strcasecmp(name, "PIXEL_STATE_ON") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "PIXEL_STATE_INVERT") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "PARITY_MODE_NONE") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "PARITY_MODE_EVEN") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "PARITY_MODE_ODD") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "STOP_BITS_ONE") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "STOP_BITS_TWO") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "HANDSHAKE_MODE_NONE") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "HANDSHAKE_MODE_REQUEST_TO_SEND") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "HANDSHAKE_MODE_READY_TO_RECEIVE") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "PROTOCOL_RS485") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "PROTOCOL_RS422") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "PROTOCOL_DMX512") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "PROTOCOL_MODBUS_RTU") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "PROTOCOL_SPI") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "PROTOCOL_I2C") == 0)
-		return (6);
-
-	if (mos_strcasecmp(name, "PROTOCOL_UART") == 0)
-		return (7);
-
-	if (mos_strcasecmp(name, "PROTOCOL_RS232") == 0)
-		return (8);
-
-	if (mos_strcasecmp(name, "SPI_MODE_0") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "SPI_MODE_1") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "SPI_MODE_2") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "SPI_MODE_3") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "ENDIANNESS_MSB_FIRST") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "ENDIANNESS_LSB_FIRST") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "IO_VOLTAGE_EXTERN") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "IO_VOLTAGE_1_8V") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "IO_VOLTAGE_2_5V") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "IO_VOLTAGE_3_3V") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "IO_VOLTAGE_5_0V") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "PACKET_ERROR_OK") == 0)
-		return (0);
-
-	if (mos_strcasecmp(name, "PACKET_ERROR_UNKNOWN") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "PACKET_ERROR_TIMEOUT") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "PACKET_ERROR_FORMAT") == 0)
-		return (3);
-
-	if (mos_strcasecmp(name, "PACKET_ERROR_INVALID") == 0)
-		return (4);
-
-	if (mos_strcasecmp(name, "PACKET_ERROR_OVERRUN") == 0)
-		return (5);
-
-	if (mos_strcasecmp(name, "PACKET_ERROR_CORRUPT") == 0)
-		return (6);
-
-	if (mos_strcasecmp(name, "SPL_RANGE_102dB") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "SPL_RANGE_82dB") == 0)
-		return (2);
-
-	if (mos_strcasecmp(name, "PORT_MODE_VINT_PORT") == 0)
-		return (0);
-
-	if (mos_strcasecmp(name, "PORT_MODE_DIGITAL_INPUT") == 0)
-		return (1);
-
-	if (mos_strcasecmp(name, "PORT_MODE_DIGITAL_OUTPUT") == 0)
-		return (2);
+/*
+ * Every enum value name, placed by a minimal perfect hash of the upper-cased name: the name's
+ * first hash selects a displacement, and the second hash, displaced, selects the only slot the
+ * name can be in.
+ */
+#define ENUMNAME_CNT		545
+#define ENUMNAME_BUCKETS	192
+
+static const struct {
+	const char	*name;
+	int			value;
+} enumNames[ENUMNAME_CNT] = {
+	{ "EPHIDGET_UNSUPPORTED", 20 },
+	{ "BRIDGE_GAIN_64", 7 },
+	{ "PROTOCOL_EM4100", 1 },
+	{ "PHIDCLASS_BRIDGE", 4 },
+	{ "PHIDID_VOLTAGEINPUT_PORT", 97 },
+	{ "VOLTAGE_RANGE_15V", 9 },
+	{ "PHIDGET_LOG_CRITICAL", 1 },
+	{ "IO_VOLTAGE_3_3V", 4 },
+	{ "PHIDCHCLASS_SOUNDSENSOR", 25 },
+	{ "PHIDID_VOLTAGERATIOINPUT_PORT", 98 },
+	{ "PHIDID_1046", 24 },
+	{ "MESHMODE_ROUTER", 1 },
+	{ "PHIDCLASS_GENERIC", 22 },
+	{ "PHIDCLASS_VINT", 21 },
+	{ "SPL_RANGE_82dB", 2 },
+	{ "PHIDCHCLASS_BLDCMOTOR", 35 },
+	{ "PACKET_ERROR_FORMAT", 3 },
+	{ "PHIDID_1063", 40 },
+	{ "EPHIDGET_FBIG", 17 },
+	{ "EEPHIDGET_OK", 4096 },
+	{ "PHIDGETSERVER_NONE", 0 },
+	{ "PHIDID_OUT1000", 75 },
+	{ "PHIDCLASS_STEPPER", 18 },
+	{ "PHIDCHSUBCLASS_NONE", 1 },
+	{ "PHIDID_STC1000", 86 },
+	{ "PHIDID_DCC1100", 108 },
+	{ "EEPHIDGET_BADCONNECTION", 4113 },
+	{ "EEPHIDGET_SATURATION", 4105 },
+	{ "PHIDCLASS_TEMPERATURESENSOR", 19 },
+	{ "PHIDCLASS_MESHDONGLE", 12 },
+	{ "EPHIDGET_ROFS", 18 },
+	{ "PHIDID_SND1000", 85 },
+	{ "SCREEN_SIZE_1x8", 2 },
+	{ "PROTOCOL_RS485", 1 },
+	{ "HANDSHAKE_MODE_READY_TO_RECEIVE", 3 },
+	{ "SENSOR_TYPE_1128", 11280 },
+	{ "PHIDCHCLASS_NOTHING", 0 },
+	{ "SENSOR_TYPE_1140", 11400 },
+	{ "PHIDID_FIRMWARE_UPGRADE_USB", 101 },
+	{ "EPHIDGET_ACCESS", 7 },
+	{ "SENSOR_TYPE_3507", 35070 },
+	{ "EPHIDGET_BADVERSION", 55 },
+	{ "PHIDUNIT_PH", 16 },
+	{ "PHIDCLASS_FIRMWAREUPGRADE", 23 },
+	{ "SENSOR_TYPE_1101_SHARP_2Y0A02", 11013 },
+	{ "EPHIDGET_CONNREF", 35 },
+	{ "BRIDGE_GAIN_16", 5 },
+	{ "PHIDGET_LOG_WARNING", 3 },
+	{ "PHIDID_1053", 30 },
+	{ "PHIDUNIT_PERCENT", 2 },
+	{ "PHIDID_LUX1000", 72 },
+	{ "SENSOR_TYPE_3519", 35190 },
+	{ "PHIDID_1062", 39 },
+	{ "PHIDCHCLASS_MOTORPOSITIONCONTROLLER", 34 },
+	{ "PHIDID_MOT1101", 74 },
+	{ "PHIDID_DST1001", 121 },
+	{ "SENSOR_TYPE_3516", 35160 },
+	{ "PHIDID_VCP1001", 93 },
+	{ "INPUT_MODE_PNP", 2 },
+	{ "PHIDID_STC1003", 119 },
+	{ "PHIDCHCLASS_DIGITALOUTPUT", 6 },
+	{ "BRIDGE_GAIN_128", 8 },
+	{ "IR_ENCODING_PULSE", 3 },
+	{ "PORT_MODE_VOLTAGE_RATIO_INPUT", 4 },
+	{ "PIXEL_STATE_INVERT", 2 },
+	{ "HANDSHAKE_MODE_NONE", 1 },
+	{ "EEPHIDGET_OUTOFRANGEHIGH", 4114 },
+	{ "EPHIDGET_NFILE", 14 },
+	{ "SENSOR_TYPE_1139", 11390 },
+	{ "PHIDCHSUBCLASS_TEMPERATURESENSOR_RTD", 32 },
+	{ "PHIDCHSUBCLASS_DIGITALOUTPUT_DUTY_CYCLE", 16 },
+	{ "PHIDID_ENC1000", 60 },
+	{ "EEPHIDGET_OUTOFRANGELOW", 4115 },
+	{ "EPHIDGET_INTERRUPTED", 4 },
+	{ "VOLTAGE_RANGE_200mV", 3 },
+	{ "PHIDID_DCC1002", 117 },
+	{ "PHIDID_1043", 21 },
+	{ "PHIDID_DST1200", 59 },
+	{ "SENSOR_TYPE_3587", 35870 },
+	{ "EPHIDGET_HOSTUNREACH", 48 },
+	{ "EPHIDGET_INVALIDPACKET", 53 },
+	{ "PHIDCHCLASS_ACCELEROMETER", 1 },
+	{ "PHIDID_MOT0100", 146 },
+	{ "RTD_WIRE_SETUP_3WIRE", 2 },
+	{ "IR_LENGTH_VARIABLE", 3 },
+	{ "SENSOR_TYPE_1110", 11100 },
+	{ "SENSOR_TYPE_1111", 11110 },
+	{ "PHIDID_1031", 16 },
+	{ "SENSOR_TYPE_1137", 11370 },
+	{ "PHIDID_MOT1102", 137 },
+	{ "PHIDCHCLASS_TEMPERATURESENSOR", 28 },
+	{ "EEPHIDGET_INVALIDSTATE", 4112 },
+	{ "PHIDCHSUBCLASS_LCD_TEXT", 81 },
+	{ "SCREEN_SIZE_64x128", 13 },
+	{ "IR_ENCODING_SPACE", 2 },
+	{ "PHIDUNIT_DEGREE_CELCIUS", 13 },
+	{ "SENSOR_TYPE_1101_SHARP_2D120X", 11011 },
+	{ "PROTOCOL_PHIDGETS", 3 },
+	{ "SENSOR_TYPE_3502", 35020 },
+	{ "RCSERVO_VOLTAGE_7_4V", 3 },
+	{ "EEPHIDGET_DISPATCH", 4 },
+	{ "PIXEL_STATE_ON", 1 },
+	{ "PHIDID_OUT1002", 77 },
+	{ "SENSOR_TYPE_1105", 11050 },
+	{ "SENSOR_TYPE_VOLTAGERATIO", 0 },
+	{ "SENSOR_TYPE_1116", 11160 },
+	{ "PHIDID_OUT1001", 76 },
+	{ "PHIDCLASS_LED", 11 },
+	{ "PROTOCOL_ISO11785_FDX_B", 2 },
+	{ "EEPHIDGET_BUSY", 2 },
+	{ "PHIDUNIT_VOLT", 12 },
+	{ "PHIDCHCLASS_SPATIAL", 26 },
+	{ "PHIDID_DCC1001", 110 },
+	{ "PACKET_ERROR_OK", 0 },
+	{ "PHIDGETSERVER_DEVICEREMOTE", 3 },
+	{ "PHIDID_DICTIONARY", 111 },
+	{ "IR_ENCODING_RC5", 5 },
+	{ "PHIDCHCLASS_LIGHTSENSOR", 17 },
+	{ "EPHIDGET_UNKNOWNVALLOW", 61 },
+	{ "PARITY_MODE_ODD", 3 },
+	{ "EPHIDGET_2BIG", 54 },
+	{ "PHIDGETSERVER_DEVICELISTENER", 1 },
+	{ "EEPHIDGET_FAILSAFE", 4108 },
+	{ "PHIDID_1048", 26 },
+	{ "PHIDID_ADP1000", 49 },
+	{ "CONTROL_MODE_RUN", 1 },
+	{ "PROTOCOL_RS232", 8 },
+	{ "SENSOR_TYPE_3513", 35130 },
+	{ "SENSOR_TYPE_1114", 11140 },
+	{ "PHIDCHCLASS_LCD", 11 },
+	{ "PHIDID_LED1000", 71 },
+	{ "IO_VOLTAGE_5_0V", 5 },
+	{ "PHIDID_1024", 14 },
+	{ "PHIDID_1000", 2 },
+	{ "FAN_MODE_AUTO", 3 },
+	{ "SENSOR_TYPE_VCP4114", 41140 },
+	{ "EPHIDGET_NOENT", 2 },
+	{ "PHIDID_DIGITALOUTPUT_PORT", 96 },
+	{ "PHIDID_1023", 13 },
+	{ "PHIDCHCLASS_GPS", 10 },
+	{ "EEPHIDGET_WRAP", 4100 },
+	{ "PHIDID_FIRMWARE_UPGRADE_STM8S", 103 },
+	{ "EPHIDGET_RESOLV", 44 },
+	{ "EPHIDGET_CLOSED", 56 },
+	{ "PHIDID_MOT0110", 141 },
+	{ "PHIDCHSUBCLASS_TEMPERATURESENSOR_THERMOCOUPLE", 33 },
+	{ "SENSOR_TYPE_3508", 35080 },
+	{ "PHIDID_HUM1100", 136 },
+	{ "SPATIAL_ALGORITHM_NONE", 0 },
+	{ "EPHIDGET_NOTATTACHED", 52 },
+	{ "PHIDID_MOT0109", 140 },
+	{ "ENDIANNESS_MSB_FIRST", 1 },
+	{ "PHIDID_PRE1000", 79 },
+	{ "PHIDID_STC1005", 149 },
+	{ "SENSOR_TYPE_3503", 35030 },
+	{ "PHIDCHCLASS_CAPACITIVETOUCH", 14 },
+	{ "PHIDUNIT_WATT", 17 },
+	{ "PHIDID_1054", 31 },
+	{ "PHIDID_1051", 28 },
+	{ "PHIDID_OUT1100", 78 },
+	{ "EEPHIDGET_ENERGYDUMP", 4110 },
+	{ "EPHIDGET_BADPASSWORD", 37 },
+	{ "EEPHIDGET_BADPOWER", 4104 },
+	{ "PHIDID_1065", 42 },
+	{ "VOLTAGE_RANGE_10mV", 1 },
+	{ "SCREEN_SIZE_1x40", 10 },
+	{ "EPHIDGET_BADPOWER", 62 },
+	{ "PHIDID_FIRMWARE_UPGRADE_STM32F0", 102 },
+	{ "PHIDCLASS_NOTHING", 0 },
+	{ "EEPHIDGET_OVERTEMP", 4101 },
+	{ "PHIDID_1016", 11 },
+	{ "PHIDID_DCC1000", 57 },
+	{ "PHIDCHCLASS_STEPPER", 27 },
+	{ "EEPHIDGET_VOLTAGEERROR", 4109 },
+	{ "PHIDCHCLASS_IR", 16 },
+	{ "PHIDCHCLASS_RFID", 24 },
+	{ "PHIDCLASS_ANALOG", 3 },
+	{ "PHIDCLASS_IR", 10 },
+	{ "DEBOUNCE_MODE_TRAILING_EDGE", 1 },
+	{ "SENSOR_TYPE_1134", 11340 },
+	{ "EEPHIDGET_FAULT", 4116 },
+	{ "SENSOR_TYPE_3123", 31230 },
+	{ "PHIDUNIT_GRAM", 7 },
+	{ "RTD_TYPE_PT100_3850", 1 },
+	{ "EPHIDGET_INVALIDARG", 21 },
+	{ "PHIDCHCLASS_VOLTAGEOUTPUT", 30 },
+	{ "PHIDCHCLASS_HUB", 13 },
+	{ "SPI_MODE_3", 4 },
+	{ "ENCODER_IO_MODE_LINE_DRIVER_2K2", 2 },
+	{ "PHIDID_REL1100", 82 },
+	{ "PHIDGETSERVER_DEVICE", 2 },
+	{ "FONT_5x8", 4 },
+	{ "SENSOR_TYPE_3588", 35880 },
+	{ "PHIDID_HUB0001", 142 },
+	{ "CONTROL_MODE_STEP", 0 },
+	{ "PHIDID_HUB5000", 123 },
+	{ "SENSOR_TYPE_1123", 11230 },
+	{ "SENSOR_TYPE_1102", 11020 },
+	{ "PHIDCHCLASS_PHSENSOR", 37 },
+	{ "SPATIAL_PRECISION_HYBRID", 0 },
+	{ "EPHIDGET_NODEV", 40 },
+	{ "EPHIDGET_EOF", 31 },
+	{ "PHIDUNIT_KILOGRAM", 8 },
+	{ "PHIDCHSUBCLASS_VOLTAGERATIOINPUT_BRIDGE", 65 },
+	{ "SENSOR_TYPE_1101_SHARP_2Y0A21", 11012 },
+	{ "PHIDID_TMP1200", 90 },
+	{ "EPHIDGET_BUSY", 9 },
+	{ "PHIDID_FIRMWARE_UPGRADE_SPI", 104 },
+	{ "PHIDCHSUBCLASS_LCD_GRAPHIC", 80 },
+	{ "PIXEL_STATE_OFF", 0 },
+	{ "SCREEN_SIZE_2x8", 3 },
+	{ "SENSOR_TYPE_1120", 11200 },
+	{ "SENSOR_TYPE_1121", 11210 },
+	{ "PHIDCLASS_SERVO", 16 },
+	{ "PHIDCHCLASS_PRESSURESENSOR", 21 },
+	{ "EEPHIDGET_MOTORSTALL", 4111 },
+	{ "SENSOR_TYPE_3515", 35150 },
+	{ "PHIDID_1045", 23 },
+	{ "PHIDID_DCC1003", 120 },
+	{ "SENSOR_TYPE_1131", 11310 },
+	{ "SPATIAL_PRECISION_LOW", 2 },
+	{ "PHIDID_1040", 18 },
+	{ "PHIDID_RCC1000", 80 },
+	{ "PHIDID_1041", 19 },
+	{ "MOTOR_DRIVE_TYPE_COAST", 1 },
+	{ "PACKET_ERROR_UNKNOWN", 1 },
+	{ "SENSOR_TYPE_1112", 11120 },
+	{ "PHIDUNIT_DECIBEL", 3 },
+	{ "SCREEN_SIZE_NONE", 1 },
+	{ "PHIDID_TMP1100", 88 },
+	{ "SENSOR_TYPE_1106", 11060 },
+	{ "INPUT_MODE_NPN", 1 },
+	{ "PHIDCHCLASS_DICTIONARY", 36 },
+	{ "PHIDID_1042", 20 },
+	{ "PHIDID_1057", 34 },
+	{ "SENSOR_TYPE_1104", 11040 },
+	{ "PHIDID_VCP1002", 94 },
+	{ "EPHIDGET_ISDIR", 12 },
+	{ "EPHIDGET_RO", 19 },
+	{ "EPHIDGET_HALLSENSOR", 64 },
+	{ "PHIDCLASS_GPS", 7 },
+	{ "PHIDID_1010_1013_1018_1019", 6 },
+	{ "EPHIDGET_PERM", 1 },
+	{ "PHIDCHSUBCLASS_VOLTAGEINPUT_SENSOR_PORT", 48 },
+	{ "PHIDCHCLASS_HUMIDITYSENSOR", 15 },
+	{ "SENSOR_TYPE_3517", 35170 },
+	{ "PHIDID_1011", 7 },
+	{ "PHIDCHCLASS_MESHDONGLE", 19 },
+	{ "PHIDGETSERVER_WWWLISTENER", 4 },
+	{ "EPHIDGET_FAULT", 8 },
+	{ "EPHIDGET_NOTEMPTY", 26 },
+	{ "SENSOR_TYPE_3120", 31200 },
+	{ "PHIDID_HUB0004", 67 },
+	{ "RCSERVO_VOLTAGE_6V", 2 },
+	{ "PHIDCHCLASS_GYROSCOPE", 12 },
+	{ "ENCODER_IO_MODE_OPEN_COLLECTOR_10K", 5 },
+	{ "IR_LENGTH_CONSTANT", 2 },
+	{ "EEPHIDGET_BADVERSION", 1 },
+	{ "SENSOR_TYPE_1118_DC", 11182 },
+	{ "STOP_BITS_ONE", 1 },
+	{ "PACKET_ERROR_CORRUPT", 6 },
+	{ "PHIDCLASS_ADVANCEDSERVO", 2 },
+	{ "PHIDID_DST1002", 126 },
+	{ "PHIDCLASS_ENCODER", 5 },
+	{ "IR_ENCODING_BIPHASE", 4 },
+	{ "PHIDCLASS_INTERFACEKIT", 9 },
+	{ "SENSOR_TYPE_3511", 35110 },
+	{ "SENSOR_TYPE_3586", 35860 },
+	{ "SCREEN_SIZE_4x40", 12 },
+	{ "PHIDCLASS_RFID", 15 },
+	{ "FONT_User1", 1 },
+	{ "ENDIANNESS_LSB_FIRST", 2 },
+	{ "SENSOR_TYPE_1136", 11360 },
+	{ "EEPHIDGET_ESTOP", 4117 },
+	{ "PHIDID_DIGITALINPUT_PORT", 95 },
+	{ "VOLTAGE_RANGE_312_5mV", 4 },
+	{ "PACKET_ERROR_INVALID", 4 },
+	{ "PHIDGET_LOG_INFO", 4 },
+	{ "PHIDUNIT_METER", 6 },
+	{ "PHIDID_RCC0004", 124 },
+	{ "SENSOR_TYPE_1119_AC", 11191 },
+	{ "FONT_6x10", 3 },
+	{ "PHIDID_HUM1000", 69 },
+	{ "RCSERVO_VOLTAGE_5V", 1 },
+	{ "SENSOR_TYPE_1122_AC", 11221 },
+	{ "PHIDID_LCD1100", 70 },
+	{ "SCREEN_SIZE_4x20", 8 },
+	{ "PHIDID_VCP1000", 92 },
+	{ "PHIDCHSUBCLASS_SPATIAL_AHRS", 112 },
+	{ "PHIDID_1044", 22 },
+	{ "EPHIDGET_CONNRESET", 46 },
+	{ "PHIDID_DAQ1400", 55 },
+	{ "PHIDID_1001", 3 },
+	{ "SPI_MODE_2", 3 },
+	{ "PHIDID_1030", 15 },
+	{ "EPHIDGET_NOTCONFIGURED", 57 },
+	{ "ENCODER_IO_MODE_LINE_DRIVER_10K", 3 },
+	{ "PHIDUNIT_CENTIMETER", 5 },
+	{ "THERMOCOUPLE_TYPE_E", 3 },
+	{ "PHIDCHCLASS_MOTORVELOCITYCONTROLLER", 39 },
+	{ "EPHIDGET_NOTDIR", 11 },
+	{ "PHIDID_1047", 25 },
+	{ "LED_FORWARD_VOLTAGE_4_0V", 5 },
+	{ "FILTER_TYPE_LOGIC_LEVEL", 2 },
+	{ "IO_VOLTAGE_EXTERN", 1 },
+	{ "PHIDUNIT_LUX", 14 },
+	{ "SPATIAL_ALGORITHM_AHRS", 1 },
+	{ "PHIDCHCLASS_DISTANCESENSOR", 7 },
+	{ "PHIDCHSUBCLASS_VOLTAGERATIOINPUT_SENSOR_PORT", 64 },
+	{ "SENSOR_TYPE_1138", 11380 },
+	{ "VOLTAGE_RANGE_40mV", 2 },
+	{ "PHIDCLASS_SPATIAL", 17 },
+	{ "SENSOR_TYPE_1109", 11090 },
+	{ "SENSOR_TYPE_1103", 11030 },
+	{ "RTD_TYPE_PT1000_3850", 2 },
+	{ "PHIDCHCLASS_GENERIC", 33 },
+	{ "SENSOR_TYPE_1119_DC", 11192 },
+	{ "PHIDID_1014", 9 },
+	{ "PHIDCLASS_MOTORCONTROL", 13 },
+	{ "EPHIDGET_TIMEOUT", 3 },
+	{ "HANDSHAKE_MODE_REQUEST_TO_SEND", 2 },
+	{ "LED_FORWARD_VOLTAGE_4_8V", 6 },
+	{ "STOP_BITS_TWO", 2 },
+	{ "SENSOR_TYPE_3518", 35180 },
+	{ "SENSOR_TYPE_VOLTAGE", 0 },
+	{ "PROTOCOL_DMX512", 3 },
+	{ "PHIDUNIT_MILLIMETER", 4 },
+	{ "PORT_MODE_VINT_PORT", 0 },
+	{ "IR_ENCODING_RC6", 6 },
+	{ "EEPHIDGET_PACKETLOST", 4099 },
+	{ "SENSOR_TYPE_1124", 11240 },
+	{ "PHIDUNIT_NONE", 0 },
+	{ "PROTOCOL_RS422", 2 },
+	{ "PHIDID_DST1000", 58 },
+	{ "PHIDCHCLASS_VOLTAGERATIOINPUT", 31 },
+	{ "PHIDID_HUB0000", 64 },
+	{ "SCREEN_SIZE_2x20", 7 },
+	{ "SENSOR_TYPE_1130_PH", 11301 },
+	{ "PHIDCHCLASS_DIGITALINPUT", 5 },
+	{ "PHIDCHCLASS_FREQUENCYCOUNTER", 9 },
+	{ "PHIDCHCLASS_CURRENTINPUT", 2 },
+	{ "PHIDCLASS_TEXTLCD", 20 },
+	{ "PHIDCHCLASS_ENCODER", 8 },
+	{ "PHIDID_1015", 10 },
+	{ "PHIDID_HUM1001", 127 },
+	{ "SENSOR_TYPE_1132", 11320 },
+	{ "SENSOR_TYPE_3510", 35100 },
+	{ "PACKET_ERROR_OVERRUN", 5 },
+	{ "PHIDUNIT_MILLIAMPERE", 9 },
+	{ "PHIDID_DAQ1301", 54 },
+	{ "THERMOCOUPLE_TYPE_T", 4 },
+	{ "PHIDCHSUBCLASS_DIGITALOUTPUT_FREQUENCY", 18 },
+	{ "FONT_6x12", 5 },
+	{ "SENSOR_TYPE_1142", 11420 },
+	{ "PHIDID_DAQ1200", 52 },
+	{ "FAN_MODE_OFF", 1 },
+	{ "PHIDCHCLASS_POWERGUARD", 20 },
+	{ "PHIDUNIT_BOOLEAN", 1 },
+	{ "LED_FORWARD_VOLTAGE_5_6V", 8 },
+	{ "PHIDID_REL1101", 83 },
+	{ "EPHIDGET_EXIST", 10 },
+	{ "PHIDID_1215__1218", 47 },
+	{ "PHIDCLASS_ACCELEROMETER", 1 },
+	{ "PHIDID_1060", 37 },
+	{ "SENSOR_TYPE_MOT2002_HIGH", 20022 },
+	{ "IR_ENCODING_UNKNOWN", 1 },
+	{ "PHIDID_NOTHING", 0 },
+	{ "PHIDID_UNKNOWN", 125 },
+	{ "SCREEN_SIZE_2x40", 11 },
+	{ "SENSOR_TYPE_1125_HUMIDITY", 11251 },
+	{ "SENSOR_TYPE_1125_TEMPERATURE", 11252 },
+	{ "EPHIDGET_NETUNAVAIL", 45 },
+	{ "SENSOR_TYPE_1115", 11150 },
+	{ "SENSOR_TYPE_1129", 11290 },
+	{ "PHIDUNIT_KILOPASCAL", 11 },
+	{ "SENSOR_TYPE_3122", 31220 },
+	{ "SCREEN_SIZE_2x16", 5 },
+	{ "SPL_RANGE_102dB", 1 },
+	{ "SENSOR_TYPE_1135", 11350 },
+	{ "PROTOCOL_SPI", 5 },
+	{ "PHIDUNIT_GAUSS", 15 },
+	{ "EEPHIDGET_FAILURE", 5 },
+	{ "FAN_MODE_ON", 2 },
+	{ "PHIDGET_LOG_DEBUG", 5 },
+	{ "PHIDID_FIRMWARE_UPGRADE_STM32F3", 145 },
+	{ "PHIDID_DAQ1300", 53 },
+	{ "RTD_WIRE_SETUP_2WIRE", 1 },
+	{ "EPHIDGET_NOSPC", 16 },
+	{ "LED_FORWARD_VOLTAGE_3_2V", 3 },
+	{ "IR_LENGTH_UNKNOWN", 1 },
+	{ "BRIDGE_GAIN_8", 4 },
+	{ "EPHIDGET_MFILE", 15 },
+	{ "SENSOR_TYPE_3514", 35140 },
+	{ "BRIDGE_GAIN_1", 1 },
+	{ "PHIDCHCLASS_CURRENTOUTPUT", 38 },
+	{ "EPHIDGET_UNEXPECTED", 28 },
+	{ "PHIDID_1056", 33 },
+	{ "SENSOR_TYPE_1126", 11260 },
+	{ "EPHIDGET_IO", 5 },
+	{ "SENSOR_TYPE_3522", 35220 },
+	{ "PHIDID_1204", 46 },
+	{ "SPI_MODE_0", 1 },
+	{ "PHIDID_1008", 5 },
+	{ "SENSOR_TYPE_1130_ORP", 11302 },
+	{ "PHIDID_STC1002", 118 },
+	{ "PHIDID_1202_1203", 45 },
+	{ "LED_FORWARD_VOLTAGE_1_7V", 1 },
+	{ "PHIDID_1067", 44 },
+	{ "PROTOCOL_UART", 7 },
+	{ "SENSOR_TYPE_3121", 31210 },
+	{ "PHIDID_FIRMWARE_UPGRADE_STM32G0", 143 },
+	{ "PHIDID_1055", 32 },
+	{ "PHIDCHCLASS_RESISTANCEINPUT", 23 },
+	{ "EPHIDGET_POWERCYCLE", 63 },
+	{ "PACKET_ERROR_TIMEOUT", 2 },
+	{ "EPHIDGET_DUPLICATE", 27 },
+	{ "SENSOR_TYPE_3520", 35200 },
+	{ "SENSOR_TYPE_1146", 11460 },
+	{ "LED_FORWARD_VOLTAGE_5_0V", 7 },
+	{ "SENSOR_TYPE_1143", 11430 },
+	{ "SENSOR_TYPE_1117", 11170 },
+	{ "EPHIDGET_OK", 0 },
+	{ "PHIDID_HIN1100", 63 },
+	{ "LED_FORWARD_VOLTAGE_3_9V", 4 },
+	{ "PHIDCHCLASS_MAGNETOMETER", 18 },
+	{ "EPHIDGET_KEEPALIVE", 58 },
+	{ "PHIDCHCLASS_VOLTAGEINPUT", 29 },
+	{ "SPI_MODE_1", 2 },
+	{ "SENSOR_TYPE_MOT2002_LOW", 20020 },
+	{ "PHIDID_1219__1222", 48 },
+	{ "PHIDGET_LOG_ERROR", 2 },
+	{ "PHIDCHSUBCLASS_DIGITALOUTPUT_LED_DRIVER", 17 },
+	{ "VOLTAGE_RANGE_400mV", 5 },
+	{ "EPHIDGET_NOMEMORY", 6 },
+	{ "ENCODER_IO_MODE_OPEN_COLLECTOR_2K2", 4 },
+	{ "BRIDGE_GAIN_2", 2 },
+	{ "PHIDGETSERVER_WWWREMOTE", 6 },
+	{ "PHIDCHCLASS_DATAADAPTER", 3 },
+	{ "VOLTAGE_RANGE_1000mV", 6 },
+	{ "PHIDGETSERVER_WWW", 5 },
+	{ "SENSOR_TYPE_1122_DC", 11222 },
+	{ "FILTER_TYPE_ZERO_CROSSING", 1 },
+	{ "PHIDGETSERVER_SBC", 7 },
+	{ "PHIDID_HIN1000", 61 },
+	{ "PARITY_MODE_EVEN", 2 },
+	{ "PHIDID_TMP1101", 89 },
+	{ "VOLTAGE_RANGE_AUTO", 11 },
+	{ "SCREEN_SIZE_2x24", 9 },
+	{ "VOLTAGE_OUTPUT_RANGE_5V", 2 },
+	{ "SPATIAL_PRECISION_HIGH", 1 },
+	{ "EPHIDGET_FAILSAFE", 59 },
+	{ "RTD_TYPE_PT100_3920", 3 },
+	{ "SENSOR_TYPE_3500", 35000 },
+	{ "SENSOR_TYPE_3130", 31300 },
+	{ "PHIDCLASS_DATAADAPTER", 25 },
+	{ "SENSOR_TYPE_1113", 11130 },
+	{ "PHIDID_HIN1101", 109 },
+	{ "EEPHIDGET_OUTOFRANGE", 4103 },
+	{ "SENSOR_TYPE_1108", 11080 },
+	{ "PHIDID_VCP1100", 105 },
+	{ "RTD_TYPE_PT1000_3920", 4 },
+	{ "PHIDCLASS_FREQUENCYCOUNTER", 6 },
+	{ "SENSOR_TYPE_3521", 35210 },
+	{ "PHIDID_1066", 43 },
+	{ "PORT_MODE_VOLTAGE_INPUT", 3 },
+	{ "PHIDID_1032", 17 },
+	{ "SENSOR_TYPE_3512", 35120 },
+	{ "THERMOCOUPLE_TYPE_J", 1 },
+	{ "VOLTAGE_RANGE_5V", 8 },
+	{ "PHIDGET_LOG_VERBOSE", 6 },
+	{ "PHIDID_1052", 29 },
+	{ "EEPHIDGET_OVERRUN", 4098 },
+	{ "BRIDGE_GAIN_4", 3 },
+	{ "SENSOR_TYPE_1118_AC", 11181 },
+	{ "SENSOR_TYPE_3501", 35010 },
+	{ "PHIDCLASS_PHSENSOR", 14 },
+	{ "SENSOR_TYPE_1107", 11070 },
+	{ "PHIDID_HIN1001", 62 },
+	{ "PHIDID_1017", 12 },
+	{ "VOLTAGE_RANGE_2V", 7 },
+	{ "EPHIDGET_WRONGDEVICE", 50 },
+	{ "SENSOR_TYPE_3585", 35850 },
+	{ "EPHIDGET_INVALID", 13 },
+	{ "PHIDID_SAF1000", 84 },
+	{ "POWER_SUPPLY_OFF", 1 },
+	{ "PHIDID_1012", 8 },
+	{ "IO_VOLTAGE_2_5V", 3 },
+	{ "VOLTAGE_OUTPUT_RANGE_10V", 1 },
+	{ "FONT_User2", 2 },
+	{ "PHIDID_REL1000", 81 },
+	{ "EPHIDGET_UNKNOWNVAL", 51 },
+	{ "PHIDCHSUBCLASS_ENCODER_MODE_SETTABLE", 96 },
+	{ "PHIDCHCLASS_RCSERVO", 22 },
+	{ "PARITY_MODE_NONE", 1 },
+	{ "MESHMODE_SLEEPYENDDEVICE", 2 },
+	{ "PHIDCHCLASS_DCMOTOR", 4 },
+	{ "PHIDID_STC1001", 115 },
+	{ "POWER_SUPPLY_12V", 2 },
+	{ "VOLTAGE_RANGE_40V", 10 },
+	{ "PHIDID_1059", 36 },
+	{ "SCREEN_SIZE_4x16", 6 },
+	{ "IO_VOLTAGE_1_8V", 2 },
+	{ "SENSOR_TYPE_3584", 35840 },
+	{ "ENCODER_IO_MODE_PUSH_PULL", 1 },
+	{ "EEPHIDGET_OVERVOLTAGE", 4107 },
+	{ "PROTOCOL_I2C", 6 },
+	{ "PHIDID_INTERFACEKIT_4_8_8", 1 },
+	{ "SENSOR_TYPE_1133", 11330 },
+	{ "PHIDID_TMP1000", 87 },
+	{ "EPHIDGET_UNKNOWNVALHIGH", 60 },
+	{ "MOTOR_POSITION_TYPE_HALL", 2 },
+	{ "EEPHIDGET_OVERCURRENT", 4102 },
+	{ "SENSOR_TYPE_1127", 11270 },
+	{ "PHIDID_1002", 4 },
+	{ "PHIDCLASS_HUB", 8 },
+	{ "SENSOR_TYPE_MOT2002_MED", 20021 },
+	{ "SPATIAL_ALGORITHM_IMU", 2 },
+	{ "PROTOCOL_MODBUS_RTU", 4 },
+	{ "PHIDUNIT_AMPERE", 10 },
+	{ "THERMOCOUPLE_TYPE_K", 2 },
+	{ "PORT_MODE_DIGITAL_OUTPUT", 2 },
+	{ "RTD_WIRE_SETUP_4WIRE", 3 },
+	{ "EPHIDGET_PIPE", 41 },
+	{ "PHIDID_1061", 38 },
+	{ "EEPHIDGET_NETWORK", 3 },
+	{ "BRIDGE_GAIN_32", 6 },
+	{ "SENSOR_TYPE_3589", 35890 },
+	{ "PHIDID_1064", 41 },
+	{ "PHIDID_DAQ1000", 51 },
+	{ "MOTOR_DRIVE_TYPE_ACTIVE", 2 },
+	{ "PHIDCHCLASS_FIRMWAREUPGRADE", 32 },
+	{ "PHIDID_DAQ1500", 56 },
+	{ "LED_FORWARD_VOLTAGE_2_75V", 2 },
+	{ "PHIDID_1049", 27 },
+	{ "MOTOR_POSITION_TYPE_ENCODER", 1 },
+	{ "SENSOR_TYPE_1141", 11410 },
+	{ "EPHIDGET_AGAIN", 22 },
+	{ "DEBOUNCE_MODE_LEADING_EDGE", 2 },
+	{ "SCREEN_SIZE_1x16", 4 },
+	{ "PHIDID_1058", 35 },
+	{ "SENSOR_TYPE_3509", 35090 },
+	{ "POWER_SUPPLY_24V", 3 },
+	{ "PORT_MODE_DIGITAL_INPUT", 1 },
+	{ "PHIDCLASS_DICTIONARY", 24 },
+	{ "PHIDID_MOT1100", 73 },
+};
+
+static const uint16_t enumNameDisp[ENUMNAME_BUCKETS] = {
+	0, 7, 0, 1, 0, 3, 0, 32, 6, 1, 8, 8,
+	3, 11, 0, 7, 17, 2, 0, 13, 0, 0, 10, 9,
+	0, 25, 0, 4, 13, 1, 2, 0, 4, 9, 0, 2,
+	2, 10, 9, 4, 0, 9, 21, 21, 12, 4, 13, 0,
+	0, 3, 0, 31, 0, 18, 29, 59, 40, 0, 2, 0,
+	28, 25, 0, 3, 22, 35, 2, 16, 9, 1, 0, 54,
+	3, 13, 2, 1, 0, 18, 1, 0, 13, 24, 6, 34,
+	13, 11, 0, 1, 69, 31, 1, 1, 52, 3, 42, 71,
+	83, 43, 35, 9, 14, 2, 22, 38, 84, 1, 0, 2,
+	0, 53, 3, 69, 1, 3, 1, 17, 0, 190, 190, 4,
+	121, 193, 3, 25, 0, 80, 1, 5, 0, 81, 8, 141,
+	3, 61, 125, 94, 5, 35, 41, 55, 1, 53, 0, 1,
+	208, 31, 21, 0, 1, 44, 9, 9, 9, 73, 160, 148,
+	261, 0, 189, 263, 0, 5, 97, 4, 12, 37, 1, 10,
+	36, 1, 36, 276, 28, 15, 53, 441, 5, 62, 51, 5,
+	6, 367, 3, 31, 8, 1225, 391, 2, 139, 29, 1986, 7,
+};
+
+static uint32_t
+enumNameSlot(uint32_t h, uint32_t d) {
+
+	h ^= d * 0x9E3779B9U;
+	h ^= h >> 16;
+	h *= 0x85EBCA6BU;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35U;
+	h ^= h >> 16;
+	return (h % ENUMNAME_CNT);
+}
 
-	if (mos_strcasecmp(name, "PORT_MODE_VOLTAGE_INPUT") == 0)
-		return (3);
+API_IRETURN
+Phidget_enumFromString(const char *name) {
+	const unsigned char *c;
+	uint32_t h1, h2;
+	uint32_t ch;
+	uint32_t i;
+
+	if (name == NULL)
+		return (-1);
+
+	h1 = 2166136261U;
+	h2 = 0;
+	for (c = (const unsigned char *)name; *c != '\0'; c++) {
+		ch = *c;
+		if (ch >= 'a' && ch <= 'z')
+			ch -= 'a' - 'A';
+		h1 = (h1 ^ ch) * 16777619U;
+		h2 = h2 * 31 + ch;
+	}
 
-	if (mos_strcasecmp(name, "PORT_MODE_VOLTAGE_RATIO_INPUT") == 0)
-		return (4);
+	i = enumNameSlot(h2, enumNameDisp[h1 % ENUMNAME_BUCKETS]);
+	if (mos_strcasecmp(name, enumNames[i].name) == 0)
+		return (enumNames[i].value);
 
 	return (-1);
 }
@@ -2561,6 +1543,17 @@ Phidget_enumString(const char *family, int id) {
 		}
 	}
 
+	if (mos_strcasecmp(family, "DebounceMode") == 0) {
+		switch (id) {
+		case 1:
+			return ("DEBOUNCE_MODE_TRAILING_EDGE");
+		case 2:
+			return ("DEBOUNCE_MODE_LEADING_EDGE");
+		default:
+			return ("");
+		}
+	}
+
 	if (mos_strcasecmp(family, "LEDForwardVoltage") == 0) {
 		switch (id) {
 		case 1:
@@ -0,0 +1,86 @@
+#include "mos_atomic.h"
+
+/*
+ * Lock-free atomics on the compiler's __atomic builtins (GCC 4.7+, clang).  configure defines
+ * MOS_ATOMIC_BUILTINS when they link; otherwise mos_atomic-pthread.c provides the mutex fallback.
+ *
+ * Everything is sequentially consistent, as the mutex version was.
+ */
+#ifdef MOS_ATOMIC_BUILTINS
+
+void
+mos_atomic_add_32(uint32_t *dst, int32_t delta) {
+
+	__atomic_add_fetch(dst, (uint32_t)delta, __ATOMIC_SEQ_CST);
+}
+
+uint32_t
+mos_atomic_add_32_nv(uint32_t *dst, int32_t delta) {
+
+	return (__atomic_add_fetch(dst, (uint32_t)delta, __ATOMIC_SEQ_CST));
+}
+
+void
+mos_atomic_add_64(uint64_t *dst, int64_t delta) {
+
+	__atomic_add_fetch(dst, (uint64_t)delta, __ATOMIC_SEQ_CST);
+}
+
+uint64_t
+mos_atomic_add_64_nv(uint64_t *dst, int64_t delta) {
+
+	return (__atomic_add_fetch(dst, (uint64_t)delta, __ATOMIC_SEQ_CST));
+}
+
+uint32_t
+mos_atomic_get_32(uint32_t *dst) {
+
+	return (__atomic_load_n(dst, __ATOMIC_SEQ_CST));
+}
+
+uint64_t
+mos_atomic_get_64(uint64_t *dst) {
+
+	return (__atomic_load_n(dst, __ATOMIC_SEQ_CST));
+}
+
+uint32_t
+mos_atomic_swap_32(uint32_t *dst, uint32_t nv) {
+
+	return (__atomic_exchange_n(dst, nv, __ATOMIC_SEQ_CST));
+}
+
+uint64_t
+mos_atomic_swap_64(uint64_t *dst, uint64_t nv) {
+
+	return (__atomic_exchange_n(dst, nv, __ATOMIC_SEQ_CST));
+}
+
+void *
+mos_atomic_swap_ptr(void **dst, void *nv) {
+
+	return (__atomic_exchange_n(dst, nv, __ATOMIC_SEQ_CST));
+}
+
+/*
+ * Stores nv if *dst is cv.  Returns the previous value of *dst.
+ */
+uint32_t
+mos_atomic_cas_32(uint32_t *dst, uint32_t cv, uint32_t nv) {
+
+	__atomic_compare_exchange_n(dst, &cv, nv, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return (cv);
+}
+
+uint64_t
+mos_atomic_cas_64(uint64_t *dst, uint64_t cv, uint64_t nv) {
+
+	__atomic_compare_exchange_n(dst, &cv, nv, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return (cv);
+}
+
+void
+_mos_atomic_init(void) {
+}
+
+#endif /* MOS_ATOMIC_BUILTINS */
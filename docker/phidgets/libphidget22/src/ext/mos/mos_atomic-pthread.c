@@ -1,6 +1,11 @@
 #include <pthread.h>
 #include "mos_atomic.h"
 
+/*
+ * Fallback for toolchains without __atomic builtins: every operation is serialized on one mutex.
+ */
+#ifndef MOS_ATOMIC_BUILTINS
+
 static pthread_mutex_t sync_lock = PTHREAD_MUTEX_INITIALIZER;
 
 void
@@ -90,6 +95,49 @@ mos_atomic_swap_64(uint64_t *dst, uint64_t nv) {
 	return (ov);
 }
 
+void *
+mos_atomic_swap_ptr(void **dst, void *nv) {
+	void *ov;
+
+	pthread_mutex_lock(&sync_lock);
+	ov = *dst;
+	*dst = nv;
+	pthread_mutex_unlock(&sync_lock);
+
+	return (ov);
+}
+
+/*
+ * Stores nv if *dst is cv.  Returns the previous value of *dst.
+ */
+uint32_t
+mos_atomic_cas_32(uint32_t *dst, uint32_t cv, uint32_t nv) {
+	uint32_t ov;
+
+	pthread_mutex_lock(&sync_lock);
+	ov = *dst;
+	if (ov == cv)
+		*dst = nv;
+	pthread_mutex_unlock(&sync_lock);
+
+	return (ov);
+}
+
+uint64_t
+mos_atomic_cas_64(uint64_t *dst, uint64_t cv, uint64_t nv) {
+	uint64_t ov;
+
+	pthread_mutex_lock(&sync_lock);
+	ov = *dst;
+	if (ov == cv)
+		*dst = nv;
+	pthread_mutex_unlock(&sync_lock);
+
+	return (ov);
+}
+
 void
 _mos_atomic_init(void) {
 }
+
+#endif /* !MOS_ATOMIC_BUILTINS */
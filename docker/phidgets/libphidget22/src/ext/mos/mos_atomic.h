@@ -16,5 +16,9 @@ MOSAPI uint64_t MOSCConv mos_atomic_get_64(uint64_t *);
 
 MOSAPI uint32_t MOSCConv mos_atomic_swap_32(uint32_t *, uint32_t);
 MOSAPI uint64_t MOSCConv mos_atomic_swap_64(uint64_t *, uint64_t);
+MOSAPI void * MOSCConv mos_atomic_swap_ptr(void **, void *);
+
+MOSAPI uint32_t MOSCConv mos_atomic_cas_32(uint32_t *, uint32_t, uint32_t);
+MOSAPI uint64_t MOSCConv mos_atomic_cas_64(uint64_t *, uint64_t, uint64_t);
 
 #endif /* _MOS_ATOMIC_H_ */
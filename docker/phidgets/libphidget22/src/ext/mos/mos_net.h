@@ -41,6 +41,16 @@ typedef struct mos_sockaddr_list {
 	struct mos_sockaddr_list *next;
 } mos_sockaddr_list_t;
 
+/*
+ * A buffer gathered into a single write by mos_netop_tcp_writev().
+ */
+typedef struct mos_iovec {
+	const void	*base;
+	size_t		len;
+} mos_iovec_t;
+
+#define MOS_IOV_MAX	16	/* most buffers a single mos_netop_tcp_writev() will write */
+
 typedef enum {
 	MOS_AF_INET4 = AF_INET,
 	MOS_AF_INET6 = AF_INET6
@@ -1,5 +1,6 @@
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <poll.h>
@@ -25,6 +26,7 @@
 #if defined(Linux)
 #include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <sys/sendfile.h>
 #endif
 
 #include "mos/mos_os.h"
@@ -283,6 +285,28 @@ mos_netop_tcp_rpoll(mosiop_t iop, mos_socket_t *sock, uint32_t msec) {
 	return (0);
 }
 
+/*
+ * Waits up to msec for the socket to have room to write (or for an error to report).
+ */
+int
+mos_netop_tcp_wpoll(mosiop_t iop, mos_socket_t *sock, uint32_t msec) {
+	struct pollfd pfd;
+	int res;
+
+	pfd.fd = *sock;
+	pfd.events = POLLOUT;
+	pfd.revents = 0;
+
+	res = poll(&pfd, 1, (int)msec);
+	if (res < 0)
+		return (MOS_ERROR(iop, mos_fromerrno(errno), "poll() failed:%s",
+		  strerror(errno)));
+	if (res == 0)
+		return (MOSN_TIMEDOUT);
+
+	return (0);
+}
+
 MOSAPI int MOSCConv
 mos_netop_tcp_rpoll2(mosiop_t iop, mos_socket_t *s1, mos_socket_t *s2, int *socks, uint32_t msec) {
 	struct timeval timeval;
@@ -378,6 +402,100 @@ mos_netop_tcp_write(mosiop_t iop, mos_socket_t *sock, const void *v, size_t *len
 	return (0);
 }
 
+static int
+tcp_writev(mosiop_t iop, mos_socket_t *sock, const mos_iovec_t *iov, int cnt, size_t *len, int flags) {
+	struct iovec vec[MOS_IOV_MAX];
+	struct msghdr msg;
+	ssize_t res;
+	int i;
+
+	CHECKTCPSOCKET;
+
+	if (cnt > MOS_IOV_MAX)
+		cnt = MOS_IOV_MAX;
+
+	for (i = 0; i < cnt; i++) {
+		vec[i].iov_base = (void *)(uintptr_t)iov[i].base;	/* sendmsg() does not write through it */
+		vec[i].iov_len = iov[i].len;
+	}
+
+	memset(&msg, 0, sizeof (msg));
+	msg.msg_iov = vec;
+	msg.msg_iovlen = cnt;
+
+	res = sendmsg(*sock, &msg, flags);
+	if (res < 0) {
+		if ((flags & MSG_DONTWAIT) && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			*len = 0;
+			return (0);
+		}
+		return (MOS_ERROR(iop, mos_fromerrno(errno), "sendmsg() failed%s",
+		  strerror(errno)));
+	}
+
+	*len = (size_t)res;
+
+	return (0);
+}
+
+/*
+ * Writes the buffers in order with a single send, so a small header and its payload can leave in
+ * one segment.  Only the first MOS_IOV_MAX buffers are considered; *len is set to the number of
+ * bytes written, which may end part way through any buffer.
+ */
+int
+mos_netop_tcp_writev(mosiop_t iop, mos_socket_t *sock, const mos_iovec_t *iov, int cnt, size_t *len) {
+
+	return (tcp_writev(iop, sock, iov, cnt, len, 0));
+}
+
+/*
+ * As mos_netop_tcp_writev(), but never blocks: *len is set to 0 if the socket has no room.
+ */
+int
+mos_netop_tcp_trywritev(mosiop_t iop, mos_socket_t *sock, const mos_iovec_t *iov, int cnt, size_t *len) {
+
+	return (tcp_writev(iop, sock, iov, cnt, len, MSG_DONTWAIT));
+}
+
+/*
+ * Sends up to *len bytes of the file open on fd, starting at off: *len is set to the number sent.
+ * The kernel copies the file straight to the socket where sendfile() is available.
+ */
+int
+mos_netop_tcp_sendfile(mosiop_t iop, mos_socket_t *sock, int fd, uint64_t off, size_t *len) {
+	ssize_t res;
+#if !defined(Linux)
+	uint8_t buf[32768];
+#endif
+
+	CHECKTCPSOCKET;
+
+#if defined(Linux)
+	{
+		off_t o;
+
+		o = (off_t)off;
+		res = sendfile(*sock, fd, &o, *len);
+		if (res < 0)
+			return (MOS_ERROR(iop, mos_fromerrno(errno), "sendfile() failed:%s", strerror(errno)));
+	}
+#else
+	res = pread(fd, buf, MOS_MIN(*len, sizeof (buf)), (off_t)off);
+	if (res < 0)
+		return (MOS_ERROR(iop, mos_fromerrno(errno), "pread() failed:%s", strerror(errno)));
+	if (res > 0) {
+		res = send(*sock, buf, (size_t)res, 0);
+		if (res < 0)
+			return (MOS_ERROR(iop, mos_fromerrno(errno), "send() failed:%s", strerror(errno)));
+	}
+#endif
+
+	*len = (size_t)res;
+
+	return (0);
+}
+
 int
 mos_netop_gethostname(mosiop_t iop, char *name, size_t namelen) {
 
@@ -22,9 +22,13 @@ MOSAPI int MOSCConv mos_netop_tcp_available(mosiop_t, mos_socket_t *, int *);
 MOSAPI int MOSCConv mos_netop_tcp_setnonblocking(mosiop_t, mos_socket_t *, int);
 MOSAPI int MOSCConv mos_netop_tcp_rpoll(mosiop_t, mos_socket_t *, uint32_t);
 MOSAPI int MOSCConv mos_netop_tcp_rpoll2(mosiop_t, mos_socket_t *, mos_socket_t *, int *, uint32_t);
+MOSAPI int MOSCConv mos_netop_tcp_wpoll(mosiop_t, mos_socket_t *, uint32_t);
 MOSAPI int MOSCConv mos_netop_tcp_read(mosiop_t, mos_socket_t *, void *, size_t *);
 MOSAPI int MOSCConv mos_netop_tcp_readfully(mosiop_t, mos_socket_t *, void *, size_t *);
 MOSAPI int MOSCConv mos_netop_tcp_write(mosiop_t, mos_socket_t *, const void *, size_t *);
+MOSAPI int MOSCConv mos_netop_tcp_writev(mosiop_t, mos_socket_t *, const mos_iovec_t *, int, size_t *);
+MOSAPI int MOSCConv mos_netop_tcp_trywritev(mosiop_t, mos_socket_t *, const mos_iovec_t *, int, size_t *);
+MOSAPI int MOSCConv mos_netop_tcp_sendfile(mosiop_t, mos_socket_t *, int, uint64_t, size_t *);
 MOSAPI int MOSCConv mos_netop_tcp_writefully(mosiop_t, mos_socket_t *, const void *, size_t);
 MOSAPI int MOSCConv mos_netop_getsockname(mosiop_t, mos_socket_t *, mos_sockaddr_t *);
 MOSAPI int MOSCConv mos_netop_getpeername(mosiop_t, mos_socket_t *, mos_sockaddr_t *);
@@ -1,4 +1,9 @@
 
+#if defined(Linux)
+#define _GNU_SOURCE	/* sched_setaffinity() */
+#include <sched.h>
+#endif
+
 #include <pthread.h>
 #include <limits.h>
 
@@ -100,3 +105,24 @@ mos_task_setname(const char *fmt, ...) {
 // XXX - Figure this out for Linux - but sometimes pthread_setname_np
 //       doesn't exist, sometimes it takes 2 args, etc..
 }
+
+/*
+ * Binds the calling task to a single cpu.
+ */
+MOSAPI int MOSCConv
+mos_task_setaffinity(int cpu) {
+#if defined(Linux)
+	cpu_set_t set;
+
+	if (cpu < 0 || cpu >= CPU_SETSIZE)
+		return (MOSN_INVALARG);
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set) != 0)
+		return (MOSN_ERR);
+	return (0);
+#else
+	return (MOSN_NOSUP);
+#endif
+}
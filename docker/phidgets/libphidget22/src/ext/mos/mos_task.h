@@ -86,5 +86,6 @@ MOSAPI int MOSCConv mos_task_exit(int);
 MOSAPI int MOSCConv mos_task_equal(mos_task_t, mos_task_t);
 MOSAPI mos_task_t MOSCConv mos_self(void);
 MOSAPI void mos_task_setname(const char *fmt, ...);
+MOSAPI int MOSCConv mos_task_setaffinity(int);
 
 #endif /* _MOS_TASK_H_ */
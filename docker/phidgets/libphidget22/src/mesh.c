@@ -42,6 +42,7 @@ addMeshHubs(PhidgetDeviceHandle device) {
 	PhidgetReturnCode res;
 	Phidget_MeshMode mode;
 	int hubIndex, found;
+	int uid;
 	size_t len;
 	int index;
 
@@ -55,8 +56,6 @@ addMeshHubs(PhidgetDeviceHandle device) {
 	assert(conn);
 
 	for (;;) {
-		pdd = Phidget_Unique_Device_Def;
-
 		if (PhidgetUSBGetString(conn, index++ + 5, vintHubString) != EPHIDGET_OK)
 			break;
 
@@ -95,41 +94,38 @@ addMeshHubs(PhidgetDeviceHandle device) {
 		found = PFALSE;
 
 		//fill in the properties
-		while (((int)pdd->type) != END_OF_LIST) {
-			if (pdd->type == PHIDTYPE_MESH && id == pdd->productID && version >= pdd->versionLow &&
-			  version < pdd->versionHigh) {
-				hub = (PhidgetHubDeviceHandle)getChild(device, hubIndex);
+		if (matchUniqueDevice(PHIDTYPE_MESH, 0, id, 0, version, &uid) == EPHIDGET_OK) {
+			pdd = &Phidget_Unique_Device_Def[uid];
+
+			hub = (PhidgetHubDeviceHandle)getChild(device, hubIndex);
 
-				if (hub && hub->phid.deviceInfo.UDD == pdd && hub->phid.deviceInfo.serialNumber == serial &&
-				  hub->phid.deviceInfo.version == version) {
-					PhidgetSetFlags(hub, PHIDGET_SCANNED_FLAG);
-				} else {
-					res = createPhidgetMeshDevice(pdd, version, device->deviceInfo.label, serial, (PhidgetDeviceHandle *)&hub);
-					if (res != EPHIDGET_OK)
-						return (res);
+			if (hub && hub->phid.deviceInfo.UDD == pdd && hub->phid.deviceInfo.serialNumber == serial &&
+			  hub->phid.deviceInfo.version == version) {
+				PhidgetSetFlags(hub, PHIDGET_SCANNED_FLAG);
+			} else {
+				res = createPhidgetMeshDevice(pdd, version, device->deviceInfo.label, serial, (PhidgetDeviceHandle *)&hub);
+				if (res != EPHIDGET_OK)
+					return (res);
 
-					PhidgetSetFlags(hub, PHIDGET_SCANNED_FLAG);
+				PhidgetSetFlags(hub, PHIDGET_SCANNED_FLAG);
 
-					hub->phid.deviceInfo.uniqueIndex = hubIndex;
-					hub->phid.deviceInfo.meshMode = mode;
+				hub->phid.deviceInfo.uniqueIndex = hubIndex;
+				hub->phid.deviceInfo.meshMode = mode;
 
-					setParent(hub, device);
-					setChild(device, hubIndex, hub);
+				setParent(hub, device);
+				setChild(device, hubIndex, hub);
 
-					deviceAttach((PhidgetDeviceHandle)hub, 0);
-				}
+				deviceAttach((PhidgetDeviceHandle)hub, 0);
+			}
 
-				//Update the vint device string and add vint devices
-				memcpy(hub->portDescString, vintHubString + 19, portCnt * 6 + portModeCnt * 6);
-				hub->portDescString[portCnt * 6 + portModeCnt * 6] = '\0';
+			//Update the vint device string and add vint devices
+			memcpy(hub->portDescString, vintHubString + 19, portCnt * 6 + portModeCnt * 6);
+			hub->portDescString[portCnt * 6 + portModeCnt * 6] = '\0';
 
-				scanVintDevices((PhidgetDeviceHandle)hub);
-				PhidgetRelease(&hub);
+			scanVintDevices((PhidgetDeviceHandle)hub);
+			PhidgetRelease(&hub);
 
-				found = PTRUE;
-				break;
-			}
-			pdd++;
+			found = PTRUE;
 		}
 
 		if (!found)
@@ -267,16 +267,21 @@ done:
 }
 
 /*
- * XXX We need to figure out what to do with single errors in these bulk sends..
- * probably something like shutting down the network connection and causing a complete
- * rebuild.
+ * Events are rendered once for each encoding in use, and queued by reference on each connection:
+ * nothing here waits on a connection, and a connection that fails does not affect the others.
+ * Anything that is not an event expects a reply, and is still sent to each connection in turn.
  */
 PhidgetReturnCode
 sendToNetworkConnections(PhidgetChannelHandle channel, BridgePacket *bp, PhidgetNetConnHandle ignoreNC) {
+	NetEventBuffer *eb[BPENC_MAX + 1];
 	PhidgetChannelNetConn *cnc;
-	PhidgetReturnCode res;
+	PhidgetReturnCode res, res1;
+	int event;
+	int i;
 
 	res = EPHIDGET_OK;
+	memset(eb, 0, sizeof (eb));
+	event = bridgePacketIsEvent(bp);
 
 	bridgePacketSetOpenChannelId(bp, getChannelId(channel));
 	bridgePacketSetPhidId(bp, PHIDID(channel)); /* set for web client so they can match the reply */
@@ -289,15 +294,40 @@ sendToNetworkConnections(PhidgetChannelHandle channel, BridgePacket *bp, Phidget
 		if (PhidgetCKFlags(cnc->nc, PNCF_CLOSED) != 0)
 			continue;
 
-		/*
-		 * Potential optimization would be to only render the json once.
-		 */
-		res = networkSendBridgePacket(channel, bp, cnc->nc);
-		if (res != EPHIDGET_OK)
-			break;
+		if (!event) {
+			res1 = networkSendBridgePacket(channel, bp, cnc->nc);
+		} else {
+			i = cnc->nc->bpenc;
+			if (eb[i] == NULL) {
+				res1 = renderNetEventBuffer(bp, i, &eb[i]);
+				if (res1 != EPHIDGET_OK) {
+					res = res1;
+					continue;
+				}
+				/* Backlogged connections may keep only the latest value */
+				if (bridgePacketCoalescable(channel, bp)) {
+					eb[i]->ckey = channel;
+					eb[i]->cpkt = bp->vpkt;
+				}
+			}
+			res1 = queueNetConnEvent(cnc->nc, eb[i]);
+		}
+
+		/* The connection closed after the check above */
+		if (res1 == EPHIDGET_CLOSED)
+			continue;
+
+		if (res1 != EPHIDGET_OK) {
+			netlogerr("failed to send %s to %s: "PRC_FMT, bridgepacketinfo[bp->vpkt].name, cnc->nc->peername,
+			  PRC_ARGS(res1));
+			res = res1;
+		}
 	}
 	mos_mutex_unlock(&channel->netconnslk);
 
+	for (i = 0; i <= BPENC_MAX; i++)
+		releaseNetEventBuffer(&eb[i]);
+
 	return (res);
 }
 
@@ -58,15 +58,11 @@ addNetVintDevice(PhidgetDeviceHandle device, int childIndex, int vintID, int ver
 	PhidgetHubDeviceHandle hub;
 	PhidgetDeviceHandle phid;
 	PhidgetReturnCode res;
+	int uid;
 
 again:
-	for (pdd = Phidget_Unique_Device_Def; (int)(pdd->type) != END_OF_LIST; pdd++) {
-		if (pdd->type != PHIDTYPE_VINT)
-			continue;
-		if (pdd->vintID != vintID)
-			continue;
-		if (version >= pdd->versionHigh || version < pdd->versionLow)
-			continue;
+	if (matchUniqueVINTDevice(vintID, version, &uid) == EPHIDGET_OK) {
+		pdd = &Phidget_Unique_Device_Def[uid];
 
 		phid = getChild(device, childIndex);
 		if (phid != NULL) {
@@ -359,10 +355,10 @@ handleBridgePacket(mosiop_t iop, PhidgetNetConnHandle nc, netreq_t *req) {
 
 	netlogverbose("%"PRIphid": %s/%s", nc, strmsgtype(req->nr_type), strmsgsubtype(req->nr_stype));
 
-	res = parseBridgePacketJSON(nc->tokens, &bp, (char *)req->nr_data, req->nr_len);
+	res = parseBridgePacket(nc->tokens, &bp, req->nr_data, req->nr_len);
 	if (res != EPHIDGET_OK) {
 		netlogerr("client failed to parse bridge packet: "PRC_FMT, PRC_ARGS(res));
-		return (MOS_ERROR(iop, EPHIDGET_UNEXPECTED, "invalid json in device attach"));
+		return (MOS_ERROR(iop, EPHIDGET_UNEXPECTED, "invalid bridge packet"));
 	}
 
 	bridgePacketSetIsFromNet(bp, nc);
@@ -503,7 +499,7 @@ again:
 		return (EPHIDGET_INVALIDARG);
 	}
 
-	res = parseBridgePacketJSON(NULL, &bp, (char *)wfr->req.nr_data, wfr->req.nr_len);
+	res = parseBridgePacket(NULL, &bp, wfr->req.nr_data, wfr->req.nr_len);
 	closeWaitForReply(&wfr);
 	MOS_ASSERT(wfr == NULL);
 	if (res != EPHIDGET_OK) {
@@ -42,17 +42,154 @@
 #include "mos/mos_base64.h"
 #include "mos/mos_sha2.h"
 #include "mos/mos_byteorder.h"
+#include "mos/mos_atomic.h"
 #include "util/json.h"
+#include "util/phidgetconfig.h"
 
 #define NET_IDENT		"phidgetclient"
 
 static void devicerelease(PhidgetNetConnHandle *);
+static void flushNetConnOutput(PhidgetNetConnHandle);
+static void dropNetConnOutput(PhidgetNetConnHandle);
+static void checkNetConnBacklog(PhidgetNetConnHandle);
+static void drainNetConnOutput(PhidgetNetConnHandle);
+static void stopOutputWorkers(void);
 
 extern int _allowDataGram;
 
+/*
+ * Pool of reply data buffers, in power of two size classes from REPLYPOOL_MIN to REPLYPOOL_MAX.
+ * Most replies are a short JSON result, so waiters only hold a buffer sized to the reply, and
+ * buffers are recycled instead of allocated per request. Larger replies are allocated directly.
+ */
+#define REPLYPOOL_MINSHIFT	6		/* 64 bytes */
+#define REPLYPOOL_MAXSHIFT	14		/* 16KB */
+#define REPLYPOOL_CLASSES	(REPLYPOOL_MAXSHIFT - REPLYPOOL_MINSHIFT + 1)
+#define REPLYPOOL_DEPTH		32		/* buffers kept per size class */
+
+typedef struct _ReplyBuffer {
+	struct _ReplyBuffer *next;
+} ReplyBuffer;
+
+static mos_mutex_t replyPoolLock;
+static ReplyBuffer *replyPool[REPLYPOOL_CLASSES];
+static int replyPoolCnt[REPLYPOOL_CLASSES];
+
+static int
+replyPoolClass(uint32_t len, uint32_t *sz) {
+	int cls;
+
+	for (cls = 0; cls < REPLYPOOL_CLASSES; cls++) {
+		*sz = 1 << (cls + REPLYPOOL_MINSHIFT);
+		if (len <= *sz)
+			return (cls);
+	}
+
+	*sz = len;
+	return (-1);
+}
+
+static uint8_t *
+getReplyBuffer(uint32_t len, uint32_t *sz) {
+	ReplyBuffer *rb;
+	int cls;
+
+	cls = replyPoolClass(len, sz);
+	if (cls < 0)
+		return (mos_malloc(*sz));
+
+	mos_mutex_lock(&replyPoolLock);
+	rb = replyPool[cls];
+	if (rb != NULL) {
+		replyPool[cls] = rb->next;
+		replyPoolCnt[cls]--;
+	}
+	mos_mutex_unlock(&replyPoolLock);
+
+	if (rb == NULL)
+		return (mos_malloc(*sz));
+	return ((uint8_t *)rb);
+}
+
+static void
+putReplyBuffer(uint8_t *buf, uint32_t sz) {
+	ReplyBuffer *rb;
+	uint32_t clssz;
+	int cls;
+
+	if (buf == NULL)
+		return;
+
+	cls = replyPoolClass(sz, &clssz);
+	if (cls >= 0) {
+		mos_mutex_lock(&replyPoolLock);
+		if (replyPoolCnt[cls] < REPLYPOOL_DEPTH) {
+			rb = (ReplyBuffer *)buf;
+			rb->next = replyPool[cls];
+			replyPool[cls] = rb;
+			replyPoolCnt[cls]++;
+			buf = NULL;
+		}
+		mos_mutex_unlock(&replyPoolLock);
+	}
+
+	if (buf != NULL)
+		mos_free(buf, sz);
+}
+
+static void
+drainReplyPool(void) {
+	ReplyBuffer *rb;
+	int cls;
+
+	mos_mutex_lock(&replyPoolLock);
+	for (cls = 0; cls < REPLYPOOL_CLASSES; cls++) {
+		while ((rb = replyPool[cls]) != NULL) {
+			replyPool[cls] = rb->next;
+			mos_free(rb, 1 << (cls + REPLYPOOL_MINSHIFT));
+		}
+		replyPoolCnt[cls] = 0;
+	}
+	mos_mutex_unlock(&replyPoolLock);
+}
+
+/*
+ * Events broadcast to several connections are queued on each connection, and written by a small
+ * pool of output workers, so the broadcast never waits on a socket.  A connection with queued
+ * events is on outWork while it waits for a worker, and is only ever drained by one worker at a time.
+ * Workers do not block on a full socket: what it will not take is kept with the connection, which is
+ * parked on outBlocked and retried.
+ */
+#define NETOUT_WORKERS		2
+#define NETOUT_BATCH		32		/* events written before the connection goes to the back of the line */
+#define NETOUT_QUEUEMIN		16		/* initial size of a connection output queue */
+#define NETOUT_RETRY		10		/* msec between write attempts to a connection with a full socket */
+
+#define NETOUT_EMPTY		0
+#define NETOUT_MORE			1		/* events remain queued */
+#define NETOUT_BLOCKED		2		/* events remain queued, but the socket is full */
+
+static mos_mutex_t outWorkLock;
+static mos_cond_t outWorkCond;
+static phidgetnetconnlist_t outWork;
+static phidgetnetconnlist_t outBlocked;	/* connections waiting for room in their socket */
+static int outWorkers;
+static int outWorkStop;
+
+/* Output queue settings for new connections: protected by outWorkLock */
+#define NETOUT_HIGH_DEFAULT	4096
+static uint32_t outQueueHigh = NETOUT_HIGH_DEFAULT;
+static uint32_t outQueueLow = NETOUT_HIGH_DEFAULT / 4;
+static int outQueuePolicy = NETOUT_POLICY_COALESCE;
+
 void
 PhidgetNetInit() {
 
+	mos_mutex_init(&replyPoolLock);
+	mos_mutex_init(&outWorkLock);
+	mos_cond_init(&outWorkCond);
+	MTAILQ_INIT(&outWork);
+	MTAILQ_INIT(&outBlocked);
 	NetworkControlInit();
 	ServersInit();
 	ServerInit();
@@ -70,6 +207,13 @@ PhidgetNetFini() {
 	ZeroconfFini();
 #endif
 	NetworkControlFini();
+
+	stopOutputWorkers();
+	mos_cond_destroy(&outWorkCond);
+	mos_mutex_destroy(&outWorkLock);
+
+	drainReplyPool();
+	mos_mutex_destroy(&replyPoolLock);
 }
 
 static int networkStartRefCnt;
@@ -326,7 +470,10 @@ handleWaitForReply(WaitForReply *wfr, netreq_t *req) {
 		return (EPHIDGET_UNEXPECTED);
 
 	assert(wfr->req.nr_repseq == req->nr_repseq);
-	wfr->req = *req;
+	wfr->req.nr_hdr = req->nr_hdr;
+	wfr->req.nr_data = getReplyBuffer(req->nr_len + 1, &wfr->req.nr_datasz);
+	memcpy(wfr->req.nr_data, req->nr_data, req->nr_len);
+	wfr->req.nr_data[req->nr_len] = '\0';
 	wfr->flags |= WFR_RECEIVED;
 	mos_cond_broadcast(&wfr->cond);
 	return (EPHIDGET_OK);
@@ -415,6 +562,7 @@ closeWaitForReply(WaitForReply **_wfr) {
 	mos_tlock_destroy(&wfr->lock);
 	mos_cond_destroy(&wfr->cond);
 
+	putReplyBuffer(wfr->req.nr_data, wfr->req.nr_datasz);
 	mos_free(wfr, sizeof(*wfr));
 
 	*_wfr = NULL;
@@ -618,41 +766,230 @@ pnread(mosiop_t iop, PhidgetNetConnHandle nc, void *vbuf, uint32_t *len) {
 	return (0);
 }
 
+/*
+ * Reads up to *len bytes, returning as soon as any have been read: *len is 0 at the end of the stream.
+ */
+API_PRETURN
+pnreadsome(mosiop_t iop, PhidgetNetConnHandle nc, void *vbuf, uint32_t *len) {
+	mos_socket_t s;
+	size_t n;
+	int err;
+
+	s = nc->sock;
+
+	for (;;) {
+		if (nc->errcondition != EPHIDGET_OK)
+			return (nc->errcondition);
+
+		n = (size_t)*len;
+		err = mos_netop_tcp_read(MOS_IOP_IGNORE, &s, vbuf, &n);
+		if (err == 0)
+			break;
+		if (err != MOSN_AGAIN)
+			return (MOS_ERROR(iop, err, "TCP read failed"));
+	}
+	*len = (uint32_t)n;
+
+	return (0);
+}
+
 PhidgetReturnCode
 devicewrite(mosiop_t iop, PhidgetNetConnHandle nc, const void *vbuf, uint32_t len) {
 
 	return (pnwrite(iop, nc, vbuf, len));
 }
 
+/*
+ * An output worker must not block on a connection's socket.  While a worker drains the queue, whatever
+ * the socket will not take is kept in outpend, and is sent ahead of anything written after it.
+ */
+static int
+pnnowait(PhidgetNetConnHandle nc) {
+
+	return (nc->outnowait && mos_task_equal(nc->outworker, mos_self()));
+}
+
+/*
+ * Appends the buffers to outpend.  Called with sendlk held.
+ */
+static void
+pnpend(PhidgetNetConnHandle nc, const mos_iovec_t *iov, int cnt) {
+	uint32_t len, sz;
+	uint8_t *buf;
+	int i;
+
+	for (len = 0, i = 0; i < cnt; i++)
+		len += (uint32_t)iov[i].len;
+
+	if (nc->outpendoff > 0) {
+		memmove(nc->outpend, nc->outpend + nc->outpendoff, nc->outpendlen - nc->outpendoff);
+		nc->outpendlen -= nc->outpendoff;
+		nc->outpendoff = 0;
+	}
+
+	if (nc->outpendlen + len > nc->outpendsz) {
+		sz = MOS_MAX(nc->outpendsz * 2, nc->outpendlen + len);
+		buf = mos_malloc(sz);
+		if (nc->outpend != NULL) {
+			memcpy(buf, nc->outpend, nc->outpendlen);
+			mos_free(nc->outpend, nc->outpendsz);
+		}
+		nc->outpend = buf;
+		nc->outpendsz = sz;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		if (iov[i].len > 0)
+			memcpy(nc->outpend + nc->outpendlen, iov[i].base, iov[i].len);
+		nc->outpendlen += (uint32_t)iov[i].len;
+	}
+}
+
+/*
+ * Sends whatever is in outpend.  With nowait, stops once the socket is full, leaving the rest in
+ * outpend.  Called with sendlk held.
+ */
+static PhidgetReturnCode
+pnsendpending(mosiop_t iop, PhidgetNetConnHandle nc, int nowait) {
+	mos_iovec_t iov;
+	size_t n;
+	int err;
+
+	while (nc->outpendoff < nc->outpendlen) {
+		if (nc->errcondition != EPHIDGET_OK)
+			return (nc->errcondition);
+
+		iov.base = nc->outpend + nc->outpendoff;
+		iov.len = nc->outpendlen - nc->outpendoff;
+		if (nowait)
+			err = mos_netop_tcp_trywritev(iop, &nc->sock, &iov, 1, &n);
+		else
+			err = mos_netop_tcp_writev(iop, &nc->sock, &iov, 1, &n);
+		if (err != 0) {
+			if (err == MOSN_AGAIN)
+				continue;
+			return (MOS_ERROR(iop, err, "TCP write failed"));
+		}
+		if (n == 0) {
+			if (nowait)
+				return (0);
+			return (MOS_ERROR(iop, EPHIDGET_IO, "stream handled 0 bytes"));
+		}
+		nc->outpendoff += (uint32_t)n;
+	}
+
+	nc->outpendoff = 0;
+	nc->outpendlen = 0;
+	return (0);
+}
+
+/*
+ * Tries to send what an output worker left in outpend, without blocking.  Returns true if some
+ * remains.  If the connection has failed, the rest is discarded: it can never be sent.
+ */
+static int
+pnpending(PhidgetNetConnHandle nc) {
+	int pending;
+
+	mos_mutex_lock(&nc->sendlk);
+	if (nc->outpendlen != 0 && pnsendpending(MOS_IOP_IGNORE, nc, 1) != 0) {
+		nc->outpendoff = 0;
+		nc->outpendlen = 0;
+	}
+	pending = nc->outpendlen != 0;
+	mos_mutex_unlock(&nc->sendlk);
+
+	return (pending);
+}
+
 API_PRETURN
 pnwrite(mosiop_t iop, PhidgetNetConnHandle nc, const void *vbuf, uint32_t len) {
+	mos_iovec_t iov;
+
+	iov.base = vbuf;
+	iov.len = len;
+
+	return (pnwritev(iop, nc, &iov, 1));
+}
+
+static PhidgetReturnCode
+_pnwritev(mosiop_t iop, PhidgetNetConnHandle nc, mos_iovec_t *iov, int cnt) {
+	PhidgetReturnCode res;
 	mos_socket_t s;
-	uint32_t nwr;
 	size_t n;
+	int nowait;
 	int err;
 
 	s = nc->sock;
+	nowait = pnnowait(nc);
+
+	/* Anything left over from an output worker goes first */
+	if (nc->outpendlen != 0) {
+		res = pnsendpending(iop, nc, nowait);
+		if (res != 0)
+			return (res);
+		if (nc->outpendlen != 0) {
+			pnpend(nc, iov, cnt);
+			return (0);
+		}
+	}
+
+	while (cnt > 0) {
+		if (iov->len == 0) {
+			iov++;
+			cnt--;
+			continue;
+		}
 
-	for (nwr = 0; nwr < len; nwr += (uint32_t)n) {
 		if (nc->errcondition != EPHIDGET_OK)
 			return (nc->errcondition);
 
-		n = len - nwr;
-		err = mos_netop_tcp_write(iop, &s, ((const uint8_t *)vbuf) + nwr, &n);
+		if (nowait)
+			err = mos_netop_tcp_trywritev(iop, &s, iov, cnt, &n);
+		else
+			err = mos_netop_tcp_writev(iop, &s, iov, cnt, &n);
 		if (err != 0) {
-			if (err == MOSN_AGAIN) {
-				n = 0;
+			if (err == MOSN_AGAIN)
 				continue;
-			}
 			return (MOS_ERROR(iop, err, "TCP write failed"));
 		}
-		if (n == 0)
-			return (MOS_ERROR(iop, EPHIDGET_IO, "stream handled %u bytes", len - nwr));
+		if (n == 0) {
+			if (nowait) {
+				pnpend(nc, iov, cnt);
+				return (0);
+			}
+			return (MOS_ERROR(iop, EPHIDGET_IO, "stream handled 0 bytes"));
+		}
+
+		for (; cnt > 0 && n >= iov->len; iov++, cnt--)
+			n -= iov->len;
+		if (cnt > 0) {
+			iov->base = (const uint8_t *)iov->base + n;
+			iov->len -= n;
+		}
 	}
 
 	return (0);
 }
 
+/*
+ * Writes the buffers in order, gathering as many as possible into each system call.
+ * The iovec array is consumed: entries are advanced past whatever has been written.
+ *
+ * From an output worker draining the queue this never blocks: what the socket will not take is kept
+ * in outpend to be sent later.
+ */
+API_PRETURN
+pnwritev(mosiop_t iop, PhidgetNetConnHandle nc, mos_iovec_t *iov, int cnt) {
+	PhidgetReturnCode res;
+
+	mos_mutex_lock(&nc->sendlk);
+	res = _pnwritev(iop, nc, iov, cnt);
+	mos_mutex_unlock(&nc->sendlk);
+
+	return (res);
+}
+
 PhidgetReturnCode
 readRequestHeader(mosiop_t iop, PhidgetNetConnHandle nc, netreq_t *req) {
 	PhidgetReturnCode res;
@@ -915,6 +1252,515 @@ writeReply(mosiop_t iop, PhidgetNetConnHandle nc, uint16_t repseq, msgtype_t typ
 	return (EPHIDGET_OK);
 }
 
+PhidgetReturnCode
+createNetEventBuffer(msgtype_t type, msgsubtype_t stype, const void *data, uint32_t len, int dgram,
+  NetEventBuffer **_eb) {
+	NetEventBuffer *eb;
+
+	TESTPTR(_eb);
+
+	if (len > NR_MAXDATALEN)
+		return (EPHIDGET_NOSPC);
+
+	eb = mos_malloc(sizeof (*eb) + len);
+	eb->refcnt = 1;
+	eb->type = type;
+	eb->stype = stype;
+	eb->dgram = dgram;
+	eb->ckey = NULL;
+	eb->cpkt = 0;
+	eb->len = len;
+	eb->data = (uint8_t *)(eb + 1);
+	if (len > 0)
+		memcpy(eb->data, data, len);
+
+	*_eb = eb;
+	return (EPHIDGET_OK);
+}
+
+void
+retainNetEventBuffer(NetEventBuffer *eb) {
+
+	mos_atomic_add_32(&eb->refcnt, 1);
+}
+
+void
+releaseNetEventBuffer(NetEventBuffer **_eb) {
+	NetEventBuffer *eb;
+
+	if (_eb == NULL || *_eb == NULL)
+		return;
+
+	eb = *_eb;
+	*_eb = NULL;
+
+	if (mos_atomic_add_32_nv(&eb->refcnt, -1) == 0)
+		mos_free(eb, sizeof (*eb) + eb->len);
+}
+
+/*
+ * Writes up to max queued events.  The write lock must be held.
+ *
+ * With nowait, nothing written blocks: whatever the socket will not take is kept in outpend, and the
+ * connection is reported blocked until that has been sent.  A client that is not reading must not
+ * hold up an output worker.
+ *
+ * If the connection has a flush handler, its write handler may hold the events back while the batch
+ * is written, and the flush handler is called before returning.
+ */
+static int
+writeNetConnOutput(PhidgetNetConnHandle nc, uint32_t max, int nowait) {
+	PhidgetReturnCode res;
+	NetEventBuffer *eb;
+	uint32_t n;
+	int failed;
+	int state;
+
+	failed = 0;
+	state = -1;
+
+	if (nowait) {
+		if (pnpending(nc))
+			return (NETOUT_BLOCKED);
+		nc->outworker = mos_self();
+		nc->outnowait = 1;
+	}
+
+	if (nc->flush != NULL && !(PhidgetCKFlags(nc, PNCF_CLOSED) & PNCF_CLOSED))
+		nc->wrbatch = 1;
+
+	for (n = 0; n < max; n++) {
+		if (nowait && pnpending(nc)) {
+			state = NETOUT_BLOCKED;
+			break;
+		}
+
+		mos_mutex_lock(&nc->outlk);
+		if (nc->outqcnt == 0) {
+			mos_mutex_unlock(&nc->outlk);
+			state = NETOUT_EMPTY;
+			break;
+		}
+		eb = nc->outq[nc->outqhead];
+		nc->outq[nc->outqhead] = NULL;
+		nc->outqhead = (nc->outqhead + 1) % nc->outqsz;
+		nc->outqcnt--;
+		checkNetConnBacklog(nc);
+		mos_mutex_unlock(&nc->outlk);
+
+		/* ncwrite() quietly discards the event if the connection has been closed */
+		res = writeNetConn(MOS_IOP_IGNORE, nc, NRF_EVENT, nc->reqseq++, 0, eb->type, eb->stype, eb->data,
+		  eb->len, eb->dgram, NULL);
+		if (res == EPHIDGET_OK) {
+			nc->io_ev++;
+		} else if (!failed) {
+			netlogerr("failed to write queued event to %s: "PRC_FMT, nc->peername, PRC_ARGS(res));
+			failed = 1;
+		}
+
+		releaseNetEventBuffer(&eb);
+	}
+
+	if (nc->wrbatch) {
+		nc->wrbatch = 0;
+		res = nc->flush(MOS_IOP_IGNORE, nc);
+		if (res != EPHIDGET_OK && !failed)
+			netlogerr("failed to flush queued events to %s: "PRC_FMT, nc->peername, PRC_ARGS(res));
+	}
+
+	if (nowait) {
+		nc->outnowait = 0;
+		if (pnpending(nc))
+			return (NETOUT_BLOCKED);
+	}
+
+	if (state != -1)
+		return (state);
+
+	mos_mutex_lock(&nc->outlk);
+	state = nc->outqcnt != 0 ? NETOUT_MORE : NETOUT_EMPTY;
+	mos_mutex_unlock(&nc->outlk);
+
+	return (state);
+}
+
+/*
+ * Called with the write lock held, before anything is written directly to the connection, so
+ * events already queued are not overtaken.
+ */
+static void
+flushNetConnOutput(PhidgetNetConnHandle nc) {
+
+	writeNetConnOutput(nc, UINT32_MAX, 0);
+}
+
+/*
+ * Writes everything queued on the connection, and takes it off the output schedule once empty.
+ * Used when no output worker could be started.
+ */
+static void
+drainNetConnOutput(PhidgetNetConnHandle nc) {
+	int more;
+
+	do {
+		PhidgetRunLock(nc);
+		flushNetConnOutput(nc);
+		PhidgetRunUnlock(nc);
+
+		mos_mutex_lock(&nc->outlk);
+		more = nc->outqcnt != 0;
+		if (!more)
+			nc->outsched = 0;
+		mos_mutex_unlock(&nc->outlk);
+	} while (more);
+}
+
+static MOS_TASK_RESULT
+runOutputWorker(void *arg) {
+	PhidgetNetConnHandle nc;
+	int state;
+
+	mos_task_setname("Phidget22 Network Output Worker");
+	netlogdebug("network output worker started: 0x%08x", mos_self());
+
+	mos_mutex_lock(&outWorkLock);
+	for (;;) {
+		nc = MTAILQ_FIRST(&outWork);
+		if (nc == NULL) {
+			if (MTAILQ_EMPTY(&outBlocked)) {
+				if (outWorkStop)
+					break;
+				mos_cond_wait(&outWorkCond, &outWorkLock);
+				continue;
+			}
+
+			/* Only connections waiting for room to write: try them again shortly */
+			mos_cond_timedwait(&outWorkCond, &outWorkLock, NETOUT_RETRY * MOS_MSEC);
+			while ((nc = MTAILQ_FIRST(&outBlocked)) != NULL) {
+				MTAILQ_REMOVE(&outBlocked, nc, outlink);
+				MTAILQ_INSERT_TAIL(&outWork, nc, outlink);
+			}
+			continue;
+		}
+		MTAILQ_REMOVE(&outWork, nc, outlink);
+		mos_mutex_unlock(&outWorkLock);
+
+		/* Not NetConnWriteLock(): that would drain the whole queue, blocking if need be */
+		PhidgetRunLock(nc);
+		state = writeNetConnOutput(nc, NETOUT_BATCH, 1);
+		PhidgetRunUnlock(nc);
+
+		if (state != NETOUT_BLOCKED) {
+			mos_mutex_lock(&nc->outlk);
+			state = nc->outqcnt != 0 ? NETOUT_MORE : NETOUT_EMPTY;
+			if (state == NETOUT_EMPTY)
+				nc->outsched = 0;
+			mos_mutex_unlock(&nc->outlk);
+		}
+
+		/* The reference taken in scheduleNetConnOutput() stays with the connection while it is queued */
+		if (state == NETOUT_EMPTY)
+			PhidgetRelease(&nc);
+
+		mos_mutex_lock(&outWorkLock);
+		if (state == NETOUT_MORE)
+			MTAILQ_INSERT_TAIL(&outWork, nc, outlink);
+		else if (state == NETOUT_BLOCKED)
+			MTAILQ_INSERT_TAIL(&outBlocked, nc, outlink);
+	}
+
+	outWorkers--;
+	mos_cond_broadcast(&outWorkCond);
+	mos_mutex_unlock(&outWorkLock);
+
+	netlogdebug("network output worker exiting");
+	MOS_TASK_EXIT(0);
+}
+
+/*
+ * Waits for the output workers to write whatever is queued, and exit.
+ */
+static void
+stopOutputWorkers() {
+
+	mos_mutex_lock(&outWorkLock);
+	outWorkStop = 1;
+	mos_cond_broadcast(&outWorkCond);
+	while (outWorkers > 0)
+		mos_cond_wait(&outWorkCond, &outWorkLock);
+	outWorkStop = 0;
+	mos_mutex_unlock(&outWorkLock);
+}
+
+/*
+ * Hands a connection with newly queued events to the output workers, starting them if required.
+ */
+static void
+scheduleNetConnOutput(PhidgetNetConnHandle nc) {
+	int i;
+
+	PhidgetRetain(nc);
+
+	mos_mutex_lock(&outWorkLock);
+	if (outWorkers == 0 && !outWorkStop) {
+		for (i = 0; i < NETOUT_WORKERS; i++) {
+			if (mos_task_create(NULL, runOutputWorker, NULL) != 0) {
+				netlogerr("failed to start network output worker");
+				break;
+			}
+			outWorkers++;
+		}
+	}
+
+	if (outWorkers == 0) {
+		mos_mutex_unlock(&outWorkLock);
+		drainNetConnOutput(nc);
+		PhidgetRelease(&nc);
+		return;
+	}
+
+	MTAILQ_INSERT_TAIL(&outWork, nc, outlink);
+	mos_cond_broadcast(&outWorkCond);	/* stopOutputWorkers() may also be waiting */
+	mos_mutex_unlock(&outWorkLock);
+}
+
+/*
+ * Ends the backlog once the queue has drained to the low watermark.  outlk must be held.
+ */
+static void
+checkNetConnBacklog(PhidgetNetConnHandle nc) {
+	mostime_t tm;
+
+	if (nc->outqfullstart == 0 || nc->outqcnt > nc->outqlow)
+		return;
+
+	tm = mos_gettime_usec() - nc->outqfullstart;
+	nc->outqfulltime += tm;
+	nc->outqfullstart = 0;
+
+	netloginfo("%s caught up after %"PRId64" msec backlogged (%"PRIu64" dropped, %"PRIu64" coalesced)",
+	  nc->peername, tm / 1000, nc->outqdropped, nc->outqcoalesced);
+}
+
+/*
+ * Replaces the newest queued value of the same channel and type with eb.  outlk must be held.
+ */
+static int
+coalesceNetConnEvent(PhidgetNetConnHandle nc, NetEventBuffer *eb) {
+	NetEventBuffer **slot;
+	uint32_t i;
+
+	for (i = nc->outqcnt; i > 0; i--) {
+		slot = &nc->outq[(nc->outqhead + i - 1) % nc->outqsz];
+		if ((*slot)->ckey == eb->ckey && (*slot)->cpkt == eb->cpkt) {
+			releaseNetEventBuffer(slot);
+			retainNetEventBuffer(eb);
+			*slot = eb;
+			nc->outqcoalesced++;
+			return (1);
+		}
+	}
+
+	return (0);
+}
+
+/*
+ * Releases everything queued on the connection.  outlk must be held.
+ */
+static void
+dropNetConnOutput(PhidgetNetConnHandle nc) {
+
+	while (nc->outqcnt > 0) {
+		releaseNetEventBuffer(&nc->outq[nc->outqhead]);
+		nc->outqhead = (nc->outqhead + 1) % nc->outqsz;
+		nc->outqcnt--;
+		nc->outqdropped++;
+	}
+}
+
+/*
+ * Queues a reference to the event on the connection.  Never blocks on the connection itself:
+ * the event is written later by an output worker.
+ *
+ * The queue holds at most outqhigh events.  Once full, the connection is backlogged until it drains
+ * to outqlow, and the connection's policy decides what happens to new events.  Only the connection's
+ * own lock is taken.
+ */
+PhidgetReturnCode
+queueNetConnEvent(PhidgetNetConnHandle nc, NetEventBuffer *eb) {
+	NetEventBuffer **outq;
+	uint32_t outqsz;
+	uint32_t i;
+	int sched;
+
+	TESTPTR(nc);
+	TESTPTR(eb);
+
+	if (PhidgetCKFlags(nc, PNCF_CLOSED) != 0 || nc->errcondition != EPHIDGET_OK)
+		return (EPHIDGET_CLOSED);
+
+	mos_mutex_lock(&nc->outlk);
+
+	if (nc->outqfullstart != 0 && eb->ckey != NULL && nc->outqpolicy == NETOUT_POLICY_COALESCE) {
+		if (coalesceNetConnEvent(nc, eb)) {
+			mos_mutex_unlock(&nc->outlk);
+			return (EPHIDGET_OK);
+		}
+	}
+
+	if (nc->outqcnt >= nc->outqhigh) {
+		if (nc->outqpolicy == NETOUT_POLICY_DISCONNECT) {
+			dropNetConnOutput(nc);
+			checkNetConnBacklog(nc);
+			mos_mutex_unlock(&nc->outlk);
+
+			netlogwarn("%s is not keeping up with events (%u queued): disconnecting", nc->peername,
+			  nc->outqhigh);
+			/* pnwrite() and the connection's request loop both give up on an error condition */
+			nc->errcondition = EPHIDGET_NOSPC;
+			PhidgetSetFlags(nc, PNCF_STOP);
+			return (EPHIDGET_CLOSED);
+		}
+
+		releaseNetEventBuffer(&nc->outq[nc->outqhead]);
+		nc->outqhead = (nc->outqhead + 1) % nc->outqsz;
+		nc->outqcnt--;
+		nc->outqdropped++;
+	}
+
+	if (nc->outqcnt == nc->outqsz) {
+		outqsz = nc->outqsz == 0 ? NETOUT_QUEUEMIN : nc->outqsz * 2;
+		if (outqsz > nc->outqhigh)
+			outqsz = nc->outqhigh;
+		outq = mos_zalloc(sizeof (*outq) * outqsz);
+		for (i = 0; i < nc->outqcnt; i++)
+			outq[i] = nc->outq[(nc->outqhead + i) % nc->outqsz];
+		if (nc->outq != NULL)
+			mos_free(nc->outq, sizeof (*outq) * nc->outqsz);
+		nc->outq = outq;
+		nc->outqsz = outqsz;
+		nc->outqhead = 0;
+	}
+
+	retainNetEventBuffer(eb);
+	nc->outq[(nc->outqhead + nc->outqcnt) % nc->outqsz] = eb;
+	nc->outqcnt++;
+
+	if (nc->outqcnt > nc->outqmax)
+		nc->outqmax = nc->outqcnt;
+
+	if (nc->outqfullstart == 0 && nc->outqcnt >= nc->outqhigh) {
+		nc->outqfullstart = mos_gettime_usec();
+		netlogwarn("%s is not keeping up with events: %u queued", nc->peername, nc->outqcnt);
+	}
+
+	sched = !nc->outsched;
+	nc->outsched = 1;
+	mos_mutex_unlock(&nc->outlk);
+
+	if (sched)
+		scheduleNetConnOutput(nc);
+
+	return (EPHIDGET_OK);
+}
+
+static const char *
+outputQueuePolicyName(int policy) {
+
+	switch (policy) {
+	case NETOUT_POLICY_COALESCE:
+		return ("coalesce");
+	case NETOUT_POLICY_DROPOLDEST:
+		return ("dropoldest");
+	case NETOUT_POLICY_DISCONNECT:
+		return ("disconnect");
+	default:
+		return ("unknown");
+	}
+}
+
+/*
+ * Sets the output queue limits and policy for connections created from now on.
+ */
+PhidgetReturnCode
+setOutputQueueProperty(const char *key, const char *val) {
+	PhidgetReturnCode res;
+	uint32_t u;
+	int i;
+
+	res = EPHIDGET_OK;
+
+	mos_mutex_lock(&outWorkLock);
+	if (mos_strcmp(key, "outqueuepolicy") == 0) {
+		for (i = NETOUT_POLICY_COALESCE; i <= NETOUT_POLICY_DISCONNECT; i++) {
+			if (mos_strcasecmp(val, outputQueuePolicyName(i)) == 0)
+				break;
+		}
+		if (i <= NETOUT_POLICY_DISCONNECT)
+			outQueuePolicy = i;
+		else
+			res = EPHIDGET_INVALIDARG;
+	} else if (mos_strtou32(val, 0, &u) != 0) {
+		res = EPHIDGET_INVALIDARG;
+	} else if (mos_strcmp(key, "outqueuehigh") == 0 && u >= NETOUT_QUEUEMIN) {
+		outQueueHigh = u;
+		if (outQueueLow >= outQueueHigh)
+			outQueueLow = outQueueHigh / 4;
+	} else if (mos_strcmp(key, "outqueuelow") == 0 && u < outQueueHigh) {
+		outQueueLow = u;
+	} else {
+		res = EPHIDGET_INVALIDARG;
+	}
+	mos_mutex_unlock(&outWorkLock);
+
+	return (res);
+}
+
+/*
+ * Adds the output queue state to a connection description.
+ */
+PhidgetReturnCode
+netConnOutputToPConf(PhidgetNetConnHandle nc, pconf_t *pc) {
+	PhidgetReturnCode res;
+	mostime_t fulltime;
+	uint64_t coalesced;
+	uint64_t dropped;
+	uint32_t depth;
+	uint32_t max;
+	int full;
+
+	mos_mutex_lock(&nc->outlk);
+	depth = nc->outqcnt;
+	max = nc->outqmax;
+	dropped = nc->outqdropped;
+	coalesced = nc->outqcoalesced;
+	full = nc->outqfullstart != 0;
+	fulltime = nc->outqfulltime;
+	if (full)
+		fulltime += mos_gettime_usec() - nc->outqfullstart;
+	mos_mutex_unlock(&nc->outlk);
+
+	res = pconf_addstr(pc, outputQueuePolicyName(nc->outqpolicy), "outqpolicy");
+	if (res == EPHIDGET_OK)
+		res = pconf_addu(pc, nc->outqhigh, "outqhigh");
+	if (res == EPHIDGET_OK)
+		res = pconf_addu(pc, nc->outqlow, "outqlow");
+	if (res == EPHIDGET_OK)
+		res = pconf_addu(pc, depth, "outqdepth");
+	if (res == EPHIDGET_OK)
+		res = pconf_addu(pc, max, "outqmax");
+	if (res == EPHIDGET_OK)
+		res = pconf_addu(pc, dropped, "outqdropped");
+	if (res == EPHIDGET_OK)
+		res = pconf_addu(pc, coalesced, "outqcoalesced");
+	if (res == EPHIDGET_OK)
+		res = pconf_addbool(pc, full, "outqfull");
+	if (res == EPHIDGET_OK)
+		res = pconf_addu(pc, fulltime / 1000, "outqfullms");
+
+	return (res);
+}
+
 static PhidgetReturnCode
 createSalt(mosiop_t iop, char *buf, uint32_t buflen) {
 	mosrandom_t *rdm;
@@ -973,6 +1819,7 @@ startClientConnection(mosiop_t iop, PhidgetNetConnHandle nc, const char *passwd)
 	char json[256];
 	netreq_t req;
 	uint32_t cnt;
+	int bpenc;
 	int err;
 
 	uint8_t digest[SHA256_DIGEST_LENGTH];
@@ -994,13 +1841,14 @@ startClientConnection(mosiop_t iop, PhidgetNetConnHandle nc, const char *passwd)
 	 * HANDSHAKE
 	 */
 	if (PhidgetCKFlags(nc, PNCF_DGRAM)) {
-		cnt = mkJSON(json, sizeof(json), "{type=%s,pmajor=%d,pminor=%d,dgram=%d,port=%d}", nc->protocol, nc->pmajor,
-		  nc->pminor, 1, ntohs(nc->dgaddr.s4.sin_port));
+		cnt = mkJSON(json, sizeof(json), "{type=%s,pmajor=%d,pminor=%d,dgram=%d,port=%d,bpenc=%d}", nc->protocol,
+		  nc->pmajor, nc->pminor, 1, ntohs(nc->dgaddr.s4.sin_port), BPENC_MAX);
 		res = writeRequest(iop, nc, 0, MSG_CONNECT, SMSG_HANDSHAKEC0, json, cnt, NULL);
 		if (res != EPHIDGET_OK)
 			return (MOS_ERROR(iop, res, "failed to write client handshake request"));
 	} else {
-		cnt = mkJSON(json, sizeof(json), "{type=%s,pmajor=%d,pminor=%d}", nc->protocol, nc->pmajor, nc->pminor);
+		cnt = mkJSON(json, sizeof(json), "{type=%s,pmajor=%d,pminor=%d,bpenc=%d}", nc->protocol, nc->pmajor,
+		  nc->pminor, BPENC_MAX);
 		res = writeRequest(iop, nc, 0, MSG_CONNECT, SMSG_HANDSHAKEC0, json, cnt, NULL);
 		if (res != EPHIDGET_OK)
 			return (MOS_ERROR(iop, res, "failed to write client handshake request"));
@@ -1012,8 +1860,11 @@ startClientConnection(mosiop_t iop, PhidgetNetConnHandle nc, const char *passwd)
 	if (req.nr_type != MSG_CONNECT || req.nr_stype != SMSG_HANDSHAKES0)
 		return (MOS_ERROR(iop, EPHIDGET_INVALID, "invalid server handshake header"));
 
+	/* servers that do not send bpenc only understand JSON bridge packets */
+	bpenc = BPENC_JSON;
 	err = parseJSON((char *)req.nr_data, req.nr_len, allocbuf, sizeof (allocbuf),
-	  "%O,type=%s,pmajor=%d,pminor=%d,result=%d", &cnt, &type, &nc->ppmajor, &nc->ppminor, &res);
+	  "%O,type=%s,pmajor=%d,pminor=%d,result=%d,bpenc?=%d", &cnt, &type, &nc->ppmajor, &nc->ppminor, &res,
+	  &bpenc);
 	if (err <= 0)
 		return (MOS_ERROR(iop, res, "failed to parse server handshake"));
 	if (res != 0) {
@@ -1028,7 +1879,11 @@ startClientConnection(mosiop_t iop, PhidgetNetConnHandle nc, const char *passwd)
 		return (MOS_ERROR(iop, EPHIDGET_BADVERSION,
 			"server protocol version '%d' does not match client version '%d'", nc->pmajor, nc->ppmajor));
 	}
-	netloginfo("server handshake '%s' %d.%d", type, nc->ppmajor, nc->ppminor);
+	if (bpenc < BPENC_JSON || bpenc > BPENC_MAX)
+		return (MOS_ERROR(iop, EPHIDGET_BADVERSION, "server selected unsupported bridge packet encoding %d", bpenc));
+	nc->bpenc = bpenc;
+
+	netloginfo("server handshake '%s' %d.%d (bpenc %d)", type, nc->ppmajor, nc->ppminor, nc->bpenc);
 
 	/*
 	 * AUTHENTICATION
@@ -1223,6 +2078,7 @@ startServerConnection(mosiop_t iop, IPhidgetServerHandle server) {
 	PhidgetReturnCode res;
 	netreq_t req;
 	uint32_t cnt;
+	int bpenc;
 	int dgram;
 	int port;
 	int err;
@@ -1249,14 +2105,25 @@ startServerConnection(mosiop_t iop, IPhidgetServerHandle server) {
 	netlogdebug("S<= %s", req.nr_data);
 
 	dgram = 0;
+	bpenc = BPENC_JSON;
 
 	/* use json buffer to store type.. type cannot be used past mkJSON() below */
 	err = parseJSON((char *)req.nr_data, req.nr_len, json, sizeof (json),
-	  "%O,type=%s,pmajor=%d,pminor=%d,dgram?=%d,port?=%d",
-	  &cnt, &type, &server->nc->ppmajor, &server->nc->ppminor, &dgram, &port);
+	  "%O,type=%s,pmajor=%d,pminor=%d,dgram?=%d,port?=%d,bpenc?=%d",
+	  &cnt, &type, &server->nc->ppmajor, &server->nc->ppminor, &dgram, &port, &bpenc);
 	if (err <= 0)
 		return (MOS_ERROR(iop, res, "failed to parse client handshake json"));
 
+	/*
+	 * The client offers the newest bridge packet encoding it understands: use that, or the newest
+	 * we understand, whichever is older.
+	 */
+	if (bpenc < BPENC_JSON)
+		bpenc = BPENC_JSON;
+	if (bpenc > BPENC_MAX)
+		bpenc = BPENC_MAX;
+	server->nc->bpenc = bpenc;
+
 	if (dgram) {
 		PhidgetSetFlags(server->nc, PNCF_DGRAM);
 		server->nc->dgaddr.s4.sin_family = server->nc->addr.s4.sin_family;
@@ -1280,8 +2147,8 @@ startServerConnection(mosiop_t iop, IPhidgetServerHandle server) {
 			"'%s' client indicated unsupported protocol version %d", type, server->nc->ppmajor));
 	}
 
-	cnt = mkJSON(json, sizeof(json), "{type=%s,pmajor=%d,pminor=%d,result=%d}",
-	  server->nc->protocol, server->nc->pmajor, server->nc->pminor, 0);
+	cnt = mkJSON(json, sizeof(json), "{type=%s,pmajor=%d,pminor=%d,result=%d,bpenc=%d}",
+	  server->nc->protocol, server->nc->pmajor, server->nc->pminor, 0, server->nc->bpenc);
 
 	res = writeRequest(iop, server->nc, 0, MSG_CONNECT, SMSG_HANDSHAKES0, json, cnt, NULL);
 	if (res != EPHIDGET_OK)
@@ -1322,9 +2189,10 @@ PhidgetNetConnClose(PhidgetNetConnHandle nc) {
 	WaitForReply *wfr1, *wfr2;
 	PhidgetReturnCode res;
 
-	NetConnWriteLock(nc);
+	/* Not NetConnWriteLock(): queued events are not flushed to a connection that is closing */
+	PhidgetRunLock(nc);
 	res = PhidgetCKandSetFlags(nc, PNCF_CLOSED);
-	NetConnWriteUnlock(nc);
+	PhidgetRunUnlock(nc);
 
 	if (res != EPHIDGET_OK)
 		return;
@@ -1390,6 +2258,15 @@ PhidgetNetConnDelete(PhidgetNetConnHandle *_nc) {
 		nc->conntypestr= NULL;
 	}
 
+	/* Events queued after the connection was closed were never written */
+	dropNetConnOutput(nc);
+	if (nc->outq != NULL)
+		mos_free(nc->outq, sizeof (*nc->outq) * nc->outqsz);
+	mos_mutex_destroy(&nc->outlk);
+	if (nc->outpend != NULL)
+		mos_free(nc->outpend, nc->outpendsz);
+	mos_mutex_destroy(&nc->sendlk);
+
 	mos_free(nc->tokens, sizeof (pjsmntok_t) * BRIDGE_JSON_TOKENS);
 	mos_free(nc->iobuf, NR_HEADERLEN + NR_MAXDATALEN);
 
@@ -1438,6 +2315,14 @@ PhidgetNetConnCreate(PhidgetNetConnHandle *nc) {
 	(*nc)->databuf = (*nc)->iobuf + NR_HEADERLEN;
 	(*nc)->databufsz = NR_MAXDATALEN;
 	(*nc)->dgsock = MOS_INVALID_SOCKET;
+	mos_mutex_init(&(*nc)->outlk);
+	mos_mutex_init(&(*nc)->sendlk);
+
+	mos_mutex_lock(&outWorkLock);
+	(*nc)->outqhigh = outQueueHigh;
+	(*nc)->outqlow = outQueueLow;
+	(*nc)->outqpolicy = outQueuePolicy;
+	mos_mutex_unlock(&outWorkLock);
 	mostimestamp_localnow(&(*nc)->ctime);
 
 	return (EPHIDGET_OK);
@@ -1447,6 +2332,9 @@ void
 NetConnWriteLock(PhidgetNetConnHandle nc) {
 
 	PhidgetRunLock(nc);
+
+	/* Events already queued go out ahead of whatever the caller is about to write */
+	flushNetConnOutput(nc);
 }
 
 void
@@ -1481,6 +2369,32 @@ netConnWrite(mosiop_t iop, PhidgetNetConnHandle nc, const void *v, size_t n) {
 	return (mos_netop_tcp_writefully(iop, &nc->sock, v, n));
 }
 
+/*
+ * Sends len bytes of the file open on fd, from the start of the file.
+ */
+API_PRETURN
+netConnSendFile(mosiop_t iop, PhidgetNetConnHandle nc, int fd, uint64_t len) {
+	uint64_t off;
+	size_t n;
+	int err;
+
+	for (off = 0; off < len; off += n) {
+		n = (size_t)MOS_MIN(len - off, (uint64_t)(1 << 30));
+		err = mos_netop_tcp_sendfile(iop, &nc->sock, fd, off, &n);
+		if (err != 0) {
+			if (err == MOSN_AGAIN) {
+				n = 0;
+				continue;
+			}
+			return (MOS_ERROR(iop, err, "failed to send file"));
+		}
+		if (n == 0)
+			return (MOS_ERROR(iop, EPHIDGET_IO, "file ended %"PRIu64" bytes early", len - off));
+	}
+
+	return (0);
+}
+
 API_PRETURN
 netConnRead(mosiop_t iop, PhidgetNetConnHandle nc, void *v, size_t *n) {
 
@@ -1558,6 +2472,37 @@ setNetConnHandlers(PhidgetNetConnHandle nc, NetConnClose cl, NetConnRelease rl,
 	return (EPHIDGET_OK);
 }
 
+/*
+ * A connection with a flush handler may have its write handler hold back events written by an output
+ * worker (getNetConnWriteBatch() is true), and write them when flush is called at the end of the batch.
+ */
+API_PRETURN
+setNetConnFlushHandler(PhidgetNetConnHandle nc, NetConnFlush fl) {
+
+	nc->flush = fl;
+	return (EPHIDGET_OK);
+}
+
+/*
+ * Called by a write handler, with the write lock held.
+ */
+API_IRETURN
+getNetConnWriteBatch(PhidgetNetConnHandle nc) {
+
+	return (nc->wrbatch);
+}
+
+/*
+ * A read handler that reads ahead must report what it is holding, so a request already buffered is
+ * serviced without waiting for the socket to become readable.
+ */
+API_PRETURN
+setNetConnBufferedHandler(PhidgetNetConnHandle nc, NetConnBuffered bf) {
+
+	nc->buffered = bf;
+	return (EPHIDGET_OK);
+}
+
 API_PRETURN
 setNetConnConnectionTypeListener(PhidgetNetConnHandle nc) {
 
@@ -177,6 +177,16 @@ typedef struct netreq {
 #define nr_stype	nr_hdr._nr_req.stype
 } netreq_t;
 
+/*
+ * A reply held for a waiter: the header, and the data in a buffer sized to the reply.
+ * The nr_* header accessors above work on this as well.
+ */
+typedef struct netreply {
+	netreqhdr_t		nr_hdr;
+	uint8_t			*nr_data;	/* nr_len bytes, NUL terminated */
+	uint32_t		nr_datasz;	/* size of the nr_data allocation */
+} netreply_t;
+
 #define WFR_WAITING		0x01
 #define WFR_CANCELLED	0x02
 #define WFR_ONLIST		0x04
@@ -193,7 +203,7 @@ typedef struct _WaitForReply {
 	mostime_t			waittime;
 	mos_tlock_t			*lock;
 	mos_cond_t			cond;
-	netreq_t			req;
+	netreply_t			req;
 	PhidgetReturnCode	res;
 	PhidgetNetConnHandle nc;
 	MTAILQ_ENTRY(_WaitForReply)	link;
@@ -205,6 +215,8 @@ typedef PhidgetReturnCode(CCONV *NetConnWrite)(mosiop_t, PhidgetNetConnHandle, c
 typedef PhidgetReturnCode(CCONV *NetConnRead)(mosiop_t, PhidgetNetConnHandle, void *, uint32_t *);
 typedef void(CCONV *NetConnClose)(PhidgetNetConnHandle);
 typedef void(CCONV *NetConnRelease)(PhidgetNetConnHandle *);
+typedef PhidgetReturnCode(CCONV *NetConnFlush)(mosiop_t, PhidgetNetConnHandle);
+typedef uint32_t(CCONV *NetConnBuffered)(PhidgetNetConnHandle);
 
 typedef struct _IPhidgetServer *IPhidgetServerHandle;
 
@@ -237,6 +249,13 @@ typedef struct _IPhidgetServer {
 	RB_ENTRY(_IPhidgetServer) link;
 } IPhidgetServer;
 
+/*
+ * What a server connection does with new events once its output queue is full (backlogged).
+ */
+#define NETOUT_POLICY_COALESCE		1	/* replace queued values with the latest, otherwise drop the oldest */
+#define NETOUT_POLICY_DROPOLDEST	2	/* drop the oldest queued event */
+#define NETOUT_POLICY_DISCONNECT	3	/* close the connection */
+
 /* Must be in the PHIDGET_OBJFLAG_MASK range */
 #define PNCF_STOP			0x01000000			/* flag that the connection is closing */
 #define PNCF_HASTHREAD		0x02000000			/* A thread is running for this connection */
@@ -254,6 +273,7 @@ typedef struct _PhidgetNetConn {
 	int					pminor;			/* protocol minor */
 	int					ppmajor;		/* peer protocol major */
 	int					ppminor;		/* peer protocol minor */
+	int					bpenc;			/* bridge packet encoding (BPENC_*) negotiated with the peer */
 	char				*peername;		/* the address and port of the peer */
 	char				*rsrvname;		/* remote server name for REMOTE connections */
 	char				*conntypestr;	/* connection type string */
@@ -276,6 +296,9 @@ typedef struct _PhidgetNetConn {
 	NetConnWrite		write;			/* write handler for connection */
 	NetConnRead			read;			/* read handler for connection */
 	NetConnRelease		release;		/* called after the connection has been closed */
+	NetConnFlush		flush;			/* writes anything the write handler held back during a batch */
+	int					wrbatch;		/* queued events are being written as a batch; protected by wrlock */
+	NetConnBuffered		buffered;		/* bytes read from the socket, but not yet consumed by the read handler */
 	handleRequest_t		handleRequest;	/* called to handle an incoming request on the connection */
 	void				*private;		/* private pointer for extending code */
 	mostimestamp_t		ctime;			/* creation time */
@@ -289,7 +312,29 @@ typedef struct _PhidgetNetConn {
 	uint32_t			databufsz;		/* data buffer size */
 	char				*databuf;		/* data buffer */
 	char				*iobuf;			/* full IO buffer */
+	mos_mutex_t			outlk;			/* protects the outbound event queue */
+	struct _NetEventBuffer **outq;		/* ring of events waiting to be written */
+	uint32_t			outqsz;			/* size of the outq ring */
+	uint32_t			outqhead;		/* first queued event */
+	uint32_t			outqcnt;		/* number of queued events */
+	int					outsched;		/* queued on, or being drained by, an output worker */
+	int					outqpolicy;		/* NETOUT_POLICY_*: what happens once the queue reaches outqhigh */
+	uint32_t			outqhigh;		/* queue limit: the connection is backlogged from here */
+	uint32_t			outqlow;		/* the backlog ends once the queue drains to here */
+	uint32_t			outqmax;		/* deepest the queue has been */
+	uint64_t			outqdropped;	/* events dropped by the backlog policy */
+	uint64_t			outqcoalesced;	/* events replaced by a newer value while backlogged */
+	mostime_t			outqfullstart;	/* when the current backlog began (usec): 0 if not backlogged */
+	mostime_t			outqfulltime;	/* time spent backlogged, not including the current backlog (usec) */
+	mos_mutex_t			sendlk;			/* serializes writes to the socket, and protects outpend */
+	uint8_t				*outpend;		/* written by an output worker, but not yet taken by the socket */
+	uint32_t			outpendoff;		/* first byte of outpend not yet sent */
+	uint32_t			outpendlen;
+	uint32_t			outpendsz;
+	int					outnowait;		/* an output worker is draining the queue: it must not block */
+	mos_task_t			outworker;		/* the output worker, while outnowait is set */
 	MTAILQ_ENTRY(_PhidgetNetConn)	openlink;	/* linkage for server events */
+	MTAILQ_ENTRY(_PhidgetNetConn)	outlink;	/* linkage for the output workers */
 } PhidgetNetConn;
 
 typedef MTAILQ_HEAD(phidgetnetconnlist, _PhidgetNetConn) phidgetnetconnlist_t;
@@ -366,6 +411,9 @@ const char *getNetworkControlEntryName(void *nce);
 #define TS_STOP		3	/* Task should stop */
 #define TS_STOPPED	4	/* Task has stopped */
 
+/* IPhidgetServer flags */
+#define IPSF_DEVICECLIENT	0x01	/* handleClient upgraded the connection to a device client */
+
 // XXX unused?
 //#define PHIDGET_NET_SRVNAME			"phidget22server"
 //#define PHIDGET_NET_SRVTYPE			"device server"
@@ -421,6 +469,21 @@ typedef enum msgsubtype {
 	SMSG_DEVCHANNEL		= 80,	/* channel info for light clients */
 } msgsubtype_t;
 
+/*
+ * An event rendered once, and queued by reference on each connection it is sent to.
+ * The data is not modified after creation: the last release frees the buffer.
+ */
+typedef struct _NetEventBuffer {
+	uint32_t		refcnt;
+	msgtype_t		type;
+	msgsubtype_t	stype;
+	int				dgram;		/* passed through to writeEvent() */
+	const void		*ckey;		/* coalescing key (the channel), or NULL if the event is never coalesced */
+	uint32_t		cpkt;		/* bridge packet type, with ckey */
+	uint32_t		len;
+	uint8_t			*data;		/* len bytes, allocated with the buffer */
+} NetEventBuffer;
+
 #define PHIDID(phid)	((uint64_t)(uintptr_t)(phid))
 
 void NetworkControlInit(void);
@@ -492,6 +555,13 @@ PhidgetReturnCode writeReply(mosiop_t, PhidgetNetConnHandle, uint16_t, msgtype_t
 PhidgetReturnCode writeEvent(mosiop_t, PhidgetNetConnHandle, msgtype_t, msgsubtype_t, const void *,
   uint32_t, int);
 
+PhidgetReturnCode createNetEventBuffer(msgtype_t, msgsubtype_t, const void *, uint32_t, int, NetEventBuffer **);
+PhidgetReturnCode renderNetEventBuffer(BridgePacket *, int, NetEventBuffer **);
+void retainNetEventBuffer(NetEventBuffer *);
+void releaseNetEventBuffer(NetEventBuffer **);
+PhidgetReturnCode queueNetConnEvent(PhidgetNetConnHandle, NetEventBuffer *);
+PhidgetReturnCode setOutputQueueProperty(const char *, const char *);
+
 PhidgetReturnCode sendSimpleReply(PhidgetNetConnHandle, uint16_t, PhidgetReturnCode, const char *);
 PhidgetReturnCode sendReply(PhidgetNetConnHandle nc, uint16_t repseq, PhidgetReturnCode rcode, const void *data, uint32_t dlen);
 
@@ -507,7 +577,26 @@ void releaseMDNSControlEntries(ZeroconfListenerHandle);
 #endif
 int validServerName(const char *);
 PhidgetReturnCode startKeepAliveTask(PhidgetNetConnHandle);
+PhidgetReturnCode serviceNetworkRequest(mosiop_t, PhidgetNetConnHandle, int *, uint32_t);
+PhidgetReturnCode beginClientConnection(IPhidgetServerHandle);
+void endClientConnection(IPhidgetServerHandle, int, PhidgetReturnCode, mosiop_t);
+
+/*
+ * On Linux, device server clients are serviced by epoll event loops and a small worker pool
+ * rather than a thread per client.
+ */
+#if defined(_LINUX) && !defined(_ANDROID)
+#define SERVER_EVENTLOOP	1
+#else
+#define SERVER_EVENTLOOP	0
+#endif
+
+#if SERVER_EVENTLOOP
+PhidgetReturnCode addEventLoopClient(IPhidgetServerHandle, int);
+PhidgetReturnCode setEventLoopProperty(const char *, const char *);
+#endif
 PhidgetReturnCode netConnToPConf(PhidgetNetConnHandle, pconf_t **);
+PhidgetReturnCode netConnOutputToPConf(PhidgetNetConnHandle, pconf_t *);
 PhidgetReturnCode openServersToPConf(pconf_t **);
 const char *strmsgtype(msgtype_t type);
 const char *strmsgsubtype(msgsubtype_t type);
@@ -516,7 +605,9 @@ const char *strmsgsubtype(msgsubtype_t type);
 /* Exported hidden */
 
 API_PRETURN_HDR pnwrite(mosiop_t, PhidgetNetConnHandle, const void *, uint32_t);
+API_PRETURN_HDR pnwritev(mosiop_t, PhidgetNetConnHandle, mos_iovec_t *, int);
 API_PRETURN_HDR pnread(mosiop_t, PhidgetNetConnHandle, void *, uint32_t *);
+API_PRETURN_HDR pnreadsome(mosiop_t, PhidgetNetConnHandle, void *, uint32_t *);
 
 API_PRETURN_HDR setNetConnConnTypeStr(PhidgetNetConnHandle, const char *);
 API_CRETURN_HDR getNetConnPeerName(PhidgetNetConnHandle);
@@ -525,10 +616,14 @@ API_VPRETURN_HDR getNetConnPrivate(PhidgetNetConnHandle);
 API_PRETURN_HDR setNetConnProtocol(PhidgetNetConnHandle, const char *, int, int);
 API_PRETURN_HDR setNetConnHandlers(PhidgetNetConnHandle, NetConnClose, NetConnRelease, NetConnWrite,
   NetConnRead);
+API_PRETURN_HDR setNetConnFlushHandler(PhidgetNetConnHandle, NetConnFlush);
+API_IRETURN_HDR getNetConnWriteBatch(PhidgetNetConnHandle);
+API_PRETURN_HDR setNetConnBufferedHandler(PhidgetNetConnHandle, NetConnBuffered);
 API_PRETURN_HDR setNetConnConnectionTypeListener(PhidgetNetConnHandle);
 API_PRETURN_HDR setNetConnConnectionTypeLocal(PhidgetNetConnHandle);
 
 API_PRETURN_HDR netConnWrite(mosiop_t, PhidgetNetConnHandle, const void *, size_t);
+API_PRETURN_HDR netConnSendFile(mosiop_t, PhidgetNetConnHandle, int, uint64_t);
 API_PRETURN_HDR netConnRead(mosiop_t, PhidgetNetConnHandle, void *, size_t *);
 API_PRETURN_HDR netConnReadLine(mosiop_t, PhidgetNetConnHandle, void *, size_t *);
 
@@ -538,6 +633,7 @@ PhidgetNetConnHandle CCONV getIPhidgetServerNetConn(IPhidgetServerHandle);
 /* device server handlers */
 API_PRETURN_HDR handleDeviceRequest(mosiop_t, PhidgetNetConnHandle, netreq_t *, int *);
 API_PRETURN_HDR handleDeviceClient(mosiop_t, IPhidgetServerHandle);
+API_PRETURN_HDR upgradeDeviceClient(mosiop_t, IPhidgetServerHandle);
 API_PRETURN_HDR handleNetworkRequest(mosiop_t, PhidgetNetConnHandle, int *);
 
 API_PRETURN_HDR createPhidgetNetConn(IPhidgetServerHandle, PhidgetNetConnHandle *);
@@ -37,8 +37,15 @@
 #include "util/json.h"
 #include "util/phidgetconfig.h"
 #include "manager.h"
+#include "stats.h"
 #include "mos/mos_byteorder.h"
 
+#if SERVER_EVENTLOOP
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
 static phidgetnetconnlist_t openServers;
 static int openServersCnt;
 
@@ -51,6 +58,12 @@ static int srvstarted;
 
 extern int _allowDataGram;
 
+#if SERVER_EVENTLOOP
+static void EventLoopInit(void);
+static void EventLoopFini(void);
+static void stopEventLoops(void);
+#endif
+
 static int
 isInitialized() {
 	int init;
@@ -78,6 +91,9 @@ ServerInit() {
 	MTAILQ_INIT(&openServers);
 	openServersCnt = 0;
 	mos_mutex_init(&srvlock);
+#if SERVER_EVENTLOOP
+	EventLoopInit();
+#endif
 	initialized = 1;
 	mos_gunlock((void *)1);
 }
@@ -92,6 +108,9 @@ ServerFini() {
 	}
 
 	mos_mutex_destroy(&srvlock);
+#if SERVER_EVENTLOOP
+	EventLoopFini();
+#endif
 	initialized = 0;
 	mos_gunlock((void *)1);
 }
@@ -130,6 +149,10 @@ ServerStop() {
 	while (!MTAILQ_EMPTY(&openServers))
 		mos_usleep(10000);
 
+#if SERVER_EVENTLOOP
+	stopEventLoops();
+#endif
+
 	mos_glock((void *)1);
 	srvstarted = 0;
 	mos_gunlock((void *)1);
@@ -227,12 +250,12 @@ handleBridgePacket(mosiop_t iop, PhidgetNetConnHandle nc, netreq_t *req) {
 	PhidgetReturnCode res, res1;
 	BridgePacket *bp;
 
-	res = parseBridgePacketJSON(nc->tokens, &bp, (char *)req->nr_data, req->nr_len);
+	res = parseBridgePacket(nc->tokens, &bp, req->nr_data, req->nr_len);
 	if (res != EPHIDGET_OK) {
-		res1 = sendSimpleReply(nc, req->nr_reqseq, EPHIDGET_UNEXPECTED, "failed to parse bridge packet JSON");
+		res1 = sendSimpleReply(nc, req->nr_reqseq, EPHIDGET_UNEXPECTED, "failed to parse bridge packet");
 		if (res1 != EPHIDGET_OK)
 			return (MOS_ERROR(iop, res1, "failed to send simple reply"));
-		return (MOS_ERROR(iop, EPHIDGET_UNEXPECTED, "failed to parse bridge packet JSON"));
+		return (MOS_ERROR(iop, EPHIDGET_UNEXPECTED, "failed to parse bridge packet"));
 	}
 
 	bridgePacketSetIsFromNet(bp, nc);
@@ -298,17 +321,26 @@ static PhidgetReturnCode
 sendEventToEachClient(mosiop_t iop, msgtype_t type, msgsubtype_t subtype, void *buf, uint32_t len, int dgram) {
 	PhidgetNetConnHandle nc;
 	PhidgetReturnCode res;
+	NetEventBuffer *eb;
+
+	res = createNetEventBuffer(type, subtype, buf, len, dgram, &eb);
+	if (res != EPHIDGET_OK)
+		return (MOS_ERROR(iop, res, "failed to create event buffer"));
 
+	/* Queued by reference: writing to each client is left to the network output workers */
 	mos_mutex_lock(&srvlock);
 	MTAILQ_FOREACH(nc, &openServers, openlink) {
-		NetConnWriteLock(nc);
-		res = sendEventToClient(nc, iop, type, subtype, buf, len, dgram);
-		NetConnWriteUnlock(nc);
-		if (res != EPHIDGET_OK)
-			netlogerr("sendEventToClient() failed for %s: "PRC_FMT, nc->peername, PRC_ARGS(res));
+		if (type == MSG_DEVICE && subtype == SMSG_DEVCHANNEL && !PhidgetCKFlags(nc, PNCF_SENDCHANNELS))
+			continue;
+
+		res = queueNetConnEvent(nc, eb);
+		if (res != EPHIDGET_OK && res != EPHIDGET_CLOSED)
+			netlogerr("queueNetConnEvent() failed for %s: "PRC_FMT, nc->peername, PRC_ARGS(res));
 	}
 	mos_mutex_unlock(&srvlock);
 
+	releaseNetEventBuffer(&eb);
+
 	return (EPHIDGET_OK);
 }
 
@@ -608,11 +640,12 @@ openDataGramSocket(PhidgetNetConnHandle nc) {
 		netlogwarn("Failed to send datagram start to client %"PRIphid"", nc);
 }
 
-API_PRETURN
-handleDeviceClient(mosiop_t iop, IPhidgetServerHandle server) {
+/*
+ * Runs the handshake with a new device client, and sends it the attached devices.
+ */
+static PhidgetReturnCode
+startDeviceClient(mosiop_t iop, IPhidgetServerHandle server) {
 	PhidgetReturnCode res;
-	mosiop_t siop;
-	int stop;
 
 	CHECKINITIALIZED;
 
@@ -655,6 +688,29 @@ handleDeviceClient(mosiop_t iop, IPhidgetServerHandle server) {
 		return (MOS_ERROR(iop, res, "failed to send devices to new client"));
 	}
 
+	return (EPHIDGET_OK);
+}
+
+static void
+stopDeviceClient(IPhidgetServerHandle server) {
+
+	mos_mutex_lock(&srvlock);
+	MTAILQ_REMOVE(&openServers, server->nc, openlink);
+	openServersCnt--;
+	MOS_ASSERT(openServersCnt >= 0);
+	mos_mutex_unlock(&srvlock);
+}
+
+API_PRETURN
+handleDeviceClient(mosiop_t iop, IPhidgetServerHandle server) {
+	PhidgetReturnCode res;
+	mosiop_t siop;
+	int stop;
+
+	res = startDeviceClient(iop, server);
+	if (res != EPHIDGET_OK)
+		return (res);
+
 	startKeepAliveTask(server->nc);
 
 	for (stop = 0; stop == 0 && server->nc->errcondition == 0;) {
@@ -692,16 +748,633 @@ handleDeviceClient(mosiop_t iop, IPhidgetServerHandle server) {
 	if (stop)
 		netlogdebug("stopped by network request");
 
-	mos_mutex_lock(&srvlock);
-	MTAILQ_REMOVE(&openServers, server->nc, openlink);
-	openServersCnt--;
-	MOS_ASSERT(openServersCnt >= 0);
-	mos_mutex_unlock(&srvlock);
+	stopDeviceClient(server);
 	if (res != EPHIDGET_OK)
 		return (MOS_ERROR(iop, res, "failed to handle client request"));
 	return (0);
 }
 
+#if SERVER_EVENTLOOP
+
+/*
+ * Device client event loop.
+ *
+ * Instead of a thread (plus a keepalive thread) per client, each client socket is registered with
+ * one of a few epoll loops.  The loops only watch for readiness and time: the work for a client
+ * (the handshake, a request, a keepalive) is queued to a small pool of workers, as request
+ * handlers may block.  A client is owned by at most one worker at a time (ELC_BUSY), and its socket
+ * is armed one-shot, so it is rearmed only once the worker is done with it.
+ *
+ * A worker reading from a client that stops sending mid-handshake or mid-request would otherwise wait
+ * for it forever, so work is given a deadline, enforced from the loop: the handshake has
+ * EVENTLOOP_HANDSHAKE, and anything after that two keepalive periods, which is as long as the
+ * keepalive task of a client thread would wait before dropping an unresponsive client.
+ *
+ * The number of loops and workers are set with the "eventloopthreads" and "eventloopworkers"
+ * network properties, and take effect the next time the loops start.  Setting "eventloop" to 0
+ * returns to a thread per client.
+ */
+#define EVENTLOOP_MAXTHREADS	16
+#define EVENTLOOP_MAXWORKERS	64
+#define EVENTLOOP_THREADS		1
+#define EVENTLOOP_WORKERS		4
+#define EVENTLOOP_TICK			250		/* ms between keepalive and stop checks */
+#define EVENTLOOP_HANDSHAKE		10000	/* ms a new client has to complete the handshake */
+#define EVENTLOOP_EVENTS		64
+
+#define ELC_START		0x01	/* handshake pending */
+#define ELC_READ		0x02	/* socket is readable */
+#define ELC_TICK		0x04	/* keepalive or stop check pending */
+#define ELC_WORK		(ELC_START | ELC_READ | ELC_TICK)
+#define ELC_BUSY		0x10	/* queued to, or owned by, a worker */
+#define ELC_ARMED		0x20	/* armed in epoll */
+#define ELC_REGISTERED	0x40	/* added to epoll */
+
+typedef struct _EventLoop EventLoop;
+
+typedef struct _EventLoopClient {
+	IPhidgetServerHandle	server;
+	EventLoop				*loop;
+	int						fd;			/* socket registered with the loop */
+	int						flags;		/* ELC_*: protected by evlock */
+	mostime_t				deadline;	/* evlock: the worker's work must be done by then; 0 if unbounded */
+	PhidgetReturnCode		deadlineres;	/* evlock: error the client fails with if the deadline passes */
+	int						begun;		/* worker only */
+	int						started;	/* worker only: handshake completed */
+	MTAILQ_ENTRY(_EventLoopClient)	link;
+	MTAILQ_ENTRY(_EventLoopClient)	worklink;
+} EventLoopClient;
+
+typedef MTAILQ_HEAD(eventloopclients, _EventLoopClient) eventloopclients_t;
+
+struct _EventLoop {
+	int						index;
+	int						epfd;
+	int						wakefd;
+	int						nclients;
+	eventloopclients_t		clients;
+};
+
+static mos_mutex_t			evlock;
+static mos_cond_t			evcond;
+static EventLoop			eventLoops[EVENTLOOP_MAXTHREADS];
+static eventloopclients_t	evWork;
+static int					eventLoopEnabled = 1;
+static int					eventLoopCnt = EVENTLOOP_THREADS;
+static int					eventWorkerCnt = EVENTLOOP_WORKERS;
+static int					eventLoopsStarted;		/* loops running */
+static int					eventThreads;			/* loop and worker threads running */
+static int					eventLoopStop;
+static int					evClients;
+static uint32_t				nextLoop;
+
+static void
+EventLoopInit() {
+
+	mos_mutex_init(&evlock);
+	mos_cond_init(&evcond);
+	MTAILQ_INIT(&evWork);
+}
+
+static void
+EventLoopFini() {
+
+	mos_mutex_destroy(&evlock);
+	mos_cond_destroy(&evcond);
+}
+
+PhidgetReturnCode
+setEventLoopProperty(const char *key, const char *val) {
+	PhidgetReturnCode res;
+	uint32_t u;
+
+	if (mos_strtou32(val, 0, &u) != 0)
+		return (EPHIDGET_INVALIDARG);
+
+	res = EPHIDGET_OK;
+
+	mos_mutex_lock(&evlock);
+	if (mos_strcmp(key, "eventloop") == 0)
+		eventLoopEnabled = (u != 0);
+	else if (mos_strcmp(key, "eventloopthreads") == 0 && u >= 1 && u <= EVENTLOOP_MAXTHREADS)
+		eventLoopCnt = u;
+	else if (mos_strcmp(key, "eventloopworkers") == 0 && u >= 1 && u <= EVENTLOOP_MAXWORKERS)
+		eventWorkerCnt = u;
+	else
+		res = EPHIDGET_INVALIDARG;
+	mos_mutex_unlock(&evlock);
+
+	return (res);
+}
+
+/*
+ * evlock must be held.
+ */
+static void
+scheduleEventLoopClient(EventLoopClient *c, int work) {
+
+	c->flags |= work;
+	if (c->flags & ELC_BUSY)
+		return;
+
+	c->flags |= ELC_BUSY;
+	MTAILQ_INSERT_TAIL(&evWork, c, worklink);
+	mos_cond_signal(&evcond);
+}
+
+/*
+ * evlock must be held.
+ */
+static void
+armEventLoopClient(EventLoopClient *c) {
+	struct epoll_event ev;
+	int op;
+
+	if (c->fd < 0 || c->flags & ELC_ARMED)
+		return;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+	ev.data.ptr = c;
+	op = (c->flags & ELC_REGISTERED) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+
+	if (epoll_ctl(c->loop->epfd, op, c->fd, &ev) != 0) {
+		netlogerr("%"PRIphid": failed to arm connection in event loop: %s", c->server->nc, strerror(errno));
+		c->server->nc->errcondition = EPHIDGET_UNEXPECTED;
+		scheduleEventLoopClient(c, ELC_TICK);
+		return;
+	}
+
+	c->flags |= ELC_ARMED | ELC_REGISTERED;
+}
+
+/*
+ * Called from the loop with evlock held: decides if a client needs a worker for a keepalive, or
+ * because it is closing.
+ */
+static int
+eventLoopClientNeedsTick(EventLoopClient *c, mostime_t now) {
+	PhidgetNetConnHandle nc;
+
+	if (eventLoopStop)
+		return (1);
+
+	nc = c->server->nc;
+	if (nc->errcondition != EPHIDGET_OK)
+		return (1);
+
+	/* The handshake is still running on a worker */
+	if (!c->started)
+		return (0);
+
+	if (PhidgetCKFlags(nc, PNCF_STOP))
+		return (1);
+
+	if (nc->keepalive == 0 || (nc->ppmajor == 1 && nc->ppminor == 0))
+		return (0);
+
+	if (nc->keepalive_dl != 0)
+		return (now > nc->keepalive_dl);
+
+	return (nc->keepalive_last == 0 || now > nc->keepalive_last + nc->keepalive);
+}
+
+/*
+ * Called by a worker with evlock held as it takes the client: bounds how long the work may take.
+ */
+static void
+setEventLoopClientDeadline(EventLoopClient *c) {
+	PhidgetNetConnHandle nc;
+
+	nc = c->server->nc;
+
+	if (!c->started) {
+		c->deadline = mos_gettime_usec() + EVENTLOOP_HANDSHAKE * 1000;
+		c->deadlineres = EPHIDGET_TIMEOUT;
+	} else if (nc->keepalive != 0 && !(nc->ppmajor == 1 && nc->ppminor == 0)) {
+		c->deadline = mos_gettime_usec() + nc->keepalive * 2;
+		c->deadlineres = EPHIDGET_KEEPALIVE;
+	} else {
+		c->deadline = 0;
+	}
+}
+
+/*
+ * Called from the loop with evlock held: fails a client whose worker has not finished by the
+ * deadline.  The worker sees the error condition the next time it tries to read or write.
+ */
+static void
+checkEventLoopClientDeadline(EventLoopClient *c, mostime_t now) {
+	PhidgetNetConnHandle nc;
+
+	if (c->deadline == 0 || now <= c->deadline)
+		return;
+
+	nc = c->server->nc;
+	netlogerr("%"PRIphid": client stalled during %s: closing connection", nc,
+	  c->deadlineres == EPHIDGET_TIMEOUT ? "handshake" : "request");
+	if (nc->errcondition == EPHIDGET_OK)
+		nc->errcondition = c->deadlineres;
+	c->deadline = 0;
+}
+
+/*
+ * Does the work for a client on a worker thread.  Returns non-zero once the client is finished,
+ * with the result in *res.
+ */
+static int
+serviceEventLoopClient(EventLoopClient *c, int work, mosiop_t iop, PhidgetReturnCode *res) {
+	IPhidgetServerHandle server;
+	PhidgetNetConnHandle nc;
+	mostime_t tm;
+	int stop;
+
+	server = c->server;
+	nc = server->nc;
+	*res = EPHIDGET_OK;
+
+	if (work & ELC_START) {
+		if (!c->begun) {
+			if (beginClientConnection(server) != EPHIDGET_OK)
+				return (1);
+			c->begun = 1;
+		}
+
+		*res = startDeviceClient(iop, server);
+		if (*res != EPHIDGET_OK)
+			return (1);
+		c->started = 1;
+		c->fd = nc->sock;
+	}
+
+	if (work & ELC_READ) {
+		stop = 0;
+		*res = serviceNetworkRequest(iop, nc, &stop, 0);
+		if (*res == EPHIDGET_TIMEOUT)
+			*res = EPHIDGET_OK;
+		if (*res != EPHIDGET_OK) {
+			nc->errcondition = *res;
+			return (1);
+		}
+		if (stop) {
+			netlogdebug("stopped by network request");
+			return (1);
+		}
+	}
+
+	if (work & ELC_TICK) {
+		if (nc->errcondition != EPHIDGET_OK) {
+			*res = nc->errcondition;
+			return (1);
+		}
+
+		tm = mos_gettime_usec();
+		if (nc->keepalive != 0 && nc->keepalive_dl != 0 && nc->keepalive_dl < tm) {
+			netlogerr("%"PRIphid": keepalive check failed - keepalive: [%"PRId64" usec] overshot by: [%"PRId64" usec]",
+			  nc, nc->keepalive, (tm - nc->keepalive_dl));
+			nc->errcondition = EPHIDGET_KEEPALIVE;
+			*res = MOS_ERROR(iop, EPHIDGET_KEEPALIVE, "keepalive failed");
+			return (1);
+		}
+
+		if (c->started) {
+			*res = keepAlive(server);
+			if (*res != EPHIDGET_OK)
+				return (1);
+		}
+	}
+
+	if (PhidgetCKFlags(nc, PNCF_STOP)) {
+		netlogdebug("connection flagged as closing");
+		return (1);
+	}
+
+	mos_mutex_lock(&evlock);
+	stop = eventLoopStop;
+	/* Requests the read handler has already buffered will not make the socket readable again */
+	if (nc->buffered != NULL && nc->buffered(nc) > 0)
+		c->flags |= ELC_READ;
+	mos_mutex_unlock(&evlock);
+
+	return (stop);
+}
+
+/*
+ * Removes a finished client from its loop and closes the connection.  evlock must be held, and
+ * is dropped while the connection is closed.
+ */
+static void
+retireEventLoopClient(EventLoopClient *c, PhidgetReturnCode res, mosiop_t iop) {
+	IPhidgetServerHandle server;
+
+	server = c->server;
+
+	MTAILQ_REMOVE(&c->loop->clients, c, link);
+	c->loop->nclients--;
+
+	/* The socket may already have been closed, and the descriptor reused, by stopPhidgetNetConn() */
+	if (c->flags & ELC_REGISTERED && c->fd == server->nc->sock)
+		epoll_ctl(c->loop->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+
+	mos_mutex_unlock(&evlock);
+
+	if (c->started)
+		stopDeviceClient(server);
+
+	endClientConnection(server, c->begun, res, iop);
+	mos_free(c, sizeof(*c));
+	decPhidgetStat("server.eventloopclients");
+
+	mos_mutex_lock(&evlock);
+	evClients--;
+}
+
+static MOS_TASK_RESULT
+runEventWorker(void *arg) {
+	EventLoopClient *c;
+	PhidgetReturnCode res;
+	mosiop_t iop;
+	int work;
+	int done;
+
+	mos_task_setname("Phidget22 Network Event Worker");
+	netlogdebug("network event worker started: 0x%08x", mos_self());
+
+	mos_mutex_lock(&evlock);
+	for (;;) {
+		c = MTAILQ_FIRST(&evWork);
+		if (c == NULL) {
+			if (eventLoopStop && evClients == 0)
+				break;
+			mos_cond_timedwait(&evcond, &evlock, EVENTLOOP_TICK * MOS_MSEC);
+			continue;
+		}
+		MTAILQ_REMOVE(&evWork, c, worklink);
+
+		while ((work = c->flags & ELC_WORK) != 0) {
+			c->flags &= ~work;
+			setEventLoopClientDeadline(c);
+			mos_mutex_unlock(&evlock);
+
+			iop = mos_iop_alloc();
+			done = serviceEventLoopClient(c, work, iop, &res);
+
+			mos_mutex_lock(&evlock);
+			if (done) {
+				retireEventLoopClient(c, res, iop);
+				c = NULL;
+			}
+			mos_iop_release(&iop);
+			if (c == NULL)
+				break;
+		}
+
+		if (c != NULL) {
+			c->deadline = 0;
+			c->flags &= ~ELC_BUSY;
+			armEventLoopClient(c);
+		}
+	}
+
+	eventThreads--;
+	mos_cond_broadcast(&evcond);
+	mos_mutex_unlock(&evlock);
+
+	netlogdebug("network event worker exiting");
+	MOS_TASK_EXIT(0);
+}
+
+static MOS_TASK_RESULT
+runEventLoop(void *arg) {
+	struct epoll_event evs[EVENTLOOP_EVENTS];
+	EventLoopClient *c;
+	EventLoop *loop;
+	mostime_t nexttick;
+	mostime_t now;
+	uint64_t val;
+	int n, i;
+
+	loop = arg;
+
+	mos_task_setname("Phidget22 Network Event Loop %d", loop->index);
+	netlogdebug("network event loop %d started: 0x%08x", loop->index, mos_self());
+
+	nexttick = 0;
+
+	mos_mutex_lock(&evlock);
+	for (;;) {
+		if (eventLoopStop && loop->nclients == 0)
+			break;
+		mos_mutex_unlock(&evlock);
+
+		n = epoll_wait(loop->epfd, evs, EVENTLOOP_EVENTS, EVENTLOOP_TICK);
+		if (n < 0 && errno != EINTR)
+			netlogerr("epoll_wait() failed: %s", strerror(errno));
+
+		mos_mutex_lock(&evlock);
+		for (i = 0; i < n; i++) {
+			c = evs[i].data.ptr;
+			if (c == NULL) {
+				if (read(loop->wakefd, &val, sizeof(val)) < 0)
+					; /* nothing to clear */
+				continue;
+			}
+			c->flags &= ~ELC_ARMED;
+			scheduleEventLoopClient(c, ELC_READ);
+		}
+
+		now = mos_gettime_usec();
+		if (eventLoopStop || now >= nexttick) {
+			MTAILQ_FOREACH(c, &loop->clients, link) {
+				if (c->flags & ELC_BUSY)
+					checkEventLoopClientDeadline(c, now);
+				else if (eventLoopClientNeedsTick(c, now))
+					scheduleEventLoopClient(c, ELC_TICK);
+			}
+			nexttick = now + EVENTLOOP_TICK * 1000;
+		}
+	}
+
+	eventThreads--;
+	mos_cond_broadcast(&evcond);
+	mos_mutex_unlock(&evlock);
+
+	netlogdebug("network event loop %d exiting", loop->index);
+	MOS_TASK_EXIT(0);
+}
+
+/*
+ * evlock must be held.
+ */
+static PhidgetReturnCode
+startEventLoops() {
+	struct epoll_event ev;
+	EventLoop *loop;
+	int i;
+
+	for (i = 0; i < eventLoopCnt; i++) {
+		loop = &eventLoops[i];
+		loop->index = i;
+		loop->nclients = 0;
+		MTAILQ_INIT(&loop->clients);
+
+		loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+		if (loop->epfd < 0) {
+			netlogerr("epoll_create1() failed: %s", strerror(errno));
+			break;
+		}
+
+		loop->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (loop->wakefd < 0) {
+			netlogerr("eventfd() failed: %s", strerror(errno));
+			close(loop->epfd);
+			break;
+		}
+
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.ptr = NULL;
+		if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, loop->wakefd, &ev) != 0
+		  || mos_task_create(NULL, runEventLoop, loop) != 0) {
+			netlogerr("failed to start network event loop %d", i);
+			close(loop->wakefd);
+			close(loop->epfd);
+			break;
+		}
+		eventThreads++;
+		eventLoopsStarted++;
+	}
+
+	if (eventLoopsStarted == 0)
+		return (EPHIDGET_UNEXPECTED);
+
+	for (i = 0; i < eventWorkerCnt; i++) {
+		if (mos_task_create(NULL, runEventWorker, NULL) != 0) {
+			netlogerr("failed to start network event worker");
+			break;
+		}
+		eventThreads++;
+	}
+
+	/* Without workers, the loops will exit once stopped */
+	if (i == 0) {
+		eventLoopStop = 1;
+		return (EPHIDGET_UNEXPECTED);
+	}
+
+	netloginfo("Started %d network event loop(s) with %d worker(s)", eventLoopsStarted, i);
+	return (EPHIDGET_OK);
+}
+
+/*
+ * Called once all device clients have been stopped: waits for the loops and workers to exit.
+ */
+static void
+stopEventLoops() {
+	uint64_t val;
+	int i;
+
+	mos_mutex_lock(&evlock);
+	if (eventLoopsStarted == 0 && eventThreads == 0) {
+		eventLoopStop = 0;
+		mos_mutex_unlock(&evlock);
+		return;
+	}
+
+	eventLoopStop = 1;
+	val = 1;
+	for (i = 0; i < eventLoopsStarted; i++) {
+		if (write(eventLoops[i].wakefd, &val, sizeof(val)) < 0)
+			netlogwarn("failed to wake network event loop %d", i);
+	}
+	mos_cond_broadcast(&evcond);
+
+	while (eventThreads > 0)
+		mos_cond_wait(&evcond, &evlock);
+
+	for (i = 0; i < eventLoopsStarted; i++) {
+		close(eventLoops[i].wakefd);
+		close(eventLoops[i].epfd);
+	}
+	eventLoopsStarted = 0;
+	eventLoopStop = 0;
+	mos_mutex_unlock(&evlock);
+}
+
+/*
+ * Hands a device client to the event loop, starting the loops if required.  begun is set if the
+ * connection is already running, as when a web connection is upgraded to a device client.
+ * Returns EPHIDGET_UNSUPPORTED if the event loop is disabled.
+ */
+PhidgetReturnCode
+addEventLoopClient(IPhidgetServerHandle server, int begun) {
+	PhidgetReturnCode res;
+	EventLoopClient *c;
+
+	mos_mutex_lock(&evlock);
+	if (!eventLoopEnabled) {
+		mos_mutex_unlock(&evlock);
+		return (EPHIDGET_UNSUPPORTED);
+	}
+
+	if (eventLoopStop) {
+		mos_mutex_unlock(&evlock);
+		return (EPHIDGET_CLOSED);
+	}
+
+	if (eventLoopsStarted == 0) {
+		res = startEventLoops();
+		if (res != EPHIDGET_OK) {
+			mos_mutex_unlock(&evlock);
+			stopEventLoops();
+			return (res);
+		}
+	}
+
+	c = mos_zalloc(sizeof(*c));
+	c->server = server;
+	c->fd = -1;
+	c->begun = begun;
+	c->loop = &eventLoops[nextLoop++ % eventLoopsStarted];
+	MTAILQ_INSERT_TAIL(&c->loop->clients, c, link);
+	c->loop->nclients++;
+	evClients++;
+
+	scheduleEventLoopClient(c, ELC_START);
+	mos_mutex_unlock(&evlock);
+
+	incPhidgetStat("server.eventloopclients_ever");
+	incPhidgetStat("server.eventloopclients");
+
+	return (EPHIDGET_OK);
+}
+
+#endif /* SERVER_EVENTLOOP */
+
+/*
+ * Called by a connection handler that has upgraded its connection to a device client (the web
+ * server, for a phidgets websocket).  Where the event loop is in use, the connection is flagged and
+ * handed to it once the handler returns, so the connection thread can exit; otherwise the client is
+ * handled on the calling thread.
+ */
+API_PRETURN
+upgradeDeviceClient(mosiop_t iop, IPhidgetServerHandle server) {
+#if SERVER_EVENTLOOP
+	int enabled;
+
+	mos_mutex_lock(&evlock);
+	enabled = eventLoopEnabled;
+	mos_mutex_unlock(&evlock);
+
+	if (enabled) {
+		server->flags |= IPSF_DEVICECLIENT;
+		return (EPHIDGET_OK);
+	}
+#endif
+
+	return (handleDeviceClient(iop, server));
+}
+
 #define CK(stmt)	do {			\
 	res = (stmt);					\
 	if (res != EPHIDGET_OK)			\
@@ -739,6 +1412,7 @@ netConnToPConf(PhidgetNetConnHandle nc, pconf_t **upc) {
 	CKBAD(pconf_addu(pc, nc->io_ev, "ioev"));
 	CKBAD(pconf_addstr(pc, ctime, "ctime"));
 	CKBAD(pconf_addi(pc, nc->openchannels, "openchannels"));
+	CKBAD(netConnOutputToPConf(nc, pc));
 
 	*upc = pc;
 	return (EPHIDGET_OK);
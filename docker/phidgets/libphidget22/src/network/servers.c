@@ -665,6 +665,16 @@ startKeepAliveTask(PhidgetNetConnHandle nc) {
 
 API_PRETURN
 handleNetworkRequest(mosiop_t iop, PhidgetNetConnHandle nc, int *stop) {
+
+	return (serviceNetworkRequest(iop, nc, stop, 500));
+}
+
+/*
+ * Waits up to msec for a request, and handles it.  The event loop calls this with 0 once the socket
+ * is known to be readable.
+ */
+PhidgetReturnCode
+serviceNetworkRequest(mosiop_t iop, PhidgetNetConnHandle nc, int *stop, uint32_t msec) {
 	PhidgetReturnCode res;
 	mosiop_t iop2;
 	netreq_t req;
@@ -674,13 +684,17 @@ handleNetworkRequest(mosiop_t iop, PhidgetNetConnHandle nc, int *stop) {
 	 * Poll for data on the TCP socket and the UDP socket.
 	 *
 	 * If both have pending IO, we always read TCP first as the UDP events
-	 * are of lower priority.
+	 * are of lower priority.  Input the read handler has already buffered counts as TCP data.
 	 */
-	res = mos_netop_tcp_rpoll2(iop, &nc->sock, &nc->dgsock, &socks, 500);
-	if (res != 0) {
-		if (res != EPHIDGET_TIMEOUT)
-			return (MOS_ERROR(iop, res, "failed to poll for IO"));
-		return (res);
+	if (nc->buffered != NULL && nc->buffered(nc) > 0) {
+		socks = 0x01;
+	} else {
+		res = mos_netop_tcp_rpoll2(iop, &nc->sock, &nc->dgsock, &socks, msec);
+		if (res != 0) {
+			if (res != EPHIDGET_TIMEOUT)
+				return (MOS_ERROR(iop, res, "failed to poll for IO"));
+			return (res);
+		}
 	}
 
 	if (socks & 0x01) {
@@ -728,35 +742,44 @@ readcomplete:
 	return (EPHIDGET_OK);
 }
 
-static MOS_TASK_RESULT
-runClientConnection(void *arg) {
-	IPhidgetServerHandle server;
+/*
+ * Moves a client connection from TS_RUN to TS_RUNNING: fails if the connection was stopped before
+ * it could be serviced.
+ */
+PhidgetReturnCode
+beginClientConnection(IPhidgetServerHandle server) {
 	PhidgetReturnCode res;
-	mosiop_t iop;
 
-	res = EPHIDGET_OK;
+	mos_tlock_lock(server->lock);
+	if (server->state == TS_RUN) {
+		server->state = TS_RUNNING;
+		res = EPHIDGET_OK;
+	} else {
+		res = EPHIDGET_CLOSED;
+	}
+	mos_tlock_unlock(server->lock);
 
-	server = arg;
+	return (res);
+}
 
-	mos_task_setname("Phidget22 Network Server Client Thread - %"PRIphid, server->nc);
-	netlogdebug("'%s' network server client thread started - %"PRIphid": 0x%08x", server->name, server->nc, mos_self());
+/*
+ * Closes and frees a client connection once it is no longer being serviced.  If the connection
+ * was begun, res and iop are the result of servicing it.
+ */
+void
+endClientConnection(IPhidgetServerHandle server, int begun, PhidgetReturnCode res, mosiop_t iop) {
 
-	mos_tlock_lock(server->lock);
-	if (server->state != TS_RUN)
+	if (!begun) {
+		mos_tlock_lock(server->lock);
 		goto done;
+	}
 
-	server->state = TS_RUNNING;
-	mos_tlock_unlock(server->lock);
-
-	iop = mos_iop_alloc();
-	res = server->handleClient(iop, server);
 	if (res != EPHIDGET_OK) {
 		if (res == EPHIDGET_IO || res == EPHIDGET_PIPE || res == EPHIDGET_ACCESS) // we expect network errors
 			netlogverbose("'%s' failed for client %"PRIphid"\n%N", server->name, server->nc, iop);
 		else
 			netlogerr("'%s' failed for client %"PRIphid"\n%N", server->name, server->nc, iop);
 	}
-	mos_iop_release(&iop);
 
 	if (res != EPHIDGET_ACCESS && server->info.type != PHIDGETSERVER_WWW)
 		netloginfo("%"PRIphid" disconnected", server->nc);
@@ -776,7 +799,49 @@ done:
 	 * This is where the handle and netconn are freed.
 	 */
 	closeIPhidgetServer(&server);
+}
+
+static MOS_TASK_RESULT
+runClientConnection(void *arg) {
+	IPhidgetServerHandle server;
+	PhidgetReturnCode res;
+	mosiop_t iop;
+
+	res = EPHIDGET_OK;
+
+	server = arg;
+
+	mos_task_setname("Phidget22 Network Server Client Thread - %"PRIphid, server->nc);
+	netlogdebug("'%s' network server client thread started - %"PRIphid": 0x%08x", server->name, server->nc, mos_self());
+
+	if (beginClientConnection(server) != EPHIDGET_OK) {
+		endClientConnection(server, 0, res, NULL);
+		goto done;
+	}
+
+	iop = mos_iop_alloc();
+	res = server->handleClient(iop, server);
+
+#if SERVER_EVENTLOOP
+	/*
+	 * The handler upgraded the connection to a device client: the event loop services and ends it
+	 * from here.
+	 */
+	if (res == EPHIDGET_OK && server->flags & IPSF_DEVICECLIENT) {
+		server->flags &= ~IPSF_DEVICECLIENT;
+		res = addEventLoopClient(server, 1);
+		if (res == EPHIDGET_OK) {
+			mos_iop_release(&iop);
+			goto done;
+		}
+		res = handleDeviceClient(iop, server);
+	}
+#endif
 
+	endClientConnection(server, 1, res, iop);
+	mos_iop_release(&iop);
+
+done:
 	decPhidgetStat("server.clienttasks");
 	MOS_TASK_EXIT(res);
 }
@@ -881,6 +946,23 @@ runAcceptServer(void *arg) {
 		netlogverbose(SERVER_FMT "%s accepted connection [%s -> %s]", SERVER_ARG, conn->name,
 		  conn->nc->peername, mos_getaddrinfo(&server->nc->addr, NULL, 0));
 
+#if SERVER_EVENTLOOP
+		/*
+		 * Device clients are serviced by the event loop instead of a thread of their own.
+		 */
+		if (conn->handleClient == handleDeviceClient) {
+			PhidgetSetFlags(conn->nc, PNCF_HASTHREAD);
+			conn->state = TS_RUN;
+			err = addEventLoopClient(conn, 0);
+			if (err == EPHIDGET_OK) {
+				netlogdebug(SERVER_FMT "connection handed to the event loop", SERVER_ARG);
+				goto next;
+			}
+			if (err != EPHIDGET_UNSUPPORTED)
+				netlogwarn(SERVER_FMT "event loop unavailable: starting a thread for the connection", SERVER_ARG);
+		}
+#endif
+
 		netlogdebug(SERVER_FMT "about to create task to handle client", SERVER_ARG);
 		PhidgetLock(conn->nc);
 		conn->nc->__flags |= PNCF_HASTHREAD;
@@ -1525,6 +1607,12 @@ PhidgetNet_setPropertyv(const char *key, const char *fmt, va_list va) {
 		res =setAllowDataGram(val);
 	else if (mos_strcmp(key, "resolveaddrs") == 0)
 		res =setResolveAddrs(val);
+	else if (mos_strncmp(key, "outqueue", 8) == 0)
+		res = setOutputQueueProperty(key, val);
+#if SERVER_EVENTLOOP
+	else if (mos_strncmp(key, "eventloop", 9) == 0)
+		res = setEventLoopProperty(key, val);
+#endif
 	else
 		res = EPHIDGET_INVALIDARG;
 
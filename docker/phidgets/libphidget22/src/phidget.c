@@ -72,6 +72,32 @@ uint32_t phidgetChannelsCount;
 attachdetachentries_t attachDetachQueue;
 mos_tlock_t *attachDetachQueueLock;
 
+/*
+ * Indexes for getDeviceById() and getChannelById(), which are called for network requests and
+ * remote opens and closes.  Devices are indexed by handle while they are in the device list, and
+ * channels by channel id while they are in the channel list and have a parent.  The indexes have
+ * their own lock so lookups do not take the device or channel list locks.
+ *
+ * Lock order is device/channel list, channel run lock, then the index lock.
+ */
+#define PHIDGET_IDBUCKETS	256
+static PhidgetDeviceHandle deviceIdIndex[PHIDGET_IDBUCKETS];
+static PhidgetChannelHandle channelIdIndex[PHIDGET_IDBUCKETS];
+static mos_rwlock_t idIndexLock;
+
+static void indexChannel(PhidgetChannelHandle);
+static void buildUDDIndex(void);
+static void freeUDDIndex(void);
+
+static uint32_t
+idIndexHash(uint64_t id) {
+
+	id ^= id >> 33;
+	id *= 0xff51afd7ed558ccdULL;
+	id ^= id >> 33;
+	return ((uint32_t)(id % PHIDGET_IDBUCKETS));
+}
+
 /*
  * Needs to be called during startup.
  *
@@ -91,6 +117,9 @@ PhidgetInit() {
 	mos_tlock_init(devicesLock, P22LOCK_DEVICELISTLOCK, P22LOCK_FLAGS | MOSLOCK_RWLOCK);
 	mos_rwrlock_init(&channelsLock);
 	mos_tlock_init(attachDetachQueueLock, P22LOCK_NETQUEUELISTLOCK, P22LOCK_FLAGS);
+	mos_rwlock_init(&idIndexLock);
+
+	buildUDDIndex();
 }
 
 void
@@ -99,6 +128,9 @@ PhidgetFini() {
 	mos_tlock_destroy(&devicesLock);
 	mos_rwrlock_destroy(&channelsLock);
 	mos_tlock_destroy(&attachDetachQueueLock);
+	mos_rwlock_destroy(&idIndexLock);
+
+	freeUDDIndex();
 }
 
 void
@@ -229,6 +261,8 @@ setParent(void *_phid, void *_device) {
 	phid->parent = device;
 	if (device)
 		PhidgetRetain(device);
+	if (ISCHANNEL(phid))
+		indexChannel((PhidgetChannelHandle)phid);
 	PhidgetRunUnlock(phid);
 }
 
@@ -398,6 +432,32 @@ PhidgetDevice_usbDataInput(PhidgetDeviceHandle device, uint8_t *buffer, size_t l
 }
 
 
+/*
+ * Notes when the packet about to be handed to dataInput() was read, falling back to now on
+ * platforms that do not timestamp their reads.
+ */
+static void
+setDeviceInputTime(PhidgetDeviceHandle device, mostime_t readTime) {
+
+	device->inputTask = mos_self();
+	device->inputTime = readTime != 0 ? readTime : mos_gettime_usec();
+}
+
+/*
+ * The host time the input being handled on the calling thread was read, or 0 if the calling
+ * thread is not in the dataInput() of the device (or one of its parents).
+ */
+mostime_t
+PhidgetDevice_getInputTime(PhidgetDeviceHandle device) {
+
+	while (device->parent != NULL && device->inputTime == 0)
+		device = device->parent;
+
+	if (device->inputTime == 0 || !mos_task_equal(device->inputTask, mos_self()))
+		return (0);
+	return (device->inputTime);
+}
+
 PhidgetReturnCode
 PhidgetDevice_read(PhidgetDeviceHandle device) {
 	PhidgetReturnCode res;
@@ -415,6 +475,7 @@ PhidgetDevice_read(PhidgetDeviceHandle device) {
 		hidusbConn = PhidgetHIDUSBConnectionCast(device->conn);
 		assert(hidusbConn);
 		length = hidusbConn->inputReportByteLength;
+		hidusbConn->readTime = 0;
 		res = PhidgetUSBReadPacket((PhidgetUSBConnectionHandle)hidusbConn, buffer, &length);
 		if (res != EPHIDGET_OK)
 			return (res);
@@ -422,13 +483,16 @@ PhidgetDevice_read(PhidgetDeviceHandle device) {
 		if (!ISOPEN(device))
 			return (EPHIDGET_CLOSED);
 
+		setDeviceInputTime(device, hidusbConn->readTime);
 		res = PhidgetDevice_usbDataInput(device, buffer, length);
+		device->inputTime = 0;
 		return (res);
 
 	case PHIDCONN_PHIDUSB:
 		phidusbConn = PhidgetPHIDUSBConnectionCast(device->conn);
 		assert(phidusbConn);
 		length = phidusbConn->pusbParams.maxPacketEP1;
+		phidusbConn->readTime = 0;
 		res = PhidgetUSBReadPacket((PhidgetUSBConnectionHandle)phidusbConn, buffer, &length);
 		if (res != EPHIDGET_OK)
 			return (res);
@@ -436,7 +500,9 @@ PhidgetDevice_read(PhidgetDeviceHandle device) {
 		if (!ISOPEN(device))
 			return (EPHIDGET_CLOSED);
 
+		setDeviceInputTime(device, phidusbConn->readTime);
 		res = PhidgetDevice_usbDataInput(device, buffer, length);
+		device->inputTime = 0;
 		return (res);
 
 	case PHIDCONN_SPI:
@@ -450,12 +516,14 @@ PhidgetDevice_read(PhidgetDeviceHandle device) {
 		if (!ISOPEN(device))
 			return (EPHIDGET_CLOSED);
 
+		setDeviceInputTime(device, 0);
 		if (buffer[0] & PHID_GENERAL_PACKET_FLAG && deviceSupportsGeneralPacketProtocolDataInput(device)) {
 			res = PhidgetGPP_dataInput(device, buffer, length);
 		} else {
 			res = device->dataInput(device, buffer, length);
 			incReadCount(device);
 		}
+		device->inputTime = 0;
 		return (res);
 
 	default:
@@ -842,9 +910,10 @@ attachNetworkChannel(PhidgetDeviceHandle device, int uniqueIndex, PhidgetChannel
 	channel->uniqueIndex = uniqueIndex;
 
 	MOS_ASSERT(PhidgetCKFlags(channel, PHIDGET_DETACHING_FLAG) == 0);
-	startDispatch((PhidgetHandle)channel);
+	/* Set before the attach is queued: attaching channels are not left for the manual event drain */
 	PhidgetCLRFlags(channel, PHIDGET_HASINITIALSTATE_FLAG | PHIDGET_INITIALIZED_FLAG);
 	PhidgetSetFlags(channel, PHIDGET_ATTACHING_FLAG);
+	startDispatch((PhidgetHandle)channel);
 
 	setParent(channel, device);
 	setChannel(device, uniqueIndex, channel);
@@ -1077,9 +1146,9 @@ attachLocalChannel(PhidgetDeviceHandle device, int uniqueIndex, PhidgetChannelHa
 	}
 
 	MOS_ASSERT(PhidgetCKFlags(channel, PHIDGET_DETACHING_FLAG) == 0);
-	startDispatch((PhidgetHandle)channel);
 	PhidgetCLRFlags(channel, PHIDGET_HASINITIALSTATE_FLAG | PHIDGET_INITIALIZED_FLAG);
 	PhidgetSetFlags(channel, PHIDGET_ATTACHING_FLAG);
+	startDispatch((PhidgetHandle)channel);
 
 	setParent(channel, device);
 	setChannel(device, uniqueIndex, channel);
@@ -1498,25 +1567,17 @@ sendpacketWithTracking(mosiop_t iop, PhidgetDeviceHandle device, const unsigned
 	PhidgetPacketTrackerHandle tracker, tmp;
 	PhidgetReturnCode res;
 
-	mos_mutex_lock(&packetTracker->_lock);
-
 	// Ensure that this packet wasn't signalled in the meantime (probably because of an error)
-	if (packetTracker->_state & PACKETTRACKER_SIGNALLED) {
-		mos_mutex_unlock(&packetTracker->_lock);
+	if (getPacketReturnCode(packetTracker, &res) == EPHIDGET_OK)
 		return EPHIDGET_INTERRUPTED;
-	}
 
 	res = sendpacket(iop, device, buf, length, trans);
-
-	// Mark this packet as actually sent
-	if (res == EPHIDGET_OK)
-		packetTracker->_state |= PACKETTRACKER_SENT;
-
-	mos_mutex_unlock(&packetTracker->_lock);
-
 	if (res != EPHIDGET_OK)
 		return res;
 
+	// Mark this packet as actually sent - if it was signalled while sending, the waiter sees that result
+	setPacketSent(packetTracker);
+
 	if (trans) {
 		//Deal with any packet trackers that are done
 		// - allows packet trackers to be released before the endTransaction call so we don't run out
@@ -2033,6 +2094,7 @@ addDevice(PhidgetDeviceHandle device) {
 
 PhidgetReturnCode
 _addDevice(PhidgetDeviceHandle device) {
+	uint32_t h;
 
 	/* callers do not always check the return value */
 	MOS_ASSERT(device);
@@ -2045,6 +2107,12 @@ _addDevice(PhidgetDeviceHandle device) {
 	MTAILQ_INSERT_HEAD(&phidgetDevices, device, link);
 	logdebug("Added %"PRIphid" (0x%"PRIXPTR") to device list", device, (uintptr_t)device);
 
+	h = idIndexHash((uint64_t)(uintptr_t)device);
+	mos_rwlock_wrlock(&idIndexLock);
+	device->idnext = deviceIdIndex[h];
+	deviceIdIndex[h] = device;
+	mos_rwlock_unlock(&idIndexLock);
+
 	phidgetDevicesCount++;
 	PhidgetRetain(device);
 
@@ -2053,6 +2121,7 @@ _addDevice(PhidgetDeviceHandle device) {
 
 PhidgetReturnCode
 _removeDevice(PhidgetDeviceHandle device) {
+	PhidgetDeviceHandle *devp;
 
 	MOS_ASSERT(device != NULL);
 
@@ -2060,6 +2129,16 @@ _removeDevice(PhidgetDeviceHandle device) {
 
 	MTAILQ_REMOVE(&phidgetDevices, device, link);
 	logdebug("Removed %"PRIphid" (0x%"PRIXPTR") from device list", device, (uintptr_t)device);
+
+	mos_rwlock_wrlock(&idIndexLock);
+	for (devp = &deviceIdIndex[idIndexHash((uint64_t)(uintptr_t)device)]; *devp != NULL; devp = &(*devp)->idnext) {
+		if (*devp == device) {
+			*devp = device->idnext;
+			break;
+		}
+	}
+	device->idnext = NULL;
+	mos_rwlock_unlock(&idIndexLock);
 	phidgetDevicesCount--;
 
 	PhidgetRelease(&device);
@@ -2122,15 +2201,15 @@ PhidgetDeviceHandle
 getDeviceById(uint64_t id) {
 	PhidgetDeviceHandle dev;
 
-	PhidgetReadLockDevices();
-	FOREACH_DEVICE(dev) {
+	mos_rwlock_rdlock(&idIndexLock);
+	for (dev = deviceIdIndex[idIndexHash(id)]; dev != NULL; dev = dev->idnext) {
 		if (id == ((uint64_t)((uintptr_t)dev)))
 			break;
 	}
 
 	if (dev)
 		PhidgetRetain(dev);
-	PhidgetUnlockDevices();
+	mos_rwlock_unlock(&idIndexLock);
 	return (dev);
 }
 
@@ -2142,6 +2221,10 @@ addChannel(PhidgetChannelHandle channel) {
 	PhidgetWriteLockChannels();
 	MTAILQ_INSERT_TAIL(&phidgetChannels, channel, link);
 	phidgetChannelsCount++;
+	PhidgetRunLock(channel);
+	channel->idxlisted = 1;
+	indexChannel(channel);
+	PhidgetRunUnlock(channel);
 	PhidgetUnlockChannels();
 
 	PhidgetRetain(channel);
@@ -2156,6 +2239,10 @@ removeChannel(PhidgetChannelHandle channel) {
 	PhidgetWriteLockChannels();
 	MTAILQ_REMOVE(&phidgetChannels, channel, link);
 	phidgetChannelsCount--;
+	PhidgetRunLock(channel);
+	channel->idxlisted = 0;
+	indexChannel(channel);
+	PhidgetRunUnlock(channel);
 	PhidgetUnlockChannels();
 
 	PhidgetRelease(&channel);
@@ -2182,33 +2269,70 @@ mkChannelId(int chindex, int chclass, int serialNumber, int vint, int port, int
 	return (mos_htole64(chid.c_id));
 }
 
+static uint64_t
+mkParentChannelId(PhidgetChannelHandle channel) {
+
+	if (isVintChannel(channel))
+		return (mkChannelId(channel->uniqueIndex, channel->class, channel->parent->deviceInfo.serialNumber, 1,
+			channel->parent->deviceInfo.hubPort, channel->parent->deviceInfo.isHubPort));
+	return (mkChannelId(channel->uniqueIndex, channel->class, channel->parent->deviceInfo.serialNumber, 0, 0, 0));
+}
+
 uint64_t
 getChannelId(PhidgetChannelHandle channel) {
 
 	if (!_ISATTACHED(channel) && !_ISATTACHING(channel))
 		return (0);
 
-	if (isVintChannel(channel))
-		return (mkChannelId(channel->uniqueIndex, channel->class, channel->parent->deviceInfo.serialNumber, 1,
-			channel->parent->deviceInfo.hubPort, channel->parent->deviceInfo.isHubPort));
-	return (mkChannelId(channel->uniqueIndex, channel->class, channel->parent->deviceInfo.serialNumber, 0, 0, 0));
+	return (mkParentChannelId(channel));
+}
+
+/*
+ * (Re)indexes the channel after its parent, or its membership in the channel list, changes.
+ * The channel run lock must be held.
+ */
+static void
+indexChannel(PhidgetChannelHandle channel) {
+	PhidgetChannelHandle *chp;
+	uint32_t h;
+
+	mos_rwlock_wrlock(&idIndexLock);
+
+	if (channel->idxid != 0) {
+		for (chp = &channelIdIndex[idIndexHash(channel->idxid)]; *chp != NULL; chp = &(*chp)->idnext) {
+			if (*chp == channel) {
+				*chp = channel->idnext;
+				break;
+			}
+		}
+		channel->idnext = NULL;
+		channel->idxid = 0;
+	}
+
+	if (channel->idxlisted && channel->parent != NULL) {
+		channel->idxid = mkParentChannelId(channel);
+		h = idIndexHash(channel->idxid);
+		channel->idnext = channelIdIndex[h];
+		channelIdIndex[h] = channel;
+	}
+
+	mos_rwlock_unlock(&idIndexLock);
 }
 
 PhidgetChannelHandle
 getChannelById(uint64_t id) {
 	PhidgetChannelHandle ch;
 
-	PhidgetReadLockChannels();
-	FOREACH_CHANNEL(ch) {
-		if (getChannelId(ch) == id) {
-			PhidgetUnlockChannels();
+	mos_rwlock_rdlock(&idIndexLock);
+	for (ch = channelIdIndex[idIndexHash(id)]; ch != NULL; ch = ch->idnext) {
+		if (ch->idxid == id && _ISATTACHEDORATTACHING(ch)) {
 			PhidgetRetain(ch);
-			return (ch);
+			break;
 		}
 	}
-	PhidgetUnlockChannels();
+	mos_rwlock_unlock(&idIndexLock);
 
-	return (NULL);
+	return (ch);
 }
 
 const char * CCONV
@@ -2322,10 +2446,211 @@ channelInfo(PhidgetChannelHandle _channel, char *ubuf, uint32_t buflen) {
 	return (buf);
 }
 
+/*
+ * Index of Phidget_Unique_Device_Def, built at startup so matching a device found during
+ * enumeration does not scan the whole table.
+ *
+ * Definitions are bucketed by a hash of their match key: the vendor, product and interface for
+ * USB, SPI, Lightning and virtual devices, the VINT id for VINT devices, and the product id for
+ * mesh devices.  Within a bucket, definitions with the same key are kept together and sorted by
+ * versionLow, so a match is a hash probe and a binary search over the version ranges.
+ */
+#define UDD_BUCKETS	256
+static uint16_t *uddIndex;
+static uint16_t uddBucket[UDD_BUCKETS + 1];
+static uint16_t uddUnknownUSB;
+static uint16_t uddUnknownSPI;
+
+typedef struct {
+	PhidgetUniqueDeviceType type;
+	int vendorID;
+	int productID;
+	int interfaceNum;
+} uddkey_t;
+
+static void
+mkUDDKey(uddkey_t *key, PhidgetUniqueDeviceType type, int vendorID, int productID, int interfaceNum,
+  int vintID) {
+
+	memset(key, 0, sizeof (*key));
+	key->type = type;
+
+	switch (type) {
+	case PHIDTYPE_VINT:
+		key->productID = vintID;
+		break;
+	case PHIDTYPE_MESH:
+		key->productID = productID;
+		break;
+	default:
+		key->vendorID = vendorID;
+		key->productID = productID;
+		key->interfaceNum = interfaceNum;
+		break;
+	}
+}
+
+static void
+mkUDDKeyFromDef(uddkey_t *key, const PhidgetUniqueDeviceDef *pdd) {
+
+	mkUDDKey(key, pdd->type, pdd->vendorID, pdd->productID, pdd->interfaceNum, pdd->vintID);
+}
+
+static int
+cmpUDDKey(const uddkey_t *a, const uddkey_t *b) {
+
+	if (a->type != b->type)
+		return ((int)a->type - (int)b->type);
+	if (a->vendorID != b->vendorID)
+		return (a->vendorID - b->vendorID);
+	if (a->productID != b->productID)
+		return (a->productID - b->productID);
+	return (a->interfaceNum - b->interfaceNum);
+}
+
+static uint32_t
+uddKeyHash(const uddkey_t *key) {
+	uint32_t h;
+
+	h = (uint32_t)key->type;
+	h = h * 0x9E3779B1U + (uint32_t)key->vendorID;
+	h = h * 0x9E3779B1U + (uint32_t)key->productID;
+	h = h * 0x9E3779B1U + (uint32_t)key->interfaceNum;
+	h ^= h >> 15;
+	h *= 0x2C1B3C6DU;
+	h ^= h >> 12;
+	return (h % UDD_BUCKETS);
+}
+
+/*
+ * Orders two definitions by key, then versionLow, then position in the table.
+ */
+static int
+cmpUDDEntry(int a, int b) {
+	const PhidgetUniqueDeviceDef *pa, *pb;
+	uddkey_t ka, kb;
+	int res;
+
+	pa = &Phidget_Unique_Device_Def[a];
+	pb = &Phidget_Unique_Device_Def[b];
+
+	mkUDDKeyFromDef(&ka, pa);
+	mkUDDKeyFromDef(&kb, pb);
+	res = cmpUDDKey(&ka, &kb);
+	if (res != 0)
+		return (res);
+	if (pa->versionLow != pb->versionLow)
+		return (pa->versionLow - pb->versionLow);
+	return (a - b);
+}
+
+static void
+buildUDDIndex(void) {
+	const PhidgetUniqueDeviceDef *pdd;
+	uint16_t fill[UDD_BUCKETS];
+	uddkey_t key;
+	int i, j, k, cnt;
+	uint16_t t;
+
+	for (cnt = 0; (int)Phidget_Unique_Device_Def[cnt].type != END_OF_LIST; cnt++)
+		;
+
+	uddIndex = mos_malloc(sizeof (uint16_t) * (cnt > 0 ? cnt : 1));
+	memset(uddBucket, 0, sizeof (uddBucket));
+
+	for (i = 0, pdd = Phidget_Unique_Device_Def; i < cnt; i++, pdd++) {
+		mkUDDKeyFromDef(&key, pdd);
+		uddBucket[uddKeyHash(&key) + 1]++;
+
+		if (pdd->uid == PHIDUID_UNKNOWNUSB)
+			uddUnknownUSB = (uint16_t)(i + 1);
+		else if (pdd->uid == PHIDUID_UNKNOWNSPI)
+			uddUnknownSPI = (uint16_t)(i + 1);
+	}
+
+	for (i = 0; i < UDD_BUCKETS; i++)
+		uddBucket[i + 1] += uddBucket[i];
+	memcpy(fill, uddBucket, sizeof (fill));
+
+	for (i = 0, pdd = Phidget_Unique_Device_Def; i < cnt; i++, pdd++) {
+		mkUDDKeyFromDef(&key, pdd);
+		uddIndex[fill[uddKeyHash(&key)]++] = (uint16_t)i;
+	}
+
+	/* Buckets only hold a handful of definitions: insertion sort them */
+	for (i = 0; i < UDD_BUCKETS; i++) {
+		for (j = uddBucket[i] + 1; j < uddBucket[i + 1]; j++) {
+			t = uddIndex[j];
+			for (k = j; k > uddBucket[i] && cmpUDDEntry(uddIndex[k - 1], t) > 0; k--)
+				uddIndex[k] = uddIndex[k - 1];
+			uddIndex[k] = t;
+		}
+	}
+}
+
+static void
+freeUDDIndex(void) {
+
+	if (uddIndex == NULL)
+		return;
+
+	mos_free(uddIndex, sizeof (uint16_t) * (uddBucket[UDD_BUCKETS] > 0 ? uddBucket[UDD_BUCKETS] : 1));
+	uddIndex = NULL;
+}
+
+static int
+findUniqueDevice(const uddkey_t *key, int version) {
+	const PhidgetUniqueDeviceDef *pdd;
+	int start, end, lo, hi, mid;
+	uddkey_t k;
+	uint32_t b;
+
+	b = uddKeyHash(key);
+
+	/* Find the run of definitions with this key */
+	for (start = uddBucket[b], end = uddBucket[b + 1]; start < end; start++) {
+		mkUDDKeyFromDef(&k, &Phidget_Unique_Device_Def[uddIndex[start]]);
+		if (cmpUDDKey(&k, key) == 0)
+			break;
+	}
+	if (start == end)
+		return (-1);
+
+	for (lo = start + 1; lo < end; lo++) {
+		mkUDDKeyFromDef(&k, &Phidget_Unique_Device_Def[uddIndex[lo]]);
+		if (cmpUDDKey(&k, key) != 0)
+			break;
+	}
+	end = lo;
+
+	/* Binary search for the first definition whose versionLow is above version */
+	lo = start;
+	hi = end;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (Phidget_Unique_Device_Def[uddIndex[mid]].versionLow <= version)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/*
+	 * Every definition below lo starts at or before version.  Version ranges for a key do not
+	 * normally overlap, but if they do the first definition in the table wins, as it always has.
+	 */
+	for (mid = -1; lo > start; lo--) {
+		pdd = &Phidget_Unique_Device_Def[uddIndex[lo - 1]];
+		if (version < pdd->versionHigh && (mid == -1 || uddIndex[lo - 1] < mid))
+			mid = uddIndex[lo - 1];
+	}
+
+	return (mid);
+}
+
 PhidgetReturnCode
 matchUniqueDevice(PhidgetUniqueDeviceType type, int vendorID, int productID, int interfaceNum, int version,
   int *id) {
-	const PhidgetUniqueDeviceDef *pdd;
+	uddkey_t key;
 	int i;
 
 	if (type == PHIDTYPE_USB) {
@@ -2334,16 +2659,9 @@ matchUniqueDevice(PhidgetUniqueDeviceType type, int vendorID, int productID, int
 			return (EPHIDGET_UNSUPPORTED);
 	}
 
-	for (pdd = Phidget_Unique_Device_Def, i = 0; ((int)pdd->type) != END_OF_LIST; pdd++, i++) {
-		if (pdd->type != type)
-			continue;
-
-		if (pdd->vendorID != vendorID || pdd->productID != productID || pdd->interfaceNum != interfaceNum)
-			continue;
-
-		if (pdd->versionLow > version || pdd->versionHigh <= version)
-			continue;
-
+	mkUDDKey(&key, type, vendorID, productID, interfaceNum, 0);
+	i = findUniqueDevice(&key, version);
+	if (i != -1) {
 		*id = i;
 		return (EPHIDGET_OK);
 	}
@@ -2355,11 +2673,8 @@ matchUniqueDevice(PhidgetUniqueDeviceType type, int vendorID, int productID, int
 			"supported by the library. A library upgrade is required to work with this Phidget",
 			productID, version);
 
-		for (pdd = Phidget_Unique_Device_Def, i = 0; ((int)pdd->type) != END_OF_LIST; pdd++, i++) {
-			if (pdd->uid != PHIDUID_UNKNOWNUSB)
-				continue;
-			*id = i;
-
+		if (uddUnknownUSB != 0) {
+			*id = uddUnknownUSB - 1;
 			return (EPHIDGET_OK);
 		}
 	} else if (type == PHIDTYPE_SPI) {
@@ -2368,11 +2683,8 @@ matchUniqueDevice(PhidgetUniqueDeviceType type, int vendorID, int productID, int
 			"supported by the library. A library upgrade is required to work with this Phidget",
 			productID, version);
 
-		for (pdd = Phidget_Unique_Device_Def, i = 0; ((int)pdd->type) != END_OF_LIST; pdd++, i++) {
-			if (pdd->uid != PHIDUID_UNKNOWNSPI)
-				continue;
-			*id = i;
-
+		if (uddUnknownSPI != 0) {
+			*id = uddUnknownSPI - 1;
 			return (EPHIDGET_OK);
 		}
 	}
@@ -2380,6 +2692,24 @@ matchUniqueDevice(PhidgetUniqueDeviceType type, int vendorID, int productID, int
 	return (EPHIDGET_NOENT);
 }
 
+/*
+ * Unlike matchUniqueDevice(), does not fall back to the unknown device: the callers log the miss
+ * with the hub port and retry with VINTID_0xff0 themselves.
+ */
+PhidgetReturnCode
+matchUniqueVINTDevice(int vintID, int version, int *id) {
+	uddkey_t key;
+	int i;
+
+	mkUDDKey(&key, PHIDTYPE_VINT, 0, 0, 0, vintID);
+	i = findUniqueDevice(&key, version);
+	if (i == -1)
+		return (EPHIDGET_NOENT);
+
+	*id = i;
+	return (EPHIDGET_OK);
+}
+
 PhidgetReturnCode
 createPhidgetDevice(PhidgetConnectionType connType, const PhidgetUniqueDeviceDef *pdd, int version,
   const char *label, int serialNumber, PhidgetDeviceHandle *device) {
@@ -2805,6 +3135,8 @@ PhidgetChannel_bridgeInput(PhidgetChannelHandle channel, BridgePacket *bp) {
 
 	assert(channel->bridgeInput);
 
+	channel->eventTimestamp = bp->timestamp;
+
 	switch (bp->vpkt) {
 	case BP_ERROREVENT:
 		channel->errorHandler(channel, getBridgePacketInt32(bp, 0));
@@ -3703,6 +4035,54 @@ Phidget_setIsLocal(PhidgetHandle phid, int local) {
 	return (EPHIDGET_OK);
 }
 
+API_PRETURN
+Phidget_getEventCoalescing(PhidgetHandle phid, int *eventCoalescing) {
+	PhidgetChannelHandle channel;
+
+	TESTPTR_PR(eventCoalescing);
+	CHANNELNOTDEVICE_PR(channel, phid);
+
+	*eventCoalescing = PhidgetCKFlags(channel, PHIDGET_COALESCE_FLAG) ? PTRUE : PFALSE;
+	return (EPHIDGET_OK);
+}
+
+/*
+ * The host monotonic time, in microseconds, that the input behind the event currently being delivered
+ * was read from the device (CLOCK_MONOTONIC on Linux).  Only meaningful from within an event handler.
+ * For a network channel this is the clock of the server the device is attached to.
+ */
+API_PRETURN
+Phidget_getEventTimestamp(PhidgetHandle phid, uint64_t *timestamp) {
+	PhidgetChannelHandle channel;
+
+	TESTPTR_PR(timestamp);
+	CHANNELNOTDEVICE_PR(channel, phid);
+
+	if (channel->eventTimestamp == 0)
+		return (PHID_RETURN(EPHIDGET_UNKNOWNVAL));
+
+	*timestamp = channel->eventTimestamp;
+	return (EPHIDGET_OK);
+}
+
+/*
+ * When enabled, a value change event (voltage, temperature, spatial data, ...) that has not been
+ * delivered yet is replaced by a newer one of the same type, rather than queuing every value behind a
+ * slow event handler.  Edge events such as digital input state changes and errors are never dropped.
+ */
+API_PRETURN
+Phidget_setEventCoalescing(PhidgetHandle phid, int eventCoalescing) {
+	PhidgetChannelHandle channel;
+
+	CHANNELNOTDEVICE_PR(channel, phid);
+
+	if (eventCoalescing)
+		PhidgetSetFlags(channel, PHIDGET_COALESCE_FLAG);
+	else
+		PhidgetCLRFlags(channel, PHIDGET_COALESCE_FLAG);
+	return (EPHIDGET_OK);
+}
+
 API_PRETURN
 Phidget_writeDeviceLabel(PhidgetHandle phid, const char *buffer) {
 	PhidgetChannelHandle channel;
@@ -47,6 +47,12 @@ API_PRETURN_HDR Phidget_getErrorDescription		(PhidgetReturnCode errorCode, const
 API_PRETURN_HDR Phidget_getLastError			(PhidgetReturnCode *errorCode, const char **errorString, char *errorDetail, size_t *errorDetailLen);
 API_PRETURN_HDR Phidget_finalize				(int flags);
 API_PRETURN_HDR Phidget_resetLibrary			(void);
+API_PRETURN_HDR Phidget_setDispatcherCount		(uint32_t count);
+API_PRETURN_HDR Phidget_getDispatcherCount		(uint32_t *count);
+API_PRETURN_HDR Phidget_setDispatcherAffinity	(uint64_t cpuMask);
+API_PRETURN_HDR Phidget_setManualEventDrain		(int manual);
+API_PRETURN_HDR Phidget_getEventFd				(int *fd);
+API_PRETURN_HDR Phidget_drainEvents				(uint32_t max, uint32_t *count);
 
 /* Methods */
 API_PRETURN_HDR Phidget_open					(PhidgetHandle phid);
@@ -66,6 +72,9 @@ API_PRETURN_HDR Phidget_getDataRate				(PhidgetHandle phid, double *dr);
 API_PRETURN_HDR Phidget_getMinDataRate			(PhidgetHandle phid, double *min);
 API_PRETURN_HDR Phidget_getMaxDataRate			(PhidgetHandle phid, double *max);
 API_PRETURN_HDR Phidget_setDataRate				(PhidgetHandle phid, double dr);
+API_PRETURN_HDR Phidget_getEventCoalescing		(PhidgetHandle phid, int *eventCoalescing);
+API_PRETURN_HDR Phidget_setEventCoalescing		(PhidgetHandle phid, int eventCoalescing);
+API_PRETURN_HDR Phidget_getEventTimestamp		(PhidgetHandle phid, uint64_t *timestamp);
 
 /* General Properties */
 API_PRETURN_HDR Phidget_getAttached				(PhidgetHandle phid, int *attached);
@@ -297,6 +306,9 @@ struct _PhidgetChannel {
 
 	MTAILQ_ENTRY(_PhidgetChannel) link;		/* open channel  linkage */
 	MTAILQ_ENTRY(_PhidgetChannel) match;	/* attach matching list linkage */
+	struct _PhidgetChannel *idnext;			/* channel id index linkage */
+	uint64_t idxid;							/* id the channel is indexed under (0 if not indexed) */
+	int idxlisted;							/* in the channel list: indexed while it has a parent */
 
 	phidgetchannelnetconnlist_t netconns;	/* list of network connections to channel */
 	mos_mutex_t					netconnslk;	/* lock for network connections */
@@ -327,6 +339,9 @@ struct _PhidgetChannel {
 	void *PropertyChangeCtx;
 	PhidgetReturnCode(*_closing)(PhidgetChannelHandle);
 
+	/* Input time of the event being delivered, 0 if unknown */
+	mostime_t eventTimestamp;
+
 	/* Error event tracking */
 	Phidget_ErrorEventCode lastErrorEventCode;
 	char *lastErrorEventDesc;
@@ -340,6 +355,7 @@ struct _PhidgetDevice {
 	mos_tlock_t *__memberlock;
 
 	MTAILQ_ENTRY(_PhidgetDevice) link;		/* phidgetDevices linkage */
+	struct _PhidgetDevice *idnext;			/* device id index linkage */
 	PhidgetConnectionType connType;
 	PhidgetHandle conn;
 
@@ -354,6 +370,13 @@ struct _PhidgetDevice {
 
 	PhidgetPacketTrackersHandle packetTracking;
 
+	/*
+	 * When the packet being handled by dataInput() was read, for stamping the bridge packets it
+	 * produces.  Only set on the device that owns the read thread, and only while dataInput() runs.
+	 */
+	mostime_t inputTime;
+	mos_task_t inputTask;
+
 	uint8_t GPPResponse;
 
 	PhidgetReturnCode (CCONV *bridgeInput)(PhidgetChannelHandle, BridgePacket *);
@@ -433,6 +456,11 @@ const PhidgetChannelAttributeDef *getPhidgetChannelAttributes(PhidgetChannelHand
 PhidgetReturnCode PhidgetDevice_usbDataInput(PhidgetDeviceHandle device, uint8_t *buffer, size_t length);
 
 PhidgetReturnCode PhidgetDevice_read(PhidgetDeviceHandle device);
+mostime_t PhidgetDevice_getInputTime(PhidgetDeviceHandle device);
+void PhidgetDigitalInputInit(void);
+void PhidgetDigitalInputFini(void);
+int PhidgetDigitalInput_debounce(PhidgetChannelHandle, BridgePacket *);
+int PhidgetDigitalInput_inputSnapshotEnabled(PhidgetChannelHandle);
 
 BOOL isVintChannel(void *);
 BOOL isNetworkPhidget(void *);
@@ -511,6 +539,7 @@ extern mos_tlock_t *attachDetachQueueLock;
 typedef MTAILQ_HEAD(phidgets, _Phidget)				phidgets_t;
 
 PhidgetReturnCode matchUniqueDevice(PhidgetUniqueDeviceType, int, int, int, int, int *);
+PhidgetReturnCode matchUniqueVINTDevice(int, int, int *);
 
 PhidgetReturnCode createPhidgetDevice(PhidgetConnectionType connType, const PhidgetUniqueDeviceDef *pdd,
   int version, const char *label, int serialNumber, PhidgetDeviceHandle *device);
@@ -193,10 +193,12 @@ Phidget22Initialize() {
 	PhidgetStatsInit();
 	PhidgetLogInit();
 	PhidgetObjectInit();
+	PhidgetBridgeInit();
 	_Phidget22Initialize();
 	PhidgetManagerInit();
 	PhidgetInit();
 	PhidgetDispatchInit();
+	PhidgetDigitalInputInit();
 	PhidgetUSBInit();
 	PhidgetNetInit();
 }
@@ -209,11 +211,13 @@ Phidget22Finalize() {
 
 	joinCentralThread();
 
+	PhidgetDigitalInputFini();
 	PhidgetDispatchFini();
 	PhidgetNetFini();
 	PhidgetUSBFini();
 	PhidgetManagerFini();
 	PhidgetFini();
+	PhidgetBridgeFini();
 	PhidgetObjectFini();
 	PhidgetLogFini();
 	PhidgetStatsFini();
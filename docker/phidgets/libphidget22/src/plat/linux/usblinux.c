@@ -36,7 +36,9 @@
 #include "manager.h"
 #include "util/utils.h"
 #include "util/phidgetlog.h"
+#include "mos/mos_atomic.h"
 #include "mos/mos_byteorder.h"
+#include "stats.h"
 
 #include <sys/stat.h>
 #include <sys/ioctl.h>
@@ -56,7 +58,32 @@ static libusb_context *libusb_ctx;
 #endif
 
 #if USB_ASYNC_READS
+static PhidgetReturnCode StartHandleEventsThread(void);
+static void StopHandleEventsThread(void);
 static void joinHandleEventsThread(void);
+
+// XXX - may wish to tune this according to the interrupt rate of each device
+#define XFER_CNT	32
+
+/*
+ * Completed transfers waiting for the read thread. Each submitted transfer owns one slot, the
+ * reader holds one, and the rest back the queue; when none are free, new packets are dropped.
+ */
+#define MAX_XFER_QUEUE_SIZE	200
+#define XFER_SLOT_CNT		(XFER_CNT + 1 + MAX_XFER_QUEUE_SIZE)
+
+/* Hotplug callbacks are delivered by the handle events thread, and need libusb >= 1.0.16 */
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000102)
+#define USB_HOTPLUG 1
+#endif
+#endif
+
+#ifndef USB_HOTPLUG
+#define USB_HOTPLUG 0
+#endif
+
+#if USB_HOTPLUG
+static void teardownHotplug(void);
 #endif
 
 static void
@@ -483,6 +510,7 @@ PhidgetUSBReadPacket(PhidgetUSBConnectionHandle conn, unsigned char *buffer, siz
 #if USB_ASYNC_READS
 	PhidgetUSBTransferHandle usbXfer;
 	mostime_t tm;
+	int slot;
 #endif
 
 	assert(conn);
@@ -495,7 +523,24 @@ PhidgetUSBReadPacket(PhidgetUSBConnectionHandle conn, unsigned char *buffer, siz
 	tm = mos_gettime_usec() + (USB_READ_TIMEOUT * 1000);
 	mos_mutex_lock(&conn->xferQueueLock);
 
-	while (MSMTAILQ_EMPTY(&conn->xferQueue)) {
+	// Async reads were stopped and the slots may already be gone
+	if (!conn->usingAsyncReads) {
+		mos_mutex_unlock(&conn->xferQueueLock);
+		PhidgetRunUnlock(conn);
+		usblogdebug("Returning early because usingAsyncReads is false");
+		return (EPHIDGET_INTERRUPTED);
+	}
+
+	/*
+	 * The slot handed out by the previous read is only recycled now, so each packet costs a single
+	 * trip through the queue lock.
+	 */
+	if (conn->xferReading >= 0) {
+		conn->xferFree[conn->xferFreeCnt++] = (uint16_t)conn->xferReading;
+		conn->xferReading = -1;
+	}
+
+	while (conn->queueCnt == 0) {
 
 		// Wait for up to USB_READ_TIMEOUT ms for incoming data
 		mos_cond_timedwait(&conn->xferQueueCond, &conn->xferQueueLock, USB_READ_TIMEOUT * MOS_MSEC);
@@ -515,19 +560,22 @@ PhidgetUSBReadPacket(PhidgetUSBConnectionHandle conn, unsigned char *buffer, siz
 		}
 	}
 
-	usbXfer = MSMTAILQ_FIRST(&conn->xferQueue);
-	MSMTAILQ_REMOVE_HEAD(&conn->xferQueue, link);
+	slot = conn->xferQueue[conn->queueHead];
+	conn->queueHead = (conn->queueHead + 1) % XFER_SLOT_CNT;
 	conn->queueCnt--;
+	conn->xferReading = slot;
 
 	mos_mutex_unlock(&conn->xferQueueLock);
 
+	// The slot is ours until the next read: libusb wrote the packet straight into it
+	usbXfer = &conn->xferSlots[slot];
 	if (usbXfer->result == LIBUSB_SUCCESS) {
 		memcpy(buffer, usbXfer->buffer, usbXfer->actual_length);
 		BytesRead = usbXfer->actual_length;
 	}
+	conn->readTime = usbXfer->timestamp;
 
 	ret = usbXfer->result;
-	mos_free(usbXfer, sizeof(PhidgetUSBTransfer));
 
 	// This means the transfer was asynchronously cancelled
 	if (ret == LIBUSB_ERROR_INTERRUPTED) {
@@ -543,6 +591,7 @@ PhidgetUSBReadPacket(PhidgetUSBConnectionHandle conn, unsigned char *buffer, siz
 	  *length,
 	  &BytesRead,
 	  USB_READ_TIMEOUT);
+	conn->readTime = mos_gettime_usec();
 #endif
 
 	PhidgetRunUnlock(conn);
@@ -693,6 +742,9 @@ PhidgetUSBUninit() {
 
 	if (libusb_ctx) {
 		usbloginfo("Deinitializing libusb");
+#if USB_HOTPLUG
+		teardownHotplug();
+#endif
 #if USB_ASYNC_READS
 		joinHandleEventsThread();
 #endif
@@ -869,6 +921,112 @@ readphidgetDeviceParams(libusb_device *device, PhidgetConnectionType *type, Phid
 	return (EPHIDGET_OK);
 }
 
+#if USB_HOTPLUG
+/*
+ * With hotplug support, libusb tells us when devices come and go, and the bus is only walked after
+ * an event. Scanning continues for HOTPLUG_SETTLE after the last event: the arrive event can beat
+ * udev to setting up permissions, and a failed open is only retried by another scan.
+ */
+#define HOTPLUG_SETTLE	(2 * 1000000)	/* usec */
+
+static libusb_hotplug_callback_handle hotplugHandle;
+static int hotplugActive;
+static int hotplugTried;
+static uint32_t hotplugEvents;
+static mostime_t hotplugSettle;
+
+static int LIBUSB_CALL
+hotplugCallback(libusb_context *ctx, libusb_device *device, libusb_hotplug_event event, void *user_data) {
+
+	usblogdebug("hotplug %s: %d/%d", event == LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED ? "arrive" : "leave",
+	  libusb_get_bus_number(device), libusb_get_device_address(device));
+
+	// Hand the event to the central thread, which does the actual attach/detach
+	mos_atomic_add_32(&hotplugEvents, 1);
+	NotifyCentralThread();
+
+	return (0);
+}
+
+static void
+setupHotplug(void) {
+	int ret;
+
+	hotplugTried = 1;
+
+	if (!libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)) {
+		usbloginfo("libusb has no hotplug support - polling for USB devices");
+		return;
+	}
+
+	// Events are delivered from libusb_handle_events(), so keep the thread running
+	if (StartHandleEventsThread() != EPHIDGET_OK) {
+		usblogwarn("Failed to start the USB handle events thread - polling for USB devices");
+		return;
+	}
+
+	// Vendor filtering happens in the scan: Phidgets use more than one VID
+	ret = libusb_hotplug_register_callback(libusb_ctx,
+	  LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT, LIBUSB_HOTPLUG_NO_FLAGS,
+	  LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY,
+	  hotplugCallback, NULL, &hotplugHandle);
+	if (ret != LIBUSB_SUCCESS) {
+		usblogwarn("libusb_hotplug_register_callback() failed: "LIBUSB_ERR_FMT" - polling for USB devices",
+		  LIBUSB_ERR_ARGS(ret));
+		StopHandleEventsThread();
+		return;
+	}
+
+	usbloginfo("Using libusb hotplug events for USB device discovery");
+	hotplugActive = 1;
+}
+
+static void
+teardownHotplug(void) {
+
+	if (hotplugActive) {
+		libusb_hotplug_deregister_callback(libusb_ctx, hotplugHandle);
+		StopHandleEventsThread();
+		hotplugActive = 0;
+	}
+	hotplugTried = 0;
+	hotplugEvents = 0;
+	hotplugSettle = 0;
+}
+
+/*
+ * Returns 0 when nothing has changed on the bus since the last scan. In that case the devices we
+ * already know about are flagged as scanned so PhidgetManager_poll() keeps them attached.
+ */
+static int
+hotplugScanNeeded(void) {
+	PhidgetDeviceHandle phid;
+	mostime_t now;
+
+	if (!hotplugTried)
+		setupHotplug();
+
+	if (!hotplugActive)
+		return (1);
+
+	now = mos_gettime_usec();
+	if (mos_atomic_swap_32(&hotplugEvents, 0) != 0)
+		hotplugSettle = now + HOTPLUG_SETTLE;
+
+	if (now < hotplugSettle)
+		return (1);
+
+	PhidgetReadLockDevices();
+	FOREACH_DEVICE(phid) {
+		if (phid->connType == PHIDCONN_PHIDUSB || phid->connType == PHIDCONN_HIDUSB)
+			PhidgetSetFlags(phid, PHIDGET_SCANNED_FLAG);
+	}
+	PhidgetUnlockDevices();
+
+	return (0);
+}
+#endif /* USB_HOTPLUG */
+
 PhidgetReturnCode
 PhidgetUSBScanDevices(void) {
 	struct libusb_device_descriptor	desc;
@@ -914,8 +1072,16 @@ PhidgetUSBScanDevices(void) {
 			return (EPHIDGET_UNEXPECTED);
 		}
 		initFailures = 0;
+#if USB_HOTPLUG
+		// Scan the whole bus once for the devices that are already plugged in
+		hotplugSettle = mos_gettime_usec() + HOTPLUG_SETTLE;
+#endif
 	}
 
+#if USB_HOTPLUG
+	if (!hotplugScanNeeded())
+		return (EPHIDGET_OK);
+#endif
 
 	ret = libusb_get_device_list(libusb_ctx, &list);
 	if (ret < 0) {
@@ -1275,9 +1441,6 @@ PhidgetUSBOpenHandle(PhidgetDeviceHandle device) {
 
 #define INCREASE_USB_EVENT_THREAD_PRIORITY
 
-// XXX - may wish to tune this according to the interrupt rate of each device
-#define XFER_CNT	32
-
 /* libusb < 1.0.9 doesn't have libusb_handle_events_timeout_completed */
 // XXX - for now I'm using LIBUSB_API_VERSION which was introduced in libusb 1.0.13
 //  There doesn't seem to be a good compile-time way of checking version before 1.0.13
@@ -1434,10 +1597,34 @@ HandleEventsThreadFunction(void *_param) {
 }
 
 
-#define MAX_XFER_QUEUE_SIZE	200
+static int
+xferResult(enum libusb_transfer_status status) {
+
+	switch (status) {
+	case LIBUSB_TRANSFER_COMPLETED:
+		return (LIBUSB_SUCCESS);
+	case LIBUSB_TRANSFER_TIMED_OUT:
+		return (LIBUSB_ERROR_TIMEOUT);
+	case LIBUSB_TRANSFER_STALL:
+		return (LIBUSB_ERROR_PIPE);
+	case LIBUSB_TRANSFER_NO_DEVICE:
+		return (LIBUSB_ERROR_NO_DEVICE);
+	case LIBUSB_TRANSFER_OVERFLOW:
+		return (LIBUSB_ERROR_OVERFLOW);
+	case LIBUSB_TRANSFER_ERROR:
+		return (LIBUSB_ERROR_IO);
+	case LIBUSB_TRANSFER_CANCELLED:
+		return (LIBUSB_ERROR_INTERRUPTED);
+	default:
+		return (LIBUSB_ERROR_OTHER);
+	}
+}
+
 static void read_cb(struct libusb_transfer *xfer) {
 	PhidgetUSBTransferHandle usbXfer;
 	PhidgetUSBConnectionHandle conn;
+	uint32_t dropped;
+	int resubmit;
 	int ret;
 	int i;
 
@@ -1447,51 +1634,38 @@ static void read_cb(struct libusb_transfer *xfer) {
 
 	//logdebug("event from: %x", conn);
 
-	if (conn->queueCnt >= MAX_XFER_QUEUE_SIZE) {
-		usblogerr("%"PRIphid": too many incoming USB packets queued: %d. Dropping a USB packet.", device, conn->queueCnt);
-	} else {
-		// Queue a transfer for the read thread - for ALL transfers
-		usbXfer = (PhidgetUSBTransferHandle)mos_malloc(sizeof(PhidgetUSBTransfer));
+	// The transfer buffer is the buffer of the slot it was submitted with
+	usbXfer = (PhidgetUSBTransferHandle)xfer->buffer;
+	usbXfer->timestamp = mos_gettime_usec();	/* CLOCK_MONOTONIC */
+	usbXfer->result = xferResult(xfer->status);
+	usbXfer->actual_length = (xfer->status == LIBUSB_TRANSFER_COMPLETED) ? xfer->actual_length : 0;
 
-		if (xfer->status == LIBUSB_TRANSFER_COMPLETED) {
-			memcpy(usbXfer->buffer, xfer->buffer, xfer->actual_length);
-			usbXfer->actual_length = xfer->actual_length;
-		}
+	resubmit = (xfer->status == LIBUSB_TRANSFER_COMPLETED && conn->usingAsyncReads);
+	dropped = 0;
 
-		switch(xfer->status) {
-			case LIBUSB_TRANSFER_COMPLETED:
-				usbXfer->result = LIBUSB_SUCCESS;
-				break;
-			case LIBUSB_TRANSFER_TIMED_OUT:
-				usbXfer->result = LIBUSB_ERROR_TIMEOUT;
-				break;
-			case LIBUSB_TRANSFER_STALL:
-				usbXfer->result = LIBUSB_ERROR_PIPE;
-				break;
-			case LIBUSB_TRANSFER_NO_DEVICE:
-				usbXfer->result = LIBUSB_ERROR_NO_DEVICE;
-				break;
-			case LIBUSB_TRANSFER_OVERFLOW:
-				usbXfer->result = LIBUSB_ERROR_OVERFLOW;
-				break;
-			case LIBUSB_TRANSFER_ERROR:
-				usbXfer->result = LIBUSB_ERROR_IO;
-				break;
-			case LIBUSB_TRANSFER_CANCELLED:
-				usbXfer->result = LIBUSB_ERROR_INTERRUPTED;
-				break;
-			default:
-				usbXfer->result = LIBUSB_ERROR_OTHER;
-				break;
-		}
-
-		mos_mutex_lock(&conn->xferQueueLock);
-		MSMTAILQ_INSERT_TAIL(&conn->xferQueue, usbXfer, link);
+	mos_mutex_lock(&conn->xferQueueLock);
+	if (resubmit && conn->xferFreeCnt == 0) {
+		/*
+		 * No spare slot to resubmit with: the reader is too far behind. Drop this packet and reuse
+		 * its slot for the next transfer.
+		 */
+		dropped = ++conn->xferDropped;
+	} else {
+		// Queue the slot for the read thread - for ALL transfers
+		conn->xferQueue[(conn->queueHead + conn->queueCnt) % XFER_SLOT_CNT] = (uint16_t)(usbXfer - conn->xferSlots);
 		conn->queueCnt++;
+		if (resubmit)
+			xfer->buffer = conn->xferSlots[conn->xferFree[--conn->xferFreeCnt]].buffer;
 		//if (conn->queueCnt > 1)
 		//	usblogdebug("Number of USB packets queued: %d", conn->queueCnt);
 		mos_cond_signal(&conn->xferQueueCond);
-		mos_mutex_unlock(&conn->xferQueueLock);
+	}
+	mos_mutex_unlock(&conn->xferQueueLock);
+
+	if (dropped) {
+		incPhidgetStat("usb.read_dropped");
+		usblogerr("%"PRIphid": too many incoming USB packets queued: %d. Dropping a USB packet (%u dropped).",
+		  device, MAX_XFER_QUEUE_SIZE, dropped);
 	}
 
 	switch (xfer->status) {
@@ -1562,19 +1736,19 @@ PhidgetUSBFreeAsyncBuffers(PhidgetUSBConnectionHandle conn) {
 		conn->xfer = NULL;
 	}
 
-	if (conn->xfer_buf) {
-		for (i = 0; i < XFER_CNT; i++) {
-			if (conn->xfer_buf[i]) {
-				if (conn->type == PHIDGET_HIDUSB_CONNECTION)
-					mos_free(conn->xfer_buf[i], ((PhidgetHIDUSBConnectionHandle)conn)->inputReportByteLength);
-				else
-					mos_free(conn->xfer_buf[i], ((PhidgetPHIDUSBConnectionHandle)conn)->pusbParams.maxPacketEP1);
-			}
-		}
-
-		mos_free(conn->xfer_buf, XFER_CNT * sizeof(unsigned char *));
-		conn->xfer_buf = NULL;
+	if (conn->xferSlots) {
+		mos_free(conn->xferSlots, XFER_SLOT_CNT * sizeof(PhidgetUSBTransfer));
+		mos_free(conn->xferFree, XFER_SLOT_CNT * sizeof(uint16_t));
+		mos_free(conn->xferQueue, XFER_SLOT_CNT * sizeof(uint16_t));
+		conn->xferSlots = NULL;
+		conn->xferFree = NULL;
+		conn->xferQueue = NULL;
 	}
+
+	conn->xferFreeCnt = 0;
+	conn->queueHead = 0;
+	conn->queueCnt = 0;
+	conn->xferReading = -1;
 }
 
 static PhidgetReturnCode
@@ -1589,14 +1763,22 @@ PhidgetUSBAllocAsyncBuffers(PhidgetUSBConnectionHandle conn) {
 			conn->xfer[i] = libusb_alloc_transfer(0);
 	}
 
-	if (!conn->xfer_buf) {
-		conn->xfer_buf = mos_malloc(XFER_CNT * sizeof(unsigned char *));
-		for (i = 0; i < XFER_CNT; i++) {
-			if (conn->type == PHIDGET_HIDUSB_CONNECTION)
-				conn->xfer_buf[i] = mos_malloc(((PhidgetHIDUSBConnectionHandle)conn)->inputReportByteLength);
-			else
-				conn->xfer_buf[i] = mos_malloc(((PhidgetPHIDUSBConnectionHandle)conn)->pusbParams.maxPacketEP1);
-		}
+	/*
+	 * Slot 0..XFER_CNT-1 start out owned by the submitted transfers; everything else is free.
+	 * Nothing is allocated on the read path after this.
+	 */
+	if (!conn->xferSlots) {
+		conn->xferSlots = mos_zalloc(XFER_SLOT_CNT * sizeof(PhidgetUSBTransfer));
+		conn->xferFree = mos_malloc(XFER_SLOT_CNT * sizeof(uint16_t));
+		conn->xferQueue = mos_malloc(XFER_SLOT_CNT * sizeof(uint16_t));
+
+		conn->xferFreeCnt = 0;
+		for (i = XFER_SLOT_CNT - 1; i >= XFER_CNT; i--)
+			conn->xferFree[conn->xferFreeCnt++] = (uint16_t)i;
+		conn->queueHead = 0;
+		conn->queueCnt = 0;
+		conn->xferReading = -1;
+		conn->xferDropped = 0;
 	}
 
 	return (EPHIDGET_OK);
@@ -1641,7 +1823,7 @@ PhidgetReturnCode PhidgetUSBStartAsyncReads(PhidgetDeviceHandle device) {
 			libusb_fill_bulk_transfer(conn->xfer[i],
 			  (libusb_device_handle *)conn->deviceHandle,
 			  LIBUSB_ENDPOINT_IN | (conn->interfaceNum + 1),
-			  conn->xfer_buf[i],
+			  conn->xferSlots[i].buffer,
 			  length,
 			  read_cb,
 			  device,
@@ -1651,7 +1833,7 @@ PhidgetReturnCode PhidgetUSBStartAsyncReads(PhidgetDeviceHandle device) {
 			libusb_fill_interrupt_transfer(conn->xfer[i],
 			  (libusb_device_handle *)conn->deviceHandle,
 			  LIBUSB_ENDPOINT_IN | (conn->interfaceNum + 1),
-			  conn->xfer_buf[i],
+			  conn->xferSlots[i].buffer,
 			  length,
 			  read_cb,
 			  device,
@@ -1731,15 +1913,13 @@ PhidgetReturnCode PhidgetUSBStopAsyncReads(PhidgetUSBConnectionHandle conn) {
 	}
 
 	// make sure xferQueue is empty
-	PhidgetUSBTransferHandle n;
 	mos_mutex_lock(&conn->xferQueueLock);
-	while (!MSMTAILQ_EMPTY(&conn->xferQueue)) {
-		n = MSMTAILQ_FIRST(&conn->xferQueue);
-		MSMTAILQ_REMOVE_HEAD(&conn->xferQueue, link);
-		conn->queueCnt--;
-		mos_free(n, sizeof(PhidgetUSBTransfer));
-	}
-	MOS_ASSERT(conn->queueCnt == 0);
+	conn->queueHead = 0;
+	conn->queueCnt = 0;
+	conn->xferReading = -1;
+
+	if (conn->xferDropped)
+		logwarn("%u incoming USB packets were dropped because the read thread fell behind", conn->xferDropped);
 
 	// Notify read thread
 	mos_cond_signal(&conn->xferQueueCond);
@@ -21,6 +21,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_ifkit488_DIGITALINPUT_000:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -169,6 +170,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1011_DIGITALINPUT_000:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -184,6 +186,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1012_DIGITALINPUT_000:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -199,6 +202,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1012_DIGITALINPUT_601:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -214,6 +218,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1012_DIGITALINPUT_602:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -257,6 +262,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1013_DIGITALINPUT_000:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -300,6 +306,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1018_DIGITALINPUT_821:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -427,6 +434,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1018_DIGITALINPUT_900:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -470,6 +478,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1018_DIGITALINPUT_1000:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -926,6 +935,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1047_DIGITALINPUT_100:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -943,6 +953,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1047_DIGITALINPUT_200:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -960,6 +971,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1047_DIGITALINPUT_300:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -1143,6 +1155,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1052_DIGITALINPUT_000:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -1159,6 +1172,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1052_DIGITALINPUT_101:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -1175,6 +1189,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1052_DIGITALINPUT_110:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -1392,6 +1407,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1060_DIGITALINPUT_100:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -1526,6 +1542,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1063_DIGITALINPUT_100:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -1574,6 +1591,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1065_DIGITALINPUT_100:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -1718,6 +1736,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1202_DIGITALINPUT_000:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -1761,6 +1780,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1202_DIGITALINPUT_120:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -1818,6 +1838,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1202_DIGITALINPUT_300:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -1891,6 +1912,7 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_1219_DIGITALINPUT_000:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_SETDEBOUNCE:
 			return (1);
 		default:
 			return (0);
@@ -1906,6 +1928,9 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_HUB_DIGITALINPUT_100:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_INPUTSNAPSHOT:
+		case BP_SETDEBOUNCE:
+		case BP_SETINPUTSNAPSHOTENABLED:
 			return (1);
 		default:
 			return (0);
@@ -2092,6 +2117,9 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_DAQ1200_DIGITALINPUT_100:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_INPUTSNAPSHOT:
+		case BP_SETDEBOUNCE:
+		case BP_SETINPUTSNAPSHOTENABLED:
 			return (1);
 		default:
 			return (0);
@@ -2128,6 +2156,9 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_DAQ1300_DIGITALINPUT_100:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_INPUTSNAPSHOT:
+		case BP_SETDEBOUNCE:
+		case BP_SETINPUTSNAPSHOTENABLED:
 			return (1);
 		default:
 			return (0);
@@ -2135,6 +2166,9 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_DAQ1301_DIGITALINPUT_100:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_INPUTSNAPSHOT:
+		case BP_SETDEBOUNCE:
+		case BP_SETINPUTSNAPSHOTENABLED:
 			return (1);
 		default:
 			return (0);
@@ -2171,6 +2205,9 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 		case BP_SETINPUTMODE:
 		case BP_SETPOWERSUPPLY:
 		case BP_STATECHANGE:
+		case BP_INPUTSNAPSHOT:
+		case BP_SETDEBOUNCE:
+		case BP_SETINPUTSNAPSHOTENABLED:
 			return (1);
 		default:
 			return (0);
@@ -2221,6 +2258,9 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 		case BP_SETINPUTMODE:
 		case BP_SETPOWERSUPPLY:
 		case BP_STATECHANGE:
+		case BP_INPUTSNAPSHOT:
+		case BP_SETDEBOUNCE:
+		case BP_SETINPUTSNAPSHOTENABLED:
 			return (1);
 		default:
 			return (0);
@@ -2818,6 +2858,9 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_HIN1101_DIGITALINPUT_100:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_INPUTSNAPSHOT:
+		case BP_SETDEBOUNCE:
+		case BP_SETINPUTSNAPSHOTENABLED:
 			return (1);
 		default:
 			return (0);
@@ -2867,6 +2910,9 @@ supportedBridgePacket(PhidgetChannelHandle ch, bridgepacket_t pkt) {
 	case PHIDCHUID_HIN1100_DIGITALINPUT_100:
 		switch (pkt) {
 		case BP_STATECHANGE:
+		case BP_INPUTSNAPSHOT:
+		case BP_SETDEBOUNCE:
+		case BP_SETINPUTSNAPSHOTENABLED:
 			return (1);
 		default:
 			return (0);
@@ -465,6 +465,11 @@ typedef enum {
 	SENSOR_TYPE_1122_AC = 0x2bd5,	/* 1122 - 30 Amp Current Sensor AC */
 } PhidgetVoltageRatioInput_SensorType;
 
+typedef enum {
+	DEBOUNCE_MODE_TRAILING_EDGE = 0x1,	/* Trailing Edge */
+	DEBOUNCE_MODE_LEADING_EDGE = 0x2,	/* Leading Edge */
+} PhidgetDigitalInput_DebounceMode;
+
 typedef enum {
 	LED_FORWARD_VOLTAGE_1_7V = 0x1,	/* 1.7 V */
 	LED_FORWARD_VOLTAGE_2_75V = 0x2,	/* 2.75 V */
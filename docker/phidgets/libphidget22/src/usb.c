@@ -334,17 +334,6 @@ __commonDelete(PhidgetUSBConnectionHandle *conn) {
 #ifndef _WINDOWS
 	PhidgetUSBFreeAsyncBuffers(*conn);
 
-	// make sure xferQueue is empty
-	PhidgetUSBTransferHandle n;
-	mos_mutex_lock(&(*conn)->xferQueueLock);
-	while (!MSMTAILQ_EMPTY(&(*conn)->xferQueue)) {
-		n = MSMTAILQ_FIRST(&(*conn)->xferQueue);
-		MSMTAILQ_REMOVE_HEAD(&(*conn)->xferQueue, link);
-		mos_free(n, sizeof(PhidgetUSBTransfer));
-	}
-	(*conn)->queueCnt = 0;
-	mos_mutex_unlock(&(*conn)->xferQueueLock);
-
 	mos_mutex_destroy(&(*conn)->xferQueueLock);
 	mos_cond_destroy(&(*conn)->xferQueueCond);
 #endif
@@ -394,7 +383,7 @@ __commonCreate(PhidgetUSBConnectionHandle *conn) {
 
 #if USB_ASYNC_READS
 #ifndef _WINDOWS
-	MSMTAILQ_INIT(&(*conn)->xferQueue);
+	(*conn)->xferReading = -1;
 	mos_mutex_init(&(*conn)->xferQueueLock);
 	mos_cond_init(&(*conn)->xferQueueCond);
 #endif
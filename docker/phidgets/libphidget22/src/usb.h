@@ -74,11 +74,15 @@ typedef struct _PhidgetUSBTransfer {
 
 #elif defined(_LINUX) || defined (_FREEBSD)
 
+/*
+ * Receive slot: libusb transfers read directly into the slot buffer, and the completed slot index
+ * is handed to the read thread without copying.
+ */
 typedef struct _PhidgetUSBTransfer{
 	unsigned char buffer[MAX_USB_BULK_INTERRUPT_IN_PACKET_SIZE];
 	int actual_length;
 	int result;
-	MSMTAILQ_ENTRY(_PhidgetUSBTransfer) link;
+	mostime_t timestamp;	/* monotonic time the transfer completed */
 } PhidgetUSBTransfer, *PhidgetUSBTransferHandle;
 
 #endif
@@ -122,15 +126,19 @@ typedef struct _PhidgetUSBTransfer{
 	int nextXfer;													\
 	PhidgetUSBTransfer **xfer;
 #elif defined(_LINUX) || defined (_FREEBSD)
-MSMTAILQ_HEAD(PhidgetUSBTransfers, _PhidgetUSBTransfer);
 #define PHIDGET_USB_CONN_STRUCT_ASYNC								\
 	int usingAsyncReads;											\
 	struct libusb_transfer **xfer;									\
-	unsigned char **xfer_buf;										\
-	struct PhidgetUSBTransfers xferQueue;							\
+	PhidgetUSBTransfer *xferSlots;	/* preallocated at open */		\
+	uint16_t *xferFree;				/* free slot stack */			\
+	int xferFreeCnt;												\
+	uint16_t *xferQueue;			/* completed slot ring */		\
+	int queueHead;													\
+	int queueCnt;													\
+	int xferReading;				/* slot held by the reader */	\
+	uint32_t xferDropped;											\
 	mos_mutex_t xferQueueLock;										\
-	mos_cond_t xferQueueCond;										\
-	int queueCnt;
+	mos_cond_t xferQueueCond;
 #endif
 #else
 #define PHIDGET_USB_CONN_STRUCT_ASYNC
@@ -144,6 +152,7 @@ MSMTAILQ_HEAD(PhidgetUSBTransfers, _PhidgetUSBTransfer);
 	mos_task_t readThread;											\
 	mos_cond_t readCond;											\
 	int readRun;													\
+	mostime_t readTime;	/* when the last packet read arrived */		\
 	HANDLE deviceHandle;
 
 typedef struct {
@@ -31,6 +31,80 @@
 #include "phidgetbase.h"
 #include "util/packettracker.h"
 #include "mos/mos_time.h"
+#include "mos/mos_atomic.h"
+
+#ifdef PACKETTRACKER_FUTEX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#endif
+
+/*
+ * PhidgetPacketWord: a 32-bit word that threads can sleep on until it changes.
+ */
+static void
+packetWordInit(PhidgetPacketWord *pw, uint32_t val) {
+
+	pw->val = val;
+#ifndef PACKETTRACKER_FUTEX
+	mos_mutex_init(&pw->lock);
+	mos_cond_init(&pw->cond);
+#endif
+}
+
+static void
+packetWordDestroy(PhidgetPacketWord *pw) {
+
+#ifndef PACKETTRACKER_FUTEX
+	mos_cond_destroy(&pw->cond);
+	mos_mutex_destroy(&pw->lock);
+#endif
+}
+
+static uint32_t
+packetWordGet(PhidgetPacketWord *pw) {
+
+	return (mos_atomic_get_32(&pw->val));
+}
+
+static int
+packetWordCas(PhidgetPacketWord *pw, uint32_t old, uint32_t new) {
+
+	return (mos_atomic_cas_32(&pw->val, old, new) == old);
+}
+
+/*
+ * Sleeps for up to ns nanoseconds as long as the word still holds val.  May return early.
+ */
+static void
+packetWordWait(PhidgetPacketWord *pw, uint32_t val, mostime_t ns) {
+#ifdef PACKETTRACKER_FUTEX
+	struct timespec ts;
+
+	ts.tv_sec = (time_t)(ns / 1000000000);
+	ts.tv_nsec = (long)(ns % 1000000000);
+	syscall(SYS_futex, &pw->val, FUTEX_WAIT_PRIVATE, val, &ts, NULL, 0);
+#else
+	mos_mutex_lock(&pw->lock);
+	if (packetWordGet(pw) == val)
+		mos_cond_timedwait(&pw->cond, &pw->lock, ns);
+	mos_mutex_unlock(&pw->lock);
+#endif
+}
+
+static void
+packetWordWake(PhidgetPacketWord *pw) {
+
+#ifdef PACKETTRACKER_FUTEX
+	syscall(SYS_futex, &pw->val, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+	mos_mutex_lock(&pw->lock);
+	mos_cond_broadcast(&pw->cond);
+	mos_mutex_unlock(&pw->lock);
+#endif
+}
 
 PhidgetPacketTrackersHandle
 mallocPhidgetPacketTrackers(void) {
@@ -40,9 +114,11 @@ mallocPhidgetPacketTrackers(void) {
 	item = (PhidgetPacketTrackersHandle)mos_zalloc(sizeof (PhidgetPacketTrackers));
 
 	for (i = 0; i < MAX_PACKET_IDS; i++) {
-		mos_cond_init(&item->packetTracker[i]._cond);
-		mos_mutex_init(&item->packetTracker[i]._lock);
+		packetWordInit(&item->packetTracker[i]._state, 0);
+		item->packetTracker[i]._trackers = item;
 	}
+	mos_mutex_init(&item->_waitLock);
+	MTAILQ_INIT(&item->_waiters);
 
 	return (item);
 }
@@ -53,48 +129,108 @@ freePhidgetPacketTrackers(PhidgetPacketTrackersHandle item) {
 
 	assert(item != NULL);
 
-	for (i = 0; i < MAX_PACKET_IDS; i++) {
-		mos_cond_destroy(&item->packetTracker[i]._cond);
-		mos_mutex_destroy(&item->packetTracker[i]._lock);
-	}
+	for (i = 0; i < MAX_PACKET_IDS; i++)
+		packetWordDestroy(&item->packetTracker[i]._state);
+	mos_mutex_destroy(&item->_waitLock);
 	mos_free(item, sizeof (PhidgetPacketTrackers));
 }
 
+/*
+ * Called whenever a tracker goes back to 0: wakes the longest waiting thread in getPacketTrackerWait()
+ * that can use it.  The wake is done under _waitLock, as the waiter lives on its own stack and cannot
+ * leave before taking that lock.
+ */
+static void
+packetTrackerFreed(PhidgetPacketTrackerHandle packetTracker) {
+	PhidgetPacketTrackersHandle trackers;
+	PhidgetPacketTrackerWaiter *waiter;
+	int id;
+
+	trackers = packetTracker->_trackers;
+	if (mos_atomic_get_32(&trackers->_waiterCnt) == 0)
+		return;
+
+	id = (int)(packetTracker - trackers->packetTracker);
+
+	mos_mutex_lock(&trackers->_waitLock);
+	MTAILQ_FOREACH(waiter, &trackers->_waiters, link) {
+		if (id < waiter->min || id > waiter->max)
+			continue;
+
+		MTAILQ_REMOVE(&trackers->_waiters, waiter, link);
+		mos_atomic_add_32(&trackers->_waiterCnt, -1);
+		waiter->queued = 0;
+		mos_atomic_swap_32(&waiter->woken.val, 1);
+		packetWordWake(&waiter->woken);
+		break;
+	}
+	mos_mutex_unlock(&trackers->_waitLock);
+}
+
+/*
+ * Signals an in use tracker with res, or releases it if its owner has abandoned it.
+ */
+static PhidgetReturnCode
+signalPacketTracker(PhidgetPacketTrackerHandle packetTracker, PhidgetReturnCode res, int sentOnly) {
+	uint32_t st, nst;
+
+	for (;;) {
+		st = packetWordGet(&packetTracker->_state);
+		if ((st & PACKETTRACKER_INUSE) == 0 || st & PACKETTRACKER_SIGNALLED)
+			return (EPHIDGET_INVALID);
+		if (sentOnly && (st & PACKETTRACKER_SENT) == 0)
+			return (EPHIDGET_INVALID);
+
+		// Release abandoned (in use) tracker here
+		if (st & PACKETTRACKER_ABANDONED)
+			nst = 0;
+		else
+			nst = (st & PACKETTRACKER_FLAGS) | PACKETTRACKER_SIGNALLED | ((uint32_t)res << 8);
+
+		if (packetWordCas(&packetTracker->_state, st, nst))
+			break;
+	}
+
+	if (nst == 0)
+		packetTrackerFreed(packetTracker);
+	else if (st & PACKETTRACKER_WAITING)
+		packetWordWake(&packetTracker->_state);
+
+	return (EPHIDGET_OK);
+}
+
 void
 setPacketLength(PhidgetPacketTrackerHandle packetTracker, size_t len) {
 
-	mos_mutex_lock(&packetTracker->_lock);
 	packetTracker->len = len;
-	mos_mutex_unlock(&packetTracker->_lock);
 }
 
 void
 setPacketDevice(PhidgetPacketTrackerHandle packetTracker, const PhidgetUniqueDeviceDef *udd) {
 
-	mos_mutex_lock(&packetTracker->_lock);
 	packetTracker->udd = udd;
-	mos_mutex_unlock(&packetTracker->_lock);
 }
 
 PhidgetReturnCode
 setPacketReturnCode(PhidgetPacketTrackerHandle packetTracker, PhidgetReturnCode res) {
 
-	mos_mutex_lock(&packetTracker->_lock);
-	if ((packetTracker->_state & PACKETTRACKER_INUSE) == 0 || packetTracker->_state & PACKETTRACKER_SIGNALLED) {
-		mos_mutex_unlock(&packetTracker->_lock);
-		return (EPHIDGET_INVALID);
-	}
+	return (signalPacketTracker(packetTracker, res, PFALSE));
+}
 
-	// Release abandoned (in use) tracker here
-	if ((packetTracker->_state & PACKETTRACKER_ABANDONED)) {
-		packetTracker->_state = 0;
-	} else {
-		packetTracker->_returnCode = res;
-		packetTracker->_state |= PACKETTRACKER_SIGNALLED;
-		mos_cond_broadcast(&packetTracker->_cond);
-	}
-	mos_mutex_unlock(&packetTracker->_lock);
+/*
+ * Marks the packet as actually sent.  Returns EPHIDGET_INTERRUPTED if it was signalled in the meantime
+ * (probably because of an error), in which case the flag is still set so the tracker is treated as sent.
+ */
+PhidgetReturnCode
+setPacketSent(PhidgetPacketTrackerHandle packetTracker) {
+	uint32_t st;
 
+	do {
+		st = packetWordGet(&packetTracker->_state);
+	} while (!packetWordCas(&packetTracker->_state, st, st | PACKETTRACKER_SENT));
+
+	if (st & PACKETTRACKER_SIGNALLED)
+		return (EPHIDGET_INTERRUPTED);
 	return (EPHIDGET_OK);
 }
 
@@ -106,23 +242,10 @@ _setPacketsReturnCode(PhidgetDeviceHandle device, int child, PhidgetReturnCode r
 	for (i = 0; i < MAX_PACKET_IDS; i++) {
 		packetTracker = &device->packetTracking->packetTracker[i];
 
-		if (!(packetTracker->_state & PACKETTRACKER_INUSE))
-			continue;
-		if (!(packetTracker->_state & PACKETTRACKER_SENT))
-			continue;
 		if (packetTracker->childIndex != child)
 			continue;
 
-		mos_mutex_lock(&packetTracker->_lock);
-		// Release abandoned (in use) tracker here
-		if ((packetTracker->_state & PACKETTRACKER_ABANDONED)) {
-			packetTracker->_state = 0;
-		} else {
-			packetTracker->_returnCode = res;
-			packetTracker->_state |= PACKETTRACKER_SIGNALLED;
-			mos_cond_broadcast(&packetTracker->_cond);
-		}
-		mos_mutex_unlock(&packetTracker->_lock);
+		signalPacketTracker(packetTracker, res, PTRUE);
 	}
 }
 
@@ -135,57 +258,65 @@ setPacketsReturnCode(PhidgetDeviceHandle device, int child, PhidgetReturnCode re
 
 PhidgetReturnCode
 getPacketReturnCode(PhidgetPacketTrackerHandle packetTracker, PhidgetReturnCode *res) {
+	uint32_t st;
 
-	mos_mutex_lock(&packetTracker->_lock);
-	if ((packetTracker->_state & PACKETTRACKER_SIGNALLED) == 0) {
-		mos_mutex_unlock(&packetTracker->_lock);
+	st = packetWordGet(&packetTracker->_state);
+	if ((st & PACKETTRACKER_SIGNALLED) == 0)
 		return (EPHIDGET_INVALID);
-	}
-	*res = packetTracker->_returnCode;
-	mos_mutex_unlock(&packetTracker->_lock);
+
+	*res = PACKETTRACKER_CODE(st);
 	return (EPHIDGET_OK);
 }
 
 PhidgetReturnCode
 waitForPendingPacket(PhidgetPacketTrackerHandle packetTracker, uint32_t ms) {
-	PhidgetReturnCode res;
 	mostime_t now;
 	mostime_t tm;
+	uint32_t st;
 
 	assert(packetTracker != NULL);
-	assert(packetTracker->_state & PACKETTRACKER_INUSE);
+	assert(packetWordGet(&packetTracker->_state) & PACKETTRACKER_INUSE);
 
 	tm = mos_gettime_usec() + (ms * 1000);
 
-	mos_mutex_lock(&packetTracker->_lock);
-	if (packetTracker->_state & PACKETTRACKER_SIGNALLED) {
-		mos_mutex_unlock(&packetTracker->_lock);
-		return (EPHIDGET_OK);
-	}
+	for (;;) {
+		st = packetWordGet(&packetTracker->_state);
+		if (st & PACKETTRACKER_SIGNALLED)
+			return (EPHIDGET_OK);
 
-	res = EPHIDGET_OK;
-	while ((packetTracker->_state & PACKETTRACKER_SIGNALLED) == 0) {
 		now = mos_gettime_usec();
 		if (now > tm) {
 			if (ms > 0)
 				logwarn("Packet tracker waitForPendingPacket timeout (%dms), Port %d", ms, packetTracker->childIndex);
-			res = EPHIDGET_TIMEOUT;
-			break;
+			return (EPHIDGET_TIMEOUT);
 		}
 
-		mos_cond_timedwait(&packetTracker->_cond, &packetTracker->_lock, ms * 1000000);
-	}
+		// Let the signaller know it has to wake us
+		if ((st & PACKETTRACKER_WAITING) == 0) {
+			if (!packetWordCas(&packetTracker->_state, st, st | PACKETTRACKER_WAITING))
+				continue;
+			st |= PACKETTRACKER_WAITING;
+		}
 
-#ifdef DEBUG
-#if 0 // disable
-	now = mos_gettime_usec();
-	mostime_t elapsed = ((now - (tm - (ms * 1000))));
+		packetWordWait(&packetTracker->_state, st, (tm - now) * 1000);
+	}
+}
 
-	logdebug("Packet tracker %d returned in %.3lfms", packetTracker->childIndex, (elapsed / 1000.0));
-#endif
-#endif
-	mos_mutex_unlock(&packetTracker->_lock);
-	return (res);
+/*
+ * Releases a tracker whose owner has abandoned it.  Returns PTRUE if it was released.
+ */
+static int
+releaseAbandonedPacketTracker(PhidgetPacketTrackerHandle packetTracker) {
+	uint32_t st;
+
+	st = packetWordGet(&packetTracker->_state);
+	if ((st & (PACKETTRACKER_INUSE | PACKETTRACKER_ABANDONED)) != (PACKETTRACKER_INUSE | PACKETTRACKER_ABANDONED))
+		return (PFALSE);
+	if (!packetWordCas(&packetTracker->_state, st, 0))
+		return (PFALSE);
+
+	packetTrackerFreed(packetTracker);
+	return (PTRUE);
 }
 
 void
@@ -193,6 +324,7 @@ waitForPendingPackets(PhidgetDeviceHandle device, int child) {
 	PhidgetPacketTrackerHandle packetTracker;
 	int stillSomeLeft;
 	mostime_t tm;
+	uint32_t st;
 	int i;
 
 	tm = mos_gettime_usec() + (10 * 1000000);
@@ -204,18 +336,15 @@ waitForPendingPackets(PhidgetDeviceHandle device, int child) {
 			if (packetTracker->childIndex != child)
 				continue;
 
-			if (!(packetTracker->_state & PACKETTRACKER_INUSE))
+			st = packetWordGet(&packetTracker->_state);
+			if (!(st & PACKETTRACKER_INUSE))
 				continue;
 
 			// Release any abandoned (in use) trackers here
-			if ((packetTracker->_state & PACKETTRACKER_ABANDONED)) {
-				mos_mutex_lock(&packetTracker->_lock);
-				packetTracker->_state = 0;
-				mos_mutex_unlock(&packetTracker->_lock);
+			if (releaseAbandonedPacketTracker(packetTracker))
 				continue;
-			}
 
-			if (!(packetTracker->_state & PACKETTRACKER_SIGNALLED))
+			if (!(st & PACKETTRACKER_SIGNALLED))
 				continue;
 
 			stillSomeLeft++;
@@ -233,33 +362,29 @@ waitForAllPendingPackets(PhidgetDeviceHandle device) {
 	PhidgetPacketTrackerHandle packetTracker;
 	int stillSomeLeft;
 	mostime_t tm;
+	uint32_t st;
 	int i;
 
 	tm = mos_gettime_usec() + (10 * 1000000);
 
 	do {
 		stillSomeLeft = 0;
-		PhidgetLock(device);
 		for (i = 0; i < MAX_PACKET_IDS; i++) {
 			packetTracker = &device->packetTracking->packetTracker[i];
 
-			if (!(packetTracker->_state & PACKETTRACKER_INUSE))
+			st = packetWordGet(&packetTracker->_state);
+			if (!(st & PACKETTRACKER_INUSE))
 				continue;
 
 			// Release any abandoned (in use) trackers here
-			if ((packetTracker->_state & PACKETTRACKER_ABANDONED)) {
-				mos_mutex_lock(&packetTracker->_lock);
-				packetTracker->_state = 0;
-				mos_mutex_unlock(&packetTracker->_lock);
+			if (releaseAbandonedPacketTracker(packetTracker))
 				continue;
-			}
 
-			if (!(packetTracker->_state & PACKETTRACKER_SIGNALLED))
+			if (!(st & PACKETTRACKER_SIGNALLED))
 				continue;
 
 			stillSomeLeft++;
 		}
-		PhidgetUnlock(device);
 		if (stillSomeLeft) {
 			if (mos_gettime_usec() > tm)
 				break;
@@ -268,14 +393,39 @@ waitForAllPendingPackets(PhidgetDeviceHandle device) {
 	} while (stillSomeLeft);
 }
 
+static void
+removePacketTrackerWaiter(PhidgetPacketTrackersHandle trackers, PhidgetPacketTrackerWaiter *waiter) {
+
+	mos_mutex_lock(&trackers->_waitLock);
+	if (waiter->queued) {
+		MTAILQ_REMOVE(&trackers->_waiters, waiter, link);
+		mos_atomic_add_32(&trackers->_waiterCnt, -1);
+		waiter->queued = 0;
+	}
+	mos_mutex_unlock(&trackers->_waitLock);
+}
+
+/*
+ * Like getPacketTracker(), but if every tracker is in use, sleeps until one in range is released (or the
+ * timeout expires) instead of failing.
+ */
 PhidgetReturnCode
 getPacketTrackerWait(PhidgetDeviceHandle device, int *packetID, PhidgetPacketTrackerHandle *packetTracker,
 	int min, int max, int childIndex, uint32_t timeout_ms) {
+	PhidgetPacketTrackerWaiter waiter;
+	PhidgetPacketTrackersHandle trackers;
 	PhidgetReturnCode ret;
+	mostime_t now;
 	mostime_t tm;
 
+	trackers = device->packetTracking;
 	tm = mos_gettime_usec() + (timeout_ms * 1000);
 
+	waiter.min = min;
+	waiter.max = max;
+	waiter.queued = 0;
+	packetWordInit(&waiter.woken, 0);
+
 	while (1) {
 
 		ret = getPacketTracker(device, packetID, packetTracker, min, max, childIndex);
@@ -286,22 +436,41 @@ getPacketTrackerWait(PhidgetDeviceHandle device, int *packetID, PhidgetPacketTra
 		if (ret != EPHIDGET_NOENT)
 			break;
 
-		if (mos_gettime_usec() > tm) {
+		now = mos_gettime_usec();
+		if (now > tm) {
 			ret = EPHIDGET_TIMEOUT;
 			break;
 		}
 
-		mos_usleep(10000);
-	}
+		mos_atomic_swap_32(&waiter.woken.val, 0);
+		mos_mutex_lock(&trackers->_waitLock);
+		MTAILQ_INSERT_TAIL(&trackers->_waiters, &waiter, link);
+		mos_atomic_add_32(&trackers->_waiterCnt, 1);
+		waiter.queued = 1;
+		mos_mutex_unlock(&trackers->_waitLock);
 
-	//loginfo("getPacketTrackerWait returning %d after %d ms", ret, (mos_gettime_usec() - tm + (timeout_ms * 1000)) / 1000);
+		// A tracker released before we were queued would not have woken us
+		ret = getPacketTracker(device, packetID, packetTracker, min, max, childIndex);
+		if (ret != EPHIDGET_NOENT) {
+			removePacketTrackerWaiter(trackers, &waiter);
+			break;
+		}
 
+		packetWordWait(&waiter.woken, 0, (tm - now) * 1000);
+		removePacketTrackerWaiter(trackers, &waiter);
+	}
+
+	packetWordDestroy(&waiter.woken);
 	return (ret);
 }
 
 PhidgetReturnCode
 getPacketTracker(PhidgetDeviceHandle device, int *packetID, PhidgetPacketTrackerHandle *packetTracker,
   int min, int max, int childIndex) {
+	PhidgetPacketTrackersHandle trackers;
+	PhidgetPacketTrackerHandle tracker;
+	uint32_t start;
+	int cnt;
 	int i, j;
 
 	assert(device != NULL);
@@ -309,66 +478,60 @@ getPacketTracker(PhidgetDeviceHandle device, int *packetID, PhidgetPacketTracker
 	assert(min >= 0);
 	assert(max < MAX_PACKET_IDS);
 
-	PhidgetLock(device);
+	trackers = device->packetTracking;
+	cnt = max - min + 1;
 
-	for (j = min; j <= max; j++) {
+	// Cycle through the valid packet IDs, starting after the last one handed out for this child
+	start = mos_atomic_get_32(&trackers->counter[childIndex]);
 
-		// XXX - cycle through the valid packet IDs
-		i = j + device->packetTracking->counter[childIndex];
-		if (i > max)
-			i -= (max - min);
-		assert (i >= min && i <= max);
+	for (j = 0; j < cnt; j++) {
+		i = min + (int)((start + j) % cnt);
+		tracker = &trackers->packetTracker[i];
 
-		if (device->packetTracking->packetTracker[i]._state & PACKETTRACKER_INUSE)
+		if (packetWordGet(&tracker->_state) != 0)
 			continue;
 
-		mos_mutex_lock(&device->packetTracking->packetTracker[i]._lock);
-		// Check again after we lock
-		if (device->packetTracking->packetTracker[i]._state & PACKETTRACKER_INUSE) {
-			mos_mutex_unlock(&device->packetTracking->packetTracker[i]._lock);
+		if (!packetWordCas(&tracker->_state, 0,
+		  PACKETTRACKER_INUSE | ((uint32_t)EPHIDGET_UNKNOWNVAL << 8)))
 			continue;
-		}
-		device->packetTracking->packetTracker[i]._state |= PACKETTRACKER_INUSE;
-		device->packetTracking->packetTracker[i]._returnCode = EPHIDGET_UNKNOWNVAL;
-		device->packetTracking->packetTracker[i].len = 0;
-		device->packetTracking->packetTracker[i].childIndex = childIndex;
-		device->packetTracking->counter[childIndex]++;
-		if (device->packetTracking->counter[childIndex] > (max - min))
-			device->packetTracking->counter[childIndex] = 0;
-		*packetID = i;
-		*packetTracker = &device->packetTracking->packetTracker[i];
-		mos_mutex_unlock(&device->packetTracking->packetTracker[i]._lock);
 
-		PhidgetUnlock(device);
+		tracker->len = 0;
+		tracker->childIndex = childIndex;
+		mos_atomic_swap_32(&trackers->counter[childIndex], start + j + 1);
+		*packetID = i;
+		*packetTracker = tracker;
 		return (EPHIDGET_OK);
 	}
 
 	// All trackers in use - wait
-
-	PhidgetUnlock(device);
 	return (EPHIDGET_NOENT);
 }
 
 void
 releasePacketTracker(PhidgetDeviceHandle device, PhidgetPacketTrackerHandle packetTracker, int force) {
+	uint32_t st, nst;
 
 	assert(device != NULL);
 	assert(device->packetTracking != NULL);
 
-	PhidgetLock(device);
-	mos_mutex_lock(&packetTracker->_lock);
-	if (force) {
-		packetTracker->_state = 0;
-	} else {
+	for (;;) {
+		st = packetWordGet(&packetTracker->_state);
 		// Don't release a packet tracker if it's sent and not signalled
-		if ((packetTracker->_state & (PACKETTRACKER_INUSE | PACKETTRACKER_SIGNALLED | PACKETTRACKER_SENT)) != (PACKETTRACKER_INUSE | PACKETTRACKER_SENT)) {
-			packetTracker->_state = 0;
-		} else {
-			logverbose("Refusing to release sent but non-signalled packet tracker, Port %d", packetTracker->childIndex);
-			// Abandon - this can be released later
-			packetTracker->_state |= PACKETTRACKER_ABANDONED;
-		}
+		if (force || (st & (PACKETTRACKER_INUSE | PACKETTRACKER_SIGNALLED | PACKETTRACKER_SENT)) !=
+		  (PACKETTRACKER_INUSE | PACKETTRACKER_SENT))
+			nst = 0;
+		else
+			nst = st | PACKETTRACKER_ABANDONED;
+
+		if (packetWordCas(&packetTracker->_state, st, nst))
+			break;
+	}
+
+	if (nst == 0) {
+		if (st != 0)
+			packetTrackerFreed(packetTracker);
+	} else {
+		logverbose("Refusing to release sent but non-signalled packet tracker, Port %d", packetTracker->childIndex);
+		// Abandoned - this can be released later
 	}
-	mos_mutex_unlock(&packetTracker->_lock);
-	PhidgetUnlock(device);
 }
@@ -35,25 +35,60 @@
 
 #define MAX_PACKET_IDS	128
 
+/*
+ * Each tracker is driven by a single 32-bit state word: the flags live in the low byte, and the return
+ * code is stored above them in the same update that sets PACKETTRACKER_SIGNALLED.  Trackers are claimed,
+ * signalled and released with compare-and-swap, and a waiter sleeps on the word itself, so completing one
+ * packet only wakes the thread waiting on that packet.
+ */
 #define PACKETTRACKER_INUSE		0x01
 #define PACKETTRACKER_SIGNALLED	0x02
 #define PACKETTRACKER_SENT		0x04
 #define PACKETTRACKER_ABANDONED	0x08
+#define PACKETTRACKER_WAITING	0x10	/* a thread is (or was) asleep on the state word */
+
+#define PACKETTRACKER_FLAGS		0xFF
+#define PACKETTRACKER_CODE(st)	((PhidgetReturnCode)((st) >> 8))
+
+/* Linux sleeps on the word with futex(2); elsewhere the word carries a mutex and condition to sleep on. */
+#if defined(_LINUX)
+#define PACKETTRACKER_FUTEX
+#endif
+
+typedef struct {
+	uint32_t							val;
+#ifndef PACKETTRACKER_FUTEX
+	mos_mutex_t							lock;
+	mos_cond_t							cond;
+#endif
+} PhidgetPacketWord;
+
+struct _PhidgetPacketTrackers;
 
 typedef struct _PhidgetPacketTracker {
-	int									_state;
-	PhidgetReturnCode					_returnCode;
+	PhidgetPacketWord					_state;
 	int									childIndex;
 	size_t								len;
-	mos_cond_t							_cond;
-	mos_mutex_t							_lock;
 	const PhidgetUniqueDeviceDef		*udd;
+	struct _PhidgetPacketTrackers		*_trackers;
 	MTAILQ_ENTRY(_PhidgetPacketTracker)	link;
 } PhidgetPacketTracker, *PhidgetPacketTrackerHandle;
 
-typedef struct {
+/* A thread in getPacketTrackerWait(), waiting for a tracker in [min, max] to be released */
+typedef struct _PhidgetPacketTrackerWaiter {
+	int											min;
+	int											max;
+	int											queued;
+	PhidgetPacketWord							woken;
+	MTAILQ_ENTRY(_PhidgetPacketTrackerWaiter)	link;
+} PhidgetPacketTrackerWaiter;
+
+typedef struct _PhidgetPacketTrackers {
 	PhidgetPacketTracker packetTracker[MAX_PACKET_IDS];
-	int counter[PHIDGET_MAXCHILDREN];
+	uint32_t counter[PHIDGET_MAXCHILDREN];
+	mos_mutex_t _waitLock;			/* protects _waiters */
+	MTAILQ_HEAD(, _PhidgetPacketTrackerWaiter) _waiters;
+	uint32_t _waiterCnt;
 } PhidgetPacketTrackers, *PhidgetPacketTrackersHandle;
 
 typedef MTAILQ_HEAD(PhidgetPacketTrackerlist, _PhidgetPacketTracker) PhidgetPacketTrackerlist_t;
@@ -69,6 +104,7 @@ void freePhidgetPacketTrackers(PhidgetPacketTrackersHandle);
 void setPacketLength(PhidgetPacketTrackerHandle, size_t len);
 void setPacketDevice(PhidgetPacketTrackerHandle packetTracker, const PhidgetUniqueDeviceDef *udd);
 PhidgetReturnCode setPacketReturnCode(PhidgetPacketTrackerHandle, PhidgetReturnCode);
+PhidgetReturnCode setPacketSent(PhidgetPacketTrackerHandle);
 void setPacketsReturnCode(PhidgetDeviceHandle, int child, PhidgetReturnCode status);
 void _setPacketsReturnCode(PhidgetDeviceHandle, int child, PhidgetReturnCode status);
 PhidgetReturnCode getPacketReturnCode(PhidgetPacketTrackerHandle, PhidgetReturnCode *);
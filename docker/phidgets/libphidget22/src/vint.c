@@ -108,16 +108,12 @@ scanVintDevice(PhidgetDeviceHandle device, int childIndex, int id, int version,
 	uint8_t prop, propLen;
 	PhidgetReturnCode res;
 	size_t bufLen;
+	int uid;
 
 	hub = (PhidgetHubDeviceHandle)device;
 again:
-	for (pdd = Phidget_Unique_Device_Def; (int)(pdd->type) != END_OF_LIST; pdd++) {
-		if (pdd->type != PHIDTYPE_VINT)
-			continue;
-		if (pdd->vintID != id)
-			continue;
-		if (version >= pdd->versionHigh || version < pdd->versionLow)
-			continue;
+	if (matchUniqueVINTDevice(id, version, &uid) == EPHIDGET_OK) {
+		pdd = &Phidget_Unique_Device_Def[uid];
 
 		/*
 		 * If the device is already here, just mark as scanned and move on.
@@ -54,6 +54,7 @@ typedef struct {
 } VINTIO_t;
 
 const VINTIO_t * const getVINTIO(unsigned int uid);
+int getVINTInputState(unsigned int uid, int pkt, const uint8_t *buf, size_t len);
 
 //PC -> VINT device Commands / Data
 typedef enum {
@@ -72,6 +72,44 @@ _recvDEFAULT(PhidgetChannelHandle ch, const uint8_t *buf, size_t len) {
 	MOS_PANIC("Unsupported Device (not vint?)");
 }
 
+/*
+ * Decodes the input state from a digital input state change packet of type pkt, followed by len bytes,
+ * from a device of the given uid.  Used by the device packet handlers, and for the hub's input snapshot
+ * of channels that are not open.  Returns -1 if the packet does not carry a state change.
+ */
+int
+getVINTInputState(unsigned int uid, int pkt, const uint8_t *buf, size_t len) {
+
+	if (uid == PHIDUID_DIGITALINPUT_PORT) {
+		// Hub port inputs send no state byte: the packet type is the state
+		switch (pkt) {
+		case VINT_PACKET_TYPE_DIGITALINPUT_STATECHANGE:
+			return (1);
+		case VINT_PACKET_TYPE_DIGITALINPUT_STATECHANGE2:
+			return (0);
+		default:
+			return (-1);
+		}
+	}
+
+	if (pkt != VINT_PACKET_TYPE_DIGITALINPUT_STATECHANGE || len < 1)
+		return (-1);
+
+	switch (uid) {
+	case PHIDUID_HIN1100:
+		return (buf[0] ? 1 : 0);
+	case PHIDUID_HIN1101:
+	case PHIDUID_DAQ1200:
+	case PHIDUID_DAQ1300:
+	case PHIDUID_DAQ1301:
+	case PHIDUID_DAQ1400:
+	case PHIDUID_DAQ1400_120:
+		return (buf[0] & 0x01);
+	default:
+		return (-1);
+	}
+}
+
 #if PHIDUID_GENERICVINT_SUPPORTED
 static PhidgetReturnCode
 sendGENERICVINT(PhidgetChannelHandle ch, BridgePacket *bp) {
@@ -5551,7 +5589,9 @@ recvHIN1100(PhidgetChannelHandle ch, const uint8_t *buf, size_t len) {
 	case PHIDCHUID_HIN1100_DIGITALINPUT_100:
 		switch (pkt) {
 		case VINT_PACKET_TYPE_DIGITALINPUT_STATECHANGE:
-			value = buf[0] ? 1 : 0;
+			value = getVINTInputState(PHIDUID_HIN1100, pkt, buf, len - 1);
+			if (value < 0)
+				return (EPHIDGET_UNEXPECTED);
 			return (bridgeSendToChannel(ch, BP_STATECHANGE, 1, "%d", value));
 		default:
 			MOS_PANIC("Unexpected packet type");
@@ -5802,7 +5842,9 @@ recvHIN1101(PhidgetChannelHandle ch, const uint8_t *buf, size_t len) {
 	case PHIDCHUID_HIN1101_DIGITALINPUT_100:
 		switch (pkt) {
 		case VINT_PACKET_TYPE_DIGITALINPUT_STATECHANGE:
-			state = buf[0] & 0x01;
+			state = getVINTInputState(PHIDUID_HIN1101, pkt, buf, len - 1);
+			if (state < 0)
+				return (EPHIDGET_UNEXPECTED);
 			return (bridgeSendToChannel(ch, BP_STATECHANGE, 1, "%d", state));
 		default:
 			MOS_PANIC("Unexpected packet type");
@@ -9254,7 +9296,9 @@ recvDAQ1400(PhidgetChannelHandle ch, const uint8_t *buf, size_t len) {
 	case PHIDCHUID_DAQ1400_DIGITALINPUT_120:
 		switch (pkt) {
 		case VINT_PACKET_TYPE_DIGITALINPUT_STATECHANGE:
-			state = buf[0] & 0x01;
+			state = getVINTInputState(PHIDUID_DAQ1400, pkt, buf, len - 1);
+			if (state < 0)
+				return (EPHIDGET_UNEXPECTED);
 			return (bridgeSendToChannel(ch, BP_STATECHANGE, 1, "%d", state));
 		default:
 			MOS_PANIC("Unexpected packet type");
@@ -9309,6 +9353,7 @@ sendDAQ1301(PhidgetChannelHandle ch, BridgePacket *bp) {
 
 static PhidgetReturnCode
 recvDAQ1301(PhidgetChannelHandle ch, const uint8_t *buf, size_t len) {
+	int state;
 	int pkt;
 
 	assert(buf);
@@ -9320,7 +9365,10 @@ recvDAQ1301(PhidgetChannelHandle ch, const uint8_t *buf, size_t len) {
 	case PHIDCHUID_DAQ1301_DIGITALINPUT_100:
 		switch (pkt) {
 		case VINT_PACKET_TYPE_DIGITALINPUT_STATECHANGE:
-			return (bridgeSendToChannel(ch, BP_STATECHANGE, 1, "%d", (buf[0] & 0x1)));
+			state = getVINTInputState(PHIDUID_DAQ1301, pkt, buf, len - 1);
+			if (state < 0)
+				return (EPHIDGET_UNEXPECTED);
+			return (bridgeSendToChannel(ch, BP_STATECHANGE, 1, "%d", state));
 		default:
 			MOS_PANIC("Unexpected packet type");
 		}
@@ -9337,6 +9385,7 @@ sendDAQ1300(PhidgetChannelHandle ch, BridgePacket *bp) {
 
 static PhidgetReturnCode
 recvDAQ1300(PhidgetChannelHandle ch, const uint8_t *buf, size_t len) {
+	int state;
 	int pkt;
 
 	assert(buf);
@@ -9348,7 +9397,10 @@ recvDAQ1300(PhidgetChannelHandle ch, const uint8_t *buf, size_t len) {
 	case PHIDCHUID_DAQ1300_DIGITALINPUT_100:
 		switch (pkt) {
 		case VINT_PACKET_TYPE_DIGITALINPUT_STATECHANGE:
-			return (bridgeSendToChannel(ch, BP_STATECHANGE, 1, "%d", (buf[0] & 0x1)));
+			state = getVINTInputState(PHIDUID_DAQ1300, pkt, buf, len - 1);
+			if (state < 0)
+				return (EPHIDGET_UNEXPECTED);
+			return (bridgeSendToChannel(ch, BP_STATECHANGE, 1, "%d", state));
 		default:
 			MOS_PANIC("Unexpected packet type");
 		}
@@ -9481,6 +9533,7 @@ sendDAQ1200(PhidgetChannelHandle ch, BridgePacket *bp) {
 
 static PhidgetReturnCode
 recvDAQ1200(PhidgetChannelHandle ch, const uint8_t *buf, size_t len) {
+	int state;
 	int pkt;
 
 	assert(buf);
@@ -9492,7 +9545,10 @@ recvDAQ1200(PhidgetChannelHandle ch, const uint8_t *buf, size_t len) {
 	case PHIDCHUID_DAQ1200_DIGITALINPUT_100:
 		switch (pkt) {
 		case VINT_PACKET_TYPE_DIGITALINPUT_STATECHANGE:
-			return (bridgeSendToChannel(ch, BP_STATECHANGE, 1, "%d", (buf[0] & 0x1)));
+			state = getVINTInputState(PHIDUID_DAQ1200, pkt, buf, len - 1);
+			if (state < 0)
+				return (EPHIDGET_UNEXPECTED);
+			return (bridgeSendToChannel(ch, BP_STATECHANGE, 1, "%d", state));
 		default:
 			MOS_PANIC("Unexpected packet type");
 		}
@@ -10356,6 +10412,7 @@ sendDIGITALINPUT_PORT(PhidgetChannelHandle ch, BridgePacket *bp) {
 
 static PhidgetReturnCode
 recvDIGITALINPUT_PORT(PhidgetChannelHandle ch, const uint8_t *buf, size_t len) {
+	int state;
 	int pkt;
 
 	assert(buf);
@@ -10367,9 +10424,9 @@ recvDIGITALINPUT_PORT(PhidgetChannelHandle ch, const uint8_t *buf, size_t len) {
 	case PHIDCHUID_HUB_DIGITALINPUT_100:
 		switch (pkt) {
 		case VINT_PACKET_TYPE_DIGITALINPUT_STATECHANGE:
-			return (bridgeSendToChannel(ch, BP_STATECHANGE, 1, "%d", 1));
 		case VINT_PACKET_TYPE_DIGITALINPUT_STATECHANGE2:
-			return (bridgeSendToChannel(ch, BP_STATECHANGE, 1, "%d", 0));
+			state = getVINTInputState(PHIDUID_DIGITALINPUT_PORT, pkt, buf, len - 1);
+			return (bridgeSendToChannel(ch, BP_STATECHANGE, 1, "%d", state));
 		default:
 			MOS_PANIC("Unexpected packet type");
 		}
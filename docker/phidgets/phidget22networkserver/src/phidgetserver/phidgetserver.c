@@ -10,6 +10,13 @@ setNetworkFlags(pconf_t *cfg) {
 	if (pconf_getbool(cfg, 0, "phidget.network.resolveaddrs"))
 		PhidgetNet_setProperty("resolveaddrs", "true");
 
+	if (pconf_exists(cfg, "phidget.network.outqueue.high"))
+		PhidgetNet_setProperty("outqueuehigh", "%u", pconf_getu32(cfg, 0, "phidget.network.outqueue.high"));
+	if (pconf_exists(cfg, "phidget.network.outqueue.low"))
+		PhidgetNet_setProperty("outqueuelow", "%u", pconf_getu32(cfg, 0, "phidget.network.outqueue.low"));
+	if (pconf_exists(cfg, "phidget.network.outqueue.policy"))
+		PhidgetNet_setProperty("outqueuepolicy", "%s", pconf_getstr(cfg, "", "phidget.network.outqueue.policy"));
+
 	return (EPHIDGET_OK);
 }
 
@@ -84,18 +84,26 @@ typedef PhidgetReturnCode(CCONV *NetConnWrite)(mosiop_t, PhidgetNetConnHandle, c
 typedef PhidgetReturnCode(CCONV *NetConnRead)(mosiop_t, PhidgetNetConnHandle, void *, uint32_t *);
 typedef void(CCONV *NetConnClose)(PhidgetNetConnHandle);
 typedef void(CCONV *NetConnRelease)(PhidgetNetConnHandle *);
+typedef PhidgetReturnCode(CCONV *NetConnFlush)(mosiop_t, PhidgetNetConnHandle);
+typedef uint32_t(CCONV *NetConnBuffered)(PhidgetNetConnHandle);
 
 typedef void (CCONV *initPhidgetNetConn_t)(IPhidgetServerHandle, PhidgetNetConnHandle);
 typedef PhidgetReturnCode(CCONV *handlePhidgetNetConn_t)(mosiop_t, IPhidgetServerHandle);
 typedef PhidgetReturnCode(CCONV *handleRequest_t)(mosiop_t, PhidgetNetConnHandle, void *, int *);
 
 PHIDGET22_API PhidgetReturnCode CCONV netConnWrite(mosiop_t, PhidgetNetConnHandle, const void *, size_t);
+PHIDGET22_API PhidgetReturnCode CCONV netConnSendFile(mosiop_t, PhidgetNetConnHandle, int, uint64_t);
 PHIDGET22_API PhidgetReturnCode CCONV netConnReadLine(mosiop_t, PhidgetNetConnHandle, void *, size_t *);
 PHIDGET22_API PhidgetReturnCode CCONV pnwrite(mosiop_t, PhidgetNetConnHandle, const void *, uint32_t);
+PHIDGET22_API PhidgetReturnCode CCONV pnwritev(mosiop_t, PhidgetNetConnHandle, mos_iovec_t *, int);
 PHIDGET22_API PhidgetReturnCode CCONV pnread(mosiop_t, PhidgetNetConnHandle, void *, uint32_t *);
+PHIDGET22_API PhidgetReturnCode CCONV pnreadsome(mosiop_t, PhidgetNetConnHandle, void *, uint32_t *);
 
 PHIDGET22_API PhidgetReturnCode CCONV setNetConnHandlers(PhidgetNetConnHandle, NetConnClose, NetConnRelease, NetConnWrite,
   NetConnRead);
+PHIDGET22_API PhidgetReturnCode CCONV setNetConnFlushHandler(PhidgetNetConnHandle, NetConnFlush);
+PHIDGET22_API int CCONV getNetConnWriteBatch(PhidgetNetConnHandle);
+PHIDGET22_API PhidgetReturnCode CCONV setNetConnBufferedHandler(PhidgetNetConnHandle, NetConnBuffered);
 PHIDGET22_API const char * CCONV getNetConnPeerName(PhidgetNetConnHandle);
 PHIDGET22_API void CCONV setNetConnPrivate(PhidgetNetConnHandle, void *);
 PHIDGET22_API void * CCONV getNetConnPrivate(PhidgetNetConnHandle);
@@ -109,6 +117,7 @@ PHIDGET22_API PhidgetNetConnHandle CCONV getIPhidgetServerNetConn(IPhidgetServer
 PHIDGET22_API PhidgetServerHandle CCONV getPhidgetServerHandle(IPhidgetServerHandle);
 PHIDGET22_API PhidgetReturnCode CCONV handleDeviceRequest(mosiop_t, PhidgetNetConnHandle, void *, int *);
 PHIDGET22_API PhidgetReturnCode CCONV handleDeviceClient(mosiop_t, IPhidgetServerHandle);
+PHIDGET22_API PhidgetReturnCode CCONV upgradeDeviceClient(mosiop_t, IPhidgetServerHandle);
 
 PHIDGET22_API PhidgetReturnCode CCONV PhidgetNet_startServer2(PhidgetServerType, int, int, const char *, const char *, int,
   const char *, initPhidgetNetConn_t, handlePhidgetNetConn_t, handleRequest_t, PhidgetServerHandle *);
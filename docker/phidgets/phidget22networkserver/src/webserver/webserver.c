@@ -7,11 +7,15 @@
 #include "mos/kv/kv.h"
 
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 static PhidgetMDNSPublishHandle publishhandle[2];
 static PhidgetServerHandle wwwserver;
 static const char *cachectrl;
 static const char *docroot;
+static char docrootcanonical[MOS_PATH_MAX];	/* resolved once at startup */
+static size_t docrootcanonicallen;
 static pconf_t *wwwcfg;
 
 static int enable_phidgets;		/* control websocket access to phidgets */
@@ -100,17 +104,37 @@ staturi(const char *path, int *type) {
 	return (0);
 }
 
+/*
+ * Returns true if the client's copy of the file is current: If-None-Match takes precedence over
+ * If-Modified-Since, which must match Last-Modified exactly (we only ever hand out that date).
+ */
+static int
+notModified(WebConnHandle wc, const char *etag, const char *lastmod) {
+	const char *val;
+
+	val = kvgetstrc(wc->header, "If-None-Match", NULL);
+	if (val != NULL)
+		return (mos_strcmp(val, "*") == 0 || mos_strstrc(val, etag) != NULL);
+
+	val = kvgetstrc(wc->header, "If-Modified-Since", NULL);
+	if (val != NULL)
+		return (mos_strcmp(val, lastmod) == 0);
+
+	return (0);
+}
+
 static int
 handleHTTPGet(mosiop_t iop, WebConnHandle wc, int *keepalive) {
 	PhidgetReturnCode err;
 	char path[MOS_PATH_MAX];
 	char pathcannonical[MOS_PATH_MAX];
-	char docrootcannonical[MOS_PATH_MAX];
-	char buf[32768];
-	size_t len;
+	char lastmod[64];
+	char etag[64];
+	struct stat sb;
+	WebFile *wf;
 	int noent;
 	int type;
-	FILE *fp;
+	int fd;
 
 	noent = 0;
 
@@ -133,11 +157,13 @@ handleHTTPGet(mosiop_t iop, WebConnHandle wc, int *keepalive) {
 	// Get cannonical names
 	if (mos_path_getcanonical(path, pathcannonical, MOS_PATH_MAX) == NULL)
 		return (MOS_ERROR(iop, ENOENT, "failed to get cannonical path"));
-	if (mos_path_getcanonical(docroot, docrootcannonical, MOS_PATH_MAX) == NULL)
+	if (docrootcanonicallen == 0)
 		return (MOS_ERROR(iop, ENOENT, "failed to get cannonical docroot"));
 
-	// Make sure request is within docroot
-	if (strncmp(pathcannonical, docrootcannonical, strlen(docrootcannonical)) != 0)
+	// Make sure request is within docroot (and not just a sibling sharing its prefix)
+	if (strncmp(pathcannonical, docrootcanonical, docrootcanonicallen) != 0 ||
+	  (pathcannonical[docrootcanonicallen] != '/' && pathcannonical[docrootcanonicallen] != '\0' &&
+	  docrootcanonical[docrootcanonicallen - 1] != '/'))
 		return (MOS_ERROR(iop, ENOENT, "file is not within docroot"));
 
 	type = 0;
@@ -154,8 +180,8 @@ handleHTTPGet(mosiop_t iop, WebConnHandle wc, int *keepalive) {
 			return (wsmoved(iop, wc, "%s/", wc->uri));
 	}
 
-	fp = fopen(pathcannonical, "rb");
-	if (fp == NULL) {
+	fd = open(pathcannonical, O_RDONLY);
+	if (fd == -1) {
 noent:
 		err = wsnoent(iop, wc, pathcannonical);
 		if (noent)
@@ -163,26 +189,46 @@ noent:
 		return (0);
 	}
 
-	err = wsheader(iop, wc, pathcannonical);
-	if (err != EPHIDGET_OK)
+	if (fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode)) {
+		close(fd);
+		goto noent;
+	}
+
+	mkfiletag(&sb, etag, sizeof (etag), lastmod, sizeof (lastmod));
+	if (notModified(wc, etag, lastmod)) {
+		close(fd);
+		return (wsnotmodified(iop, wc, etag, lastmod));
+	}
+
+	err = wsfileheader(iop, wc, pathcannonical, (uint64_t)sb.st_size, etag, lastmod);
+	if (err != EPHIDGET_OK) {
+		close(fd);
 		return (MOS_ERROR(iop, err, "failed to write header to client"));
+	}
 
 	/* Do not send the body if the method is HEAD */
 	if (mos_strcmp(wc->method, "HEAD") == 0)
 		goto done;
 
-	for (;;) {
-		len = fread(buf, 1, sizeof (buf), fp);
-		if (len == 0)
-			break;
-		err = netConnWrite(iop, wc->conn, buf, len);
-		if (err != 0)
-			return (MOS_ERROR(iop, err, "failed to write reply block to client"));
+	/*
+	 * Small files are served from memory.  Anything else is sent straight from the file without
+	 * passing through a buffer here.
+	 */
+	wf = getCachedFile(pathcannonical, fd, &sb);
+	if (wf != NULL) {
+		err = netConnWrite(iop, wc->conn, wf->data, (size_t)wf->size);
+		putCachedFile(&wf);
+	} else {
+		err = netConnSendFile(iop, wc->conn, fd, (uint64_t)sb.st_size);
+	}
+	if (err != 0) {
+		close(fd);
+		return (MOS_ERROR(iop, err, "failed to write reply to client"));
 	}
 
 done:
 
-	fclose(fp);
+	close(fd);
 	return (0);
 }
 
@@ -421,7 +467,7 @@ handleWWWClient(mosiop_t iop, IPhidgetServerHandle server) {
 			goto done;
 		}
 		if (wc->flags & WC_PHIDGETS) {
-			err = handleDeviceClient(iop, server);
+			err = upgradeDeviceClient(iop, server);
 			if (err != 0)
 				wslogerr("failed to handle phidgets websocket connection\n%N", iop);
 		}
@@ -466,6 +512,7 @@ netconnclose(PhidgetNetConnHandle nc) {
 	setNetConnPrivate(nc, NULL);
 	if (wc->serverhost)
 		mos_free(wc->serverhost, MOSM_FSTR);
+	mos_mutex_destroy(&wc->writelk);
 	mos_free(wc, sizeof (WebConn));
 }
 
@@ -480,6 +527,7 @@ initNetConn(IPhidgetServerHandle server, PhidgetNetConnHandle nc) {
 	setNetConnPrivate(nc, wc);
 	wc->conn = nc;
 	wc->port = port;
+	mos_mutex_init(&wc->writelk);
 	setNetConnHandlers(nc, netconnclose, NULL, NULL, NULL);
 	setNetConnProtocol(nc, NULL, 0, 0);
 	wc->accessfp = accessfp;
@@ -536,6 +584,14 @@ startWebServer(pconf_t *cfg) {
 		return (EPHIDGET_INVALID);
 	}
 
+	if (mos_path_getcanonical(docroot, docrootcanonical, sizeof (docrootcanonical)) == NULL) {
+		wslogwarn("failed to get cannonical path for docroot '%s': files will not be served", docroot);
+		docrootcanonical[0] = '\0';
+	}
+	docrootcanonicallen = mos_strlen(docrootcanonical);
+
+	initFileCache(cfg);
+
 	port = pconf_get32(cfg, DEFAULT_PORT, "phidget.www.network.ipv4.port");
 	address = pconf_getstr(cfg, NULL, "phidget.www.network.ipv4.address");
 	af = AF_INET;
@@ -558,6 +614,7 @@ startWebServer(pconf_t *cfg) {
 	 * The server code will handle accepting connection and the creation of a thread to handle the connection.
 	 * That thread will call handleWWWClient() which will serve HTTP requests, and possibly upgrade the
 	 * connection to a phidget device server, which will result in calls to handleDeviceRequest().
+	 * An upgraded connection is passed to the library's event loop where it has one, and the thread exits.
 	 */
 	res = PhidgetNet_startServer2(PHIDGETSERVER_WWWLISTENER, 0, af, "webserver", address, port, passwd,
 	  initNetConn, handleWWWClient, handleDeviceRequest, &wwwserver);
@@ -603,6 +660,7 @@ stopWebServer() {
 		fclose(accessfp);
 
 	releaseMimeTypes();
+	releaseFileCache();
 
 	serverhost = NULL;
 }
@@ -20,6 +20,9 @@ struct _WebConn;
 #define WEBSOCK_KEY		"Sec-WebSocket-Key"
 #define WEBSOCK_VER		"Sec-WebSocket-Version"
 #define WEBSOCK_ACCEPT	"Sec-WebSocket-Accept"
+#define WEBSOCK_HDRMAX	10		/* largest (unmasked) websocket frame header */
+#define WEBSOCK_WRITEBUF	16384	/* frames held back while the output worker writes a batch */
+#define WEBSOCK_READBUF		16384	/* read ahead from the socket */
 
 #define APIPATH			"/api/v1"
 #define DICTIONARYAPI	"dictionary"
@@ -34,6 +37,9 @@ struct _WebConn;
 
 #define MIME_WWW_DEFAULT		"application/octet-stream"
 
+#define FILECACHE_SIZE			(4 * 1024 * 1024)	/* default bytes of static files held in memory */
+#define FILECACHE_MAXFILE		(256 * 1024)		/* default largest file held: larger files are sent from disk */
+
 struct webapi {
 	int	enabled;
 	int	adddictionary;
@@ -56,16 +62,42 @@ typedef struct _WebConn {
 	uint32_t				httpminor;
 	kv_t					*header;
 	kv_t					*query;
-	char					readbuf[16384];	/* read buffer */
-	size_t					readbufavail;	/* bytes available in read buffer */
+	uint8_t					readbuf[WEBSOCK_READBUF];	/* data read from the socket (still masked) */
+	uint32_t				readoff;		/* first unconsumed byte in readbuf */
+	uint32_t				readlen;		/* end of the data in readbuf */
+	uint64_t				frameleft;		/* payload of the current data frame not yet consumed */
+	uint8_t					framekey[4];	/* masking key of the current data frame */
+	uint32_t				framekeyoff;	/* position in framekey of the next payload byte */
+	mos_mutex_t				writelk;		/* serializes websocket frames, and protects writebuf */
+	uint8_t					writebuf[WEBSOCK_WRITEBUF];	/* frames not yet written */
+	uint32_t				writebufused;	/* bytes held in writebuf */
 	FILE					*accessfp;
 	struct webapi			webapi;
 } WebConn, *WebConnHandle;
 
+/*
+ * A static file held in memory by the file cache.
+ */
+typedef struct _WebFile {
+	char					*path;			/* canonical path */
+	uint8_t					*data;			/* contents of the file */
+	uint64_t				size;
+	uint64_t				ino;			/* inode, size and mtime identify the version of the file held */
+	uint64_t				mtime;
+	uint32_t				refcnt;			/* one held by the cache while the file is cached */
+	RB_ENTRY(_WebFile)		link;
+	MTAILQ_ENTRY(_WebFile)	lru;
+} WebFile;
+
+struct stat;
+
 void initWebSockNetConn(IPhidgetServerHandle, PhidgetNetConnHandle);
 PhidgetReturnCode handleAPIRequest(mosiop_t, pconf_t *, WebConnHandle, int *);
 
-PhidgetReturnCode mkheader(char *, size_t *, const char *, int);
+/*
+ * (buffer, buffer size, path, nocache, extra header lines or NULL)
+ */
+PhidgetReturnCode mkheader(char *, size_t *, const char *, int, const char *);
 
 /*
  * Writes a message to the access log.
@@ -79,6 +111,20 @@ void wsaccesslog(const char *, const char *, WebConnHandle, int, uint32_t);
  */
 PhidgetReturnCode wsheader(mosiop_t, WebConnHandle, const char *);
 
+/*
+ * Writes the HTTP header for a static file, with its length and validators.
+ *
+ * (iop, conn, path, size, etag, last modified)
+ */
+PhidgetReturnCode wsfileheader(mosiop_t, WebConnHandle, const char *, uint64_t, const char *, const char *);
+
+/*
+ * Writes a 304 message: the client's copy of the file is current.
+ *
+ * (iop, conn, etag, last modified)
+ */
+PhidgetReturnCode wsnotmodified(mosiop_t, WebConnHandle, const char *, const char *);
+
 /*
  * Writes a 404 message to the client.
  */
@@ -100,6 +146,25 @@ const char *getmimetype(kv_t *, const char *);
 PhidgetReturnCode loadMimeTypes(const char *);
 void releaseMimeTypes(void);
 
+/*
+ * Renders the ETag and Last-Modified values for a file.
+ *
+ * (stat, etag, etag size, last modified, last modified size)
+ */
+void mkfiletag(const struct stat *, char *, size_t, char *, size_t);
+
+void initFileCache(pconf_t *);
+void releaseFileCache(void);
+
+/*
+ * Returns the contents of the file open on fd, from the cache or loaded into it, or NULL if the
+ * file is not to be cached.  The file must be released with putCachedFile().
+ *
+ * (canonical path, fd, stat of fd)
+ */
+WebFile *getCachedFile(const char *, int, const struct stat *);
+void putCachedFile(WebFile **);
+
 #define WSSRC "www"
 
 #ifdef NDEBUG
@@ -12,186 +12,224 @@ typedef struct _wsheader {
 	uint8_t opcode;
 	uint8_t mask;
 	uint8_t maskkey[4];
-	uint8_t	hbuf[10];
 } wsheader_t;
 
 #define ISCTRL(op)	((op & 0x8) == 0x8)
+#define WSOPC_BINARY	0x2
 #define WSOPC_CLOSE	0x8
 #define WSOPC_PING	0x9
 #define WSOPC_PONG	0xA
 
-static PhidgetReturnCode
-wsReadHeader(mosiop_t iop, WebConnHandle wc, wsheader_t *ws) {
-	PhidgetReturnCode res;
-	int maskoff;
-	uint32_t len;
+#define WEBSOCK_READDIRECT	4096	/* payload reads at least this large bypass readbuf */
 
-	len = 2;
-	res = pnread(iop, wc->conn, ws->hbuf, &len);
-	if (res != 0)
-		return (MOS_ERROR(iop, res, "failed to read websocket header"));
-	if (len != 2)
-		return (MOS_ERROR(iop, EPHIDGET_IO, "failed to read first 2 bytes of websocket header"));
+/*
+ * Unmasks len bytes from src into dst (which may be src), a word at a time.
+ * keyoff is the position in the key of the first byte, and is advanced past the last.
+ */
+static void
+wsUnmask(uint8_t *dst, const uint8_t *src, size_t len, const uint8_t key[4], uint32_t *keyoff) {
+	uint8_t kb[8];
+	uint64_t k;
+	uint64_t a;
+	uint64_t b;
+	size_t off;
+	int i;
+
+	/* The key, rotated to line up with src, repeated to fill a word */
+	for (i = 0; i < 8; i++)
+		kb[i] = key[(*keyoff + i) & 3];
+	memcpy(&k, kb, sizeof (k));
+
+	for (off = 0; off + 16 <= len; off += 16) {
+		memcpy(&a, src + off, sizeof (a));
+		memcpy(&b, src + off + 8, sizeof (b));
+		a ^= k;
+		b ^= k;
+		memcpy(dst + off, &a, sizeof (a));
+		memcpy(dst + off + 8, &b, sizeof (b));
+	}
+	if (off + 8 <= len) {
+		memcpy(&a, src + off, sizeof (a));
+		a ^= k;
+		memcpy(dst + off, &a, sizeof (a));
+		off += 8;
+	}
+	for (; off < len; off++)
+		dst[off] = src[off] ^ kb[off & 3];
 
-	ws->fin =  (ws->hbuf[0] >> 7) & 0x01;
-	ws->rsv1 = (ws->hbuf[0] >> 4) & 0x01;
-	ws->rsv2 = (ws->hbuf[0] >> 5) & 0x01;
-	ws->rsv3 = (ws->hbuf[0] >> 6) & 0x01;
-	ws->opcode = ws->hbuf[0] & 0x0F;
-	ws->mask = (ws->hbuf[1] >> 7) & 0x01;
-	ws->len = ws->hbuf[1] & 0x7F;
+	*keyoff = (uint32_t)((*keyoff + len) & 3);
+}
 
-	maskoff = 2;
+/*
+ * Reads until at least n bytes are buffered, taking as much as the socket has each time.
+ *
+ * n is never more than a frame header plus a control frame payload, so making room only ever moves
+ * the partial frame left at the end of the buffer.
+ */
+static PhidgetReturnCode
+wsFill(mosiop_t iop, WebConnHandle wc, uint32_t n) {
+	PhidgetReturnCode res;
+	uint32_t avail;
+	uint32_t len;
 
-	if (ws->len == 127) {
-		if (ISCTRL(ws->opcode))
-			return (MOS_ERROR(iop, EPHIDGET_INVALID, "control frame has large payload"));
+	for (;;) {
+		avail = wc->readlen - wc->readoff;
+		if (avail >= n)
+			return (0);
 
-		len = 8;
-		res = pnread(iop, wc->conn, &ws->hbuf[2], &len);
-		if (res != 0)
-			return (MOS_ERROR(iop, res, "failed to read websocket 16bit length"));
-		if (len != 8)
-			return (MOS_ERROR(iop, res, "failed to read 64bit length 8 bytes of websocket header"));
-
-		ws->len =
-		  ((uint64_t)ws->hbuf[2] << 56) |
-		  ((uint64_t)ws->hbuf[3] << 48) |
-		  ((uint64_t)ws->hbuf[4] << 40) |
-		  ((uint64_t)ws->hbuf[5] << 32) |
-		  (ws->hbuf[6] << 24) |
-		  (ws->hbuf[7] << 16) |
-		  (ws->hbuf[8] << 8) |
-		  ws->hbuf[9];
-		maskoff += 8;
-	} else if (ws->len == 126) {
-		if (ISCTRL(ws->opcode))
-			return (MOS_ERROR(iop, EPHIDGET_INVALID, "control frame has large payload"));
+		if (avail == 0 || wc->readoff + n > sizeof (wc->readbuf)) {
+			memmove(wc->readbuf, wc->readbuf + wc->readoff, avail);
+			wc->readoff = 0;
+			wc->readlen = avail;
+		}
 
-		len = 2;
-		res = pnread(iop, wc->conn, &ws->hbuf[2], &len);
+		len = sizeof (wc->readbuf) - wc->readlen;
+		res = pnreadsome(iop, wc->conn, wc->readbuf + wc->readlen, &len);
 		if (res != 0)
-			return (MOS_ERROR(iop, res, "failed to read websocket 16bit length"));
-		if (len != 2)
-			return (MOS_ERROR(iop, res, "failed to read 16bit length 2 bytes of websocket header"));
-		ws->len = (ws->hbuf[2] << 8) | ws->hbuf[3];
-		maskoff += 2;
+			return (MOS_ERROR(iop, res, "failed to read from websocket client"));
+		if (len == 0)
+			return (MOS_ERROR(iop, EPHIDGET_EOF, "websocket client closed the connection"));
+		wc->readlen += len;
 	}
-
-	len = 4;
-	res = pnread(iop, wc->conn, &ws->hbuf[maskoff], &len);
-	if (res != 0)
-		return (MOS_ERROR(iop, res, "failed to read websocket mask"));
-	if (len != 4)
-		return (MOS_ERROR(iop, res, "failed to read websocket mask"));
-
-	ws->maskkey[0] = ws->hbuf[maskoff];
-	ws->maskkey[1] = ws->hbuf[maskoff + 1];
-	ws->maskkey[2] = ws->hbuf[maskoff + 2];
-	ws->maskkey[3] = ws->hbuf[maskoff + 3];
-
-	return (res);
 }
 
+/*
+ * Parses the next frame header in place, and consumes it.
+ */
 static PhidgetReturnCode
-wsReadPayload(mosiop_t iop, wsheader_t *ws, WebConnHandle wc, uint8_t *buf, uint32_t *bufsz) {
+wsReadHeader(mosiop_t iop, WebConnHandle wc, wsheader_t *ws) {
 	PhidgetReturnCode res;
-	uint32_t off;
-	uint32_t n;
+	const uint8_t *p;
+	uint32_t hlen;
+	int i;
 
-	if (*bufsz < ws->len)
-		return (MOS_ERROR(iop, EPHIDGET_NOSPC, "buf too small for payload (%u vs %u)", *bufsz, ws->len));
+	res = wsFill(iop, wc, 2);
+	if (res != 0)
+		return (MOS_ERROR(iop, res, "failed to read websocket header"));
 
-	for (off = 0; off < ws->len; off += n) {
-		n = (uint32_t)ws->len - off;
-		res = pnread(iop, wc->conn, buf + off, &n);
-		if (res != 0)
-			return (MOS_ERROR(iop, res, "failed to read websock payload"));
+	p = wc->readbuf + wc->readoff;
+	ws->fin =  (p[0] >> 7) & 0x01;
+	ws->rsv1 = (p[0] >> 6) & 0x01;
+	ws->rsv2 = (p[0] >> 5) & 0x01;
+	ws->rsv3 = (p[0] >> 4) & 0x01;
+	ws->opcode = p[0] & 0x0F;
+	ws->mask = (p[1] >> 7) & 0x01;
+	ws->len = p[1] & 0x7F;
+
+	hlen = 2;
+	if (ws->len == 127)
+		hlen += 8;
+	else if (ws->len == 126)
+		hlen += 2;
+	if (hlen > 2 && ISCTRL(ws->opcode))
+		return (MOS_ERROR(iop, EPHIDGET_INVALID, "control frame has large payload"));
+	if (ws->mask)
+		hlen += 4;
+
+	res = wsFill(iop, wc, hlen);
+	if (res != 0)
+		return (MOS_ERROR(iop, res, "failed to read websocket header"));
+
+	p = wc->readbuf + wc->readoff;
+	if (ws->len == 127) {
+		ws->len = 0;
+		for (i = 2; i < 10; i++)
+			ws->len = (ws->len << 8) | p[i];
+	} else if (ws->len == 126) {
+		ws->len = (p[2] << 8) | p[3];
 	}
-	for (off = 0; off < (uint32_t)ws->len; off++)
-		buf[off] = buf[off] ^ ws->maskkey[off % 4];
 
-	*bufsz = (uint32_t)ws->len;
+	if (ws->mask)
+		memcpy(ws->maskkey, p + hlen - 4, sizeof (ws->maskkey));
+	else
+		memset(ws->maskkey, 0, sizeof (ws->maskkey));
+
+	wc->readoff += hlen;
 	return (0);
 }
 
-static PhidgetReturnCode
-wsRead(mosiop_t iop, WebConnHandle wc, uint8_t *buf, uint32_t *bufsz, uint8_t *opcode) {
-	PhidgetReturnCode res;
-	wsheader_t ws;
-	uint32_t boff;
-	uint32_t bsz;
-	int pkt;
-
-	memset(&ws, 0, sizeof (ws));
-	boff = 0;
-
-	for (pkt = 0; !ws.fin; pkt++) {
-		res = wsReadHeader(iop, wc, &ws);
-		if (res != 0)
-			return (MOS_ERROR(iop, res, "failed to read websocket header"));
+/*
+ * Fills in an unmasked frame header, returning its length.
+ */
+static uint32_t
+wsFrameHeader(uint8_t *hdr, int fin, uint8_t opcode, uint64_t len) {
+	int i;
 
-		if (pkt == 0)
-			*opcode = ws.opcode;
+	hdr[0] = opcode & 0x0F;
+	if (fin)
+		hdr[0] |= 0x80;
 
-		bsz = *bufsz - boff;
-		res = wsReadPayload(iop, &ws, wc, buf + boff, &bsz);
-		if (res != 0)
-			return (MOS_ERROR(iop, res, "failed to read websocket payload"));
+	if (len > 65535) {
+		hdr[1] = 127;
+		for (i = 0; i < 8; i++)
+			hdr[2 + i] = (len >> (56 - 8 * i)) & 0xFF;
+		return (10);
+	}
 
-		boff += bsz;
+	if (len > 125) {
+		hdr[1] = 126;
+		hdr[2] = (len >> 8) & 0xFF;
+		hdr[3] = len & 0xFF;
+		return (4);
 	}
-	*bufsz = boff;
-	return (0);
+
+	hdr[1] = len & 0x7F;
+	return (2);
 }
 
+/*
+ * Writes a frame.  Header and payload go out in a single write, together with any frames held back.
+ *
+ * With hold, the frame is only copied into the write buffer if it fits, and is written by wsFlush().
+ */
 static PhidgetReturnCode
-wsWritex(mosiop_t iop, WebConnHandle wc, int fin, uint8_t opcode, const char *buf, uint32_t len) {
+wsWritex(mosiop_t iop, WebConnHandle wc, int fin, uint8_t opcode, const char *buf, uint64_t len, int hold) {
+	uint8_t hdr[WEBSOCK_HDRMAX];
 	PhidgetReturnCode res;
-	uint8_t hdr[4];
-	int off;
-
-	if (len > 65535)
-		return (MOS_ERROR(iop, EPHIDGET_UNSUPPORTED, "write too large for implementation"));
+	mos_iovec_t iov[3];
+	uint32_t hlen;
 
-	hdr[0] = 0;
-	off = 0;
+	hlen = wsFrameHeader(hdr, fin, opcode, len);
 
-	if (fin)
-		hdr[off] = 0x80;
-	hdr[off] |= (opcode & 0x07);
-	off++;
-
-
-	if (len > 125) {
-		hdr[off++] = 126;
-		hdr[off++] = (len >> 8) & 0xFF;
-		hdr[off++] = len & 0xFF;
-	} else {
-		hdr[off++] = len & 0x7F;
+	mos_mutex_lock(&wc->writelk);
+	if (hold && wc->writebufused + hlen + len <= sizeof (wc->writebuf)) {
+		memcpy(wc->writebuf + wc->writebufused, hdr, hlen);
+		memcpy(wc->writebuf + wc->writebufused + hlen, buf, (size_t)len);
+		wc->writebufused += hlen + (uint32_t)len;
+		mos_mutex_unlock(&wc->writelk);
+		return (0);
 	}
 
-	res = pnwrite(iop, wc->conn, hdr, off);
-	if (res != 0)
-		return (MOS_ERROR(iop, res, "failed to write header to websocket client"));
-	res = pnwrite(iop, wc->conn, buf, len);
+	iov[0].base = wc->writebuf;
+	iov[0].len = wc->writebufused;
+	iov[1].base = hdr;
+	iov[1].len = hlen;
+	iov[2].base = buf;
+	iov[2].len = (size_t)len;
+	wc->writebufused = 0;
+
+	res = pnwritev(iop, wc->conn, iov, 3);
+	mos_mutex_unlock(&wc->writelk);
 	if (res != 0)
-		return (MOS_ERROR(iop, res, "failed to write payload to websocket client"));
+		return (MOS_ERROR(iop, res, "failed to write frame to websocket client"));
 	return (0);
 }
 
+/*
+ * Writes the frames held back by wsWritex().
+ */
 static PhidgetReturnCode
-wsWrite(mosiop_t iop, WebConnHandle wc, const char *buf, uint32_t len) {
+wsFlush(mosiop_t iop, WebConnHandle wc) {
 	PhidgetReturnCode res;
-	uint32_t off;
-	uint32_t n;
+	uint32_t len;
 
-	for (off = 0; off < len; off += n) {
-		n = MOS_MIN(65535, len - off);
-		res = wsWritex(iop, wc, off + n == len, off == 0 ? 0x2 : 0, buf + off, n);
-		if (res != 0)
-			return (MOS_ERROR(iop, res, "failed to write payload to client"));
-	}
+	mos_mutex_lock(&wc->writelk);
+	len = wc->writebufused;
+	wc->writebufused = 0;
+	res = len > 0 ? pnwrite(iop, wc->conn, wc->writebuf, len) : 0;
+	mos_mutex_unlock(&wc->writelk);
+	if (res != 0)
+		return (MOS_ERROR(iop, res, "failed to write frames to websocket client"));
 	return (0);
 }
 
@@ -199,83 +237,123 @@ static void
 wsPong(WebConnHandle wc, const char *buf, uint32_t len) {
 
 	nslogdebug("");
-	wsWritex(MOS_IOP_IGNORE, wc, 1, WSOPC_PONG, buf, len);
+	wsWritex(MOS_IOP_IGNORE, wc, 1, WSOPC_PONG, buf, len, 0);
 }
 
 static void
 wsClose(WebConnHandle wc, const char *buf, uint32_t len) {
 
 	nslogdebug("");
-	wsWritex(MOS_IOP_IGNORE, wc, 1, WSOPC_CLOSE, buf, len);
+	wsWritex(MOS_IOP_IGNORE, wc, 1, WSOPC_CLOSE, buf, len, 0);
 }
 
+/*
+ * Reads frame headers until there is data frame payload to consume, handling any control frames on
+ * the way.
+ */
 static PhidgetReturnCode
-_netconnread(mosiop_t iop, PhidgetNetConnHandle nc, void *buf, uint32_t *bufsz) {
+wsNextFrame(mosiop_t iop, WebConnHandle wc) {
 	PhidgetReturnCode res;
-	WebConnHandle wc;
-	uint8_t opcode;
+	uint32_t keyoff;
+	wsheader_t ws;
 	uint32_t len;
+	uint8_t *p;
 
-	wc = getNetConnPrivate(nc);
-	if (wc == NULL)
-		return (EPHIDGET_IO);
-
-readbuf:
-
-	if (wc->readbufavail > 0) {
-		len = MOS_MIN(*bufsz, (uint32_t)wc->readbufavail);
-		memcpy(buf, wc->readbuf, len);
-		*bufsz = len;
-		memmove(wc->readbuf, wc->readbuf + len, wc->readbufavail - len);
-		wc->readbufavail -= len;
-		return (0);
-	}
-
-again:
-
-	len = sizeof (wc->readbuf);
-	opcode = 0;
-	res = wsRead(iop, wc, (uint8_t *)wc->readbuf, &len, &opcode);
-	if (res != 0)
-		return (res);
-
-	if (opcode == WSOPC_PING) {
-		wsPong(wc, buf, len);
-		goto again;
-	}
-
-	if (opcode == WSOPC_CLOSE) {
-		wsClose(wc, buf, len);
-		return (EPHIDGET_PIPE);
+	while (wc->frameleft == 0) {
+		res = wsReadHeader(iop, wc, &ws);
+		if (res != 0)
+			return (res);
+
+		/* Messages are only a byte stream to the network code: fragments and types do not matter */
+		if (!ISCTRL(ws.opcode)) {
+			wc->frameleft = ws.len;
+			memcpy(wc->framekey, ws.maskkey, sizeof (wc->framekey));
+			wc->framekeyoff = 0;
+			continue;
+		}
+
+		/* Control frames are short: read the whole frame, and unmask it in place */
+		len = (uint32_t)ws.len;
+		res = wsFill(iop, wc, len);
+		if (res != 0)
+			return (MOS_ERROR(iop, res, "failed to read websocket control frame"));
+
+		p = wc->readbuf + wc->readoff;
+		keyoff = 0;
+		wsUnmask(p, p, len, ws.maskkey, &keyoff);
+		wc->readoff += len;
+
+		if (ws.opcode == WSOPC_PING) {
+			wsPong(wc, (const char *)p, len);
+		} else if (ws.opcode == WSOPC_CLOSE) {
+			wsClose(wc, (const char *)p, len);
+			return (EPHIDGET_PIPE);
+		}
 	}
 
-	wc->readbufavail = len;
-	if (wc->readbufavail == 0) {
-		*bufsz = 0;
-		return (0);
-	}
-	goto readbuf;
+	return (0);
 }
 
 static PhidgetReturnCode CCONV
 netconnread(mosiop_t iop, PhidgetNetConnHandle nc, void *buf, uint32_t *bufsz) {
 	PhidgetReturnCode res;
+	WebConnHandle wc;
 	uint32_t nread;
+	uint32_t avail;
+	uint8_t *dst;
 	uint32_t n;
 
+	wc = getNetConnPrivate(nc);
+	if (wc == NULL)
+		return (EPHIDGET_IO);
+
 	for (nread = 0; nread < *bufsz; nread += n) {
-		n = *bufsz - nread;
-		res = _netconnread(iop, nc, ((uint8_t *)buf) + nread, &n);
+		res = wsNextFrame(iop, wc);
 		if (res != 0)
 			return (MOS_ERROR(iop, res, "failed to read from websocket"));
-		if (n == 0)
-			break;
+
+		dst = (uint8_t *)buf + nread;
+		n = (uint32_t)MOS_MIN(wc->frameleft, (uint64_t)(*bufsz - nread));
+		avail = wc->readlen - wc->readoff;
+
+		if (avail > 0) {
+			/* Unmask the buffered slice of the payload straight into the caller's buffer */
+			n = MOS_MIN(n, avail);
+			wsUnmask(dst, wc->readbuf + wc->readoff, n, wc->framekey, &wc->framekeyoff);
+			wc->readoff += n;
+		} else if (n >= WEBSOCK_READDIRECT) {
+			/* Nothing buffered, and plenty wanted: read directly into the caller's buffer */
+			res = pnreadsome(iop, nc, dst, &n);
+			if (res != 0)
+				return (MOS_ERROR(iop, res, "failed to read websocket payload"));
+			if (n == 0)
+				return (MOS_ERROR(iop, EPHIDGET_EOF, "websocket client closed the connection"));
+			wsUnmask(dst, dst, n, wc->framekey, &wc->framekeyoff);
+		} else {
+			res = wsFill(iop, wc, 1);
+			if (res != 0)
+				return (MOS_ERROR(iop, res, "failed to read websocket payload"));
+			n = 0;
+			continue;
+		}
+
+		wc->frameleft -= n;
 	}
-	*bufsz = nread;
 
 	return (0);
 }
 
+static uint32_t CCONV
+netconnbuffered(PhidgetNetConnHandle nc) {
+	WebConnHandle wc;
+
+	wc = getNetConnPrivate(nc);
+	if (wc == NULL)
+		return (0);
+
+	return (wc->readlen - wc->readoff);
+}
+
 static PhidgetReturnCode CCONV
 netconnwrite(mosiop_t iop, PhidgetNetConnHandle nc, const void *buf, uint32_t bufsz) {
 	WebConnHandle wc;
@@ -284,11 +362,25 @@ netconnwrite(mosiop_t iop, PhidgetNetConnHandle nc, const void *buf, uint32_t bu
 	if (wc == NULL)
 		return (EPHIDGET_IO);
 
-	return (wsWrite(iop, wc, buf, bufsz));
+	/* Each message is a single binary frame; events written by the output worker are batched */
+	return (wsWritex(iop, wc, 1, WSOPC_BINARY, buf, bufsz, getNetConnWriteBatch(nc)));
+}
+
+static PhidgetReturnCode CCONV
+netconnflush(mosiop_t iop, PhidgetNetConnHandle nc) {
+	WebConnHandle wc;
+
+	wc = getNetConnPrivate(nc);
+	if (wc == NULL)
+		return (EPHIDGET_IO);
+
+	return (wsFlush(iop, wc));
 }
 
 void
 initWebSockNetConn(IPhidgetServerHandle server, PhidgetNetConnHandle nc) {
 
 	setNetConnHandlers(nc, NULL, NULL, netconnwrite, netconnread);
+	setNetConnFlushHandler(nc, netconnflush);
+	setNetConnBufferedHandler(nc, netconnbuffered);
 }
@@ -1,8 +1,36 @@
 #include "server.h"
 #include "webserver/webserver.h"
 
+#include <sys/stat.h>
+#include <unistd.h>
+
 static kv_t *mimetypes;
 
+/*
+ * Static files are cached by canonical path, and dropped in least recently used order once the
+ * cache is full.  A cached file is only used while the file on disk still has the inode, size and
+ * mtime it was loaded with.
+ */
+typedef RB_HEAD(webfiles, _WebFile) webfiles_t;
+typedef MTAILQ_HEAD(webfilelru, _WebFile) webfilelru_t;
+
+static int
+webfile_compare(WebFile *a, WebFile *b) {
+
+	return (mos_strcmp(a->path, b->path));
+}
+
+RB_PROTOTYPE(webfiles, _WebFile, link, webfile_compare)
+RB_GENERATE(webfiles, _WebFile, link, webfile_compare)
+
+static webfiles_t filecache;
+static webfilelru_t filecachelru;
+static mos_mutex_t filecachelk;
+static uint64_t filecachesize;	/* most bytes held */
+static uint64_t filecachemax;	/* largest file held */
+static uint64_t filecacheused;	/* bytes held */
+static int filecacheinit;
+
 static const char *MOVED301 =
 	"<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\n"
 	"<html><head>\n"
@@ -22,9 +50,12 @@ static const char *NOTFOUND404 =
 	"</BODY></HTML>\n";
 
 PhidgetReturnCode
-mkheader(char *buf, size_t *bufsz, const char *path, int nocache) {
+mkheader(char *buf, size_t *bufsz, const char *path, int nocache, const char *extra) {
 	size_t len;
 
+	if (extra == NULL)
+		extra = "";
+
 	if (nocache) {
 		len = mos_snprintf(buf, *bufsz,
 		  "HTTP/1.1 200 OK\r\nServer: Phidget22\r\n"
@@ -33,15 +64,17 @@ mkheader(char *buf, size_t *bufsz, const char *path, int nocache) {
 		  "Expires: 0\r\n"
 		  "Connection: close\r\n"
 		  "Content-Type: %s\r\n"
+		  "%s"
 		  "\r\n",
-		  getmimetype(mimetypes, path));
+		  getmimetype(mimetypes, path), extra);
 	} else {
 		len = mos_snprintf(buf, *bufsz,
 		  "HTTP/1.1 200 OK\r\nServer: Phidget22\r\n"
 		  "Connection: close\r\n"
 		  "Content-Type: %s\r\n"
+		  "%s"
 		  "\r\n",
-		  getmimetype(mimetypes, path));
+		  getmimetype(mimetypes, path), extra);
 	}
 	if (len >= *bufsz)
 		return (EPHIDGET_NOSPC);
@@ -57,7 +90,7 @@ wsheader(mosiop_t iop, WebConnHandle wc, const char *path) {
 	size_t n;
 
 	n = sizeof (header);
-	res = mkheader(header, &n, path, wc->flags & WC_NOCACHE);
+	res = mkheader(header, &n, path, wc->flags & WC_NOCACHE, NULL);
 	if (res != EPHIDGET_OK)
 		return (MOS_ERROR(iop, res, "failed to create header"));
 
@@ -69,6 +102,50 @@ wsheader(mosiop_t iop, WebConnHandle wc, const char *path) {
 
 }
 
+PhidgetReturnCode
+wsfileheader(mosiop_t iop, WebConnHandle wc, const char *path, uint64_t size, const char *etag,
+  const char *lastmod) {
+	PhidgetReturnCode res;
+	char header[512];
+	char extra[256];
+	size_t n;
+
+	n = mos_snprintf(extra, sizeof (extra), "Content-Length: %"PRIu64"\r\nETag: %s\r\nLast-Modified: %s\r\n",
+	  size, etag, lastmod);
+	if (n >= sizeof (extra))
+		return (MOS_ERROR(iop, EPHIDGET_NOSPC, "not enough space to render header"));
+
+	n = sizeof (header);
+	res = mkheader(header, &n, path, wc->flags & WC_NOCACHE, extra);
+	if (res != EPHIDGET_OK)
+		return (MOS_ERROR(iop, res, "failed to create header"));
+
+	res = netConnWrite(iop, wc->conn, header, n);
+	if (res != EPHIDGET_OK)
+		return (MOS_ERROR(iop, res, "failed to write header"));
+
+	return (EPHIDGET_OK);
+}
+
+PhidgetReturnCode
+wsnotmodified(mosiop_t iop, WebConnHandle wc, const char *etag, const char *lastmod) {
+	PhidgetReturnCode res;
+	char reply[256];
+	size_t len;
+
+	len = mos_snprintf(reply, sizeof (reply),
+	  "HTTP/1.1 304 Not Modified\r\nServer: Phidget22\r\nConnection: close\r\n"
+	  "ETag: %s\r\nLast-Modified: %s\r\n\r\n", etag, lastmod);
+	if (len >= sizeof (reply))
+		return (MOS_ERROR(iop, EPHIDGET_NOSPC, "not enough space to render header"));
+
+	res = netConnWrite(iop, wc->conn, reply, len);
+	if (res != 0)
+		return (MOS_ERROR(iop, res, "failed to write header to client"));
+
+	return (EPHIDGET_OK);
+}
+
 PhidgetReturnCode
 wsnoent(mosiop_t iop, WebConnHandle wc, const char *path) {
 	PhidgetReturnCode res;
@@ -218,3 +295,176 @@ releaseMimeTypes() {
 	if (mimetypes)
 		kvfree(&mimetypes);
 }
+
+void
+mkfiletag(const struct stat *sb, char *etag, size_t etagsz, char *lastmod, size_t lastmodsz) {
+	mostimestamp_t mts;
+	struct tm tm;
+
+	mos_snprintf(etag, etagsz, "\"%"PRIx64"-%"PRIx64"-%"PRIx64"\"", (uint64_t)sb->st_ino,
+	  (uint64_t)sb->st_mtime, (uint64_t)sb->st_size);
+
+	gmtime_r(&sb->st_mtime, &tm);
+	mostimestamp_fromtm(MOS_IOP_IGNORE, &tm, &mts);
+	mos_snprintf(lastmod, lastmodsz, "%lT", &mts);
+}
+
+void
+initFileCache(pconf_t *cfg) {
+	int64_t size;
+	int64_t max;
+
+	if (filecacheinit)
+		releaseFileCache();
+
+	size = pconf_get64(cfg, FILECACHE_SIZE, "phidget.www.cache.size");
+	max = pconf_get64(cfg, FILECACHE_MAXFILE, "phidget.www.cache.maxfile");
+
+	filecachesize = size > 0 ? (uint64_t)size : 0;
+	filecachemax = max > 0 ? (uint64_t)MOS_MIN(max, size) : 0;
+	filecacheused = 0;
+
+	RB_INIT(&filecache);
+	MTAILQ_INIT(&filecachelru);
+	mos_mutex_init(&filecachelk);
+	filecacheinit = 1;
+}
+
+static void
+freeWebFile(WebFile *wf) {
+
+	if (wf->data)
+		mos_free(wf->data, (size_t)wf->size);
+	mos_free(wf->path, MOSM_FSTR);
+	mos_free(wf, sizeof (*wf));
+}
+
+/*
+ * Takes the file out of the cache.  The file is freed once the last request using it is done.
+ * Called with filecachelk held.
+ */
+static void
+dropWebFile(WebFile *wf) {
+
+	RB_REMOVE(webfiles, &filecache, wf);
+	MTAILQ_REMOVE(&filecachelru, wf, lru);
+	filecacheused -= wf->size;
+
+	if (--wf->refcnt == 0)
+		freeWebFile(wf);
+}
+
+static int
+isWebFile(const WebFile *wf, const struct stat *sb) {
+
+	return (wf->ino == (uint64_t)sb->st_ino && wf->size == (uint64_t)sb->st_size &&
+	  wf->mtime == (uint64_t)sb->st_mtime);
+}
+
+static PhidgetReturnCode
+loadWebFile(const char *path, int fd, const struct stat *sb, WebFile **wfp) {
+	WebFile *wf;
+	uint64_t off;
+	ssize_t n;
+
+	wf = mos_zalloc(sizeof (*wf));
+	wf->path = mos_strdup(path, NULL);
+	wf->size = (uint64_t)sb->st_size;
+	wf->ino = (uint64_t)sb->st_ino;
+	wf->mtime = (uint64_t)sb->st_mtime;
+
+	if (wf->size > 0)
+		wf->data = mos_malloc((size_t)wf->size);
+
+	for (off = 0; off < wf->size; off += (uint64_t)n) {
+		n = pread(fd, wf->data + off, (size_t)(wf->size - off), (off_t)off);
+		if (n <= 0) {
+			wslogwarn("failed to read '%s' into the file cache", path);
+			freeWebFile(wf);
+			return (EPHIDGET_IO);
+		}
+	}
+
+	*wfp = wf;
+	return (EPHIDGET_OK);
+}
+
+WebFile *
+getCachedFile(const char *path, int fd, const struct stat *sb) {
+	WebFile *wf, *nwf;
+	WebFile key;
+
+	if (!filecacheinit || filecachemax == 0 || (uint64_t)sb->st_size > filecachemax)
+		return (NULL);
+
+	key.path = (char *)path;
+
+	mos_mutex_lock(&filecachelk);
+	wf = RB_FIND(webfiles, &filecache, &key);
+	if (wf != NULL) {
+		if (isWebFile(wf, sb))
+			goto found;
+		dropWebFile(wf);	/* the file has changed */
+	}
+	mos_mutex_unlock(&filecachelk);
+
+	/* Read without the lock: another request may load the same file meanwhile */
+	if (loadWebFile(path, fd, sb, &nwf) != EPHIDGET_OK)
+		return (NULL);
+
+	mos_mutex_lock(&filecachelk);
+	wf = RB_INSERT(webfiles, &filecache, nwf);
+	if (wf != NULL) {
+		if (isWebFile(wf, sb)) {
+			freeWebFile(nwf);
+			goto found;
+		}
+		dropWebFile(wf);
+		RB_INSERT(webfiles, &filecache, nwf);
+	}
+
+	wf = nwf;
+	wf->refcnt = 1;
+	MTAILQ_INSERT_HEAD(&filecachelru, wf, lru);
+	filecacheused += wf->size;
+
+	while (filecacheused > filecachesize && MTAILQ_LAST(&filecachelru, webfilelru) != wf)
+		dropWebFile(MTAILQ_LAST(&filecachelru, webfilelru));
+
+	wf->refcnt++;
+	mos_mutex_unlock(&filecachelk);
+	return (wf);
+
+found:
+	MTAILQ_REMOVE(&filecachelru, wf, lru);
+	MTAILQ_INSERT_HEAD(&filecachelru, wf, lru);
+	wf->refcnt++;
+	mos_mutex_unlock(&filecachelk);
+	return (wf);
+}
+
+void
+putCachedFile(WebFile **wf) {
+
+	mos_mutex_lock(&filecachelk);
+	if (--(*wf)->refcnt == 0)
+		freeWebFile(*wf);
+	mos_mutex_unlock(&filecachelk);
+	*wf = NULL;
+}
+
+void
+releaseFileCache() {
+	WebFile *wf;
+
+	if (!filecacheinit)
+		return;
+
+	mos_mutex_lock(&filecachelk);
+	while ((wf = MTAILQ_FIRST(&filecachelru)) != NULL)
+		dropWebFile(wf);
+	mos_mutex_unlock(&filecachelk);
+
+	mos_mutex_destroy(&filecachelk);
+	filecacheinit = 0;
+}